@@ -8,7 +8,11 @@
 #include "bench/Benchmark.h"
 #include "bench/BigPath.h"
 #include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkGraphics.h"
 #include "include/core/SkPath.h"
+#include "include/core/SkPathUtils.h"
+#include "src/core/SkScan.h"
 #include "tools/ToolUtils.h"
 
 enum Align {
@@ -83,3 +87,58 @@ DEF_BENCH( return new BigPathBench(kRight_Align,    false); )
 DEF_BENCH( return new BigPathBench(kLeft_Align,     true); )
 DEF_BENCH( return new BigPathBench(kMiddle_Align,   true); )
 DEF_BENCH( return new BigPathBench(kRight_Align,    true); )
+
+// The big path's stroke, stacked a few times down the canvas, filled with analytic AA either on
+// one thread or in bands on the default executor.
+class BigPathBandedBench : public Benchmark {
+    static constexpr int kCopies = 8;
+    static constexpr int kSpacing = 100;
+
+    SkPath fPath;
+    bool   fBanded;
+
+public:
+    explicit BigPathBandedBench(bool banded) : fBanded(banded) {}
+
+protected:
+    const char* onGetName() override {
+        return fBanded ? "bigpath_stacked_banded" : "bigpath_stacked";
+    }
+
+    SkIPoint onGetSize() override {
+        return SkIPoint::Make(640, kCopies * kSpacing);
+    }
+
+    void onDelayedSetup() override {
+        SkPaint stroke;
+        stroke.setStyle(SkPaint::kStroke_Style);
+        stroke.setStrokeWidth(2);
+        SkPath outline;
+        skpathutils::FillPathWithPaint(BenchUtils::make_big_path(), stroke, &outline);
+        for (int i = 0; i < kCopies; ++i) {
+            fPath.addPath(outline, 0, SkIntToScalar(i * kSpacing));
+        }
+    }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        this->setupPaint(&paint);
+
+        // The path has far too many points for AntiFillPath to pick analytic AA on its own.
+        const bool forceAAA = gSkForceAnalyticAA.exchange(true);
+        SkExecutor* prev = SkGraphics::SetRasterPathExecutor(
+                fBanded ? &SkExecutor::GetDefault() : nullptr);
+        for (int i = 0; i < loops; i++) {
+            canvas->drawPath(fPath, paint);
+        }
+        SkGraphics::SetRasterPathExecutor(prev);
+        gSkForceAnalyticAA = forceAAA;
+    }
+
+private:
+    using INHERITED = Benchmark;
+};
+
+DEF_BENCH( return new BigPathBandedBench(false); )
+DEF_BENCH( return new BigPathBandedBench(true); )
@@ -9,16 +9,18 @@
 #ifdef SK_ENABLE_ANDROID_UTILS
 #include "bench/CodecBenchPriv.h"
 #include "client_utils/android/BitmapRegionDecoder.h"
+#include "include/codec/SkCodec.h"
 #include "include/core/SkBitmap.h"
 #include "src/core/SkOSFile.h"
 
 BitmapRegionDecoderBench::BitmapRegionDecoderBench(const char* baseName, SkData* encoded,
-        SkColorType colorType, uint32_t sampleSize, const SkIRect& subset)
+        SkColorType colorType, uint32_t sampleSize, const SkIRect& subset, bool useRowIndex)
     : fBRD(nullptr)
     , fData(SkRef(encoded))
     , fColorType(colorType)
     , fSampleSize(sampleSize)
     , fSubset(subset)
+    , fUseRowIndex(useRowIndex)
 {
     // Choose a useful name for the color type
     const char* colorName = color_type_to_str(colorType);
@@ -27,6 +29,9 @@ BitmapRegionDecoderBench::BitmapRegionDecoderBench(const char* baseName, SkData*
     if (1 != sampleSize) {
         fName.appendf("_%.3f", 1.0f / (float) sampleSize);
     }
+    if (useRowIndex) {
+        fName.append("_rowindex");
+    }
 }
 
 const char* BitmapRegionDecoderBench::onGetName() {
@@ -39,6 +44,10 @@ bool BitmapRegionDecoderBench::isSuitableFor(Backend backend) {
 
 void BitmapRegionDecoderBench::onDelayedSetup() {
     fBRD = android::skia::BitmapRegionDecoder::Make(fData);
+    if (fUseRowIndex) {
+        // Building the index decodes the whole image, so it is not part of the timing.
+        SkAssertResult(fBRD->setRowIndex(SkCodec::MakeFromData(fData)->buildRowIndex()));
+    }
 }
 
 void BitmapRegionDecoderBench::onDraw(int n, SkCanvas* canvas) {
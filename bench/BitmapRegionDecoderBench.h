@@ -29,9 +29,9 @@ class BitmapRegionDecoder;
  */
 class BitmapRegionDecoderBench : public Benchmark {
 public:
-    // Calls encoded->ref()
+    // Calls encoded->ref(). If useRowIndex, decodes through an index from SkCodec::buildRowIndex().
     BitmapRegionDecoderBench(const char* basename, SkData* encoded, SkColorType colorType,
-            uint32_t sampleSize, const SkIRect& subset);
+            uint32_t sampleSize, const SkIRect& subset, bool useRowIndex = false);
 
 protected:
     const char* onGetName() override;
@@ -46,6 +46,7 @@ private:
     const SkColorType                                   fColorType;
     const uint32_t                                      fSampleSize;
     const SkIRect                                       fSubset;
+    const bool                                          fUseRowIndex;
     using INHERITED = Benchmark;
 };
 #endif // SK_ENABLE_ANDROID_UTILS
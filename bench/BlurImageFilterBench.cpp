@@ -61,18 +61,21 @@ static sk_sp<SkImage> make_checkerboard(int width, int height) {
 class BlurImageFilterBench : public Benchmark {
 public:
     BlurImageFilterBench(SkScalar sigmaX, SkScalar sigmaY,  bool small, bool cropped,
-                         bool expanded)
+                         bool expanded,
+                         SkImageFilters::BlurQuality quality = SkImageFilters::BlurQuality::kExact)
       : fIsSmall(small)
       , fIsCropped(cropped)
       , fIsExpanded(expanded)
       , fInitialized(false)
       , fSigmaX(sigmaX)
-      , fSigmaY(sigmaY) {
-        fName.printf("blur_image_filter_%s%s%s_%.2f_%.2f",
+      , fSigmaY(sigmaY)
+      , fQuality(quality) {
+        fName.printf("blur_image_filter_%s%s%s_%.2f_%.2f%s",
             fIsSmall ? "small" : "large",
             fIsCropped ? "_cropped" : "",
             fIsExpanded ? "_expanded" : "",
-            SkScalarToFloat(sigmaX), SkScalarToFloat(sigmaY));
+            SkScalarToFloat(sigmaX), SkScalarToFloat(sigmaY),
+            fQuality == SkImageFilters::BlurQuality::kFast ? "_fast" : "");
         SkASSERT(!fIsExpanded || fIsCropped); // never want expansion w/o cropping
     }
 
@@ -103,7 +106,8 @@ protected:
         const SkIRect* crop =
             fIsExpanded ? &bmpRect : fIsCropped ? &bmpRectInset : nullptr;
         SkPaint paint;
-        paint.setImageFilter(SkImageFilters::Blur(fSigmaX, fSigmaY, std::move(input), crop));
+        paint.setImageFilter(SkImageFilters::Blur(fSigmaX, fSigmaY, SkTileMode::kDecal, fQuality,
+                                                  std::move(input), crop));
         SkSamplingOptions sampling;
 
         for (int i = 0; i < loops; i++) {
@@ -120,6 +124,7 @@ private:
     bool fInitialized;
     sk_sp<SkImage> fCheckerboard;
     SkScalar fSigmaX, fSigmaY;
+    SkImageFilters::BlurQuality fQuality;
     using INHERITED = Benchmark;
 };
 
@@ -161,3 +166,21 @@ DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_LARGE, BLUR_SIGMA_LARGE, tr
 DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_LARGE, BLUR_SIGMA_LARGE, false, true, true);)
 DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_HUGE, BLUR_SIGMA_HUGE, true, true, true);)
 DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_HUGE, BLUR_SIGMA_HUGE, false, true, true);)
+
+// Large sigmas, with and without blurring at a lower resolution. Exact blurs with
+// BLUR_SIGMA_LARGE and BLUR_SIGMA_HUGE are covered above.
+static constexpr SkImageFilters::BlurQuality kExact = SkImageFilters::BlurQuality::kExact,
+                                             kFast  = SkImageFilters::BlurQuality::kFast;
+DEF_BENCH(return new BlurImageFilterBench(10, 10, false, false, false, kFast);)
+DEF_BENCH(return new BlurImageFilterBench(25, 25, false, false, false, kExact);)
+DEF_BENCH(return new BlurImageFilterBench(25, 25, false, false, false, kFast);)
+DEF_BENCH(return new BlurImageFilterBench(50, 50, false, false, false, kExact);)
+DEF_BENCH(return new BlurImageFilterBench(50, 50, false, false, false, kFast);)
+DEF_BENCH(return new BlurImageFilterBench(100, 100, false, false, false, kExact);)
+DEF_BENCH(return new BlurImageFilterBench(100, 100, false, false, false, kFast);)
+DEF_BENCH(return new BlurImageFilterBench(200, 200, false, false, false, kExact);)
+DEF_BENCH(return new BlurImageFilterBench(200, 200, false, false, false, kFast);)
+DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_HUGE, BLUR_SIGMA_HUGE, false, false, false,
+                                          kFast);)
+DEF_BENCH(return new BlurImageFilterBench(BLUR_SIGMA_HUGE, BLUR_SIGMA_HUGE, false, true, true,
+                                          kFast);)
@@ -7,11 +7,16 @@
 
 #include "bench/CodecBench.h"
 #include "bench/CodecBenchPriv.h"
+#include "include/codec/SkAndroidCodec.h"
 #include "include/codec/SkCodec.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkExecutor.h"
 #include "src/core/SkOSFile.h"
+#include "tools/Resources.h"
 #include "tools/flags/CommandLineFlags.h"
 
+#include <vector>
+
 // Actually zeroing the memory would throw off timing, so we just lie.
 static DEFINE_bool(zero_init, false,
                    "Pretend our destination is zero-intialized, simulating Android?");
@@ -64,3 +69,72 @@ void CodecBench::onDraw(int n, SkCanvas* canvas) {
                  || result == SkCodec::kIncompleteInput);
     }
 }
+
+// Decodes a batch of thumbnails, either one after another or with SkAndroidCodec::DecodeBatch().
+class CodecBatchBench : public Benchmark {
+public:
+    CodecBatchBench(bool batched) : fBatched(batched) {
+        fName.printf("Codec_batch_%s", batched ? "threaded" : "serial");
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+    bool isSuitableFor(Backend backend) override { return kNonRendering_Backend == backend; }
+
+    void onDelayedSetup() override {
+        const char* kImages[] = {
+            "images/mandrill_512_q075.jpg",
+            "images/color_wheel.jpg",
+            "images/mandrill_256.png",
+            "images/yellow_rose.png",
+        };
+        for (int i = 0; i < kBatchSize; i++) {
+            sk_sp<SkData> data = GetResourceAsData(kImages[i % std::size(kImages)]);
+            auto codec = SkAndroidCodec::MakeFromData(data);
+            if (!codec) {
+                continue;
+            }
+            constexpr int kSampleSize = 2;
+            SkImageInfo info = codec->getInfo().makeDimensions(
+                    codec->getSampledDimensions(kSampleSize)).makeColorType(kN32_SkColorType);
+            fPixels.emplace_back().allocPixels(info);
+
+            SkAndroidCodec::BatchDecodeRequest req;
+            req.fData       = std::move(data);
+            req.fDst        = fPixels.back().pixmap();
+            req.fSampleSize = kSampleSize;
+            fRequests.push_back(req);
+        }
+        if (fBatched) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool();
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        while (loops --> 0) {
+            if (fBatched) {
+                SkAndroidCodec::DecodeBatch(fRequests, fExecutor.get());
+                continue;
+            }
+            for (auto& req : fRequests) {
+                auto codec = SkAndroidCodec::MakeFromData(req.fData);
+                SkAndroidCodec::AndroidOptions options;
+                options.fSampleSize = req.fSampleSize;
+                req.fResult = codec->getAndroidPixels(req.fDst.info(), req.fDst.writable_addr(),
+                                                      req.fDst.rowBytes(), &options);
+            }
+        }
+    }
+
+private:
+    static constexpr int kBatchSize = 64;
+
+    const bool                                      fBatched;
+    SkString                                        fName;
+    std::vector<SkBitmap>                           fPixels;
+    std::vector<SkAndroidCodec::BatchDecodeRequest> fRequests;
+    std::unique_ptr<SkExecutor>                     fExecutor;
+};
+
+DEF_BENCH( return new CodecBatchBench(false); )
+DEF_BENCH( return new CodecBatchBench(true); )
@@ -6,11 +6,29 @@
  */
 
 #include "bench/Benchmark.h"
+#include "include/codec/SkAndroidCodec.h"
+#include "include/codec/SkCodec.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkPictureRecorder.h"
+#include "include/core/SkSamplingOptions.h"
+#include "include/core/SkStream.h"
+#include "include/core/SkYUVAInfo.h"
+#include "include/core/SkYUVAPixmaps.h"
+#include "include/effects/SkColorMatrix.h"
+#include "include/encode/SkJpegEncoder.h"
+#include "include/private/base/SkFloatingPoint.h"
+#include "include/private/base/SkTPin.h"
+#include "include/private/base/SkTo.h"
 #include "modules/skottie/include/Skottie.h"
+#include "src/base/SkRandom.h"
+#include "src/utils/SkAnimCodecFrameCache.h"
 #include "tools/Resources.h"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 class DecodeBench : public Benchmark {
 protected:
     DecodeBench(const char* name, const char* source)
@@ -54,6 +72,238 @@ private:
     using INHERITED = DecodeBench;
 };
 
+// Decodes with SkCodec directly, optionally letting the codec split the work across threads.
+class CodecDecodeBench final : public DecodeBench {
+public:
+    CodecDecodeBench(const char* name, const char* source, bool threaded)
+        : INHERITED(name, source)
+        , fThreaded(threaded)
+    {}
+
+    void onDelayedSetup() override {
+        INHERITED::onDelayedSetup();
+        auto codec = SkCodec::MakeFromData(fData);
+        SkASSERT(codec);
+        fBitmap.allocPixels(codec->getInfo().makeColorType(kN32_SkColorType));
+        if (fThreaded) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool();
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        SkCodec::Options options;
+        options.fExecutor = fExecutor.get();
+        while (loops-- > 0) {
+            auto codec = SkCodec::MakeFromData(fData);
+            SkAssertResult(SkCodec::kSuccess == codec->getPixels(fBitmap.pixmap(), &options));
+        }
+    }
+
+private:
+    const bool                  fThreaded;
+    SkBitmap                    fBitmap;
+    std::unique_ptr<SkExecutor> fExecutor;
+
+    using INHERITED = DecodeBench;
+};
+
+
+// Seeks to random frames of an animation, either decoding each from scratch with SkCodec (which
+// decodes every frame it depends on), or through an SkAnimCodecFrameCache with room for
+// keyframeBudget keyframes.
+class AnimSeekDecodeBench final : public DecodeBench {
+public:
+    static constexpr int kNoCache = 0;
+
+    AnimSeekDecodeBench(const char* name, const char* source, int keyframeBudget)
+        : INHERITED(name, source)
+        , fKeyframeBudget(keyframeBudget)
+    {}
+
+    void onDelayedSetup() override {
+        INHERITED::onDelayedSetup();
+        fCodec = SkCodec::MakeFromData(fData);
+        SkASSERT(fCodec);
+        if (fKeyframeBudget != kNoCache) {
+            fCache = std::make_unique<SkAnimCodecFrameCache>(
+                    fCodec.get(), fKeyframeBudget * fCodec->getInfo().computeMinByteSize());
+        }
+        fBitmap.allocPixels(fCodec->getInfo().makeAlphaType(kPremul_SkAlphaType));
+
+        SkRandom rand;
+        for (int& frame : fSeeks) {
+            frame = rand.nextULessThan(fCodec->getFrameCount());
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        while (loops-- > 0) {
+            for (int frame : fSeeks) {
+                if (fCache) {
+                    SkAssertResult(fCache->getFrame(frame));
+                } else {
+                    SkCodec::Options options;
+                    options.fFrameIndex = frame;
+                    SkAssertResult(SkCodec::kSuccess ==
+                                   fCodec->getPixels(fBitmap.pixmap(), &options));
+                }
+            }
+        }
+    }
+
+private:
+    const int                              fKeyframeBudget;
+    std::unique_ptr<SkCodec>               fCodec;
+    std::unique_ptr<SkAnimCodecFrameCache> fCache;
+    SkBitmap                               fBitmap;
+    int                                    fSeeks[16];
+
+    using INHERITED = DecodeBench;
+};
+
+// Decodes a thumbnail of an image, either with SkAndroidCodec::getResizedPixels, or by decoding
+// with the closest sample size and then downscaling with mipmaps. If encodedSize is not empty,
+// the image is first resized to it and re-encoded as a JPEG.
+class ThumbnailDecodeBench final : public DecodeBench {
+public:
+    ThumbnailDecodeBench(const char* name, const char* source, SkISize encodedSize,
+                         int thumbnailWidth, bool resized)
+        : INHERITED(name, source)
+        , fEncodedSize(encodedSize)
+        , fThumbnailWidth(thumbnailWidth)
+        , fResized(resized)
+    {}
+
+    void onDelayedSetup() override {
+        INHERITED::onDelayedSetup();
+        if (!fEncodedSize.isEmpty()) {
+            SkBitmap decoded, scaled;
+            SkAssertResult(DecodeDataToBitmap(fData, &decoded));
+            scaled.allocPixels(decoded.info().makeDimensions(fEncodedSize));
+            decoded.pixmap().scalePixels(scaled.pixmap(), SkSamplingOptions(SkFilterMode::kLinear));
+            SkDynamicMemoryWStream stream;
+            SkAssertResult(SkJpegEncoder::Encode(&stream, scaled.pixmap(), {}));
+            fData = stream.detachAsData();
+        }
+        auto codec = SkAndroidCodec::MakeFromData(fData);
+        SkASSERT(codec);
+        const SkISize dims = codec->getInfo().dimensions();
+        fThumbnail.allocPixels(codec->getInfo().makeColorType(kN32_SkColorType).makeWH(
+                fThumbnailWidth, fThumbnailWidth * dims.height() / dims.width()));
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        while (loops-- > 0) {
+            auto codec = SkAndroidCodec::MakeFromData(fData);
+            if (fResized) {
+                SkAssertResult(SkCodec::kSuccess ==
+                               codec->getResizedPixels(fThumbnail.info(), fThumbnail.getPixels(),
+                                                       fThumbnail.rowBytes()));
+                continue;
+            }
+            SkISize size = fThumbnail.dimensions();
+            SkAndroidCodec::AndroidOptions options;
+            options.fSampleSize = codec->computeSampleSize(&size);
+            SkBitmap sampled;
+            sampled.allocPixels(fThumbnail.info().makeDimensions(size));
+            SkAssertResult(SkCodec::kSuccess ==
+                           codec->getAndroidPixels(sampled.info(), sampled.getPixels(),
+                                                   sampled.rowBytes(), &options));
+            SkAssertResult(sampled.pixmap().scalePixels(
+                    fThumbnail.pixmap(),
+                    SkSamplingOptions(SkFilterMode::kLinear, SkMipmapMode::kLinear)));
+        }
+    }
+
+private:
+    const SkISize fEncodedSize;
+    const int     fThumbnailWidth;
+    const bool    fResized;
+    SkBitmap      fThumbnail;
+
+    using INHERITED = DecodeBench;
+};
+
+// Decodes to the codec's native YUV planes, either directly with getYUVAPlanes or by decoding to
+// RGBA and converting that back to planes, as a client without planar support would have to.
+class YUVDecodeBench final : public DecodeBench {
+public:
+    YUVDecodeBench(const char* name, const char* source, bool planar)
+        : INHERITED(name, source)
+        , fPlanar(planar)
+    {}
+
+    void onDelayedSetup() override {
+        INHERITED::onDelayedSetup();
+        auto codec = SkCodec::MakeFromData(fData);
+        SkASSERT(codec);
+        SkYUVAPixmapInfo yuvaPixmapInfo;
+        SkYUVAPixmapInfo::SupportedDataTypes unorm8Only;
+        for (int numChannels = 1; numChannels <= 4; ++numChannels) {
+            unorm8Only.enableDataType(SkYUVAPixmapInfo::DataType::kUnorm8, numChannels);
+        }
+        SkAssertResult(codec->queryYUVAInfo(unorm8Only, &yuvaPixmapInfo));
+        fPlanes = SkYUVAPixmaps::Allocate(yuvaPixmapInfo);
+        if (!fPlanar) {
+            fRGBA.allocPixels(codec->getInfo().makeColorType(kRGBA_8888_SkColorType)
+                                              .makeAlphaType(kUnpremul_SkAlphaType));
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        while (loops-- > 0) {
+            auto codec = SkCodec::MakeFromData(fData);
+            if (fPlanar) {
+                SkAssertResult(SkCodec::kSuccess == codec->getYUVAPlanes(fPlanes));
+                continue;
+            }
+            SkAssertResult(SkCodec::kSuccess == codec->getPixels(fRGBA.pixmap()));
+            this->convertToPlanes();
+        }
+    }
+
+private:
+    void convertToPlanes() {
+        const SkYUVAInfo& yuvaInfo = fPlanes.yuvaInfo();
+        float m[20];
+        SkColorMatrix::RGBtoYUV(yuvaInfo.yuvColorSpace()).getRowMajor(m);
+        const SkPixmap& src = fRGBA.pixmap();
+        for (int i = 0; i < fPlanes.numPlanes(); ++i) {
+            const SkPixmap& dst = fPlanes.plane(i);
+            auto [sx, sy] = yuvaInfo.planeSubsamplingFactors(i);
+            for (int y = 0; y < dst.height(); ++y) {
+                uint8_t* dstRow = dst.writable_addr8(0, y);
+                for (int x = 0; x < dst.width(); ++x) {
+                    // Average the block of source pixels covered by this sample.
+                    float rgba[4] = {};
+                    int count = 0;
+                    for (int v = y * sy; v < std::min((y + 1) * sy, src.height()); ++v) {
+                        for (int u = x * sx; u < std::min((x + 1) * sx, src.width()); ++u) {
+                            const uint8_t* p = static_cast<const uint8_t*>(src.addr(u, v));
+                            for (int c = 0; c < 4; ++c) {
+                                rgba[c] += p[c];
+                            }
+                            count++;
+                        }
+                    }
+                    float value = rgba[3];
+                    if (i < 3) {
+                        const float* row = m + 5 * i;
+                        value = row[0] * rgba[0] + row[1] * rgba[1] + row[2] * rgba[2] +
+                                row[4] * 255 * count;
+                    }
+                    dstRow[x] = SkTo<uint8_t>(SkTPin(sk_float_round2int(value / count), 0, 255));
+                }
+            }
+        }
+    }
+
+    const bool    fPlanar;
+    SkYUVAPixmaps fPlanes;
+    SkBitmap      fRGBA;
+
+    using INHERITED = DecodeBench;
+};
 
 class SkottieDecodeBench final : public DecodeBench {
 public:
@@ -94,6 +344,40 @@ private:
     using INHERITED = DecodeBench;
 };
 
+// A 12MP camera photo with restart markers.
+DEF_BENCH(return new CodecDecodeBench("jpeg_restart_serial", "images/iphone_13_pro.jpeg", false));
+DEF_BENCH(return new CodecDecodeBench("jpeg_restart_threaded", "images/iphone_13_pro.jpeg", true));
+
+// 256 pixel wide thumbnails of that photo, and of a 24MP version of it.
+DEF_BENCH(return new ThumbnailDecodeBench("jpeg_thumbnail_12mp_resized",
+                                          "images/iphone_13_pro.jpeg",
+                                          SkISize::MakeEmpty(), 256, true));
+DEF_BENCH(return new ThumbnailDecodeBench("jpeg_thumbnail_12mp_sampled",
+                                          "images/iphone_13_pro.jpeg",
+                                          SkISize::MakeEmpty(), 256, false));
+DEF_BENCH(return new ThumbnailDecodeBench("jpeg_thumbnail_24mp_resized",
+                                          "images/iphone_13_pro.jpeg",
+                                          {6000, 4000}, 256, true));
+DEF_BENCH(return new ThumbnailDecodeBench("jpeg_thumbnail_24mp_sampled",
+                                          "images/iphone_13_pro.jpeg",
+                                          {6000, 4000}, 256, false));
+
+// 4:2:0 lossy WebP, and AVIF.
+DEF_BENCH(return new YUVDecodeBench("webp_yuv_planar", "images/webp-color-profile-lossy.webp",
+                                    true));
+DEF_BENCH(return new YUVDecodeBench("webp_yuv_from_rgba", "images/webp-color-profile-lossy.webp",
+                                    false));
+#ifdef SK_CODEC_DECODES_AVIF
+DEF_BENCH(return new YUVDecodeBench("avif_yuv_planar", "images/ducky.avif", true));
+DEF_BENCH(return new YUVDecodeBench("avif_yuv_from_rgba", "images/ducky.avif", false));
+#endif
+
+// A 60 frame animation.
+DEF_BENCH(return new AnimSeekDecodeBench("gif_seek_nocache", "images/flightAnim.gif",
+                                         AnimSeekDecodeBench::kNoCache));
+DEF_BENCH(return new AnimSeekDecodeBench("gif_seek_4keyframes", "images/flightAnim.gif", 4));
+DEF_BENCH(return new AnimSeekDecodeBench("gif_seek_allkeyframes", "images/flightAnim.gif", 60));
+
 DEF_BENCH(return new SkottieDecodeBench("skottie_large",  // 426593
                                         "skottie/skottie-text-scale-to-fit-minmax.json"));
 DEF_BENCH(return new SkottieDecodeBench("skottie_medium", //  10947
@@ -7,6 +7,9 @@
 
 #include "bench/Benchmark.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkEncodedImageFormat.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkStream.h"
 #include "include/encode/SkJpegEncoder.h"
 #include "include/encode/SkPngEncoder.h"
@@ -123,3 +126,109 @@ DEF_BENCH(return new EncodeBench(srcs[1], PNG(kNone, 3), "PNG_3n"));
 DEF_BENCH(return new EncodeBench(srcs[1], PNG(kNone, 1), "PNG_1n"));
 
 #undef PNG
+
+// Encodes a 3840x2160 RGBA image (31.6MB of pixels), serially or split across a thread pool of the
+// given size.  Serial PNG encodes use Skia's own filters and deflate, not libpng's row writer.
+// MB/s is 31.6 / the reported time in seconds.  libwebp manages its own threads, so for lossless
+// WEBP any thread count just enables them.
+class ThreadsEncodeBench : public Benchmark {
+public:
+    ThreadsEncodeBench(SkEncodedImageFormat format, int threads)
+        : fFormat(format)
+        , fThreads(threads) {
+        const char* formatName = "PNG";
+        switch (format) {
+            case SkEncodedImageFormat::kJPEG:
+                formatName = "JPEG";
+                break;
+            case SkEncodedImageFormat::kWEBP:
+                formatName = "WEBP_LL";
+                break;
+            default:
+                SkASSERT(format == SkEncodedImageFormat::kPNG);
+                break;
+        }
+        fName = threads ? SkStringPrintf("Encode_4k_%s_threads_%d", formatName, threads)
+                        : SkStringPrintf("Encode_4k_%s_serial", formatName);
+    }
+
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        SkBitmap tile;
+        SkAssertResult(GetResourceAsBitmap("images/mandrill_512.png", &tile));
+        fBitmap.allocN32Pixels(3840, 2160);
+        SkCanvas canvas(fBitmap);
+        for (int y = 0; y < fBitmap.height(); y += tile.height()) {
+            for (int x = 0; x < fBitmap.width(); x += tile.width()) {
+                canvas.drawImage(tile.asImage(), x, y);
+            }
+        }
+        if (fThreads && fFormat != SkEncodedImageFormat::kWEBP) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads);
+        }
+        if (fThreads && fFormat == SkEncodedImageFormat::kPNG) {
+            // Each band is deflated on its own, which should cost little compression.
+            SkDynamicMemoryWStream serial, parallel;
+            SkAssertResult(SkPngEncoder::Encode(&serial, fBitmap.pixmap(), {}));
+            SkAssertResult(this->encode(&parallel));
+            SkASSERTF(parallel.bytesWritten() <= serial.bytesWritten() * 101 / 100,
+                      "%zu vs. %zu bytes", parallel.bytesWritten(), serial.bytesWritten());
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        while (loops-- > 0) {
+            SkNullWStream dst;
+            SkAssertResult(this->encode(&dst));
+            SkASSERT(dst.bytesWritten() > 0);
+        }
+    }
+
+private:
+    bool encode(SkWStream* dst) const {
+        switch (fFormat) {
+            case SkEncodedImageFormat::kJPEG: {
+                SkJpegEncoder::Options opts;
+                opts.fQuality = 90;
+                opts.fExecutor = fExecutor.get();
+                return SkJpegEncoder::Encode(dst, fBitmap.pixmap(), opts);
+            }
+            case SkEncodedImageFormat::kWEBP: {
+                SkWebpEncoder::Options opts;
+                opts.fCompression = SkWebpEncoder::Compression::kLossless;
+                opts.fQuality = 90;
+                opts.fMultithreaded = fThreads > 0;
+                return SkWebpEncoder::Encode(dst, fBitmap.pixmap(), opts);
+            }
+            default: {
+                SkPngEncoder::Options opts;
+                opts.fExecutor = fExecutor.get();
+                return SkPngEncoder::Encode(dst, fBitmap.pixmap(), opts);
+            }
+        }
+    }
+
+    const SkEncodedImageFormat  fFormat;
+    const int                   fThreads;
+    SkString                    fName;
+    SkBitmap                    fBitmap;
+    std::unique_ptr<SkExecutor> fExecutor;
+};
+
+DEF_BENCH(return new ThreadsEncodeBench(SkEncodedImageFormat::kPNG, 0));
+DEF_BENCH(return new ThreadsEncodeBench(SkEncodedImageFormat::kPNG, 1));
+DEF_BENCH(return new ThreadsEncodeBench(SkEncodedImageFormat::kPNG, 2));
+DEF_BENCH(return new ThreadsEncodeBench(SkEncodedImageFormat::kPNG, 4));
+DEF_BENCH(return new ThreadsEncodeBench(SkEncodedImageFormat::kPNG, 8));
+
+DEF_BENCH(return new ThreadsEncodeBench(SkEncodedImageFormat::kJPEG, 0));
+DEF_BENCH(return new ThreadsEncodeBench(SkEncodedImageFormat::kJPEG, 1));
+DEF_BENCH(return new ThreadsEncodeBench(SkEncodedImageFormat::kJPEG, 2));
+DEF_BENCH(return new ThreadsEncodeBench(SkEncodedImageFormat::kJPEG, 4));
+DEF_BENCH(return new ThreadsEncodeBench(SkEncodedImageFormat::kJPEG, 8));
+
+DEF_BENCH(return new ThreadsEncodeBench(SkEncodedImageFormat::kWEBP, 0));
+DEF_BENCH(return new ThreadsEncodeBench(SkEncodedImageFormat::kWEBP, 2));
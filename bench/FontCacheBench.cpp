@@ -11,11 +11,17 @@
 #include "include/core/SkPaint.h"
 #include "include/core/SkPath.h"
 #include "include/core/SkString.h"
+#include "include/core/SkSurface.h"
 #include "include/private/SkChecksum.h"
+#include "include/private/base/SkSemaphore.h"
 #include "include/private/base/SkTemplates.h"
 
 #include "bench/gUniqueGlyphIDs.h"
 
+#include <memory>
+#include <thread>
+#include <vector>
+
 #define gUniqueGlyphIDs_Sentinel    0xFFFF
 
 static int count_glyphs(const uint16_t start[]) {
@@ -142,6 +148,96 @@ private:
 };
 DEF_BENCH( return new FontCacheBench(); )
 
+// Measures and draws the same glyphs from many threads at once, each into its own raster surface,
+// so that all threads hit the same strikes in the global strike cache. The threads and surfaces
+// are created once, so each onDraw() only times the drawing.
+class FontCacheThreadsBench : public Benchmark {
+public:
+    explicit FontCacheThreadsBench(int threadCount) : fThreadCount(threadCount) {
+        fName.printf("fontcache_threads_%d", threadCount);
+    }
+
+    ~FontCacheThreadsBench() override {
+        fLoops = -1;
+        for (const auto& worker : fWorkers) {
+            worker->fStart.signal();
+        }
+        for (const auto& worker : fWorkers) {
+            worker->fThread.join();
+        }
+    }
+
+protected:
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onDelayedSetup() override {
+        if (!fWorkers.empty()) {
+            return;
+        }
+        for (int t = 0; t < fThreadCount; ++t) {
+            Worker* worker = fWorkers.emplace_back(std::make_unique<Worker>()).get();
+            sk_sp<SkSurface> surface = SkSurface::MakeRasterN32Premul(256, 256);
+            worker->fThread = std::thread([this, worker, surface] {
+                SkFont font;
+                font.setEdging(SkFont::Edging::kAntiAlias);
+                SkCanvas* canvas = surface->getCanvas();
+                SkPaint paint;
+
+                for (worker->fStart.wait(); fLoops >= 0; worker->fStart.wait()) {
+                    for (int i = 0; i < fLoops; ++i) {
+                        const uint16_t* array = gUniqueGlyphIDs;
+                        while (*array != gUniqueGlyphIDs_Sentinel) {
+                            int count = count_glyphs(array);
+                            size_t byteLength = count * sizeof(uint16_t);
+                            (void)font.measureText(array, byteLength, SkTextEncoding::kGlyphID);
+                            canvas->drawSimpleText(array, byteLength, SkTextEncoding::kGlyphID,
+                                                   0, 128, font, paint);
+                            array += count + 1;    // skip the sentinel
+                        }
+                    }
+                    fDone.signal();
+                }
+            });
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        // The semaphores order fLoops before the threads read it, and their draws before we return.
+        fLoops = loops;
+        for (const auto& worker : fWorkers) {
+            worker->fStart.signal();
+        }
+        for (int t = 0; t < fThreadCount; ++t) {
+            fDone.wait();
+        }
+    }
+
+private:
+    struct Worker {
+        SkSemaphore fStart;
+        std::thread fThread;
+    };
+
+    const int fThreadCount;
+    SkString fName;
+    std::vector<std::unique_ptr<Worker>> fWorkers;
+    int fLoops = 0;  // -1 tells the threads to exit
+    SkSemaphore fDone;
+
+    using INHERITED = Benchmark;
+};
+
+DEF_BENCH( return new FontCacheThreadsBench(1); )
+DEF_BENCH( return new FontCacheThreadsBench(4); )
+DEF_BENCH( return new FontCacheThreadsBench(16); )
+DEF_BENCH( return new FontCacheThreadsBench(64); )
+
 // undefine this to run the efficiency test
 //DEF_BENCH( return new FontCacheEfficiency(); )
 
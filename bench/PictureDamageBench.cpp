@@ -0,0 +1,82 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkBBHFactory.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkColor.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/core/SkRect.h"
+#include "include/utils/SkPictureDamage.h"
+#include "src/base/SkRandom.h"
+
+#include <vector>
+
+// Emulates a dashboard that re-records a 10k op picture every frame, where one op changes per
+// frame. Compares redrawing the whole picture with redrawing only the damage.
+class PictureDamageBench : public Benchmark {
+public:
+    explicit PictureDamageBench(bool partial) : fPartial(partial) {}
+
+private:
+    static constexpr int kOps = 10000;
+    static constexpr int kFrames = 16;
+
+    const char* onGetName() override {
+        return fPartial ? "picture_damage_10k_partial" : "picture_damage_10k_full";
+    }
+    SkIPoint onGetSize() override { return SkIPoint::Make(1024, 1024); }
+
+    void onDelayedSetup() override {
+        SkRandom rand;
+        std::vector<SkRect> rects(kOps);
+        std::vector<SkColor> colors(kOps);
+        for (int i = 0; i < kOps; i++) {
+            rects[i] = SkRect::MakeXYWH(rand.nextRangeScalar(0, 1000),
+                                        rand.nextRangeScalar(0, 1000),
+                                        rand.nextRangeScalar(4, 24),
+                                        rand.nextRangeScalar(4, 24));
+            colors[i] = rand.nextU() | 0xFF000000;
+        }
+
+        SkRTreeFactory factory;
+        for (int frame = 0; frame < kFrames; frame++) {
+            colors[rand.nextULessThan(kOps)] = rand.nextU() | 0xFF000000;
+
+            SkPictureRecorder recorder;
+            SkCanvas* canvas = recorder.beginRecording(1024, 1024, &factory);
+            for (int i = 0; i < kOps; i++) {
+                SkPaint paint;
+                paint.setColor(colors[i]);
+                canvas->drawRect(rects[i], paint);
+            }
+            fFrames[frame] = recorder.finishRecordingAsPicture();
+        }
+    }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        const SkPicture* prev = nullptr;
+        for (int i = 0; i < loops; i++) {
+            const SkPicture* frame = fFrames[i % kFrames].get();
+            if (fPartial) {
+                SkPictureDamage::Redraw(canvas, frame, SkPictureDamage::Compute(prev, frame));
+            } else {
+                canvas->clear(SK_ColorTRANSPARENT);
+                canvas->drawPicture(frame);
+            }
+            prev = frame;
+        }
+    }
+
+    bool             fPartial;
+    sk_sp<SkPicture> fFrames[kFrames];
+};
+
+DEF_BENCH( return new PictureDamageBench(false); )
+DEF_BENCH( return new PictureDamageBench(true); )
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkString.h"
+#include "src/base/SkRandom.h"
+#include "src/core/SkOpts.h"
+
+// Filters one 4K RGBA row.  The _scalar variants are the byte-at-a-time loops SkOpts replaced,
+// for comparison.
+static constexpr size_t kRowBytes = 3840 * 4;
+static constexpr int kBpp = 4;
+
+static void scalar_filter_row(int filter, uint8_t dst[], const uint8_t row[],
+                              const uint8_t prev[], size_t rowBytes, int bpp) {
+    for (size_t i = 0; i < rowBytes; i++) {
+        int a = i >= (size_t)bpp ? row[i - bpp] : 0,
+            b = prev[i],
+            c = i >= (size_t)bpp ? prev[i - bpp] : 0;
+        switch (filter) {
+            case 1: dst[i] = row[i] - a;                                    break;
+            case 2: dst[i] = row[i] - b;                                    break;
+            case 3: dst[i] = row[i] - ((a + b) >> 1);                       break;
+            case 4: dst[i] = row[i] - SkOpts::png_paeth_predictor(a, b, c); break;
+        }
+    }
+}
+
+static uint64_t scalar_filter_sum(const uint8_t bytes[], size_t len) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < len; i++) {
+        sum += bytes[i] < 128 ? bytes[i] : 256 - bytes[i];
+    }
+    return sum;
+}
+
+class PngFilterBench : public Benchmark {
+public:
+    // filter 0 benches the filter selection heuristic instead of a filter.
+    PngFilterBench(const char* name, int filter, bool scalar)
+        : fFilter(filter), fScalar(scalar) {
+        fName.printf("PngFilter_%s%s", name, scalar ? "_scalar" : "");
+    }
+
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        SkRandom rand;
+        for (size_t i = 0; i < kRowBytes; i++) {
+            fRow[i]  = rand.nextU() >> 24;
+            fPrev[i] = rand.nextU() >> 24;
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        uint64_t sum = 0;
+        while (loops --> 0) {
+            if (fFilter == 0) {
+                sum += fScalar ? scalar_filter_sum(fRow, kRowBytes)
+                               : SkOpts::png_filter_sum(fRow, kRowBytes);
+            } else if (fScalar) {
+                scalar_filter_row(fFilter, fDst, fRow, fPrev, kRowBytes, kBpp);
+            } else {
+                SkOpts::png_filter_row(fFilter, fDst, fRow, fPrev, kRowBytes, kBpp);
+            }
+        }
+        fSink = sum + fDst[kRowBytes - 1];
+    }
+
+private:
+    SkString fName;
+    int fFilter;
+    bool fScalar;
+    uint8_t fRow[kRowBytes], fPrev[kRowBytes], fDst[kRowBytes];
+    volatile uint64_t fSink;
+};
+
+DEF_BENCH(return new PngFilterBench("sub",   1, false);)
+DEF_BENCH(return new PngFilterBench("sub",   1, true);)
+DEF_BENCH(return new PngFilterBench("up",    2, false);)
+DEF_BENCH(return new PngFilterBench("up",    2, true);)
+DEF_BENCH(return new PngFilterBench("avg",   3, false);)
+DEF_BENCH(return new PngFilterBench("avg",   3, true);)
+DEF_BENCH(return new PngFilterBench("paeth", 4, false);)
+DEF_BENCH(return new PngFilterBench("paeth", 4, true);)
+DEF_BENCH(return new PngFilterBench("sum",   0, false);)
+DEF_BENCH(return new PngFilterBench("sum",   0, true);)
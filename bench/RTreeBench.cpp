@@ -12,6 +12,9 @@
 #include "src/base/SkRandom.h"
 #include "src/core/SkRTree.h"
 
+#include <algorithm>
+#include <vector>
+
 using namespace skia_private;
 
 // confine rectangles to a smallish area, so queries generally hit something, and overlap occurs:
@@ -98,6 +101,93 @@ private:
     using INHERITED = Benchmark;
 };
 
+// Time building and searching R-Trees of many small rects, e.g. of a long page recorded into one
+// picture, and culling the tiles of a screen scrolled somewhere on the page.
+class RTreePageBench : public Benchmark {
+public:
+    enum class Mode { kBuild, kSearch, kTiles };
+
+    RTreePageBench(Mode mode, int numRects) : fMode(mode), fNumRects(numRects) {
+        static const char* kModes[] = {"build", "search", "tiles"};
+        fName.printf("rtree_page_%s_%dk", kModes[(int)mode], numRects / 1000);
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    static constexpr int kColumns = 100;
+    static constexpr SkScalar kCellSize = 10, kPageWidth = kColumns * kCellSize, kTileSize = 256;
+    static constexpr int kScreenTiles = 4;
+
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+
+    SkScalar pageHeight() const { return fNumRects / kColumns * kCellSize; }
+
+    void onDelayedSetup() override {
+        SkRandom rand;
+        fRects.resize(fNumRects);
+        for (int i = 0; i < fNumRects; ++i) {
+            fRects[i] = SkRect::MakeXYWH((i % kColumns) * kCellSize + rand.nextRangeF(0, 5),
+                                         (i / kColumns) * kCellSize + rand.nextRangeF(0, 5),
+                                         1 + rand.nextRangeF(0, 3 * kCellSize),
+                                         1 + rand.nextRangeF(0, 3 * kCellSize));
+        }
+        if (fMode != Mode::kBuild) {
+            fTree.insert(fRects.data(), fNumRects);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        SkRandom rand;
+        const SkScalar screenSize = kScreenTiles * kTileSize;
+        SkRect tiles[kScreenTiles * kScreenTiles];
+        std::vector<int> hits[kScreenTiles * kScreenTiles];
+        for (int i = 0; i < loops; ++i) {
+            switch (fMode) {
+                case Mode::kBuild: {
+                    SkRTree tree;
+                    tree.insert(fRects.data(), fNumRects);
+                    break;
+                }
+                case Mode::kSearch: {
+                    hits[0].clear();
+                    fTree.search(SkRect::MakeXYWH(rand.nextRangeF(0, kPageWidth - kTileSize),
+                                                  rand.nextRangeF(0, this->pageHeight()),
+                                                  kTileSize, kTileSize),
+                                 &hits[0]);
+                    break;
+                }
+                case Mode::kTiles: {
+                    const SkScalar scroll =
+                            rand.nextRangeF(0, std::max(0.0f, this->pageHeight() - screenSize));
+                    for (int t = 0; t < kScreenTiles * kScreenTiles; ++t) {
+                        tiles[t] = SkRect::MakeXYWH((t % kScreenTiles) * kTileSize,
+                                                    (t / kScreenTiles) * kTileSize + scroll,
+                                                    kTileSize, kTileSize);
+                        hits[t].clear();
+                    }
+                    for (int t = 0; t < kScreenTiles * kScreenTiles; ++t) {
+                        fTree.search(tiles[t], &hits[t]);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+private:
+    Mode fMode;
+    int fNumRects;
+    std::vector<SkRect> fRects;
+    SkRTree fTree;
+    SkString fName;
+    using INHERITED = Benchmark;
+};
+
 static inline SkRect make_XYordered_rects(SkRandom& rand, int index, int numRects) {
     SkRect out;
     out.fLeft   = SkIntToScalar(index % GRID_WIDTH);
@@ -139,3 +229,15 @@ DEF_BENCH(return new RTreeQueryBench("XY", &make_XYordered_rects));
 DEF_BENCH(return new RTreeQueryBench("YX", &make_YXordered_rects));
 DEF_BENCH(return new RTreeQueryBench("random", &make_random_rects));
 DEF_BENCH(return new RTreeQueryBench("concentric", &make_concentric_rects));
+
+DEF_BENCH(return new RTreePageBench(RTreePageBench::Mode::kBuild, 10000));
+DEF_BENCH(return new RTreePageBench(RTreePageBench::Mode::kBuild, 100000));
+DEF_BENCH(return new RTreePageBench(RTreePageBench::Mode::kBuild, 1000000));
+
+DEF_BENCH(return new RTreePageBench(RTreePageBench::Mode::kSearch, 10000));
+DEF_BENCH(return new RTreePageBench(RTreePageBench::Mode::kSearch, 100000));
+DEF_BENCH(return new RTreePageBench(RTreePageBench::Mode::kSearch, 1000000));
+
+DEF_BENCH(return new RTreePageBench(RTreePageBench::Mode::kTiles, 10000));
+DEF_BENCH(return new RTreePageBench(RTreePageBench::Mode::kTiles, 100000));
+DEF_BENCH(return new RTreePageBench(RTreePageBench::Mode::kTiles, 1000000));
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkString.h"
+#include "src/core/SkCpu.h"
+#include "src/core/SkOpts.h"
+#include "src/core/SkRasterPipeline.h"
+
+#include <vector>
+
+// Runs common lowp pipelines over a row of pixels.  The "_hsw" variants run the 16-wide hsw
+// stages directly from their own table, so on CPUs with AVX-512 both widths can be compared in
+// one run without touching the stages SkOpts has installed.
+class RasterPipelineLowpBench : public Benchmark {
+public:
+    enum class Op { kSrcOver, kBilerp };
+
+    RasterPipelineLowpBench(Op op, bool forceHSW) : fOp(op), fForceHSW(forceHSW) {
+        fName.printf("SkRasterPipeline_lowp_%s%s",
+                     op == Op::kSrcOver ? "srcover" : "bilerp",
+                     forceHSW ? "_hsw" : "");
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        if (backend != kNonRendering_Backend) {
+            return false;
+        }
+        if (fForceHSW) {
+        #if defined(SK_CPU_X86) && !defined(SK_ENABLE_OPTIMIZE_SIZE)
+            if (SkCpu::Supports(SkCpu::HSW)) {
+                SkOpts::GetLowpStages_hsw(&fStages);
+            }
+        #endif
+            // Builds without lowp stages (e.g. not compiled by Clang) leave the table empty.
+            return fStages.just_return != nullptr;
+        }
+        return true;
+    }
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onDelayedSetup() override {
+        for (int i = 0; i < kWidth; i++) {
+            fSrc[i] = (i & 1) ? 0x80402010 : 0xff336699;
+            fDst[i] = 0xff000000 | (uint32_t)(i * 0x010203);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        SkRasterPipeline_MemoryCtx src = {fSrc, 0},
+                                   dst = {fDst, 0};
+        SkRasterPipeline_GatherCtx gather;
+        gather.pixels = fSrc;
+        gather.stride = kWidth / 4;
+        gather.width  = kWidth / 4;
+        gather.height = 4;
+        float scaleTranslate[] = {0.23f, 0.25f, 0.5f, 0.5f};
+
+        SkRasterPipeline_<256> p;
+        if (fOp == Op::kSrcOver) {
+            p.append(SkRasterPipelineOp::load_8888_dst, &dst);
+            p.append(SkRasterPipelineOp::load_8888, &src);
+            p.append(SkRasterPipelineOp::srcover);
+        } else {
+            p.append(SkRasterPipelineOp::seed_shader);
+            p.append(SkRasterPipelineOp::matrix_scale_translate, scaleTranslate);
+            p.append(SkRasterPipelineOp::bilerp_clamp_8888, &gather);
+        }
+        p.append(SkRasterPipelineOp::store_8888, &dst);
+
+        if (!fForceHSW) {
+            auto fn = p.compile();
+            while (loops --> 0) {
+                fn(0,0,kWidth,1);
+            }
+            return;
+        }
+
+        // Lay the program out the way SkRasterPipeline does for lowp: stages in order, then
+        // just_return.  getStageList() hands the stages back last-to-first.
+        std::vector<SkRasterPipelineStage> program(p.getNumStages() + 1);
+        SkRasterPipelineStage* ip = program.data() + program.size();
+        --ip;
+        ip->fn  = fStages.just_return;
+        ip->ctx = nullptr;
+        for (const SkRasterPipeline::StageList* st = p.getStageList(); st; st = st->prev) {
+            SkASSERT((int)st->stage < kNumRasterPipelineLowpOps && fStages.ops[(int)st->stage]);
+            --ip;
+            ip->fn  = fStages.ops[(int)st->stage];
+            ip->ctx = st->ctx;
+        }
+        SkASSERT(ip == program.data());
+
+        while (loops --> 0) {
+            fStages.start_pipeline(0,0,kWidth,1, program.data());
+        }
+    }
+
+private:
+    static constexpr int kWidth = 1024;
+
+    Op       fOp;
+    bool     fForceHSW;
+    SkOpts::LowpStages fStages = {};
+    SkString fName;
+    uint32_t fSrc[kWidth];
+    uint32_t fDst[kWidth];
+};
+
+DEF_BENCH( return new RasterPipelineLowpBench(RasterPipelineLowpBench::Op::kSrcOver, false); )
+DEF_BENCH( return new RasterPipelineLowpBench(RasterPipelineLowpBench::Op::kSrcOver, true); )
+DEF_BENCH( return new RasterPipelineLowpBench(RasterPipelineLowpBench::Op::kBilerp, false); )
+DEF_BENCH( return new RasterPipelineLowpBench(RasterPipelineLowpBench::Op::kBilerp, true); )
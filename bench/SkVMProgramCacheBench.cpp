@@ -0,0 +1,87 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkColorFilter.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkPaint.h"
+#include "include/effects/SkGradientShader.h"
+#include "src/core/SkOSFile.h"
+#include "src/utils/SkOSPath.h"
+#include "tools/ToolUtils.h"
+
+#include <thread>
+
+extern bool gUseSkVMBlitter;
+
+// Measures the first frame drawn by a new render worker through SkVMBlitter: each draw happens on
+// a fresh thread, so it starts with an empty in-memory program cache. "cold" compiles every
+// program; "warm" loads them from an SkGraphics::SetProgramCacheDirectory() directory populated
+// by an earlier draw.
+class SkVMProgramCacheBench : public Benchmark {
+    bool     fWarm;
+    SkPaint  fPaint;
+    SkString fDirectory;
+
+public:
+    explicit SkVMProgramCacheBench(bool warm) : fWarm(warm) {}
+
+protected:
+    const char* onGetName() override {
+        return fWarm ? "skvm_first_frame_warm" : "skvm_first_frame_cold";
+    }
+
+    bool isSuitableFor(Backend backend) override { return backend == kRaster_Backend; }
+
+    void onDelayedSetup() override {
+        const SkPoint pts[] = {{0, 0}, {256, 256}};
+        const SkColor colors[] = {SK_ColorRED, SK_ColorGREEN, SK_ColorBLUE};
+        fPaint.setShader(SkGradientShader::MakeLinear(pts, colors, nullptr, std::size(colors),
+                                                      SkTileMode::kMirror));
+        fPaint.setColorFilter(SkColorFilters::Blend(0x80FFFF00, SkBlendMode::kMultiply));
+        fPaint.setAntiAlias(true);
+
+        if (fWarm) {
+            SkString tmp = ToolUtils::temp_dir();
+            fDirectory = SkOSPath::Join(tmp.isEmpty() ? "." : tmp.c_str(),
+                                        "skvm_program_cache_bench");
+            sk_mkdir(fDirectory.c_str());
+        }
+    }
+
+    void onPerCanvasPreDraw(SkCanvas* canvas) override {
+        if (fWarm) {
+            // Leave this frame's programs in the directory for the timed draws to find.
+            this->drawFirstFrame(canvas);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        for (int i = 0; i < loops; i++) {
+            this->drawFirstFrame(canvas);
+        }
+    }
+
+private:
+    void drawFirstFrame(SkCanvas* canvas) {
+        const bool useSkVM = gUseSkVMBlitter;
+        gUseSkVMBlitter = true;
+        SkGraphics::SetProgramCacheDirectory(fWarm ? fDirectory.c_str() : nullptr);
+        std::thread([&] {
+            canvas->drawCircle(128, 128, 100, fPaint);
+            canvas->drawRect({16, 16, 240, 240}, fPaint);
+        }).join();
+        SkGraphics::SetProgramCacheDirectory(nullptr);
+        gUseSkVMBlitter = useSkVM;
+    }
+
+    using INHERITED = Benchmark;
+};
+
+DEF_BENCH( return new SkVMProgramCacheBench(false); )
+DEF_BENCH( return new SkVMProgramCacheBench(true); )
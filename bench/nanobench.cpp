@@ -25,6 +25,7 @@
 #include "include/codec/SkCodec.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkGraphics.h"
 #include "include/core/SkImageEncoder.h"
 #include "include/core/SkPictureRecorder.h"
@@ -36,6 +37,10 @@
 #include "src/base/SkLeanWindows.h"
 #include "src/core/SkColorSpacePriv.h"
 #include "src/core/SkOSFile.h"
+#include "src/core/SkRecord.h"
+#include "src/core/SkRecordDraw.h"
+#include "src/core/SkRecordOpts.h"
+#include "src/core/SkRecorder.h"
 #include "src/core/SkTaskGroup.h"
 #include "src/core/SkTraceEvent.h"
 #include "src/utils/SkJSONWriter.h"
@@ -141,6 +146,8 @@ static DEFINE_string(zoom, "1.0,0",
                      "function that ping-pongs between 1.0 and zoomMax.");
 static DEFINE_bool(bbh, true, "Build a BBH for SKPs?");
 static DEFINE_bool(loopSKP, true, "Loop SKPs like we do for micro benches?");
+static DEFINE_bool(optimizeSKPs, false,
+                   "Also play back SKPs after the experimental SkRecordOptimize2 passes?");
 static DEFINE_int(flushEvery, 10, "Flush --outResultsFile every Nth run.");
 static DEFINE_bool(gpuStats, false, "Print GPU stats after each gpu benchmark?");
 static DEFINE_bool(gpuStatsDump, false, "Dump GPU stats after each benchmark to json");
@@ -226,6 +233,28 @@ bool Target::init(SkImageInfo info, Benchmark* bench) {
     }
     return true;
 }
+// Raster config whose surface records draws and plays them back per tile on the thread pool.
+static constexpr char kThreadedRasterConfig[] = "threaded8888";
+
+struct ThreadedRasterTarget : public Target {
+    explicit ThreadedRasterTarget(const Config& c) : Target(c) {}
+
+    bool init(SkImageInfo info, Benchmark*) override {
+        this->surface = SkSurface::MakeRasterThreaded(info, &SkExecutor::GetDefault());
+        return this->surface != nullptr;
+    }
+    // Recorded draws only rasterize when the pixels are needed, so ask for them before the timer
+    // stops.
+    void endTiming() override {
+        SkPixmap unused;
+        this->surface->peekPixels(&unused);
+    }
+    bool capturePixels(SkBitmap* bmp) override {
+        bmp->allocPixels(this->surface->imageInfo());
+        return this->surface->readPixels(*bmp, 0, 0);
+    }
+};
+
 bool Target::capturePixels(SkBitmap* bmp) {
     SkCanvas* canvas = this->getCanvas();
     if (!canvas) {
@@ -671,6 +700,7 @@ static std::optional<Config> create_config(const SkCommandLineConfig* config) {
     CPU_CONFIG("bgra",  kRaster_Backend,  kBGRA_8888_SkColorType, kPremul_SkAlphaType)
     CPU_CONFIG("f16",   kRaster_Backend,   kRGBA_F16_SkColorType, kPremul_SkAlphaType)
     CPU_CONFIG("srgba", kRaster_Backend, kSRGBA_8888_SkColorType, kPremul_SkAlphaType)
+    CPU_CONFIG(kThreadedRasterConfig, kRaster_Backend, kN32_SkColorType, kPremul_SkAlphaType)
 
 #undef CPU_CONFIG
 
@@ -724,7 +754,11 @@ static Target* is_enabled(Benchmark* bench, const Config& config) {
         break;
 #endif
     default:
-        target = new Target(config);
+        if (config.name.equals(kThreadedRasterConfig)) {
+            target = new ThreadedRasterTarget(config);
+        } else {
+            target = new Target(config);
+        }
         break;
     }
 
@@ -760,6 +794,12 @@ static bool valid_brd_bench(sk_sp<SkData> encoded, SkColorType colorType, uint32
     *height = brd->height();
     return true;
 }
+
+static bool supports_row_index(sk_sp<SkData> encoded) {
+    std::unique_ptr<SkCodec> codec = SkCodec::MakeFromData(std::move(encoded));
+    return codec && codec->getEncodedFormat() == SkEncodedImageFormat::kPNG &&
+           codec->buildRowIndex(1 << 30) != nullptr;
+}
 #endif
 
 static void cleanup_run(Target* target) {
@@ -839,6 +879,20 @@ public:
         return SkPicture::MakeFromStream(stream.get());
     }
 
+    // Re-records pic after running the experimental SkRecordOptimize2() passes over its ops.
+    static sk_sp<SkPicture> OptimizePicture(const SkPicture* pic, bool bbh) {
+        SkRecord record;
+        SkRecorder recorder(&record, pic->cullRect());
+        pic->playback(&recorder);
+        SkRecordOptimize2(&record);
+
+        SkRTreeFactory factory;
+        SkPictureRecorder rerecorder;
+        SkRecordDraw(record, rerecorder.beginRecording(pic->cullRect(), bbh ? &factory : nullptr),
+                     nullptr, nullptr, 0, nullptr, nullptr);
+        return rerecorder.finishRecordingAsPicture();
+    }
+
     static std::unique_ptr<MSKPPlayer> ReadMSKP(const char* path) {
         // Not strictly necessary, as it will be checked again later,
         // but helps to avoid a lot of pointless work if we're going to skip it.
@@ -998,8 +1052,26 @@ public:
                 }
             }
 
+            while (FLAGS_optimizeSKPs && fCurrentOptimizedSKP < fSKPs.size()) {
+                const SkString& path = fSKPs[fCurrentOptimizedSKP++];
+                sk_sp<SkPicture> pic = ReadPicture(path.c_str());
+                if (!pic) {
+                    continue;
+                }
+                sk_sp<SkPicture> optimized = OptimizePicture(pic.get(), FLAGS_bbh);
+                SkString name = SkOSPath::Basename(path.c_str());
+                name.append("_optimized");
+                fSourceType = "skp";
+                fBenchType = "optimized_playback";
+                fSKPOps = optimized->approximateOpCount();
+                fSKPUnoptimizedOps = pic->approximateOpCount();
+                return new SKPBench(name.c_str(), optimized.get(), fClip, fScales[fCurrentScale],
+                                    FLAGS_loopSKP);
+            }
+
             fCurrentSKP = 0;
             fCurrentSVG = 0;
+            fCurrentOptimizedSKP = 0;
             fCurrentScale++;
         }
 
@@ -1175,7 +1247,17 @@ public:
                         sk_sp<SkData> encoded(SkData::MakeFromFileName(path.c_str()));
                         const SkColorType colorType = fColorTypes[fCurrentColorType];
                         uint32_t sampleSize = brdSampleSizes[fCurrentSampleSize];
-                        int currentSubsetType = fCurrentSubsetType++;
+                        int currentSubsetType = fCurrentSubsetType;
+
+                        // Bench each subset below the top rows again with a row index, if the
+                        // image supports one.
+                        const bool useRowIndex = fUseBRDRowIndex;
+                        fUseBRDRowIndex = !useRowIndex &&
+                                          kMiddle_SubsetType <= currentSubsetType &&
+                                          supports_row_index(encoded);
+                        if (!fUseBRDRowIndex) {
+                            fCurrentSubsetType++;
+                        }
 
                         int width = 0;
                         int height = 0;
@@ -1217,7 +1299,7 @@ public:
                         }
 
                         return new BitmapRegionDecoderBench(basename.c_str(), encoded.get(),
-                                colorType, sampleSize, subset);
+                                colorType, sampleSize, subset, useRowIndex);
                     }
                     fCurrentSubsetType = 0;
                     fCurrentSampleSize++;
@@ -1249,6 +1331,10 @@ public:
             log.appendMetric("bytes", fSKPBytes);
             log.appendMetric("ops", fSKPOps);
         }
+        if (0 == strcmp(fBenchType, "optimized_playback")) {
+            log.appendMetric("ops", fSKPOps);
+            log.appendMetric("unoptimized_ops", fSKPUnoptimizedOps);
+        }
     }
 
 private:
@@ -1279,7 +1365,7 @@ private:
     SkScalar           fZoomMax;
     double             fZoomPeriodMs;
 
-    double fSKPBytes, fSKPOps;
+    double fSKPBytes, fSKPOps, fSKPUnoptimizedOps;
 
     const char* fSourceType;  // What we're benching: bench, GM, SKP, ...
     const char* fBenchType;   // How we bench it: micro, recording, playback, ...
@@ -1289,12 +1375,14 @@ private:
     int fCurrentScale = 0;
     int fCurrentSKP = 0;
     int fCurrentSVG = 0;
+    int fCurrentOptimizedSKP = 0;
     int fCurrentTextBlobTrace = 0;
     int fCurrentCodec = 0;
     int fCurrentAndroidCodec = 0;
 #ifdef SK_ENABLE_ANDROID_UTILS
     int fCurrentBRDImage = 0;
     int fCurrentSubsetType = 0;
+    bool fUseBRDRowIndex = false;
 #endif
     int fCurrentColorType = 0;
     int fCurrentAlphaType = 0;
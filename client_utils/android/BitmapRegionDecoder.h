@@ -42,6 +42,15 @@ public:
     int width() const;
     int height() const;
 
+    /**
+     *  Uses an index from SkCodec::buildRowIndex(), built from the same encoded data, so that
+     *  regions far from the top of the image are decoded without decoding every row above them.
+     *  Returns false if the index does not match the image.
+     */
+    bool setRowIndex(sk_sp<SkData> index) {
+        return fCodec->codec()->setRowIndex(std::move(index));
+    }
+
     bool getAndroidGainmap(SkGainmapInfo* outInfo,
                            std::unique_ptr<SkStream>* outGainmapImageStream) {
         return fCodec->getAndroidGainmap(outInfo, outGainmapImageStream);
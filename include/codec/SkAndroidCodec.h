@@ -11,8 +11,10 @@
 #include "include/codec/SkCodec.h"
 #include "include/core/SkColorSpace.h"
 #include "include/core/SkImageInfo.h"
+#include "include/core/SkPixmap.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkSize.h"
+#include "include/core/SkSpan.h"
 #include "include/core/SkTypes.h"
 #include "include/private/SkEncodedInfo.h"
 #include "include/private/base/SkNoncopyable.h"
@@ -27,6 +29,7 @@
 #include <memory>
 
 class SkData;
+class SkExecutor;
 class SkPngChunkReader;
 class SkStream;
 struct SkGainmapInfo;
@@ -78,6 +81,35 @@ public:
      */
     static std::unique_ptr<SkAndroidCodec> MakeFromData(sk_sp<SkData>, SkPngChunkReader* = nullptr);
 
+    /**
+     *  One entry of a DecodeBatch() call.
+     */
+    struct BatchDecodeRequest {
+        sk_sp<SkData>   fData;
+
+        /**
+         *  Caller-owned destination. Its dimensions must match
+         *  getSampledDimensions(fSampleSize) for the encoded image.
+         */
+        SkPixmap        fDst;
+        int             fSampleSize = 1;
+
+        /**
+         *  Set by DecodeBatch(). kInvalidInput if fData could not be decoded.
+         */
+        SkCodec::Result fResult = SkCodec::kUnimplemented;
+    };
+
+    /**
+     *  Decode each request into its fDst, spreading the work across |executor|
+     *  with at most one task per core. If |executor| is null,
+     *  SkExecutor::GetDefault() is used. Returns once
+     *  every request has finished; check each fResult for the outcome.
+     *
+     *  The requests must not share destination pixels.
+     */
+    static void DecodeBatch(SkSpan<BatchDecodeRequest>, SkExecutor* executor = nullptr);
+
     virtual ~SkAndroidCodec();
 
     // TODO: fInfo is now just a cache of SkCodec's SkImageInfo. No need to
@@ -261,6 +293,22 @@ public:
         return this->getAndroidPixels(info, pixels, rowBytes);
     }
 
+    /**
+     *  Decode |subset| of the image (or all of it, if |subset| is null), resized to the
+     *  dimensions of |info| with a high quality filter. Unlike getAndroidPixels(), any
+     *  output size is supported, and the aspect ratio need not be preserved.
+     *
+     *  The codec scales as far as it can natively without going below the output size
+     *  (for JPEG, in the DCT domain), skips the rows and columns outside |subset| where it
+     *  can, and filters the remaining rows as they are decoded, so that the full size image
+     *  is never held in memory.
+     *
+     *  Supports 8888 and 8-bit single channel color types. If the image is not opaque,
+     *  |info| must not be unpremul.
+     */
+    SkCodec::Result getResizedPixels(const SkImageInfo& info, void* pixels, size_t rowBytes,
+                                     const SkIRect* subset = nullptr);
+
     SkCodec* codec() const { return fCodec.get(); }
 
     /**
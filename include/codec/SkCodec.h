@@ -27,6 +27,7 @@
 
 class SkAndroidCodec;
 class SkData;
+class SkExecutor;
 class SkFrameHolder;
 class SkImage;
 class SkPngChunkReader;
@@ -298,6 +299,7 @@ public:
             , fSubset(nullptr)
             , fFrameIndex(0)
             , fPriorFrame(kNoFrame)
+            , fExecutor(nullptr)
         {}
 
         ZeroInitialized            fZeroInitialized;
@@ -341,6 +343,16 @@ public:
          *  If set to kNoFrame, the codec will decode any necessary required frame(s) first.
          */
         int                        fPriorFrame;
+
+        /**
+         *  If not NULL, a codec that can split the decode into independent parts
+         *  may decode them in parallel on this executor. getPixels() still
+         *  returns only once the whole image has been decoded.
+         *
+         *  Currently only used for full-size JPEG decodes of images containing
+         *  restart markers.
+         */
+        SkExecutor*                fExecutor;
     };
 
     /**
@@ -475,6 +487,30 @@ public:
         return this->onIncrementalDecode(rowsDecoded);
     }
 
+    /**
+     *  Builds an index that lets later incremental decodes of a subset start near the subset's
+     *  top row, rather than decoding every row above it. This decodes the whole image once.
+     *
+     *  The index has a checkpoint roughly every rowInterval rows. It may be stored, and passed
+     *  to setRowIndex() on any codec for the same encoded data.
+     *
+     *  Currently only supported for non-interlaced PNGs. Returns nullptr otherwise, or if the
+     *  image is invalid or incomplete.
+     */
+    sk_sp<SkData> buildRowIndex(int rowInterval = 256);
+
+    /**
+     *  Uses an index from buildRowIndex() for subsequent incremental decodes of a subset.
+     *  Passing nullptr stops using one.
+     *
+     *  This reads the image data once, to check that it is what the index was built from, so
+     *  any scanline or incremental decode in progress must be started again.
+     *
+     *  Returns false, and keeps the previous index, if the index is not for this image, or the
+     *  image data is incomplete or has been modified since.
+     */
+    bool setRowIndex(sk_sp<SkData> index);
+
     /**
      * The remaining functions revolve around decoding scanlines.
      */
@@ -969,6 +1005,8 @@ private:
         return kUnimplemented;
     }
 
+    virtual sk_sp<SkData> onBuildRowIndex(int rowInterval);
+    virtual bool onSetRowIndex(sk_sp<SkData>);
 
     virtual bool onSkipScanlines(int /*countLines*/) { return false; }
 
@@ -13,6 +13,7 @@
 #include <memory>
 
 class SkData;
+class SkExecutor;
 class SkImageGenerator;
 class SkOpenTypeSVGDecoder;
 class SkTraceMemoryDump;
@@ -103,6 +104,22 @@ public:
     static size_t GetResourceCacheSingleAllocationByteLimit();
     static size_t SetResourceCacheSingleAllocationByteLimit(size_t newLimit);
 
+    /**
+     *  How the resource cache chooses entries to purge when it is over its limit.
+     *
+     *  kLRU purges the least recently used entries. kTinyLFU (W-TinyLFU) keeps entries that are
+     *  used often, so that drawing many images once (e.g. scrolling through a gallery) does not
+     *  purge the blur masks and mipmaps that are used on every frame.
+     *
+     *  The default is kLRU. SetResourceCachePolicy() returns the previous policy.
+     */
+    enum class ResourceCachePolicy {
+        kLRU,
+        kTinyLFU,
+    };
+    static ResourceCachePolicy GetResourceCachePolicy();
+    static ResourceCachePolicy SetResourceCachePolicy(ResourceCachePolicy);
+
     /**
      *  Dumps memory usage of caches using the SkTraceMemoryDump interface. See SkTraceMemoryDump
      *  for usage of this method.
@@ -156,6 +173,26 @@ public:
      *  Call early in main() to allow Skia to use a JIT to accelerate CPU-bound operations.
      */
     static void AllowJIT();
+
+    /**
+     *  Set an executor that the CPU backend may use to split large rasterization work into
+     *  horizontal bands that run concurrently: scan converting very large anti-aliased path fills,
+     *  and blurring large masks for blur mask filters. The resulting pixels are identical to doing
+     *  the work on the calling thread. The executor must outlive any drawing that might use it.
+     *  Pass nullptr (the default) to do all of it on the calling thread.
+     *  Returns the previous executor.
+     */
+    static SkExecutor* SetRasterPathExecutor(SkExecutor*);
+
+    /**
+     *  Set a directory in which the CPU backend saves the blitter programs it compiles (and their
+     *  JIT code, where supported), so that later processes can load them instead of compiling them
+     *  again. Entries written by another Skia milestone or for another kind of CPU are ignored,
+     *  but builds within a milestone are not told apart: use one directory per build of Skia.
+     *  JIT code is loaded and run as is, so the directory must only be writable by trusted
+     *  processes. Pass nullptr (the default) to disable.
+     */
+    static void SetProgramCacheDirectory(const char* path);
 };
 
 class SkAutoGraphics {
@@ -65,6 +65,11 @@ public:
         may be used to provide user context to procs->fPictureProc; procs->fPictureProc
         is called with a pointer to data, data byte length, and user context.
 
+        If procs->fShareData is true, encoded images are not copied out of data: they
+        reference it, and are decoded lazily. So data may be kept alive by the returned
+        SkPicture, and data from SkData::MakeFromFileName() lets large files be loaded
+        without reading them in.
+
         @param data   container for serial data
         @param procs  custom serial data decoders; may be nullptr
         @return       SkPicture constructed from data
@@ -243,9 +248,11 @@ private:
 
     void serialize(SkWStream*, const SkSerialProcs*, class SkRefCntSet* typefaces,
         bool textBlobsOnly=false) const;
+    // If streamData is not null, the stream reads from it, and may share its bytes.
     static sk_sp<SkPicture> MakeFromStreamPriv(SkStream*, const SkDeserialProcs*,
                                                class SkTypefacePlayback*,
-                                               int recursionLimit);
+                                               int recursionLimit,
+                                               const SkData* streamData = nullptr);
     friend class SkPictureData;
 
     /** Return true if the SkStream/Buffer represents a serialized picture, and
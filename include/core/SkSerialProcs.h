@@ -67,6 +67,10 @@ struct SK_API SkDeserialProcs {
 
     SkDeserialTypefaceProc  fTypefaceProc = nullptr;
     void*                   fTypefaceCtx = nullptr;
+
+    // If true, SkPicture::MakeFromData() lets the picture reference the data, rather than copy
+    // encoded images (and aligned op data) out of it. The data is then kept alive by the picture.
+    bool                    fShareData = false;
 };
 
 #endif
@@ -57,6 +57,7 @@ class SkCanvas;
 class SkCapabilities;
 class SkColorSpace;
 class SkDeferredDisplayList;
+class SkExecutor;
 class SkPaint;
 class SkSurfaceCharacterization;
 enum SkColorType : int;
@@ -207,6 +208,30 @@ public:
     static sk_sp<SkSurface> MakeRasterN32Premul(int width, int height,
                                                 const SkSurfaceProps* surfaceProps = nullptr);
 
+    /** Allocates raster SkSurface whose SkCanvas records draws instead of rasterizing them
+        immediately. Recorded draws are rasterized when the surface contents are needed
+        (makeImageSnapshot(), readPixels(), peekPixels(), writePixels() or draw()), by splitting
+        the surface into tiles and replaying the draws that touch each tile on executor.
+        Draws that read back the surface (backdrop filters, layers saved with
+        SkCanvas::kInitWithPrevious_SaveLayerFlag) make that flush run on one thread instead.
+
+        The pixels produced are identical to those of a surface made with MakeRaster().
+        Allocates and zeroes pixel memory, which is deleted when SkSurface is deleted.
+
+        SkCanvas::peekPixels() and SkCanvas::readPixels() on the returned canvas fail; use the
+        SkSurface methods instead.
+
+        @param imageInfo  width, height, SkColorType, SkAlphaType, SkColorSpace,
+                          of raster surface; width and height must be greater than zero
+        @param executor   runs tile playback; must outlive the SkSurface
+        @param props      LCD striping orientation and setting for device independent fonts;
+                          may be nullptr
+        @return           SkSurface if all parameters are valid; otherwise, nullptr
+    */
+    static sk_sp<SkSurface> MakeRasterThreaded(const SkImageInfo& imageInfo,
+                                               SkExecutor* executor,
+                                               const SkSurfaceProps* props = nullptr);
+
     /** Caller data passed to RenderTarget/TextureReleaseProc; may be nullptr. */
     typedef void* ReleaseContext;
 
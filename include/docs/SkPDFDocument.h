@@ -134,15 +134,26 @@ struct Metadata {
     /** Executor to handle threaded work within PDF Backend. If this is nullptr,
         then all work will be done serially on the main thread. To have worker
         threads assist with various tasks, set this to a valid SkExecutor
-        instance. Currently used for executing Deflate algorithm in parallel.
+        instance. Currently used for compressing page contents and images and
+        for subsetting fonts in parallel.
 
-        If set, the PDF output will be non-reproducible in the order and
-        internal numbering of objects, but should render the same.
+        The PDF output is the same whether or not this is set, and no matter
+        how many threads the executor uses.
 
         Experimental.
     */
     SkExecutor* fExecutor = nullptr;
 
+    /** If true, each page is written to the stream as soon as it ends, rather
+        than held until the document is closed, so memory use no longer grows
+        with the number of pages.  Images and form XObjects are always written
+        as soon as they are first used.  The page tree may then have one more
+        "Pages" node than it would otherwise.
+
+        Experimental.
+    */
+    bool fStreamPages = false;
+
     /** PDF streams may be compressed to save space.
         Use this to specify the desired compression vs time tradeoff.
     */
@@ -128,6 +128,24 @@ public:
         return Blur(sigmaX, sigmaY, SkTileMode::kDecal, std::move(input), cropRect);
     }
 
+    /**
+     *  How closely the CPU backend follows a true Gaussian for large blurs. kFast blurs sigmas of
+     *  16 and up at a lower resolution, and scales the result back up. Each channel of its result
+     *  is within kFastBlurMaxError of kExact's. GPU backends ignore this hint.
+     */
+    enum class BlurQuality {
+        kExact,
+        kFast,
+
+        kLast = kFast
+    };
+    static constexpr int kFastBlurMaxError = 8;
+
+    // Like the first Blur(), but large blurs may be computed at a lower resolution on the CPU.
+    static sk_sp<SkImageFilter> Blur(SkScalar sigmaX, SkScalar sigmaY, SkTileMode tileMode,
+                                     BlurQuality quality, sk_sp<SkImageFilter> input,
+                                     const CropRect& cropRect = {});
+
     /**
      *  Create a filter that applies the color filter to the input filter results.
      *  @param cf       The color filter that transforms the input image.
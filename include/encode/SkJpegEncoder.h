@@ -11,11 +11,14 @@
 #include "include/encode/SkEncoder.h"
 #include "include/private/base/SkAPI.h"
 
+#include <functional>
 #include <memory>
 
 class SkColorSpace;
 class SkData;
+class SkExecutor;
 class SkJpegEncoderMgr;
+struct SkImageInfo;
 class SkPixmap;
 class SkWStream;
 class SkYUVAPixmaps;
@@ -85,6 +88,14 @@ public:
          */
         const skcms_ICCProfile* fICCProfile = nullptr;
         const char* fICCProfileDescription = nullptr;
+
+        /**
+         *  If not null, encoding all of the rows of an SkPixmap at once (as Encode() does) will
+         *  encode strips of rows in parallel on this executor, and join them with restart
+         *  markers.  The output decodes to the same pixels as a serial encode, but uses the
+         *  standard Huffman tables (see the RowProc variants below), so is somewhat larger.
+         */
+        SkExecutor* fExecutor = nullptr;
     };
 
     /**
@@ -114,6 +125,38 @@ public:
                                            const SkColorSpace* srcColorSpace,
                                            const Options& options);
 
+    /**
+     *  Fills |rows|, which holds the |rows.height()| rows of the image starting at |firstRow|.
+     *  Returning false fails the encode.
+     */
+    using RowProc = std::function<bool(int firstRow, const SkPixmap& rows)>;
+
+    /**
+     *  Encode an image described by |srcInfo| without holding all of its pixels. The encoder
+     *  owns a buffer of |stripHeight| rows, which it asks |rowProc| to fill, in order from the
+     *  top, as rows are needed. Compressed data is written to |dst| as it is produced, so memory
+     *  use does not grow with the height of the image (e.g. an SkPicture can be played back strip
+     *  by strip into a JPEG far larger than would fit in memory as a bitmap).
+     *
+     *  Computing optimal Huffman tables would mean buffering the whole image, so these use the
+     *  standard tables instead. This makes the output a few percent larger at typical qualities,
+     *  and up to ~15% larger at quality 100. |stripHeight| is best a multiple of 16, the height
+     *  of a row of MCUs.
+     *
+     *  Returns false (or nullptr) on an invalid or unsupported |srcInfo|, a |stripHeight| less
+     *  than one, or if the strip buffer cannot be allocated.
+     */
+    static bool Encode(SkWStream* dst,
+                       const SkImageInfo& srcInfo,
+                       int stripHeight,
+                       const RowProc& rowProc,
+                       const Options& options);
+    static std::unique_ptr<SkEncoder> Make(SkWStream* dst,
+                                           const SkImageInfo& srcInfo,
+                                           int stripHeight,
+                                           RowProc rowProc,
+                                           const Options& options);
+
     ~SkJpegEncoder() override;
 
 protected:
@@ -127,7 +170,9 @@ private:
                                            const SkPixmap* src,
                                            const SkYUVAPixmaps* srcYUVA,
                                            const SkColorSpace* srcYUVAColorSpace,
-                                           const Options& options);
+                                           const Options& options,
+                                           RowProc rowProc = nullptr,
+                                           int stripHeight = 0);
 
     std::unique_ptr<SkJpegEncoderMgr> fEncoderMgr;
     const SkYUVAPixmaps* fSrcYUVA = nullptr;
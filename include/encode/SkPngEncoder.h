@@ -15,6 +15,7 @@
 
 #include <memory>
 
+class SkExecutor;
 class SkPixmap;
 class SkPngEncoderMgr;
 class SkWStream;
@@ -75,6 +76,14 @@ public:
          */
         const skcms_ICCProfile* fICCProfile = nullptr;
         const char* fICCProfileDescription = nullptr;
+
+        /**
+         *  If not null, encoding all of the rows at once (as Encode() does) will filter and
+         *  deflate bands of rows in parallel on this executor, and stitch the results into a
+         *  single zlib stream.  The output is a valid png, but not byte-for-byte identical to
+         *  a serial encode, and is typically slightly larger.
+         */
+        SkExecutor* fExecutor = nullptr;
     };
 
     /**
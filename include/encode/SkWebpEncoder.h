@@ -48,6 +48,20 @@ namespace SkWebpEncoder {
          */
         const skcms_ICCProfile* fICCProfile = nullptr;
         const char* fICCProfileDescription = nullptr;
+
+        /**
+         *  libwebp's |method|, which must be in [0, 6].  Lower methods encode faster into larger
+         *  files.  If negative, the method is chosen based on |fCompression|.
+         */
+        int fMethod = -1;
+
+        /**
+         *  If true, libwebp may use a second thread (its |thread_level|).  Lossy encodes
+         *  analyze the image and compress its alpha plane in parallel with the rest of the
+         *  encode.  Lossless encodes that try several strategies (at high |fQuality| or
+         *  |fMethod|) try two of them at once.
+         */
+        bool fMultithreaded = false;
     };
 
     /**
@@ -13,15 +13,22 @@
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkSize.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <vector>
 
+class SkAnimCodecFrameCache;
 class SkImage;
 
 class SkAnimCodecPlayer {
 public:
-    SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec);
+    /**
+     *  Frames of an animated codec are decoded on demand. Up to frameCacheBytes of them are kept
+     *  as keyframes, spread evenly through the animation, and a frame that is seek()ed to is
+     *  decoded forward from the nearest one. By default, every decoded frame is kept.
+     */
+    SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec, size_t frameCacheBytes = SIZE_MAX);
     ~SkAnimCodecPlayer();
 
     /**
@@ -53,12 +60,14 @@ public:
 
 
 private:
-    std::unique_ptr<SkCodec>        fCodec;
-    SkImageInfo                     fImageInfo;
-    std::vector<SkCodec::FrameInfo> fFrameInfos;
-    std::vector<sk_sp<SkImage> >    fImages;
-    int                             fCurrIndex = 0;
-    uint32_t                        fTotalDuration;
+    std::unique_ptr<SkCodec>               fCodec;
+    SkImageInfo                            fImageInfo;
+    std::vector<SkCodec::FrameInfo>        fFrameInfos;
+    std::unique_ptr<SkAnimCodecFrameCache> fFrameCache;
+    sk_sp<SkImage>                         fImage;       // The static image, or fImageIndex.
+    int                                    fImageIndex = -1;
+    int                                    fCurrIndex = 0;
+    uint32_t                               fTotalDuration;
 
     sk_sp<SkImage> getFrameAt(int index);
 };
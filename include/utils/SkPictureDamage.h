@@ -0,0 +1,51 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPictureDamage_DEFINED
+#define SkPictureDamage_DEFINED
+
+#include "include/core/SkMatrix.h"
+#include "include/core/SkRegion.h"
+#include "include/core/SkTypes.h"
+
+class SkCanvas;
+class SkPicture;
+
+/**
+ *  Helpers for redrawing only the parts of a surface that change between two versions of a
+ *  picture, e.g. successive frames of a dashboard that is re-recorded every frame.
+ *
+ *      SkRegion damage = SkPictureDamage::Compute(prevFrame.get(), frame.get());
+ *      SkPictureDamage::Redraw(surface->getCanvas(), frame.get(), damage);
+ *
+ *  Redraw() only skips the ops outside of the damage if the picture was recorded with an
+ *  SkBBHFactory.
+ */
+class SK_API SkPictureDamage {
+public:
+    /**
+     *  Returns the device pixels that may differ between drawing prev and drawing next, both with
+     *  matrix, onto a cleared surface. The ops of the two pictures are compared one by one;
+     *  ops that are not identical (or that draw somewhere else) damage their bounds in both.
+     *
+     *  Images, text blobs, pictures and other ref-counted objects are compared by identity, so
+     *  reusing them from frame to frame keeps the damage small. Either picture may be null,
+     *  which damages everything the other one draws.
+     */
+    static SkRegion Compute(const SkPicture* prev, const SkPicture* next,
+                            const SkMatrix& matrix = SkMatrix::I());
+
+    /**
+     *  Clears damage (in device space) to transparent and draws picture with matrix, clipped to
+     *  damage. If canvas held the result of drawing the picture that damage was computed
+     *  against, it then holds the result of drawing picture.
+     */
+    static void Redraw(SkCanvas* canvas, const SkPicture* picture, const SkRegion& damage,
+                       const SkMatrix& matrix = SkMatrix::I());
+};
+
+#endif
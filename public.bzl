@@ -219,6 +219,7 @@ SKIA_PUBLIC_HDRS = [
     "include/utils/SkPaintFilterCanvas.h",
     "include/utils/SkParse.h",
     "include/utils/SkParsePath.h",
+    "include/utils/SkPictureDamage.h",
     "include/utils/SkShadowUtils.h",
     "include/utils/SkTextUtils.h",
     "include/utils/SkTraceEventPhase.h",
@@ -1245,10 +1246,12 @@ BASE_SRCS_ALL = [
     "src/image/SkSurface_Gpu.cpp",
     "src/image/SkSurface_Gpu.h",
     "src/image/SkSurface_Raster.cpp",
+    "src/image/SkSurface_ThreadedRaster.cpp",
     "src/opts/SkBitmapProcState_opts.h",
     "src/opts/SkBlitMask_opts.h",
     "src/opts/SkBlitRow_opts.h",
     "src/opts/SkChecksum_opts.h",
+    "src/opts/SkPngFilter_opts.h",
     "src/opts/SkRasterPipeline_opts.h",
     "src/opts/SkSwizzler_opts.h",
     "src/opts/SkUtils_opts.h",
@@ -1645,6 +1648,8 @@ BASE_SRCS_ALL = [
     "src/text/gpu/TextBlobRedrawCoordinator.h",
     "src/text/StrikeForGPU.cpp",
     "src/text/StrikeForGPU.h",
+    "src/utils/SkAnimCodecFrameCache.cpp",
+    "src/utils/SkAnimCodecFrameCache.h",
     "src/utils/SkAnimCodecPlayer.cpp",
     "src/utils/SkBase64.cpp",
     "src/utils/SkBitSet.h",
@@ -1687,6 +1692,7 @@ BASE_SRCS_ALL = [
     "src/utils/SkParsePath.cpp",
     "src/utils/SkPatchUtils.cpp",
     "src/utils/SkPatchUtils.h",
+    "src/utils/SkPictureDamage.cpp",
     "src/utils/SkPolyUtils.cpp",
     "src/utils/SkPolyUtils.h",
     "src/utils/SkShaderUtils.cpp",
@@ -9,17 +9,23 @@
 
 #include "include/codec/SkCodec.h"
 #include "include/core/SkAlphaType.h"
+#include "include/core/SkBitmap.h"
 #include "include/core/SkColor.h"
 #include "include/core/SkColorType.h"
 #include "include/core/SkData.h"
 #include "include/core/SkEncodedImageFormat.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkRect.h"
 #include "include/core/SkStream.h"
 #include "include/private/SkGainmapInfo.h"
 #include "include/private/base/SkFloatingPoint.h"
+#include "include/private/base/SkTemplates.h"
 #include "modules/skcms/skcms.h"
+#include "src/base/SkAutoMalloc.h"
 #include "src/codec/SkCodecPriv.h"
 #include "src/codec/SkSampledCodec.h"
+#include "src/codec/SkStreamingResizer.h"
+#include "src/core/SkTaskGroup.h"
 
 #if defined(SK_CODEC_DECODES_WEBP) || defined(SK_CODEC_DECODES_RAW) || \
         defined(SK_HAS_WUFFS_LIBRARY) || defined(SK_CODEC_DECODES_AVIF)
@@ -27,7 +33,10 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <thread>
 #include <utility>
 
 class SkPngChunkReader;
@@ -538,6 +547,181 @@ SkCodec::Result SkAndroidCodec::getAndroidPixels(const SkImageInfo& info, void*
     return this->getAndroidPixels(info, pixels, rowBytes, nullptr);
 }
 
+SkCodec::Result SkAndroidCodec::getResizedPixels(const SkImageInfo& info, void* pixels,
+                                                 size_t rowBytes, const SkIRect* subset) {
+    if (!pixels || info.isEmpty() || rowBytes < info.minRowBytes()) {
+        return SkCodec::kInvalidParameters;
+    }
+    const SkISize dims = fCodec->dimensions();
+    const SkIRect srcSubset = subset ? *subset : SkIRect::MakeSize(dims);
+    if (!is_valid_subset(srcSubset, dims)) {
+        return SkCodec::kInvalidParameters;
+    }
+
+    int channels;
+    switch (info.colorType()) {
+        case kRGBA_8888_SkColorType:
+        case kBGRA_8888_SkColorType:
+            channels = 4;
+            break;
+        case kGray_8_SkColorType:
+        case kAlpha_8_SkColorType:
+            channels = 1;
+            break;
+        default:
+            return SkCodec::kInvalidConversion;
+    }
+    // Filtering unpremultiplied pixels would bleed the color of transparent ones.
+    const bool opaque = fCodec->getInfo().isOpaque();
+    if (info.alphaType() == kUnpremul_SkAlphaType && !opaque) {
+        return SkCodec::kInvalidConversion;
+    }
+
+    // Let the codec do as much of the downscale as it can natively, e.g. in the DCT domain for
+    // JPEG, without leaving fewer pixels in the subset than the output has.
+    auto covers = [&](SkISize native) {
+        return (int64_t)srcSubset.width() * native.width() >=
+                       (int64_t)info.width() * dims.width() &&
+               (int64_t)srcSubset.height() * native.height() >=
+                       (int64_t)info.height() * dims.height();
+    };
+    SkISize nativeDims = dims;
+    for (int num = 1; num < 8; ++num) {
+        const SkISize scaled = fCodec->getScaledDimensions(num / 8.0f);
+        if (!scaled.isEmpty() && covers(scaled)) {
+            nativeDims = scaled;
+            break;
+        }
+    }
+    // Scaled in double, so that edges landing on native pixels, e.g. of the whole image, are exact.
+    auto scale = [](int x, int native, int full) {
+        return (float)std::min((double)x * native / full, (double)native);
+    };
+    const SkRect srcRect = SkRect::MakeLTRB(
+            scale(srcSubset.left(), nativeDims.width(), dims.width()),
+            scale(srcSubset.top(), nativeDims.height(), dims.height()),
+            scale(srcSubset.right(), nativeDims.width(), dims.width()),
+            scale(srcSubset.bottom(), nativeDims.height(), dims.height()));
+
+    SkStreamingResizer resizer(nativeDims, srcRect, info.dimensions(), channels,
+                               channels == 4 && !opaque);
+    const SkIRect& srcBounds = resizer.srcBounds();
+    const SkImageInfo decodeInfo = info.makeDimensions(nativeDims);
+    const size_t bpp = info.bytesPerPixel();
+    // When the native scale alone produces the output, copy decoded rows instead of filtering.
+    auto emitRow = [&](int y, const uint8_t* row) {
+        if (resizer.isIdentity()) {
+            memcpy(SkTAddOffset<void>(pixels, y * rowBytes), row, info.minRowBytes());
+        } else {
+            resizer.addRow(row);
+        }
+    };
+    auto finishRow = [&](int y) {
+        if (!resizer.isIdentity()) {
+            resizer.writeRow(y, SkTAddOffset<uint8_t>(pixels, y * rowBytes));
+        }
+    };
+
+    // Only decode the columns the filter reads, where the codec can crop rows.
+    const SkIRect columns = SkIRect::MakeLTRB(srcBounds.left(), 0, srcBounds.right(),
+                                              nativeDims.height());
+    // Like getAndroidPixels(), rewind and set up the color xform here rather than in fCodec.
+    auto startDecode = [&](const SkIRect* crop) {
+        SkCodec::Options options;
+        options.fSubset = crop;
+        SkCodec::Result result = fCodec->handleFrameIndex(decodeInfo, nullptr, 0, options, this);
+        return result == SkCodec::kSuccess ? fCodec->startScanlineDecode(decodeInfo, &options)
+                                           : result;
+    };
+    SkCodec::Result result = SkCodec::kUnimplemented;
+    if (columns.width() != nativeDims.width()) {
+        result = startDecode(&columns);
+    }
+    int rowOffset = 0;
+    if (result == SkCodec::kUnimplemented) {
+        result = startDecode(nullptr);
+        rowOffset = srcBounds.left() * bpp;
+    }
+
+    SkCodec::Result decodeResult = SkCodec::kSuccess;
+    if (result == SkCodec::kSuccess &&
+        fCodec->getScanlineOrder() == SkCodec::kTopDown_SkScanlineOrder) {
+        // Skip the rows above the filter, which for JPEG avoids most of their decoding, and stop
+        // decoding after the last row it reads.
+        if (!fCodec->skipScanlines(srcBounds.top())) {
+            decodeResult = SkCodec::kIncompleteInput;
+        }
+        const size_t decodeRowBytes = decodeInfo.minRowBytes();
+        SkAutoMalloc row(decodeRowBytes);
+        int rowsRead = 0;
+        for (int y = 0; y < info.height(); ++y) {
+            for (; rowsRead < resizer.rowsNeeded(y); ++rowsRead) {
+                // An incomplete decode fills the missing rows, so keep filtering.
+                if (1 != fCodec->getScanlines(row.get(), 1, decodeRowBytes)) {
+                    decodeResult = SkCodec::kIncompleteInput;
+                }
+                emitRow(rowsRead, SkTAddOffset<const uint8_t>(row.get(), rowOffset));
+            }
+            finishRow(y);
+        }
+        return decodeResult;
+    }
+    if (result != SkCodec::kSuccess && result != SkCodec::kUnimplemented) {
+        return result;
+    }
+
+    // Without a top-down scanline decoder, decode the natively scaled image first.
+    SkBitmap decoded;
+    if (!decoded.tryAllocPixels(decodeInfo)) {
+        return SkCodec::kInternalError;
+    }
+    decodeResult = fCodec->handleFrameIndex(decodeInfo, nullptr, 0, SkCodec::Options(), this);
+    if (decodeResult == SkCodec::kSuccess) {
+        decodeResult = fCodec->getPixels(decoded.pixmap());
+    }
+    if (decodeResult != SkCodec::kSuccess && decodeResult != SkCodec::kIncompleteInput &&
+        decodeResult != SkCodec::kErrorInInput) {
+        return decodeResult;
+    }
+    int rowsRead = 0;
+    for (int y = 0; y < info.height(); ++y) {
+        for (; rowsRead < resizer.rowsNeeded(y); ++rowsRead) {
+            emitRow(rowsRead, static_cast<const uint8_t*>(
+                    decoded.getAddr(srcBounds.left(), srcBounds.top() + rowsRead)));
+        }
+        finishRow(y);
+    }
+    return decodeResult;
+}
+
+void SkAndroidCodec::DecodeBatch(SkSpan<BatchDecodeRequest> requests, SkExecutor* executor) {
+    auto decode = [](BatchDecodeRequest& req) {
+        auto codec = SkAndroidCodec::MakeFromData(req.fData);
+        if (!codec) {
+            req.fResult = SkCodec::kInvalidInput;
+            return;
+        }
+        AndroidOptions options;
+        options.fSampleSize = req.fSampleSize;
+        req.fResult = codec->getAndroidPixels(req.fDst.info(), req.fDst.writable_addr(),
+                                              req.fDst.rowBytes(), &options);
+    };
+
+    // A fixed set of workers, no more than there are cores, pulls requests off a shared counter
+    // rather than queueing a task per image.  A few large images can't leave the other threads
+    // idle while a long tail of small ones waits, and a large batch doesn't flood the executor.
+    const int count = SkToInt(requests.size());
+    const int workers = std::min(count, std::max(1, (int)std::thread::hardware_concurrency()));
+    std::atomic<int> next{0};
+    SkTaskGroup tg(executor ? *executor : SkExecutor::GetDefault());
+    tg.batch(workers, [&](int) {
+        for (int i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+            decode(requests[i]);
+        }
+    });
+    tg.wait();
+}
+
 bool SkAndroidCodec::getAndroidGainmap(SkGainmapInfo* info,
                                        std::unique_ptr<SkStream>* outGainmapImageStream) {
     if (!fCodec->onGetGainmapInfo(info, outGainmapImageStream)) {
@@ -14,6 +14,8 @@
 #include "include/core/SkSize.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkTypes.h"
+#include "include/core/SkYUVAInfo.h"
+#include "include/core/SkYUVAPixmaps.h"
 #include "modules/skcms/skcms.h"
 #include "src/core/SkStreamPriv.h"
 
@@ -237,3 +239,131 @@ SkCodec::Result SkAvifCodec::onGetPixels(const SkImageInfo& dstInfo,
     *rowsDecoded = fAvifDecoder->image->height;
     return kSuccess;
 }
+
+static bool avif_yuv_color_space(const avifImage* image, SkYUVColorSpace* colorSpace) {
+    const bool fullRange = image->yuvRange == AVIF_RANGE_FULL;
+    switch (image->matrixCoefficients) {
+        case AVIF_MATRIX_COEFFICIENTS_BT709:
+            *colorSpace = fullRange ? kRec709_Full_SkYUVColorSpace
+                                    : kRec709_Limited_SkYUVColorSpace;
+            return true;
+        case AVIF_MATRIX_COEFFICIENTS_UNSPECIFIED:
+            // libavif converts these with the BT.601 coefficients.
+        case AVIF_MATRIX_COEFFICIENTS_BT470BG:
+        case AVIF_MATRIX_COEFFICIENTS_BT601:
+            *colorSpace = fullRange ? kJPEG_Full_SkYUVColorSpace
+                                    : kRec601_Limited_SkYUVColorSpace;
+            return true;
+        case AVIF_MATRIX_COEFFICIENTS_BT2020_NCL:
+            switch (image->depth) {
+                case 8:
+                    *colorSpace = fullRange ? kBT2020_8bit_Full_SkYUVColorSpace
+                                            : kBT2020_8bit_Limited_SkYUVColorSpace;
+                    return true;
+                case 10:
+                    *colorSpace = fullRange ? kBT2020_10bit_Full_SkYUVColorSpace
+                                            : kBT2020_10bit_Limited_SkYUVColorSpace;
+                    return true;
+                case 12:
+                    *colorSpace = fullRange ? kBT2020_12bit_Full_SkYUVColorSpace
+                                            : kBT2020_12bit_Limited_SkYUVColorSpace;
+                    return true;
+                default:
+                    return false;
+            }
+        default:
+            // This includes AVIF_MATRIX_COEFFICIENTS_IDENTITY, whose planes are G, B and R rather
+            // than the R, G and B of kIdentity_SkYUVColorSpace.
+            return false;
+    }
+}
+
+bool SkAvifCodec::onQueryYUVAInfo(const SkYUVAPixmapInfo::SupportedDataTypes& supportedDataTypes,
+                                  SkYUVAPixmapInfo* yuvaPixmapInfo) const {
+    // avifDecoderParse() has already filled in the image's format, without decoding its planes.
+    const avifImage* image = fAvifDecoder->image;
+    SkYUVAInfo::Subsampling subsampling;
+    switch (image->yuvFormat) {
+        case AVIF_PIXEL_FORMAT_YUV444:
+            subsampling = SkYUVAInfo::Subsampling::k444;
+            break;
+        case AVIF_PIXEL_FORMAT_YUV422:
+            subsampling = SkYUVAInfo::Subsampling::k422;
+            break;
+        case AVIF_PIXEL_FORMAT_YUV420:
+            subsampling = SkYUVAInfo::Subsampling::k420;
+            break;
+        default:
+            return false;
+    }
+
+    SkYUVColorSpace colorSpace;
+    if (!avif_yuv_color_space(image, &colorSpace)) {
+        return false;
+    }
+
+    // Premultiplied alpha cannot be described by SkYUVAInfo.
+    const bool hasAlpha = fAvifDecoder->alphaPresent == AVIF_TRUE;
+    if (hasAlpha && image->alphaPremultiplied) {
+        return false;
+    }
+    const auto planeConfig = hasAlpha ? SkYUVAInfo::PlaneConfig::kY_U_V_A
+                                      : SkYUVAInfo::PlaneConfig::kY_U_V;
+    const auto dataType = image->depth > 8 ? SkYUVAPixmapInfo::DataType::kUnorm16
+                                           : SkYUVAPixmapInfo::DataType::kUnorm8;
+    if (!supportedDataTypes.supported(planeConfig, dataType)) {
+        return false;
+    }
+    if (yuvaPixmapInfo) {
+        SkYUVAInfo yuvaInfo(this->dimensions(),
+                            planeConfig,
+                            subsampling,
+                            colorSpace,
+                            this->getOrigin(),
+                            SkYUVAInfo::Siting::kCentered,
+                            SkYUVAInfo::Siting::kCentered);
+        *yuvaPixmapInfo = SkYUVAPixmapInfo(yuvaInfo, dataType, nullptr);
+    }
+    return true;
+}
+
+SkCodec::Result SkAvifCodec::onGetYUVAPlanes(const SkYUVAPixmaps& yuvaPixmaps) {
+    SkYUVAPixmapInfo info;
+    if (!this->onQueryYUVAInfo(SkYUVAPixmapInfo::SupportedDataTypes::All(), &info) ||
+        info.yuvaInfo() != yuvaPixmaps.yuvaInfo() || info.dataType() != yuvaPixmaps.dataType()) {
+        return kInvalidInput;
+    }
+
+    avifResult result = avifDecoderNthImage(fAvifDecoder.get(), 0);
+    if (result != AVIF_RESULT_OK) {
+        return kInvalidInput;
+    }
+
+    // The decoder owns the decoded planes, so copy them out. Unlike onGetPixels, this skips the
+    // conversion to RGB.
+    const avifImage* image = fAvifDecoder->image;
+    const uint32_t depth = image->depth;
+    for (int i = 0; i < yuvaPixmaps.numPlanes(); ++i) {
+        const uint8_t* src = i < 3 ? image->yuvPlanes[i] : image->alphaPlane;
+        const size_t srcRowBytes = i < 3 ? image->yuvRowBytes[i] : image->alphaRowBytes;
+        const SkPixmap& dst = yuvaPixmaps.plane(i);
+        if (!src) {
+            return kInvalidInput;
+        }
+        for (int y = 0; y < dst.height(); ++y) {
+            if (depth == 8) {
+                memcpy(dst.writable_addr8(0, y), src, dst.width());
+            } else {
+                // Scale the samples up to the full 16 bit range by replicating their high bits.
+                const uint16_t* srcRow = reinterpret_cast<const uint16_t*>(src);
+                uint16_t* dstRow = dst.writable_addr16(0, y);
+                for (int x = 0; x < dst.width(); ++x) {
+                    dstRow[x] = static_cast<uint16_t>((srcRow[x] << (16 - depth)) |
+                                                    (srcRow[x] >> (2 * depth - 16)));
+                }
+            }
+            src += srcRowBytes;
+        }
+    }
+    return kSuccess;
+}
@@ -564,6 +564,30 @@ SkCodec::Result SkCodec::startIncrementalDecode(const SkImageInfo& info, void* p
 }
 
 
+sk_sp<SkData> SkCodec::buildRowIndex(int rowInterval) {
+    if (rowInterval <= 0 || !this->rewindIfNeeded()) {
+        return nullptr;
+    }
+    return this->onBuildRowIndex(rowInterval);
+}
+
+bool SkCodec::setRowIndex(sk_sp<SkData> index) {
+    // Checking the index against the image data reads the stream.
+    if (index && !this->rewindIfNeeded()) {
+        return false;
+    }
+    return this->onSetRowIndex(std::move(index));
+}
+
+sk_sp<SkData> SkCodec::onBuildRowIndex(int) {
+    return nullptr;
+}
+
+bool SkCodec::onSetRowIndex(sk_sp<SkData> index) {
+    // Without an index, decoding works the same as before.
+    return !index;
+}
+
 SkCodec::Result SkCodec::startScanlineDecode(const SkImageInfo& info,
         const SkCodec::Options* options) {
     // Reset fCurrScanline in case of failure.
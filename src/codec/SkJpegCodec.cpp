@@ -28,19 +28,22 @@
 #include "src/codec/SkJpegConstants.h"
 #include "src/codec/SkJpegDecoderMgr.h"
 #include "src/codec/SkJpegPriv.h"
+#include "src/codec/SkJpegSegmentScan.h"
 #include "src/codec/SkParseEncodedOrigin.h"
 #include "src/codec/SkSwizzler.h"
+#include "src/core/SkTaskGroup.h"
 
 #ifdef SK_CODEC_DECODES_JPEG_GAINMAPS
 #include "include/private/SkGainmapInfo.h"
 #include "src/codec/SkJpegMultiPicture.h"
-#include "src/codec/SkJpegSegmentScan.h"
 #include "src/codec/SkJpegXmp.h"
 #endif  // SK_CODEC_DECODES_JPEG_GAINMAPS
 
 #include <array>
+#include <atomic>
 #include <csetjmp>
 #include <cstring>
+#include <numeric>
 #include <utility>
 #include <vector>
 
@@ -614,6 +617,142 @@ static inline bool needs_swizzler_to_convert_from_cmyk(J_COLOR_SPACE jpegColorTy
     return !hasCMYKColorSpace || !hasColorSpaceXform;
 }
 
+// Splitting only pays for itself once each band has a reasonable amount of work.
+static constexpr int kMinParallelBandHeight = 256;
+
+bool SkJpegCodec::decodeRestartIntervalsInParallel(const SkImageInfo& dstInfo, void* dst,
+                                                   size_t rowBytes, const Options& options) {
+    const jpeg_decompress_struct* dinfo = fDecoderMgr->dinfo();
+    if (!options.fExecutor || dstInfo.dimensions() != this->dimensions() ||
+        0 == dinfo->restart_interval || dinfo->progressive_mode || dinfo->arith_code ||
+        dinfo->comps_in_scan != dinfo->num_components) {
+        return false;
+    }
+
+    SkStream* stream = this->stream();
+    if (!stream->getMemoryBase() || !stream->hasLength()) {
+        return false;
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(stream->getMemoryBase());
+    const size_t size = stream->getLength();
+
+    const int width  = this->dimensions().width(),
+              height = this->dimensions().height();
+    int mcuWidth  = DCTSIZE * dinfo->max_h_samp_factor,
+        mcuHeight = DCTSIZE * dinfo->max_v_samp_factor;
+    if (1 == dinfo->num_components) {
+        // A non-interleaved scan's MCU is a single block of its only component.
+        mcuWidth  /= dinfo->comp_info[0].h_samp_factor;
+        mcuHeight /= dinfo->comp_info[0].v_samp_factor;
+    }
+    const int mcusPerRow = (width  + mcuWidth  - 1) / mcuWidth,
+              mcuRows    = (height + mcuHeight - 1) / mcuHeight;
+    const int restartInterval = dinfo->restart_interval;
+    const int intervals = (mcusPerRow * mcuRows + restartInterval - 1) / restartInterval;
+
+    // Bands must start on an MCU row that is also the start of a restart interval.  Each band is
+    // decoded with |step| extra MCU rows above and below it, so that the chroma upsampling at its
+    // edges sees the same neighbors it would in a serial decode.
+    const int step = restartInterval / std::gcd(restartInterval, mcusPerRow);
+    const int minBandRows = std::max(4 * step, kMinParallelBandHeight / mcuHeight);
+    const int bandRows = (minBandRows + step - 1) / step * step;
+    if (bandRows >= mcuRows) {
+        return false;
+    }
+
+    // Find the frame header, the end of the scan header, every restart marker, and the end of the
+    // image.  Anything else after the scan header means this isn't a single baseline scan.
+    SkJpegSegmentScanner scanner;
+    scanner.onBytes(data, size);
+    if (!scanner.isDone()) {
+        return false;
+    }
+    size_t sofOffset = 0, headerSize = 0, eoiOffset = 0;
+    std::vector<size_t> restarts;
+    for (const SkJpegSegment& segment : scanner.getSegments()) {
+        if (0 == headerSize) {
+            if (0xC0 == segment.marker || 0xC1 == segment.marker) {
+                sofOffset = segment.offset;
+            } else if (kJpegMarkerStartOfScan == segment.marker) {
+                headerSize = segment.offset + kJpegMarkerCodeSize + segment.parameterLength;
+            }
+        } else if (segment.marker >= 0xD0 && segment.marker <= 0xD7) {
+            restarts.push_back(segment.offset);
+        } else if (kJpegMarkerEndOfImage == segment.marker) {
+            eoiOffset = segment.offset;
+        } else {
+            return false;
+        }
+    }
+    if (0 == sofOffset || 0 == headerSize || 0 == eoiOffset ||
+        SkToInt(restarts.size()) != intervals - 1) {
+        return false;
+    }
+
+    // The offsets of the entropy-coded data starting or ending at a restart boundary.
+    auto intervalStart = [&](int i) { return 0 == i ? headerSize : restarts[i - 1] + 2; };
+    auto intervalEnd   = [&](int i) { return intervals == i ? eoiOffset : restarts[i - 1]; };
+
+    const int bandCount = (mcuRows + bandRows - 1) / bandRows;
+    std::atomic<bool> success{true};
+    SkTaskGroup tg(*options.fExecutor);
+    tg.batch(bandCount, [&](int band) {
+        const int top    = band * bandRows,
+                  bottom = std::min(top + bandRows, mcuRows),
+                  decodeTop    = std::max(top - step, 0),
+                  decodeBottom = std::min(bottom + step, mcuRows);
+        const int firstInterval = decodeTop * mcusPerRow / restartInterval,
+                  endInterval   = decodeBottom == mcuRows
+                                        ? intervals  // The last interval may be partial.
+                                        : decodeBottom * mcusPerRow / restartInterval;
+        const int decodeHeight = std::min(decodeBottom * mcuHeight, height) - decodeTop * mcuHeight;
+
+        // Build a standalone JPEG out of the original headers, with the frame height reduced to
+        // this band, and the band's entropy-coded data with its restart markers renumbered.
+        const size_t entropyStart = intervalStart(firstInterval),
+                     entropySize  = intervalEnd(endInterval) - entropyStart;
+        sk_sp<SkData> bandData = SkData::MakeUninitialized(headerSize + entropySize + 2);
+        uint8_t* bytes = static_cast<uint8_t*>(bandData->writable_data());
+        memcpy(bytes, data, headerSize);
+        bytes[sofOffset + 5] = SkToU8(decodeHeight >> 8);
+        bytes[sofOffset + 6] = SkToU8(decodeHeight & 0xFF);
+        memcpy(bytes + headerSize, data + entropyStart, entropySize);
+        for (int i = firstInterval + 1; i < endInterval; i++) {
+            bytes[headerSize + restarts[i - 1] - entropyStart + 1] =
+                    SkToU8(0xD0 + ((i - firstInterval - 1) & 7));
+        }
+        bytes[headerSize + entropySize + 0] = 0xFF;
+        bytes[headerSize + entropySize + 1] = kJpegMarkerEndOfImage;
+
+        Result result;
+        auto profile = this->getEncodedInfo().profile()
+                ? SkEncodedInfo::ICCProfile::Make(*this->getEncodedInfo().profile())
+                : nullptr;
+        auto codec = MakeFromStream(SkMemoryStream::Make(std::move(bandData)), &result,
+                                    std::move(profile));
+        if (!codec || kSuccess != codec->startScanlineDecode(dstInfo.makeWH(width, decodeHeight))) {
+            success = false;
+            return;
+        }
+
+        // Discard the overlap rows above the band, which the band above writes.
+        AutoTMalloc<uint8_t> scratch(rowBytes);
+        for (int y = decodeTop * mcuHeight; y < top * mcuHeight; y++) {
+            if (1 != codec->getScanlines(scratch.get(), 1, rowBytes)) {
+                success = false;
+                return;
+            }
+        }
+        const int rows = std::min(bottom * mcuHeight, height) - top * mcuHeight;
+        if (rows != codec->getScanlines(SkTAddOffset<void>(dst, top * mcuHeight * rowBytes),
+                                        rows, rowBytes)) {
+            success = false;
+        }
+    });
+    tg.wait();
+    return success;
+}
+
 /*
  * Performs the jpeg decode
  */
@@ -626,6 +765,10 @@ SkCodec::Result SkJpegCodec::onGetPixels(const SkImageInfo& dstInfo,
         return kUnimplemented;
     }
 
+    if (this->decodeRestartIntervalsInParallel(dstInfo, dst, dstRowBytes, options)) {
+        return kSuccess;
+    }
+
     // Get a pointer to the decompress info since we will use it quite frequently
     jpeg_decompress_struct* dinfo = fDecoderMgr->dinfo();
 
@@ -131,6 +131,14 @@ private:
     bool SK_WARN_UNUSED_RESULT allocateStorage(const SkImageInfo& dstInfo);
     int readRows(const SkImageInfo& dstInfo, void* dst, size_t rowBytes, int count, const Options&);
 
+    /*
+     * Splits the entropy-coded data at restart markers and decodes the resulting horizontal
+     * bands on options.fExecutor. Returns false if the image can't be split this way, or if
+     * any band fails, in which case the caller should decode serially.
+     */
+    bool decodeRestartIntervalsInParallel(const SkImageInfo& dstInfo, void* dst, size_t rowBytes,
+                                          const Options& options);
+
     /*
      * Scanline decoding.
      */
@@ -24,12 +24,14 @@
 #include "src/codec/SkCodecPriv.h"
 #include "src/codec/SkColorTable.h"
 #include "src/codec/SkPngPriv.h"
+#include "src/codec/SkPngRowIndex.h"
 #include "src/codec/SkSwizzler.h"
 #include "src/core/SkOpts.h"
 
 #include <csetjmp>
 #include <algorithm>
 #include <cstring>
+#include <memory>
 #include <utility>
 
 #include <png.h>
@@ -505,14 +507,19 @@ static SkCodec::Result log_and_return_error(bool success) {
 
 class SkPngNormalDecoder : public SkPngCodec {
 public:
+    // rowIndexBitsPerPixel is the size of a pixel in the unfiltered rows, if libpng passes them
+    // through unchanged, so that a row index can be used, or 0 otherwise.
     SkPngNormalDecoder(SkEncodedInfo&& info, std::unique_ptr<SkStream> stream,
-            SkPngChunkReader* reader, png_structp png_ptr, png_infop info_ptr, int bitDepth)
+            SkPngChunkReader* reader, png_structp png_ptr, png_infop info_ptr, int bitDepth,
+            int rowIndexBitsPerPixel)
         : INHERITED(std::move(info), std::move(stream), reader, png_ptr, info_ptr, bitDepth)
         , fRowsWrittenToOutput(0)
         , fDst(nullptr)
         , fRowBytes(0)
         , fFirstRow(0)
         , fLastRow(0)
+        , fRowIndexBitsPerPixel(rowIndexBitsPerPixel)
+        , fCheckpoint(nullptr)
     {}
 
     static void AllRowsCallback(png_structp png_ptr, png_bytep row, png_uint_32 rowNum, int /*pass*/) {
@@ -533,6 +540,12 @@ private:
     int                         fLastRow;
     int                         fRowsNeeded;
 
+    // Variables for decoding from a row index
+    const int                               fRowIndexBitsPerPixel;
+    std::unique_ptr<SkPngRowIndex>          fRowIndex;
+    const SkPngRowIndex::Checkpoint*        fCheckpoint;
+    std::unique_ptr<SkPngRowIndex::Reader>  fRowReader;
+
     using INHERITED = SkPngCodec;
 
     static SkPngNormalDecoder* GetDecoder(png_structp png_ptr) {
@@ -576,6 +589,10 @@ private:
         fRowBytes = rowBytes;
         fRowsWrittenToOutput = 0;
         fRowsNeeded = fLastRow - fFirstRow + 1;
+
+        // Skip the rows above the range, if the index has a checkpoint there.
+        fCheckpoint = fRowIndex ? fRowIndex->find(firstRow) : nullptr;
+        fRowReader.reset();
     }
 
     Result decode(int* rowsDecoded) override {
@@ -584,6 +601,10 @@ private:
             fRowsNeeded = get_scaled_dimension(fLastRow - fFirstRow + 1, sampleY);
         }
 
+        if (fCheckpoint) {
+            return this->decodeFromCheckpoint(rowsDecoded);
+        }
+
         const bool success = this->processData();
         if (success && fRowsWrittenToOutput == fRowsNeeded) {
             return kSuccess;
@@ -596,7 +617,40 @@ private:
         return log_and_return_error(success);
     }
 
+    // Decodes rows without libpng, which cannot start partway through the image data. This
+    // relies on libpng not transforming the unfiltered rows, so they are the same either way.
+    Result decodeFromCheckpoint(int* rowsDecoded) {
+        if (!fRowReader) {
+            // Nothing has been read since the header, so the stream is at the image data.
+            fRowReader = std::make_unique<SkPngRowIndex::Reader>(*fRowIndex, *fCheckpoint,
+                                                                 this->stream());
+        }
+
+        while (fRowsWrittenToOutput < fRowsNeeded) {
+            const uint8_t* row;
+            int rowNum;
+            const Result result = fRowReader->nextRow(&row, &rowNum);
+            if (kSuccess != result) {
+                if (rowsDecoded) {
+                    *rowsDecoded = fRowsWrittenToOutput;
+                }
+                return log_and_return_error(kIncompleteInput == result);
+            }
+            this->writeRow(row, rowNum);
+        }
+        return kSuccess;
+    }
+
     void rowCallback(png_bytep row, int rowNum) {
+        this->writeRow(row, rowNum);
+
+        if (fRowsWrittenToOutput == fRowsNeeded) {
+            // Fake error to stop decoding scanlines.
+            longjmp(PNG_JMPBUF(this->png_ptr()), kStopDecoding);
+        }
+    }
+
+    void writeRow(const png_byte* row, int rowNum) {
         if (rowNum < fFirstRow) {
             // Ignore this row.
             return;
@@ -611,11 +665,33 @@ private:
             fDst = SkTAddOffset<void>(fDst, fRowBytes);
             fRowsWrittenToOutput++;
         }
+    }
 
-        if (fRowsWrittenToOutput == fRowsNeeded) {
-            // Fake error to stop decoding scanlines.
-            longjmp(PNG_JMPBUF(this->png_ptr()), kStopDecoding);
+    sk_sp<SkData> onBuildRowIndex(int rowInterval) override {
+        if (!fRowIndexBitsPerPixel) {
+            return nullptr;
         }
+        // rewindIfNeeded() left the stream at the start of the image data.
+        return SkPngRowIndex::Build(this->stream(), this->idatLength(), this->dimensions().width(),
+                                    this->dimensions().height(), fRowIndexBitsPerPixel,
+                                    rowInterval);
+    }
+
+    bool onSetRowIndex(sk_sp<SkData> data) override {
+        std::unique_ptr<SkPngRowIndex> index;
+        if (data) {
+            // setRowIndex() rewound the stream, which left it at the start of the image data.
+            index = SkPngRowIndex::Make(std::move(data), this->stream(), this->idatLength(),
+                                        this->dimensions().width(), this->dimensions().height(),
+                                        fRowIndexBitsPerPixel);
+            if (!index) {
+                return false;
+            }
+        }
+        fRowIndex = std::move(index);
+        fCheckpoint = nullptr;
+        fRowReader.reset();
+        return true;
     }
 };
 
@@ -855,11 +931,16 @@ void AutoCleanPng::infoCallback(size_t idatLength) {
     png_get_IHDR(fPng_ptr, fInfo_ptr, &origWidth, &origHeight, &bitDepth,
                  &encodedColorType, nullptr, nullptr, nullptr);
 
+    // A row index can only be used if libpng passes the unfiltered rows through unchanged.
+    const int encodedBitsPerPixel = bitDepth * png_get_channels(fPng_ptr, fInfo_ptr);
+    bool transformsRows = false;
+
     // TODO: Should we support 16-bits of precision for gray images?
     if (bitDepth == 16 && (PNG_COLOR_TYPE_GRAY == encodedColorType ||
                            PNG_COLOR_TYPE_GRAY_ALPHA == encodedColorType)) {
         bitDepth = 8;
         png_set_strip_16(fPng_ptr);
+        transformsRows = true;
     }
 
     // Now determine the default colorType and alphaType and set the required transforms.
@@ -875,6 +956,7 @@ void AutoCleanPng::infoCallback(size_t idatLength) {
                 // TODO: Should we use SkSwizzler here?
                 bitDepth = 8;
                 png_set_packing(fPng_ptr);
+                transformsRows = true;
             }
 
             color = SkEncodedInfo::kPalette_Color;
@@ -886,6 +968,7 @@ void AutoCleanPng::infoCallback(size_t idatLength) {
             if (png_get_valid(fPng_ptr, fInfo_ptr, PNG_INFO_tRNS)) {
                 // Convert to RGBA if transparency chunk exists.
                 png_set_tRNS_to_alpha(fPng_ptr);
+                transformsRows = true;
                 color = SkEncodedInfo::kRGBA_Color;
                 alpha = SkEncodedInfo::kBinary_Alpha;
             } else {
@@ -899,10 +982,12 @@ void AutoCleanPng::infoCallback(size_t idatLength) {
                 // TODO: Should we use SkSwizzler here?
                 bitDepth = 8;
                 png_set_expand_gray_1_2_4_to_8(fPng_ptr);
+                transformsRows = true;
             }
 
             if (png_get_valid(fPng_ptr, fInfo_ptr, PNG_INFO_tRNS)) {
                 png_set_tRNS_to_alpha(fPng_ptr);
+                transformsRows = true;
                 color = SkEncodedInfo::kGrayAlpha_Color;
                 alpha = SkEncodedInfo::kBinary_Alpha;
             } else {
@@ -985,7 +1070,8 @@ void AutoCleanPng::infoCallback(size_t idatLength) {
                                                         bitDepth, std::move(profile));
         if (1 == numberPasses) {
             *fOutCodec = new SkPngNormalDecoder(std::move(encodedInfo),
-                   std::unique_ptr<SkStream>(fStream), fChunkReader, fPng_ptr, fInfo_ptr, bitDepth);
+                   std::unique_ptr<SkStream>(fStream), fChunkReader, fPng_ptr, fInfo_ptr, bitDepth,
+                   transformsRows ? 0 : encodedBitsPerPixel);
         } else {
             *fOutCodec = new SkPngInterlacedDecoder(std::move(encodedInfo),
                     std::unique_ptr<SkStream>(fStream), fChunkReader, fPng_ptr, fInfo_ptr, bitDepth,
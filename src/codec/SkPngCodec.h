@@ -62,6 +62,8 @@ protected:
     SkSampler* getSampler(bool createIfNecessary) override;
     void applyXformRow(void* dst, const void* src);
 
+    size_t idatLength() const { return fIdatLength; }
+
     voidp png_ptr() { return fPng_ptr; }
     voidp info_ptr() { return fInfo_ptr; }
 
@@ -0,0 +1,445 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/codec/SkPngRowIndex.h"
+
+#include "include/core/SkStream.h"
+#include "include/private/base/SkAlign.h"
+#include "include/private/base/SkTo.h"
+#include "src/base/SkScopeExit.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+using namespace skia_private;
+
+static constexpr uint32_t kMagic   = SkSetFourByteTag('S', 'k', 'P', 'I');
+static constexpr uint32_t kVersion = 2;
+
+static constexpr size_t kHeaderSize     = 9 * sizeof(uint32_t);
+static constexpr size_t kCheckpointSize = 5 * sizeof(uint32_t);
+
+static size_t row_bytes(int width, int bitsPerPixel) {
+    return SkToSizeT((static_cast<uint64_t>(width) * bitsPerPixel + 7) / 8);
+}
+
+static uint32_t read_be32(const uint8_t* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+// Reads up to size bytes of image data into buffer, moving on to the next IDAT chunk when
+// *chunkBytesLeft runs out. Returns 0 at the end of the stream, and also sets *error if the image
+// data ends first. If crc is not null, it is updated with every byte read, including the framing.
+static size_t read_idat(SkStream* stream, uint8_t* buffer, size_t size, size_t* chunkBytesLeft,
+                        size_t* offset, bool* error, uLong* crc = nullptr) {
+    while (*chunkBytesLeft == 0) {
+        // The CRC of this chunk, then the length and type of the next.
+        uint8_t framing[12];
+        const size_t bytesRead = stream->read(framing, sizeof(framing));
+        if (bytesRead < sizeof(framing)) {
+            *error = bytesRead > 0;
+            return 0;
+        }
+        if (0 != memcmp(framing + 8, "IDAT", 4)) {
+            *error = true;
+            return 0;
+        }
+        *chunkBytesLeft = read_be32(framing + 4);
+        *offset += sizeof(framing);
+        if (crc) {
+            *crc = crc32(*crc, framing, sizeof(framing));
+        }
+    }
+
+    const size_t bytesRead = stream->read(buffer, std::min(size, *chunkBytesLeft));
+    if (crc) {
+        *crc = crc32(*crc, buffer, SkToUInt(bytesRead));
+    }
+    *chunkBytesLeft -= bytesRead;
+    *offset += bytesRead;
+    return bytesRead;
+}
+
+// Undoes the filter in row[0] on the pixels that follow it, given the unfiltered prior row (which
+// also starts with its filter byte).
+static bool unfilter_row(uint8_t* row, const uint8_t* prior, size_t rowBytes, int bpp) {
+    uint8_t* dst = row + 1;
+    const uint8_t* up = prior + 1;
+    switch (row[0]) {
+        case 0:  // None
+            break;
+        case 1:  // Sub
+            for (size_t i = bpp; i < rowBytes; ++i) {
+                dst[i] += dst[i - bpp];
+            }
+            break;
+        case 2:  // Up
+            for (size_t i = 0; i < rowBytes; ++i) {
+                dst[i] += up[i];
+            }
+            break;
+        case 3:  // Average
+            for (size_t i = 0; i < rowBytes; ++i) {
+                const int left = i >= (size_t)bpp ? dst[i - bpp] : 0;
+                dst[i] += (left + up[i]) >> 1;
+            }
+            break;
+        case 4:  // Paeth
+            for (size_t i = 0; i < rowBytes; ++i) {
+                const int a = i >= (size_t)bpp ? dst[i - bpp] : 0,
+                          b = up[i],
+                          c = i >= (size_t)bpp ? up[i - bpp] : 0;
+                const int pa = std::abs(b - c),
+                          pb = std::abs(a - c),
+                          pc = std::abs(a + b - 2 * c);
+                dst[i] += pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+            }
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+sk_sp<SkData> SkPngRowIndex::Build(SkStream* stream, size_t idatLength, int width, int height,
+                                   int bitsPerPixel, int rowInterval) {
+    if (width <= 0 || height <= 0 || bitsPerPixel <= 0 || rowInterval <= 0) {
+        return nullptr;
+    }
+    const size_t rowBytes = row_bytes(width, bitsPerPixel);
+    const size_t stride = rowBytes + 1;
+    const int bpp = std::max(1, bitsPerPixel / 8);
+
+    z_stream zstream = {};
+    if (Z_OK != inflateInit(&zstream)) {
+        return nullptr;
+    }
+    SK_AT_SCOPE_EXIT(inflateEnd(&zstream));
+
+    // Inflate into a circular window, so the last kWindowSize bytes of output are always there
+    // to copy into a checkpoint.
+    AutoTMalloc<uint8_t> window(kWindowSize);
+    sk_bzero(window.get(), kWindowSize);
+
+    AutoTMalloc<uint8_t> rows(2 * stride);
+    sk_bzero(rows.get(), 2 * stride);
+    uint8_t* prior = rows.get();
+    uint8_t* current = prior + stride;
+    size_t rowFilled = 0;
+    int rowsDone = 0;
+
+    uint8_t input[4096];
+    size_t inputSize = 0;
+    size_t inputOffset = 0;
+    size_t chunkBytesLeft = idatLength;
+    uint8_t lastByte = 0;
+    uint64_t outputOffset = 0;
+    // Covers all the input, so that Make can tell whether the image data is the same.
+    uLong crc = crc32(0, nullptr, 0);
+
+    struct PendingCheckpoint {
+        Checkpoint           fCheckpoint;
+        std::vector<uint8_t> fWindow;
+        std::vector<uint8_t> fPriorRow;
+    };
+    std::vector<PendingCheckpoint> checkpoints;
+    int nextCheckpointRow = rowInterval;
+
+    while (rowsDone < height) {
+        if (zstream.avail_in == 0) {
+            if (inputSize > 0) {
+                lastByte = input[inputSize - 1];
+            }
+            bool error = false;
+            inputSize = read_idat(stream, input, sizeof(input), &chunkBytesLeft, &inputOffset,
+                                  &error, &crc);
+            if (inputSize == 0) {
+                return nullptr;
+            }
+            zstream.next_in = input;
+            zstream.avail_in = SkToUInt(inputSize);
+        }
+        if (zstream.avail_out == 0) {
+            zstream.next_out = window.get();
+            zstream.avail_out = kWindowSize;
+        }
+
+        const uint8_t* output = zstream.next_out;
+        const int ret = inflate(&zstream, Z_BLOCK);
+        if (ret != Z_OK && ret != Z_STREAM_END) {
+            return nullptr;
+        }
+
+        for (const uint8_t* p = output; p < zstream.next_out && rowsDone < height;) {
+            const size_t n = std::min(stride - rowFilled, SkToSizeT(zstream.next_out - p));
+            memcpy(current + rowFilled, p, n);
+            p += n;
+            rowFilled += n;
+            if (rowFilled == stride) {
+                if (!unfilter_row(current, prior, rowBytes, bpp)) {
+                    return nullptr;
+                }
+                std::swap(prior, current);
+                rowFilled = 0;
+                rowsDone++;
+                if (!checkpoints.empty() && checkpoints.back().fPriorRow.empty() &&
+                        checkpoints.back().fCheckpoint.fRow == rowsDone) {
+                    checkpoints.back().fPriorRow.assign(prior + 1, prior + stride);
+                }
+            }
+        }
+        outputOffset += zstream.next_out - output;
+
+        if (ret == Z_STREAM_END) {
+            break;
+        }
+
+        // Bit 7 of data_type is set at the end of a block, and bit 6 if it was the last block.
+        const bool blockBoundary = (zstream.data_type & 128) && !(zstream.data_type & 64);
+        const uint64_t row = (outputOffset + stride - 1) / stride;
+        if (!blockBoundary || row < (uint64_t)nextCheckpointRow || row >= (uint64_t)height) {
+            continue;
+        }
+        const size_t consumed = inputSize - zstream.avail_in;
+        const size_t checkpointOffset = inputOffset - zstream.avail_in;
+        if (checkpointOffset > UINT32_MAX || chunkBytesLeft + zstream.avail_in > UINT32_MAX) {
+            // No more checkpoints fit the format.
+            nextCheckpointRow = height;
+            continue;
+        }
+
+        PendingCheckpoint& checkpoint = checkpoints.emplace_back();
+        checkpoint.fCheckpoint.fRow = SkToInt(row);
+        checkpoint.fCheckpoint.fInputOffset = SkToU32(checkpointOffset);
+        checkpoint.fCheckpoint.fChunkBytesLeft = SkToU32(chunkBytesLeft + zstream.avail_in);
+        checkpoint.fCheckpoint.fOutputSkip = SkToU32(row * stride - outputOffset);
+        checkpoint.fCheckpoint.fBits = SkToU8(zstream.data_type & 7);
+        checkpoint.fCheckpoint.fLastByte = consumed > 0 ? input[consumed - 1] : lastByte;
+
+        // The oldest output starts where the next output will go.
+        const size_t left = zstream.avail_out;
+        checkpoint.fWindow.resize(kWindowSize);
+        memcpy(checkpoint.fWindow.data(), window.get() + kWindowSize - left, left);
+        memcpy(checkpoint.fWindow.data() + left, window.get(), kWindowSize - left);
+
+        if (rowsDone == checkpoint.fCheckpoint.fRow) {
+            checkpoint.fPriorRow.assign(prior + 1, prior + stride);
+        }
+        nextCheckpointRow = checkpoint.fCheckpoint.fRow + rowInterval;
+    }
+    if (rowsDone < height || inputOffset > UINT32_MAX) {
+        return nullptr;
+    }
+
+    SkDynamicMemoryWStream out;
+    out.write32(kMagic);
+    out.write32(kVersion);
+    out.write32(SkToU32(idatLength));
+    out.write32(width);
+    out.write32(height);
+    out.write32(bitsPerPixel);
+    out.write32(SkToU32(inputOffset));
+    out.write32(SkToU32(crc));
+    out.write32(SkToU32(checkpoints.size()));
+    for (const PendingCheckpoint& checkpoint : checkpoints) {
+        SkASSERT(checkpoint.fPriorRow.size() == rowBytes);
+        out.write32(checkpoint.fCheckpoint.fRow);
+        out.write32(checkpoint.fCheckpoint.fInputOffset);
+        out.write32(checkpoint.fCheckpoint.fChunkBytesLeft);
+        out.write32(checkpoint.fCheckpoint.fOutputSkip);
+        out.write8(checkpoint.fCheckpoint.fBits);
+        out.write8(checkpoint.fCheckpoint.fLastByte);
+        out.write16(0);
+        out.write(checkpoint.fWindow.data(), kWindowSize);
+        out.write(checkpoint.fPriorRow.data(), rowBytes);
+        out.padToAlign4();
+    }
+    return out.detachAsData();
+}
+
+std::unique_ptr<SkPngRowIndex> SkPngRowIndex::Make(sk_sp<SkData> data, SkStream* stream,
+                                                   size_t idatLength, int width, int height,
+                                                   int bitsPerPixel) {
+    if (!data || data->size() < kHeaderSize) {
+        return nullptr;
+    }
+    const uint8_t* ptr = data->bytes();
+    auto read32 = [&ptr]() {
+        uint32_t value;
+        memcpy(&value, ptr, sizeof(value));
+        ptr += sizeof(value);
+        return value;
+    };
+    if (read32() != kMagic || read32() != kVersion || read32() != idatLength ||
+            read32() != (uint32_t)width || read32() != (uint32_t)height ||
+            read32() != (uint32_t)bitsPerPixel) {
+        return nullptr;
+    }
+    const uint32_t inputLength = read32();
+    const uint32_t inputCrc = read32();
+    const uint32_t count = read32();
+
+    const size_t rowBytes = row_bytes(width, bitsPerPixel);
+    const size_t recordSize = SkAlign4(kCheckpointSize + kWindowSize + rowBytes);
+    if ((data->size() - kHeaderSize) / recordSize != count ||
+            (data->size() - kHeaderSize) % recordSize != 0) {
+        return nullptr;
+    }
+
+    std::vector<Checkpoint> checkpoints(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t* record = ptr;
+        Checkpoint& checkpoint = checkpoints[i];
+        checkpoint.fRow = SkToInt(read32());
+        checkpoint.fInputOffset = read32();
+        checkpoint.fChunkBytesLeft = read32();
+        checkpoint.fOutputSkip = read32();
+        checkpoint.fBits = ptr[0];
+        checkpoint.fLastByte = ptr[1];
+        checkpoint.fWindow = record + kCheckpointSize;
+        checkpoint.fPriorRow = checkpoint.fWindow + kWindowSize;
+        ptr = record + recordSize;
+
+        const int prevRow = i > 0 ? checkpoints[i - 1].fRow : 0;
+        if (checkpoint.fRow <= prevRow || checkpoint.fRow >= height || checkpoint.fBits > 7 ||
+                checkpoint.fOutputSkip > rowBytes || checkpoint.fInputOffset > inputLength) {
+            return nullptr;
+        }
+    }
+
+    // The checkpoints are only valid for the image data they were built from, and the header
+    // alone does not tell whether it has changed since.
+    uLong crc = crc32(0, nullptr, 0);
+    uint8_t buffer[4096];
+    for (size_t left = inputLength; left > 0;) {
+        const size_t bytesRead = stream->read(buffer, std::min(left, sizeof(buffer)));
+        if (bytesRead == 0) {
+            return nullptr;
+        }
+        crc = crc32(crc, buffer, SkToUInt(bytesRead));
+        left -= bytesRead;
+    }
+    if (crc != inputCrc) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<SkPngRowIndex>(new SkPngRowIndex(std::move(data), rowBytes,
+                                                            std::max(1, bitsPerPixel / 8),
+                                                            std::move(checkpoints)));
+}
+
+SkPngRowIndex::SkPngRowIndex(sk_sp<SkData> data, size_t rowBytes, int bytesPerPixel,
+                             std::vector<Checkpoint> checkpoints)
+        : fData(std::move(data))
+        , fRowBytes(rowBytes)
+        , fBytesPerPixel(bytesPerPixel)
+        , fCheckpoints(std::move(checkpoints)) {}
+
+const SkPngRowIndex::Checkpoint* SkPngRowIndex::find(int row) const {
+    auto next = std::upper_bound(fCheckpoints.begin(), fCheckpoints.end(), row,
+                                 [](int r, const Checkpoint& checkpoint) {
+                                     return r < checkpoint.fRow;
+                                 });
+    return next == fCheckpoints.begin() ? nullptr : &*(next - 1);
+}
+
+SkPngRowIndex::Reader::Reader(const SkPngRowIndex& index, const Checkpoint& checkpoint,
+                              SkStream* stream)
+        : fStream(stream)
+        , fZStream{}
+        , fInitialized(false)
+        , fError(false)
+        , fChunkBytesLeft(checkpoint.fChunkBytesLeft)
+        , fOutputSkip(checkpoint.fOutputSkip)
+        , fRowBytes(index.fRowBytes)
+        , fBytesPerPixel(index.fBytesPerPixel)
+        , fRowNum(checkpoint.fRow)
+        , fRowFilled(0)
+        , fRows(2 * (index.fRowBytes + 1)) {
+    fPrior = fRows.get();
+    fCurrent = fPrior + fRowBytes + 1;
+    memcpy(fPrior + 1, checkpoint.fPriorRow, fRowBytes);
+
+    if (fStream->skip(checkpoint.fInputOffset) != checkpoint.fInputOffset ||
+            Z_OK != inflateInit2(&fZStream, -MAX_WBITS)) {
+        fError = true;
+        return;
+    }
+    fInitialized = true;
+
+    if (checkpoint.fBits > 0 &&
+            Z_OK != inflatePrime(&fZStream, checkpoint.fBits,
+                                 checkpoint.fLastByte >> (8 - checkpoint.fBits))) {
+        fError = true;
+    }
+    if (Z_OK != inflateSetDictionary(&fZStream, checkpoint.fWindow, kWindowSize)) {
+        fError = true;
+    }
+}
+
+SkPngRowIndex::Reader::~Reader() {
+    if (fInitialized) {
+        inflateEnd(&fZStream);
+    }
+}
+
+bool SkPngRowIndex::Reader::fill() {
+    size_t offset = 0;
+    const size_t bytesRead = read_idat(fStream, fInput, sizeof(fInput), &fChunkBytesLeft, &offset,
+                                       &fError);
+    fZStream.next_in = fInput;
+    fZStream.avail_in = SkToUInt(bytesRead);
+    return bytesRead > 0;
+}
+
+SkCodec::Result SkPngRowIndex::Reader::nextRow(const uint8_t** row, int* rowNum) {
+    const size_t stride = fRowBytes + 1;
+    uint8_t skipped[256];
+    while (!fError) {
+        if (fZStream.avail_in == 0 && !this->fill()) {
+            return fError ? SkCodec::kErrorInInput : SkCodec::kIncompleteInput;
+        }
+
+        if (fOutputSkip > 0) {
+            fZStream.next_out = skipped;
+            fZStream.avail_out = SkToUInt(std::min(fOutputSkip, sizeof(skipped)));
+        } else {
+            fZStream.next_out = fCurrent + fRowFilled;
+            fZStream.avail_out = SkToUInt(stride - fRowFilled);
+        }
+        const uInt availOut = fZStream.avail_out;
+        const int ret = inflate(&fZStream, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && !(ret == Z_BUF_ERROR && !fZStream.avail_in)) {
+            break;
+        }
+
+        const size_t produced = availOut - fZStream.avail_out;
+        if (fOutputSkip > 0) {
+            fOutputSkip -= produced;
+        } else {
+            fRowFilled += produced;
+        }
+        if (fRowFilled == stride) {
+            if (!unfilter_row(fCurrent, fPrior, fRowBytes, fBytesPerPixel)) {
+                break;
+            }
+            std::swap(fPrior, fCurrent);
+            fRowFilled = 0;
+            *row = fPrior + 1;
+            *rowNum = fRowNum++;
+            return SkCodec::kSuccess;
+        }
+        if (ret == Z_STREAM_END) {
+            // The image data ended before the last row.
+            break;
+        }
+    }
+    fError = true;
+    return SkCodec::kErrorInInput;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPngRowIndex_DEFINED
+#define SkPngRowIndex_DEFINED
+
+#include "include/codec/SkCodec.h"
+#include "include/core/SkData.h"
+#include "include/core/SkRefCnt.h"
+#include "include/private/base/SkTemplates.h"
+#include "include/private/base/SkTo.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "zlib.h"
+
+class SkStream;
+
+/*
+ * Inflate checkpoints into the image data of a non-interlaced PNG, so that decoding can start near
+ * any row rather than at the top of the image.
+ *
+ * Each checkpoint is at a deflate block boundary. It holds what a raw inflate needs to resume
+ * there (the input position, the bits left over in the last input byte and the 32K of output
+ * before it), and the unfiltered row before the first row that starts after it, which the next
+ * row's filter may refer to.
+ *
+ * The index is serialized to an SkData, so it can be built once and stored with the image. It
+ * includes a CRC of the image data it was built from, since a checkpoint into different data
+ * would decode garbage.
+ */
+class SkPngRowIndex {
+public:
+    static constexpr size_t kWindowSize = 32768;
+
+    struct Checkpoint {
+        // First row that starts at or after this checkpoint.
+        int fRow;
+        // Offset of the next input byte from the start of the first IDAT payload, counting the
+        // framing of later IDAT chunks, and the bytes left in its chunk.
+        uint32_t fInputOffset;
+        uint32_t fChunkBytesLeft;
+        // Inflated bytes before fRow starts.
+        uint32_t fOutputSkip;
+        // Bits of the last input byte that have not been consumed, and that byte.
+        uint8_t fBits;
+        uint8_t fLastByte;
+        // kWindowSize bytes of output before the checkpoint.
+        const uint8_t* fWindow;
+        // The unfiltered row fRow - 1.
+        const uint8_t* fPriorRow;
+    };
+
+    /*
+     * Inflates the image data that stream is positioned at the start of, and returns an index with
+     * a checkpoint at the first block boundary after every rowInterval rows. idatLength is the
+     * length of the first IDAT chunk. Returns nullptr if the data is invalid or incomplete.
+     */
+    static sk_sp<SkData> Build(SkStream* stream, size_t idatLength, int width, int height,
+                               int bitsPerPixel, int rowInterval);
+
+    /*
+     * Parses an index returned by Build, for an image with these parameters. stream must be
+     * positioned at the start of the image data, which is read to check that it is the data the
+     * index was built from. Returns nullptr if the index is invalid, was built for another image,
+     * or the image data differs or is incomplete.
+     */
+    static std::unique_ptr<SkPngRowIndex> Make(sk_sp<SkData> data, SkStream* stream,
+                                               size_t idatLength, int width, int height,
+                                               int bitsPerPixel);
+
+    // Returns the last checkpoint at or before row, or nullptr if there is none.
+    const Checkpoint* find(int row) const;
+
+    int count() const { return SkToInt(fCheckpoints.size()); }
+
+    /*
+     * Inflates and unfilters rows, starting from a checkpoint.
+     */
+    class Reader {
+    public:
+        // stream must be positioned at the start of the first IDAT payload.
+        Reader(const SkPngRowIndex&, const Checkpoint&, SkStream* stream);
+        ~Reader();
+
+        /*
+         * Points row at the next unfiltered row, and sets rowNum. Returns kIncompleteInput if the
+         * stream ended first, in which case this may be called again after more data has been
+         * provided, or kErrorInInput.
+         */
+        SkCodec::Result nextRow(const uint8_t** row, int* rowNum);
+
+    private:
+        bool fill();
+
+        SkStream*                 fStream;
+        z_stream                  fZStream;
+        bool                      fInitialized;
+        bool                      fError;
+        size_t                    fChunkBytesLeft;
+        size_t                    fOutputSkip;
+        const size_t              fRowBytes;
+        const int                 fBytesPerPixel;
+        int                       fRowNum;
+        size_t                    fRowFilled;
+        // fRows holds the previous row and the row being inflated, each prefixed by its filter
+        // byte.
+        skia_private::AutoTMalloc<uint8_t> fRows;
+        uint8_t*                  fPrior;
+        uint8_t*                  fCurrent;
+        uint8_t                   fInput[4096];
+    };
+
+private:
+    SkPngRowIndex(sk_sp<SkData> data, size_t rowBytes, int bytesPerPixel,
+                  std::vector<Checkpoint> checkpoints);
+
+    const sk_sp<SkData>           fData;
+    const size_t                  fRowBytes;
+    const int                     fBytesPerPixel;
+    const std::vector<Checkpoint> fCheckpoints;
+};
+
+#endif  // SkPngRowIndex_DEFINED
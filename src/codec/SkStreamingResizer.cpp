@@ -0,0 +1,164 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/codec/SkStreamingResizer.h"
+
+#include "include/core/SkTypes.h"
+#include "include/private/base/SkFloatingPoint.h"
+#include "include/private/base/SkTPin.h"
+
+#include <algorithm>
+#include <numeric>
+
+// Mitchell-Netravali with B = C = 1/3.
+static float mitchell(float x) {
+    x = sk_float_abs(x);
+    if (x < 1) {
+        return (7 * x * x * x - 12 * x * x + 16.0f / 3) / 6;
+    }
+    if (x < 2) {
+        return (-7.0f / 3 * x * x * x + 12 * x * x - 20 * x + 32.0f / 3) / 6;
+    }
+    return 0;
+}
+
+void SkStreamingResizer::Filter::init(int srcSize, float srcStart, float srcLength, int dstSize) {
+    // Mitchell doesn't interpolate, so filtering would blur a span that is already the right size.
+    fIdentity = srcLength == dstSize && srcStart == sk_float_floor(srcStart);
+    if (fIdentity) {
+        fSrcStart = (int)srcStart;
+        fSrcEnd = fSrcStart + dstSize;
+        SkASSERT(fSrcEnd <= srcSize);
+        fStart.resize(dstSize);
+        std::iota(fStart.begin(), fStart.end(), 0);
+        fCount.assign(dstSize, 1);
+        fWeights.assign(dstSize, 1.0f);
+        fMaxCount = 1;
+        return;
+    }
+
+    // When downscaling, stretch the filter to cover every source pixel.
+    const float scale = srcLength / dstSize;
+    const float filterScale = std::max(scale, 1.0f);
+    const float support = 2 * filterScale;
+
+    fStart.resize(dstSize);
+    fCount.resize(dstSize);
+    fMaxCount = 0;
+    for (int i = 0; i < dstSize; ++i) {
+        // Source pixel j is centered at j + 0.5.
+        const float center = srcStart + (i + 0.5f) * scale;
+        int start = std::max(sk_float_ceil2int(center - support - 0.5f), 0);
+        int end = std::min(sk_float_floor2int(center + support - 0.5f) + 1, srcSize);
+        if (start >= end) {
+            start = SkTPin(sk_float_floor2int(center), 0, srcSize - 1);
+            end = start + 1;
+        }
+        fStart[i] = start;
+        fCount[i] = end - start;
+        fMaxCount = std::max(fMaxCount, end - start);
+    }
+    // Both ends of the filter move monotonically with the output pixel.
+    fSrcStart = fStart.front();
+    fSrcEnd = fStart.back() + fCount.back();
+
+    fWeights.assign(dstSize * fMaxCount, 0.0f);
+    for (int i = 0; i < dstSize; ++i) {
+        const float center = srcStart + (i + 0.5f) * scale;
+        float* weights = &fWeights[i * fMaxCount];
+        float sum = 0;
+        for (int k = 0; k < fCount[i]; ++k) {
+            weights[k] = mitchell((fStart[i] + k + 0.5f - center) / filterScale);
+            sum += weights[k];
+        }
+        for (int k = 0; k < fCount[i]; ++k) {
+            weights[k] = sum > 0 ? weights[k] / sum : 1.0f / fCount[i];
+        }
+        fStart[i] -= fSrcStart;
+    }
+}
+
+SkStreamingResizer::SkStreamingResizer(SkISize srcSize, const SkRect& srcRect, SkISize dstSize,
+                                       int channels, bool alphaLast)
+        : fChannels(channels)
+        , fDstWidth(dstSize.width())
+        , fAlphaLast(alphaLast) {
+    SkASSERT(!dstSize.isEmpty() && SkRect::Make(srcSize).contains(srcRect));
+    SkASSERT(!alphaLast || channels == 4);
+    fX.init(srcSize.width(), srcRect.left(), srcRect.width(), dstSize.width());
+    fY.init(srcSize.height(), srcRect.top(), srcRect.height(), dstSize.height());
+    fSrcBounds = SkIRect::MakeLTRB(fX.fSrcStart, fY.fSrcStart, fX.fSrcEnd, fY.fSrcEnd);
+    fRows.resize(fY.fMaxCount * fDstWidth * fChannels);
+    fAccum.resize(fDstWidth * fChannels);
+}
+
+int SkStreamingResizer::rowsNeeded(int y) const {
+    return fY.fStart[y] + fY.fCount[y];
+}
+
+template <int N>
+static void filter_row(const uint8_t* src, float* dst, int dstWidth, const int* starts,
+                       const int* counts, const float* weights, int maxCount) {
+    for (int x = 0; x < dstWidth; ++x, weights += maxCount, dst += N) {
+        float sum[N] = {};
+        const uint8_t* p = src + starts[x] * N;
+        for (int k = 0; k < counts[x]; ++k, p += N) {
+            for (int c = 0; c < N; ++c) {
+                sum[c] += weights[k] * p[c];
+            }
+        }
+        for (int c = 0; c < N; ++c) {
+            dst[c] = sum[c];
+        }
+    }
+}
+
+void SkStreamingResizer::addRow(const uint8_t* row) {
+    SkASSERT(fRowsAdded < fSrcBounds.height());
+    const size_t rowFloats = fDstWidth * fChannels;
+    float* dst = &fRows[(fRowsAdded % fY.fMaxCount) * rowFloats];
+    if (fChannels == 4) {
+        filter_row<4>(row, dst, fDstWidth, fX.fStart.data(), fX.fCount.data(),
+                      fX.fWeights.data(), fX.fMaxCount);
+    } else {
+        SkASSERT(fChannels == 1);
+        filter_row<1>(row, dst, fDstWidth, fX.fStart.data(), fX.fCount.data(),
+                      fX.fWeights.data(), fX.fMaxCount);
+    }
+    fRowsAdded++;
+}
+
+void SkStreamingResizer::writeRow(int y, uint8_t* dst) {
+    SkASSERT(fRowsAdded >= this->rowsNeeded(y));
+    // Rows are only evicted once no later output row can use them.
+    SkASSERT(fY.fStart[y] >= fRowsAdded - fY.fMaxCount);
+
+    const size_t rowFloats = fDstWidth * fChannels;
+    std::fill(fAccum.begin(), fAccum.end(), 0.0f);
+    const float* weights = &fY.fWeights[y * fY.fMaxCount];
+    for (int k = 0; k < fY.fCount[y]; ++k) {
+        const float* row = &fRows[((fY.fStart[y] + k) % fY.fMaxCount) * rowFloats];
+        for (size_t i = 0; i < rowFloats; ++i) {
+            fAccum[i] += weights[k] * row[i];
+        }
+    }
+
+    // The filter's negative lobes can overshoot.
+    if (fAlphaLast) {
+        for (size_t i = 0; i < rowFloats; i += 4) {
+            const float a = SkTPin(fAccum[i + 3], 0.0f, 255.0f);
+            for (int c = 0; c < 3; ++c) {
+                dst[i + c] = (uint8_t)sk_float_round2int(SkTPin(fAccum[i + c], 0.0f, a));
+            }
+            dst[i + 3] = (uint8_t)sk_float_round2int(a);
+        }
+    } else {
+        for (size_t i = 0; i < rowFloats; ++i) {
+            dst[i] = (uint8_t)sk_float_round2int(SkTPin(fAccum[i], 0.0f, 255.0f));
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkStreamingResizer_DEFINED
+#define SkStreamingResizer_DEFINED
+
+#include "include/core/SkRect.h"
+#include "include/core/SkSize.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Resizes 8-bit-per-channel rows with a separable Mitchell filter, widened when downscaling so
+ * that every source pixel contributes.
+ *
+ * Source rows are filtered horizontally as they arrive, and only as many filtered rows as the
+ * vertical filter covers are kept, so the source image never needs to be in memory at once.
+ */
+class SkStreamingResizer {
+public:
+    /*
+     * Resizes srcRect, within a source of srcSize, to dstSize. If alphaLast, each pixel has four
+     * channels, the last of which is premultiplied alpha, and the others are clamped to it.
+     */
+    SkStreamingResizer(SkISize srcSize, const SkRect& srcRect, SkISize dstSize, int channels,
+                       bool alphaLast);
+
+    // The source pixels that contribute to the output. Only these are passed to addRow.
+    const SkIRect& srcBounds() const { return fSrcBounds; }
+
+    // True if srcBounds() is the size of the output, and is passed through unfiltered. Callers
+    // may then copy source rows instead of adding and writing them.
+    bool isIdentity() const { return fX.fIdentity && fY.fIdentity; }
+
+    // Rows from srcBounds().top() that must have been added before dst row y can be written.
+    int rowsNeeded(int y) const;
+
+    // Adds the next source row. row points at the pixel in column srcBounds().left().
+    void addRow(const uint8_t* row);
+
+    // Writes dst row y. Rows must be written in order.
+    void writeRow(int y, uint8_t* dst);
+
+private:
+    // The source pixels, and their weights, that make up each output pixel along one axis.
+    struct Filter {
+        void init(int srcSize, float srcStart, float srcLength, int dstSize);
+
+        std::vector<int>   fStart;   // relative to the first contributing source pixel
+        std::vector<int>   fCount;
+        std::vector<float> fWeights; // fMaxCount per output pixel
+        int                fMaxCount;
+        int                fSrcStart;
+        int                fSrcEnd;
+        bool               fIdentity;  // each output pixel is one source pixel
+    };
+
+    const int          fChannels;
+    const int          fDstWidth;
+    const bool         fAlphaLast;
+    Filter             fX;
+    Filter             fY;
+    SkIRect            fSrcBounds;
+    int                fRowsAdded = 0;
+    // fY.fMaxCount horizontally filtered rows, indexed by source row modulo the count.
+    std::vector<float> fRows;
+    std::vector<float> fAccum;
+};
+
+#endif  // SkStreamingResizer_DEFINED
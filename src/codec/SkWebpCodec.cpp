@@ -16,6 +16,8 @@
 #include "include/core/SkRect.h"
 #include "include/core/SkSize.h"
 #include "include/core/SkStream.h"
+#include "include/core/SkYUVAInfo.h"
+#include "include/core/SkYUVAPixmaps.h"
 #include "include/private/base/SkAlign.h"
 #include "include/private/base/SkMath.h"
 #include "include/private/base/SkTFitsIn.h"
@@ -30,6 +32,7 @@
 #include "src/core/SkStreamPriv.h"
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstring>
 #include <utility>
@@ -563,6 +566,122 @@ SkCodec::Result SkWebpCodec::onGetPixels(const SkImageInfo& dstInfo, void* dst,
     return result;
 }
 
+bool SkWebpCodec::onQueryYUVAInfo(const SkYUVAPixmapInfo::SupportedDataTypes& supportedDataTypes,
+                                  SkYUVAPixmapInfo* yuvaPixmapInfo) const {
+    // Lossy images are stored as 4:2:0 YUV, which libwebp can write out without converting to
+    // RGB. This only works if the first frame covers the whole canvas.
+    const SkEncodedInfo::Color color = this->getEncodedInfo().color();
+    if (color != SkEncodedInfo::kYUV_Color && color != SkEncodedInfo::kYUVA_Color) {
+        return false;
+    }
+
+    WebPIterator frame;
+    SkAutoTCallVProc<WebPIterator, WebPDemuxReleaseIterator> autoFrame(&frame);
+    if (!WebPDemuxGetFrame(fDemux, 1, &frame) ||
+        SkIRect::MakeXYWH(frame.x_offset, frame.y_offset, frame.width, frame.height) !=
+                this->bounds()) {
+        return false;
+    }
+
+    const auto planeConfig = frame.has_alpha ? SkYUVAInfo::PlaneConfig::kY_U_V_A
+                                             : SkYUVAInfo::PlaneConfig::kY_U_V;
+    if (!supportedDataTypes.supported(planeConfig, SkYUVAPixmapInfo::DataType::kUnorm8)) {
+        return false;
+    }
+    if (yuvaPixmapInfo) {
+        // VP8 uses BT.601 studio range, with chroma centered between luma samples.
+        SkYUVAInfo yuvaInfo(this->dimensions(),
+                            planeConfig,
+                            SkYUVAInfo::Subsampling::k420,
+                            kRec601_Limited_SkYUVColorSpace,
+                            this->getOrigin(),
+                            SkYUVAInfo::Siting::kCentered,
+                            SkYUVAInfo::Siting::kCentered);
+        *yuvaPixmapInfo = SkYUVAPixmapInfo(yuvaInfo, SkYUVAPixmapInfo::DataType::kUnorm8, nullptr);
+    }
+    return true;
+}
+
+// Fills the rows of the planes below the image's first rowsDecoded rows like SkCodec fills the rows
+// an incomplete getPixels() didn't decode: black, and transparent if there is alpha.
+static void fill_incomplete_planes(const SkYUVAPixmaps& yuvaPixmaps, int rowsDecoded) {
+    // Rec.601 limited range black, neutral chroma, and transparent alpha.
+    static constexpr uint8_t kFillValues[SkYUVAPixmaps::kMaxPlanes] = {16, 128, 128, 0};
+    const int height = yuvaPixmaps.plane(0).height();
+    for (int i = 0; i < yuvaPixmaps.numPlanes(); ++i) {
+        const SkPixmap& plane = yuvaPixmaps.plane(i);
+        // A subsampled row is decoded along with the first full resolution row it covers.
+        const int firstRow = (rowsDecoded * plane.height() + height - 1) / height;
+        for (int y = firstRow; y < plane.height(); ++y) {
+            memset(plane.writable_addr8(0, y), kFillValues[i], plane.width());
+        }
+    }
+}
+
+SkCodec::Result SkWebpCodec::onGetYUVAPlanes(const SkYUVAPixmaps& yuvaPixmaps) {
+    SkYUVAPixmapInfo info;
+    if (!this->onQueryYUVAInfo(SkYUVAPixmapInfo::SupportedDataTypes::All(), &info) ||
+        info.yuvaInfo() != yuvaPixmaps.yuvaInfo() ||
+        yuvaPixmaps.dataType() != SkYUVAPixmapInfo::DataType::kUnorm8) {
+        return kInvalidInput;
+    }
+
+    WebPDecoderConfig config;
+    if (0 == WebPInitDecoderConfig(&config)) {
+        // ABI mismatch.
+        return kInvalidInput;
+    }
+
+    // Free any memory associated with the buffer. Must be called last, so we declare it first.
+    SkAutoTCallVProc<WebPDecBuffer, WebPFreeDecBuffer> autoFree(&(config.output));
+
+    WebPIterator frame;
+    SkAutoTCallVProc<WebPIterator, WebPDemuxReleaseIterator> autoFrame(&frame);
+    SkAssertResult(WebPDemuxGetFrame(fDemux, 1, &frame));
+
+    const std::array<SkPixmap, SkYUVAPixmaps::kMaxPlanes>& planes = yuvaPixmaps.planes();
+    const bool hasAlpha = yuvaPixmaps.numPlanes() == 4;
+    config.output.colorspace = hasAlpha ? MODE_YUVA : MODE_YUV;
+    config.output.is_external_memory = 1;
+
+    WebPYUVABuffer& yuva = config.output.u.YUVA;
+    yuva.y = static_cast<uint8_t*>(planes[0].writable_addr());
+    yuva.u = static_cast<uint8_t*>(planes[1].writable_addr());
+    yuva.v = static_cast<uint8_t*>(planes[2].writable_addr());
+    yuva.y_stride = SkToInt(planes[0].rowBytes());
+    yuva.u_stride = SkToInt(planes[1].rowBytes());
+    yuva.v_stride = SkToInt(planes[2].rowBytes());
+    yuva.y_size = planes[0].computeByteSize();
+    yuva.u_size = planes[1].computeByteSize();
+    yuva.v_size = planes[2].computeByteSize();
+    if (hasAlpha) {
+        yuva.a = static_cast<uint8_t*>(planes[3].writable_addr());
+        yuva.a_stride = SkToInt(planes[3].rowBytes());
+        yuva.a_size = planes[3].computeByteSize();
+    }
+
+    SkAutoTCallVProc<WebPIDecoder, WebPIDelete> idec(WebPIDecode(nullptr, 0, &config));
+    if (!idec) {
+        return kInvalidInput;
+    }
+
+    switch (WebPIUpdate(idec, frame.fragment.bytes, frame.fragment.size)) {
+        case VP8_STATUS_OK:
+            return kSuccess;
+        case VP8_STATUS_SUSPENDED: {
+            int rowsDecoded = 0;
+            if (!WebPIDecGetYUVA(idec, &rowsDecoded, nullptr, nullptr, nullptr, nullptr, nullptr,
+                                 nullptr, nullptr, nullptr) || rowsDecoded <= 0) {
+                return kInvalidInput;
+            }
+            fill_incomplete_planes(yuvaPixmaps, rowsDecoded);
+            return kIncompleteInput;
+        }
+        default:
+            return kInvalidInput;
+    }
+}
+
 SkWebpCodec::SkWebpCodec(SkEncodedInfo&& info, std::unique_ptr<SkStream> stream,
                          WebPDemuxer* demux, sk_sp<SkData> data, SkEncodedOrigin origin)
     : INHERITED(std::move(info), skcms_PixelFormat_BGRA_8888, std::move(stream),
@@ -13,6 +13,7 @@
 #include "include/core/SkEncodedImageFormat.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkTypes.h"
+#include "include/core/SkYUVAPixmaps.h"
 #include "include/private/SkEncodedInfo.h"
 #include "include/private/base/SkTemplates.h"
 #include "src/codec/SkFrameHolder.h"
@@ -43,6 +44,11 @@ protected:
 
     bool onGetValidSubset(SkIRect* /* desiredSubset */) const override;
 
+    bool onQueryYUVAInfo(const SkYUVAPixmapInfo::SupportedDataTypes&,
+                         SkYUVAPixmapInfo*) const override;
+
+    Result onGetYUVAPlanes(const SkYUVAPixmaps& yuvaPixmaps) override;
+
     int onGetFrameCount() override;
     bool onGetFrameInfo(int, FrameInfo*) const override;
     int onGetRepetitionCount() override;
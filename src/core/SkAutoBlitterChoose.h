@@ -44,6 +44,7 @@ public:
                                      drawCoverage,
                                      draw.fRC->clipShader(),
                                      SkSurfacePropsCopyOrDefault(draw.fProps));
+        fBlitter = draw.clipBlitter(fBlitter, &fAlloc);
         return fBlitter;
     }
 
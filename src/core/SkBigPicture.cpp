@@ -52,6 +52,15 @@ void SkBigPicture::partialPlayback(SkCanvas* canvas,
                         initialCTM);
 }
 
+const SkRect* SkBigPicture::opBounds() const {
+    fOpBoundsOnce([this] {
+        fOpBounds.reset(fRecord->count());
+        skia_private::AutoTMalloc<SkBBoxHierarchy::Metadata> meta(fRecord->count());
+        SkRecordFillBounds(fCullRect, *fRecord, fOpBounds.get(), meta.get());
+    });
+    return fOpBounds.get();
+}
+
 struct NestedApproxOpCounter {
     int fCount = 0;
 
@@ -59,6 +59,8 @@ public:
 // Used by GrRecordReplaceDraw
     const SkBBoxHierarchy* bbh() const { return fBBH.get(); }
     const SkRecord*     record() const { return fRecord.get(); }
+// Used by SkPictureDamage. The bounds of each op of record(), computed on first use.
+    const SkRect* opBounds() const;
 
 private:
     int drawableCount() const;
@@ -69,6 +71,9 @@ private:
     sk_sp<const SkRecord>                fRecord;
     std::unique_ptr<const SnapshotArray> fDrawablePicts;
     sk_sp<const SkBBoxHierarchy>         fBBH;
+
+    mutable SkOnce                                fOpBoundsOnce;
+    mutable skia_private::AutoTMalloc<SkRect>     fOpBounds;
 };
 
 #endif//SkBigPicture_DEFINED
@@ -59,6 +59,7 @@ class SkDrawTiler {
     // fCurr... are only used if fNeedTiling
     SkTLazy<SkPostTranslateMatrixProvider> fTileMatrixProvider;
     SkRasterClip                           fTileRC;
+    SkIRect                                fTileBlitClip;
     SkIPoint                               fOrigin;
 
     bool            fDone, fNeedsTiling;
@@ -117,6 +118,7 @@ public:
             fDraw.fDst = fRootPixmap;
             fDraw.fMatrixProvider = dev;
             fDraw.fRC = &dev->fRCStack.rc();
+            fDraw.fBlitClip = dev->fBlitClip ? &*dev->fBlitClip : nullptr;
             fOrigin.set(0, 0);
         }
 
@@ -173,6 +175,15 @@ private:
         fDevice->fRCStack.rc().translate(-fOrigin.x(), -fOrigin.y(), &fTileRC);
         fTileRC.op(SkIRect::MakeWH(fDraw.fDst.width(), fDraw.fDst.height()),
                    SkClipOp::kIntersect);
+
+        if (fDevice->fBlitClip) {
+            fTileBlitClip = fDevice->fBlitClip->makeOffset(-fOrigin.x(), -fOrigin.y());
+            if (fTileBlitClip.intersect(fTileRC.getBounds())) {
+                fDraw.fBlitClip = &fTileBlitClip;
+            } else {
+                fTileRC.setEmpty();  // nothing this tile draws would be written
+            }
+        }
     }
 };
 
@@ -197,6 +208,7 @@ public:
         }
         fMatrixProvider = dev;
         fRC = &dev->fRCStack.rc();
+        fBlitClip = dev->fBlitClip ? &*dev->fBlitClip : nullptr;
     }
 };
 
@@ -585,6 +597,7 @@ void SkBitmapDevice::drawSpecial(SkSpecialImage* src,
         }
         draw.fMatrixProvider = &matrixProvider;
         draw.fRC = &fRCStack.rc();
+        draw.fBlitClip = fBlitClip ? &*fBlitClip : nullptr;
         draw.drawBitmap(resultBM, SkMatrix::I(), nullptr, sampling, paint);
     }
 }
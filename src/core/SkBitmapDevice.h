@@ -20,6 +20,8 @@
 #include "src/core/SkRasterClip.h"
 #include "src/core/SkRasterClipStack.h"
 
+#include <optional>
+
 class SkImageFilterCache;
 class SkMatrix;
 class SkPaint;
@@ -61,6 +63,13 @@ public:
     static SkBitmapDevice* Create(const SkImageInfo&, const SkSurfaceProps&,
                                   SkRasterHandleAllocator* = nullptr);
 
+    /**
+     *  Restricts every pixel this device writes to rect (in device space). Unlike a clip, this
+     *  does not change how geometry is scan converted, so the pixels inside rect are exactly
+     *  those a device without it would produce. Layers made from this device are not affected.
+     */
+    void setBlitClip(const SkIRect& rect) { fBlitClip = rect; }
+
 protected:
     void* getRasterHandle() const override { return fRasterHandle; }
 
@@ -157,6 +166,7 @@ private:
     SkBitmap    fBitmap;
     void*       fRasterHandle = nullptr;
     SkRasterClipStack  fRCStack;
+    std::optional<SkIRect> fBlitClip;
     SkGlyphRunListPainterCPU fGlyphPainter;
 
 
@@ -7,10 +7,14 @@
 
 #include "include/private/chromium/SkChromeRemoteGlyphCache.h"
 
+#include "include/core/SkData.h"
 #include "include/core/SkDrawable.h"
+#include "include/core/SkFontArguments.h"
 #include "include/core/SkSpan.h"
+#include "include/core/SkStream.h"
 #include "include/core/SkTypeface.h"
 #include "include/private/SkChecksum.h"
+#include "include/private/base/SkTo.h"
 #include "src/base/SkTLazy.h"
 #include "src/core/SkDevice.h"
 #include "src/core/SkDistanceFieldGen.h"
@@ -18,6 +22,8 @@
 #include "src/core/SkEnumerate.h"
 #include "src/core/SkGlyph.h"
 #include "src/core/SkReadBuffer.h"
+#include "src/core/SkScalerContext.h"
+#include "src/core/SkStreamPriv.h"
 #include "src/core/SkStrike.h"
 #include "src/core/SkStrikeCache.h"
 #include "src/core/SkTHash.h"
@@ -28,12 +34,14 @@
 
 #include <algorithm>
 #include <bitset>
+#include <cstring>
 #include <iterator>
 #include <memory>
 #include <new>
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 
 #if defined(SK_GANESH)
 #include "include/gpu/GrContextOptions.h"
@@ -1091,3 +1099,319 @@ sk_sp<sktext::gpu::Slug> SkStrikeClient::deserializeSlug(const void* data, size_
     return sktext::gpu::Slug::Deserialize(data, size, this);
 }
 #endif  // defined(SK_GANESH)
+
+// -- SkStrikeCache snapshots ----------------------------------------------------------------------
+namespace {
+constexpr uint32_t kSnapshotMagic = SkSetFourByteTag('s', 'k', 's', 's');
+constexpr uint32_t kSnapshotVersion = 2;
+
+using VariationCoordinate = SkFontArguments::VariationPosition::Coordinate;
+
+// What a snapshot records about a typeface to check that a typeface in a later process has the
+// same glyphs. The start of the 'head' table holds the font revision, checksum and dates. Fonts
+// without tables, or whose tables don't identify them, are told apart by their serialized
+// descriptor and variation design position, which follow this in the snapshot.
+struct SnapshotTypeface {
+    SkTypefaceID fTypefaceID{0};
+    int32_t      fGlyphCount{0};
+    int32_t      fUnitsPerEm{0};
+    uint32_t     fTables{0};  // A hash of every table's tag and size.
+    uint8_t      fHead[36]{};
+
+    static SnapshotTypeface Make(const SkTypeface& typeface) {
+        SnapshotTypeface snapshot;
+        snapshot.fTypefaceID = typeface.uniqueID();
+        snapshot.fGlyphCount = typeface.countGlyphs();
+        snapshot.fUnitsPerEm = typeface.getUnitsPerEm();
+        typeface.getTableData(SkSetFourByteTag('h', 'e', 'a', 'd'), 0, sizeof(fHead),
+                              snapshot.fHead);
+
+        std::vector<SkFontTableTag> tags(std::max(typeface.countTables(), 0));
+        tags.resize(std::max(typeface.getTableTags(tags.data()), 0));
+        for (SkFontTableTag tag : tags) {
+            snapshot.fTables = SkChecksum::Mix(snapshot.fTables ^ tag);
+            snapshot.fTables = SkChecksum::Mix(
+                    snapshot.fTables ^ SkToU32(typeface.getTableSize(tag)));
+        }
+        return snapshot;
+    }
+
+    bool hasSameGlyphs(const SnapshotTypeface& that) const {
+        return fGlyphCount == that.fGlyphCount &&
+               fUnitsPerEm == that.fUnitsPerEm &&
+               fTables == that.fTables &&
+               memcmp(fHead, that.fHead, sizeof(fHead)) == 0;
+    }
+};
+
+// A typeface of this process, with everything readSnapshot() compares to a snapshot typeface.
+struct SnapshotTypefaceIdentity {
+    SnapshotTypeface                 fTypeface;
+    sk_sp<SkData>                    fDescriptor;
+    std::vector<VariationCoordinate> fCoordinates;
+
+    static SnapshotTypefaceIdentity Make(const SkTypeface& typeface) {
+        SnapshotTypefaceIdentity identity;
+        identity.fTypeface = SnapshotTypeface::Make(typeface);
+        identity.fDescriptor = typeface.serialize(SkTypeface::SerializeBehavior::kDontIncludeData);
+        identity.fCoordinates.resize(
+                std::max(typeface.getVariationDesignPosition(nullptr, 0), 0));
+        const int count = typeface.getVariationDesignPosition(
+                identity.fCoordinates.data(), SkToInt(identity.fCoordinates.size()));
+        identity.fCoordinates.resize(std::max(count, 0));
+        return identity;
+    }
+
+    bool matches(const SnapshotTypeface& typeface,
+                 SkSpan<const uint8_t> descriptor,
+                 SkSpan<const VariationCoordinate> coordinates) const {
+        return fTypeface.hasSameGlyphs(typeface) &&
+               fDescriptor->size() == descriptor.size() &&
+               memcmp(fDescriptor->data(), descriptor.data(), descriptor.size()) == 0 &&
+               fCoordinates.size() == coordinates.size() &&
+               std::equal(fCoordinates.begin(), fCoordinates.end(), coordinates.begin(),
+                          [](const VariationCoordinate& a, const VariationCoordinate& b) {
+                              return a.axis == b.axis && a.value == b.value;
+                          });
+    }
+};
+
+enum SnapshotGlyphFlags : uint8_t {
+    kHasImage_SnapshotGlyphFlag       = 1 << 0,
+    kHasPath_SnapshotGlyphFlag        = 1 << 1,
+    kPathIsHairline_SnapshotGlyphFlag = 1 << 2,
+};
+}  // namespace
+
+void SkStrikeCache::writeSnapshot(SkWStream* stream) const {
+    // Strikes made with effects can't be recreated from their descriptor alone.
+    std::vector<sk_sp<SkStrike>> strikes;
+    this->forEachStrike([&](const SkStrike& strike) {
+        if (strike.getDescriptor().findEntry(kEffects_SkDescriptorTag, nullptr) == nullptr) {
+            strikes.push_back(sk_ref_sp(&strike));
+        }
+    });
+
+    SkTHashMap<SkTypefaceID, sk_sp<SkTypeface>> typefaces;
+    for (const sk_sp<SkStrike>& strike : strikes) {
+        const SkTypeface& typeface = strike->strikeSpec().typeface();
+        typefaces.set(typeface.uniqueID(), sk_ref_sp(&typeface));
+    }
+
+    std::vector<uint8_t> memory;
+    Serializer serializer(&memory);
+    serializer.write<uint32_t>(kSnapshotMagic);
+    serializer.write<uint32_t>(kSnapshotVersion);
+
+    serializer.write<uint64_t>(typefaces.count());
+    typefaces.foreach([&](SkTypefaceID, sk_sp<SkTypeface>* typeface) {
+        SnapshotTypefaceIdentity identity = SnapshotTypefaceIdentity::Make(**typeface);
+        serializer.write<SnapshotTypeface>(identity.fTypeface);
+        serializer.write<uint64_t>(identity.fDescriptor->size());
+        memcpy(serializer.allocate(identity.fDescriptor->size(), 1),
+               identity.fDescriptor->data(), identity.fDescriptor->size());
+        const size_t coordinatesSize =
+                identity.fCoordinates.size() * sizeof(VariationCoordinate);
+        serializer.write<uint64_t>(identity.fCoordinates.size());
+        memcpy(serializer.allocate(coordinatesSize, alignof(VariationCoordinate)),
+               identity.fCoordinates.data(), coordinatesSize);
+    });
+
+    serializer.write<uint64_t>(strikes.size());
+    for (const sk_sp<SkStrike>& strike : strikes) {
+        serializer.write<SkTypefaceID>(strike->strikeSpec().typeface().uniqueID());
+        serializer.writeDescriptor(strike->getDescriptor());
+        serializer.write<SkFontMetrics>(strike->getFontMetrics());
+
+        // The count is only known after visiting the glyphs under the strike's lock.
+        size_t glyphCountOffset = static_cast<uint8_t*>(
+                serializer.allocate(sizeof(uint64_t), serialization_alignment<uint64_t>())) -
+                memory.data();
+        uint64_t glyphCount = 0;
+        strike->forEachGlyph([&](const SkGlyph& glyph) {
+            const SkPath* path = glyph.setPathHasBeenCalled() ? glyph.path() : nullptr;
+            uint8_t flags = 0;
+            if (glyph.fImage != nullptr) {
+                flags |= kHasImage_SnapshotGlyphFlag;
+            }
+            if (glyph.setPathHasBeenCalled()) {
+                flags |= kHasPath_SnapshotGlyphFlag;
+                if (path != nullptr && glyph.pathIsHairline()) {
+                    flags |= kPathIsHairline_SnapshotGlyphFlag;
+                }
+            }
+
+            write_glyph(glyph, &serializer);
+            serializer.write<uint16_t>(glyph.fScalerContextBits);
+            serializer.write<uint8_t>(flags);
+            if (flags & kHasImage_SnapshotGlyphFlag) {
+                memcpy(serializer.allocate(glyph.imageSize(), glyph.formatAlignment()),
+                       glyph.fImage, glyph.imageSize());
+            }
+            if (flags & kHasPath_SnapshotGlyphFlag) {
+                uint64_t pathSize = path != nullptr ? path->writeToMemory(nullptr) : 0;
+                serializer.write<uint64_t>(pathSize);
+                if (pathSize > 0) {
+                    path->writeToMemory(serializer.allocate(pathSize, kPathAlignment));
+                }
+            }
+            glyphCount += 1;
+        });
+        memcpy(&memory[glyphCountOffset], &glyphCount, sizeof(glyphCount));
+    }
+
+    stream->write(memory.data(), memory.size());
+}
+
+int SkStrikeCache::readSnapshot(SkStream* stream, SkSpan<const sk_sp<SkTypeface>> typefaces) {
+    sk_sp<SkData> data = SkCopyStreamToData(stream);
+    Deserializer deserializer(static_cast<const volatile char*>(data->data()), data->size());
+
+    uint32_t magic, version;
+    if (!deserializer.read<uint32_t>(&magic) || magic != kSnapshotMagic) { return -1; }
+    if (!deserializer.read<uint32_t>(&version)) { return -1; }
+    if (version != kSnapshotVersion) { return 0; }
+
+    // Map the typeface IDs of the writing process to typefaces with the same glyphs in this one.
+    std::vector<SnapshotTypefaceIdentity> candidates;
+    for (const sk_sp<SkTypeface>& typeface : typefaces) {
+        candidates.push_back(SnapshotTypefaceIdentity::Make(*typeface));
+    }
+    SkTHashMap<SkTypefaceID, sk_sp<SkTypeface>> localTypefaces;
+    uint64_t typefaceCount;
+    if (!deserializer.read<uint64_t>(&typefaceCount)) { return -1; }
+    for (uint64_t i = 0; i < typefaceCount; ++i) {
+        SnapshotTypeface snapshot;
+        uint64_t size, coordinateCount;
+        if (!deserializer.read<SnapshotTypeface>(&snapshot)) { return -1; }
+        if (!deserializer.read<uint64_t>(&size)) { return -1; }
+        auto* serialized = deserializer.read(size, 1);
+        if (!serialized) { return -1; }
+        if (!deserializer.read<uint64_t>(&coordinateCount)) { return -1; }
+        if (coordinateCount > data->size() / sizeof(VariationCoordinate)) {
+            return -1;
+        }
+        auto* coordinatesData = deserializer.read(coordinateCount * sizeof(VariationCoordinate),
+                                                  alignof(VariationCoordinate));
+        if (!coordinatesData) { return -1; }
+        std::vector<VariationCoordinate> coordinates(coordinateCount);
+        memcpy(coordinates.data(), const_cast<const void*>(coordinatesData),
+               coordinateCount * sizeof(VariationCoordinate));
+        SkSpan<const uint8_t> descriptor{
+                static_cast<const uint8_t*>(const_cast<const void*>(serialized)), size};
+
+        sk_sp<SkTypeface> local;
+        for (size_t j = 0; j < candidates.size() && !local; ++j) {
+            if (candidates[j].matches(snapshot, descriptor, coordinates)) {
+                local = typefaces[j];
+            }
+        }
+        if (!local) {
+            SkMemoryStream typefaceStream(descriptor.data(), descriptor.size());
+            local = SkTypeface::MakeDeserialize(&typefaceStream);
+            if (local && !SnapshotTypefaceIdentity::Make(*local).matches(snapshot, descriptor,
+                                                                         coordinates)) {
+                local = nullptr;
+            }
+        }
+        if (local) {
+            localTypefaces.set(snapshot.fTypefaceID, std::move(local));
+        }
+    }
+
+    int strikesLoaded = 0;
+    uint64_t strikeCount;
+    if (!deserializer.read<uint64_t>(&strikeCount)) { return -1; }
+    for (uint64_t i = 0; i < strikeCount; ++i) {
+        SkTypefaceID typefaceID;
+        SkAutoDescriptor ad;
+        SkFontMetrics fontMetrics;
+        uint64_t glyphCount;
+        if (!deserializer.read<SkTypefaceID>(&typefaceID)) { return -1; }
+        if (!deserializer.readDescriptor(&ad)) { return -1; }
+        if (!deserializer.read<SkFontMetrics>(&fontMetrics)) { return -1; }
+        if (!deserializer.read<uint64_t>(&glyphCount)) { return -1; }
+
+        // The glyphs of strikes that are not loaded are still read to skip over them.
+        sk_sp<SkStrike> strike;
+        if (sk_sp<SkTypeface>* typeface = localTypefaces.find(typefaceID)) {
+            SkDescriptor* desc = ad.getDesc();
+            uint32_t size;
+            void* ptr = const_cast<void*>(desc->findEntry(kRec_SkDescriptorTag, &size));
+            SkScalerContextRec rec;
+            if (ptr == nullptr || size != sizeof(rec)) { return -1; }
+            std::memcpy((void*)&rec, ptr, size);
+            rec.fTypefaceID = (*typeface)->uniqueID();
+            std::memcpy(ptr, &rec, size);
+            desc->computeChecksum();
+
+            // Leave strikes that this process has already started alone. Other threads may be
+            // looking the strike up, so find and create it under one hold of the shard's lock.
+            SkStrikeSpec strikeSpec{*desc, *typeface};
+            Shard& shard = this->shardFor(strikeSpec.descriptor());
+            bool created;
+            {
+                SkAutoMutexExclusive ac(shard.fLock);
+                strike = this->internalFindOrCreateStrike(shard, strikeSpec, &fontMetrics,
+                                                          &created);
+            }
+            if (created) {
+                strikesLoaded += 1;
+            } else {
+                strike = nullptr;
+            }
+        }
+
+        for (uint64_t j = 0; j < glyphCount; ++j) {
+            SkPackedGlyphID packedID;
+            if (!deserializer.read<SkPackedGlyphID>(&packedID)) { return -1; }
+            SkGlyph glyph{packedID};
+            uint8_t maskFormat, flags;
+            if (!deserializer.read<float>(&glyph.fAdvanceX)) { return -1; }
+            if (!deserializer.read<float>(&glyph.fAdvanceY)) { return -1; }
+            if (!deserializer.read<uint16_t>(&glyph.fWidth)) { return -1; }
+            if (!deserializer.read<uint16_t>(&glyph.fHeight)) { return -1; }
+            if (!deserializer.read<int16_t>(&glyph.fTop)) { return -1; }
+            if (!deserializer.read<int16_t>(&glyph.fLeft)) { return -1; }
+            if (!deserializer.read<uint8_t>(&maskFormat)) { return -1; }
+            if (!SkMask::IsValidFormat(maskFormat)) { return -1; }
+            glyph.fMaskFormat = static_cast<SkMask::Format>(maskFormat);
+            if (!deserializer.read<uint16_t>(&glyph.fScalerContextBits)) { return -1; }
+            if (!deserializer.read<uint8_t>(&flags)) { return -1; }
+            SkDEBUGCODE(glyph.fAdvancesBoundsFormatAndInitialPathDone = true;)
+
+            if (flags & kHasImage_SnapshotGlyphFlag) {
+                if (glyph.isEmpty()) { return -1; }
+                auto* image = deserializer.read(glyph.imageSize(), glyph.formatAlignment());
+                if (!image) { return -1; }
+                glyph.fImage = (void*)image;
+            }
+
+            SkPath path;
+            const SkPath* pathPtr = nullptr;
+            if (flags & kHasPath_SnapshotGlyphFlag) {
+                uint64_t pathSize;
+                if (!deserializer.read<uint64_t>(&pathSize)) { return -1; }
+                if (pathSize > 0) {
+                    auto* pathData = deserializer.read(pathSize, kPathAlignment);
+                    if (!pathData) { return -1; }
+                    if (!path.readFromMemory(const_cast<const void*>(pathData), pathSize)) {
+                        return -1;
+                    }
+                    pathPtr = &path;
+                }
+            }
+
+            // Threads drawing with the new strike may have added this glyph already; theirs
+            // is kept.
+            if (strike != nullptr) {
+                strike->mergeGlyphIfAbsent(glyph, (flags & kHasPath_SnapshotGlyphFlag) != 0,
+                                           pathPtr,
+                                           (flags & kPathIsHairline_SnapshotGlyphFlag) != 0);
+            }
+        }
+    }
+
+    this->purgeIfNeeded();
+    return strikesLoaded;
+}
@@ -59,6 +59,15 @@ static SkPaint make_paint_with_image(const SkPaint& origPaint, const SkBitmap& b
 
 SkDraw::SkDraw() {}
 
+SkBlitter* SkDraw::clipBlitter(SkBlitter* blitter, SkArenaAlloc* alloc) const {
+    if (!fBlitClip || !blitter) {
+        return blitter;
+    }
+    SkRectClipBlitter* clipped = alloc->make<SkRectClipBlitter>();
+    clipped->init(blitter, *fBlitClip);
+    return clipped;
+}
+
 bool SkDraw::computeConservativeLocalClipBounds(SkRect* localBounds) const {
     if (fRC->isEmpty()) {
         return false;
@@ -821,6 +830,26 @@ void SkDraw::drawDevPath(const SkPath& devPath, const SkPaint& paint, bool drawC
     if (SkPathPriv::TooBigForMath(devPath)) {
         return;
     }
+
+    if (doFill && paint.isAntiAlias() && !customBlitter && !paint.getMaskFilter()) {
+        if (SkExecutor* executor = gSkRasterPathExecutor.load(std::memory_order_relaxed)) {
+            // Each band draws through its own blitter, on whichever thread picks it up.
+            auto makeBlitter = [&](SkArenaAlloc* alloc) {
+                return this->clipBlitter(SkBlitter::Choose(fDst,
+                                                           fMatrixProvider->localToDevice(),
+                                                           paint,
+                                                           alloc,
+                                                           drawCoverage,
+                                                           fRC->clipShader(),
+                                                           SkSurfacePropsCopyOrDefault(fProps)),
+                                         alloc);
+            };
+            if (SkScan::AntiFillPathBanded(devPath, *fRC, executor, makeBlitter)) {
+                return;
+            }
+        }
+    }
+
     SkBlitter* blitter = nullptr;
     SkAutoBlitterChoose blitterStorage;
     if (nullptr == customBlitter) {
@@ -1110,6 +1139,7 @@ void SkDraw::drawBitmap(const SkBitmap& bitmap, const SkMatrix& prematrix,
             SkBlitter* blitter = SkBlitter::ChooseSprite(fDst, *paint, pmap, ix, iy, &allocator,
                                                          fRC->clipShader());
             if (blitter) {
+                blitter = this->clipBlitter(blitter, &allocator);
                 SkScan::FillIRect(SkIRect::MakeXYWH(ix, iy, pmap.width(), pmap.height()),
                                   *fRC, blitter);
                 return;
@@ -1172,6 +1202,7 @@ void SkDraw::drawSprite(const SkBitmap& bitmap, int x, int y, const SkPaint& ori
         SkBlitter* blitter = SkBlitter::ChooseSprite(fDst, paint, pmap, x, y, &allocator,
                                                      fRC->clipShader());
         if (blitter) {
+            blitter = this->clipBlitter(blitter, &allocator);
             SkScan::FillIRect(bounds, *fRC, blitter);
             return;
         }
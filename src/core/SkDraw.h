@@ -17,6 +17,7 @@
 #include "src/core/SkGlyphRunPainter.h"
 #include "src/core/SkMask.h"
 
+class SkArenaAlloc;
 class SkBitmap;
 class SkClipStack;
 class SkBaseDevice;
@@ -125,6 +126,12 @@ public:
     static RectType ComputeRectType(const SkRect&, const SkPaint&, const SkMatrix&,
                                     SkPoint* strokeSize);
 
+    /**
+     *  If fBlitClip is set, returns a blitter allocated in alloc that forwards to blitter only
+     *  what falls inside fBlitClip. Otherwise returns blitter.
+     */
+    SkBlitter* clipBlitter(SkBlitter* blitter, SkArenaAlloc* alloc) const;
+
 private:
 #if defined(SK_SUPPORT_LEGACY_ALPHA_BITMAP_AS_COVERAGE)
     void drawBitmapAsMask(const SkBitmap&, const SkSamplingOptions&, const SkPaint&) const;
@@ -167,6 +174,9 @@ public:
     const SkMatrixProvider* fMatrixProvider{nullptr};  // required
     const SkRasterClip*     fRC{nullptr};              // required
     const SkSurfaceProps*   fProps{nullptr};           // optional
+    // Restricts which pixels are written without changing fRC, so geometry is still scan
+    // converted against the full clip.
+    const SkIRect*          fBlitClip{nullptr};        // optional
 
 #ifdef SK_DEBUG
     void validate() const;
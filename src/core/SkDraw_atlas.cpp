@@ -152,6 +152,7 @@ void SkDraw::drawAtlas(const SkRSXform xform[],
         if (!blitter) {
             return false;
         }
+        SkBlitter* clippedBlitter = this->clipBlitter(blitter, &alloc);
         SkPath scratchPath;
 
         for (int i = 0; i < count; ++i) {
@@ -166,7 +167,7 @@ void SkDraw::drawAtlas(const SkRSXform xform[],
             mx.preTranslate(-textures[i].fLeft, -textures[i].fTop);
             mx.postConcat(ctm);
             if (transformShader->update(mx)) {
-                fill_rect(mx, *fRC, textures[i], blitter, &scratchPath);
+                fill_rect(mx, *fRC, textures[i], clippedBlitter, &scratchPath);
             }
         }
         return true;
@@ -190,6 +191,7 @@ void SkDraw::drawAtlas(const SkRSXform xform[],
                                              SkMatrix::I(),
                                              &alloc,
                                              fRC->clipShader())) {
+            SkBlitter* clippedBlitter = this->clipBlitter(blitter, &alloc);
             SkPath scratchPath;
             for (int i = 0; i < count; ++i) {
                 if (colorShader) {
@@ -201,7 +203,7 @@ void SkDraw::drawAtlas(const SkRSXform xform[],
                 mx.preTranslate(-textures[i].fLeft, -textures[i].fTop);
                 mx.postConcat(ctm);
                 if (transformShader->update(mx)) {
-                    fill_rect(mx, *fRC, textures[i], blitter, &scratchPath);
+                    fill_rect(mx, *fRC, textures[i], clippedBlitter, &scratchPath);
                 }
             }
         }
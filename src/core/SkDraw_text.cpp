@@ -46,6 +46,7 @@ void SkDraw::paintMasks(SkZip<const SkGlyph*, SkPoint> accepted, const SkPaint&
                                            false,
                                            fRC->clipShader(),
                                            SkSurfacePropsCopyOrDefault(fProps));
+    blitter = this->clipBlitter(blitter, &alloc);
 
     SkAAClipBlitterWrapper wrapper{*fRC, blitter};
     blitter = wrapper.getBlitter();
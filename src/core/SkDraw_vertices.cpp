@@ -427,6 +427,7 @@ void SkDraw::drawFixedVertices(const SkVertices* vertices,
         if (!blitter) {
             return false;
         }
+        SkBlitter* clippedBlitter = this->clipBlitter(blitter, outerAlloc);
         while (vertProc(&state)) {
             if (triColorShader && !triColorShader->update(ctmInverse, positions, dstColors,
                                                           state.f0, state.f1, state.f2)) {
@@ -436,7 +437,7 @@ void SkDraw::drawFixedVertices(const SkVertices* vertices,
             SkMatrix localM;
             if (!transformShader || (texture_to_matrix(state, positions, texCoords, &localM) &&
                                      transformShader->update(SkMatrix::Concat(ctm, localM)))) {
-                fill_triangle(state, blitter, *fRC, dev2, dev3);
+                fill_triangle(state, clippedBlitter, *fRC, dev2, dev3);
             }
         }
         return true;
@@ -454,6 +455,7 @@ void SkDraw::drawFixedVertices(const SkVertices* vertices,
         if (!blitter) {
             return;
         }
+        SkBlitter* clippedBlitter = this->clipBlitter(blitter, outerAlloc);
         while (vertProc(&state)) {
             SkMatrix localM;
             if (transformShader && !(texture_to_matrix(state, positions, texCoords, &localM) &&
@@ -466,7 +468,7 @@ void SkDraw::drawFixedVertices(const SkVertices* vertices,
                 continue;
             }
 
-            fill_triangle(state, blitter, *fRC, dev2, dev3);
+            fill_triangle(state, clippedBlitter, *fRC, dev2, dev3);
         }
     }
 }
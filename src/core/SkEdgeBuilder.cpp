@@ -375,14 +375,20 @@ int SkEdgeBuilder::build(const SkPath& path, const SkIRect* iclip, bool canCullT
 
 int SkEdgeBuilder::buildEdges(const SkPath& path,
                               const SkIRect* shiftedClip) {
+    return this->buildEdges(path, path, shiftedClip);
+}
+
+int SkEdgeBuilder::buildEdges(const SkPath& contours,
+                              const SkPath& wholePath,
+                              const SkIRect* shiftedClip) {
     // If we're convex, then we need both edges, even if the right edge is past the clip.
-    const bool canCullToTheRight = !path.isConvex();
+    const bool canCullToTheRight = !wholePath.isConvex();
 
     // We can use our buildPoly() optimization if all the segments are lines.
     // (Edges are homogeneous and stored contiguously in memory, no need for indirection.)
-    const int count = SkPath::kLine_SegmentMask == path.getSegmentMasks()
-        ? this->buildPoly(path, shiftedClip, canCullToTheRight)
-        : this->build    (path, shiftedClip, canCullToTheRight);
+    const int count = SkPath::kLine_SegmentMask == wholePath.getSegmentMasks()
+        ? this->buildPoly(contours, shiftedClip, canCullToTheRight)
+        : this->build    (contours, shiftedClip, canCullToTheRight);
 
     SkASSERT(count >= 0);
 
@@ -23,6 +23,12 @@ public:
     int buildEdges(const SkPath& path,
                    const SkIRect* shiftedClip);
 
+    // Builds the edges of contours, a run of consecutive contours taken from wholePath, exactly as
+    // buildEdges(wholePath, shiftedClip) would have built them.
+    int buildEdges(const SkPath& contours,
+                   const SkPath& wholePath,
+                   const SkIRect* shiftedClip);
+
 protected:
     SkEdgeBuilder() = default;
     virtual ~SkEdgeBuilder() = default;
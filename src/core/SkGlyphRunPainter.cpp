@@ -50,16 +50,15 @@ prepare_for_path_drawing(SkStrike* strike,
                          SkZip<SkGlyphID, SkPoint> rejectedBuffer) {
     int acceptedSize = 0;
     int rejectedSize = 0;
-    strike->lock();
     for (auto [glyphID, pos] : source) {
         if (!SkScalarsAreFinite(pos.x(), pos.y())) {
             continue;
         }
         const SkPackedGlyphID packedID{glyphID};
-        switch (SkGlyphDigest digest = strike->digestFor(kPath, packedID);
-                digest.actionFor(kPath)) {
+        auto [digest, glyph] = strike->digestAndGlyphFor(kPath, packedID);
+        switch (digest.actionFor(kPath)) {
             case GlyphAction::kAccept:
-                acceptedBuffer[acceptedSize++] = std::make_tuple(strike->glyph(digest), pos);
+                acceptedBuffer[acceptedSize++] = std::make_tuple(glyph, pos);
                 break;
             case GlyphAction::kReject:
                 rejectedBuffer[rejectedSize++] = std::make_tuple(glyphID, pos);
@@ -68,7 +67,6 @@ prepare_for_path_drawing(SkStrike* strike,
                 break;
         }
     }
-    strike->unlock();
     return {acceptedBuffer.first(acceptedSize), rejectedBuffer.first(rejectedSize)};
 }
 
@@ -81,16 +79,15 @@ prepare_for_drawable_drawing(SkStrike* strike,
                              SkZip<SkGlyphID, SkPoint> rejectedBuffer) {
     int acceptedSize = 0;
     int rejectedSize = 0;
-    strike->lock();
     for (auto [glyphID, pos] : source) {
         if (!SkScalarsAreFinite(pos.x(), pos.y())) {
             continue;
         }
         const SkPackedGlyphID packedID{glyphID};
-        switch (SkGlyphDigest digest = strike->digestFor(kDrawable, packedID);
-                digest.actionFor(kDrawable)) {
+        auto [digest, glyph] = strike->digestAndGlyphFor(kDrawable, packedID);
+        switch (digest.actionFor(kDrawable)) {
             case GlyphAction::kAccept:
-                acceptedBuffer[acceptedSize++] = std::make_tuple(strike->glyph(digest), pos);
+                acceptedBuffer[acceptedSize++] = std::make_tuple(glyph, pos);
                 break;
             case GlyphAction::kReject:
                 rejectedBuffer[rejectedSize++] = std::make_tuple(glyphID, pos);
@@ -99,7 +96,6 @@ prepare_for_drawable_drawing(SkStrike* strike,
                 break;
         }
     }
-    strike->unlock();
     return {acceptedBuffer.first(acceptedSize), rejectedBuffer.first(rejectedSize)};
 }
 
@@ -119,7 +115,6 @@ prepare_for_direct_mask_drawing(SkStrike* strike,
 
     int acceptedSize = 0;
     int rejectedSize = 0;
-    strike->lock();
     for (auto [glyphID, pos] : source) {
         if (!SkScalarsAreFinite(pos.x(), pos.y())) {
             continue;
@@ -127,13 +122,12 @@ prepare_for_direct_mask_drawing(SkStrike* strike,
 
         const SkPoint mappedPos = positionMatrixWithRounding.mapPoint(pos);
         const SkPackedGlyphID packedGlyphID = SkPackedGlyphID{glyphID, mappedPos, mask};
-        switch (SkGlyphDigest digest = strike->digestFor(kDirectMaskCPU, packedGlyphID);
-                digest.actionFor(kDirectMaskCPU)) {
+        auto [digest, glyph] = strike->digestAndGlyphFor(kDirectMaskCPU, packedGlyphID);
+        switch (digest.actionFor(kDirectMaskCPU)) {
             case GlyphAction::kAccept: {
                 const SkPoint roundedPos{SkScalarFloorToScalar(mappedPos.x()),
                                          SkScalarFloorToScalar(mappedPos.y())};
-                acceptedBuffer[acceptedSize++] =
-                        std::make_tuple(strike->glyph(digest), roundedPos);
+                acceptedBuffer[acceptedSize++] = std::make_tuple(glyph, roundedPos);
                 break;
             }
             case GlyphAction::kReject:
@@ -143,7 +137,6 @@ prepare_for_direct_mask_drawing(SkStrike* strike,
                 break;
         }
     }
-    strike->unlock();
 
     return {acceptedBuffer.first(acceptedSize), rejectedBuffer.first(rejectedSize)};
 }
@@ -8,6 +8,7 @@
 #include "src/core/SkMaskBlurFilter.h"
 
 #include "include/core/SkColorPriv.h"
+#include "include/core/SkExecutor.h"
 #include "include/private/base/SkTPin.h"
 #include "include/private/base/SkTemplates.h"
 #include "src/base/SkVx.h"
@@ -15,9 +16,13 @@
 #include "include/private/base/SkTo.h"
 #include "src/base/SkArenaAlloc.h"
 #include "src/core/SkGaussFilter.h"
+#include "src/core/SkScan.h"
+#include "src/core/SkTaskGroup.h"
 
+#include <atomic>
 #include <cmath>
 #include <climits>
+#include <functional>
 
 namespace {
 static const double kPi = 3.14159265358979323846264338327950288;
@@ -227,6 +232,109 @@ public:
             buffer2, buffer2End);
     }
 
+    // Rows are blurred kLanes at a time, one per SIMD lane, by blurRows().
+    static constexpr int kLanes = 8;
+
+    // Whether blurRows() can blur rows this wide. (A window of one has empty pass buffers.)
+    bool canBlurRows(int width) const {
+        return width > 0 && fPass0Size > 0 && fPass1Size > 0 && fPass2Size > 0;
+    }
+
+    // Blurs kLanes rows of A8 values, starting at src and rowBytes apart, exactly like
+    // makeBlurScan(width, ...).blur() would blur each of them. Blurred row i is written to
+    // dst[i], dst[i + dstStride], ... for dstCount values, so the kLanes values written for each
+    // position are contiguous. buffer must have room for bufferSize() * kLanes values.
+    void blurRows(const uint8_t* src, size_t rowBytes, int width,
+                  uint8_t* dst, size_t dstStride, int dstCount, uint32_t* buffer) const {
+        SkASSERT(this->canBlurRows(width));
+        using U32 = skvx::Vec<kLanes, uint32_t>;
+        using U64 = skvx::Vec<kLanes, uint64_t>;
+
+        // Positions are blurred kBlock at a time. Each lane holds kBlock values of its row, one
+        // per byte, so unpacking the inputs and packing the outputs are just shifts and masks.
+        constexpr int kBlock = 4;
+
+        // The values of each row at x, ... x + n - 1, or 0 past the end of the rows.
+        auto load = [&](int x, int n) {
+            uint32_t edges[kLanes];
+            const uint8_t* row = src + x;
+            if (n == kBlock && x + kBlock <= width) {
+                for (int i = 0; i < kLanes; i++, row += rowBytes) {
+                    edges[i] = row[0] | row[1] << 8 | row[2] << 16 | (uint32_t)row[3] << 24;
+                }
+            } else {
+                for (int i = 0; i < kLanes; i++, row += rowBytes) {
+                    edges[i] = 0;
+                    for (int j = 0; j < n && x + j < width; j++) {
+                        edges[i] |= (uint32_t)row[j] << (8 * j);
+                    }
+                }
+            }
+            return U32::Load(edges);
+        };
+
+        // Writes the n values of each row in blurred to dst at position p, ... p + n - 1.
+        auto store = [&](const U32& blurred, int p, int n) {
+            uint32_t values[kLanes];
+            blurred.store(values);
+            for (int j = 0; j < n; j++) {
+                uint8_t* to = dst + (p + j) * dstStride;
+                for (int i = 0; i < kLanes; i++) {
+                    to[i] = (uint8_t)(values[i] >> (8 * j));
+                }
+            }
+        };
+
+        uint32_t* buffer0 = buffer;
+        uint32_t* buffer1 = buffer0 + fPass0Size * kLanes;
+        uint32_t* buffer2 = buffer1 + fPass1Size * kLanes;
+
+        // First consume the source generating values, and keep going while the leading edge is
+        // off the right side of the rows. Then, starting from the right, fill in the rest.
+        const int noChangeCount = fSlidingWindow > width ? fSlidingWindow - width : 0;
+        const int forwardCount = width + noChangeCount;
+        SkASSERT(forwardCount <= dstCount && dstCount - forwardCount <= width);
+        for (bool reverse : {false, true}) {
+            sk_bzero(buffer, this->bufferSize() * kLanes * sizeof(uint32_t));
+            int cursor0 = 0, cursor1 = 0, cursor2 = 0;
+            U32 sum0 = 0, sum1 = 0, sum2 = 0;
+
+            const int count = reverse ? dstCount - forwardCount : forwardCount;
+            for (int k = 0; k < count; k += kBlock) {
+                // The block's values are read from and written to the same byte of each lane.
+                const int n = std::min(kBlock, count - k),
+                          p = reverse ? dstCount - k - n : k;
+                const U32 edges = load(reverse ? width - k - n : k, n);
+                U32 blurred = 0;
+                for (int j = 0; j < n; j++) {
+                    // The same steps as Scan::blur(), for all the rows at once.
+                    const int shift = 8 * (reverse ? n - 1 - j : j);
+                    const U32 leadingEdge = (edges >> shift) & 0xff;
+                    sum0 += leadingEdge;
+                    sum1 += sum0;
+                    sum2 += sum1;
+
+                    const U64 scaled = (skvx::cast<uint64_t>(sum2) * fWeight + (1ull << 31)) >> 32;
+                    blurred |= skvx::cast<uint32_t>(scaled) << shift;
+
+                    sum2 -= U32::Load(buffer2 + cursor2 * kLanes);
+                    sum1.store(buffer2 + cursor2 * kLanes);
+                    cursor2 = cursor2 + 1 < fPass2Size ? cursor2 + 1 : 0;
+
+                    sum1 -= U32::Load(buffer1 + cursor1 * kLanes);
+                    sum0.store(buffer1 + cursor1 * kLanes);
+                    cursor1 = cursor1 + 1 < fPass1Size ? cursor1 + 1 : 0;
+
+                    sum0 -= U32::Load(buffer0 + cursor0 * kLanes);
+                    leadingEdge.store(buffer0 + cursor0 * kLanes);
+                    cursor0 = cursor0 + 1 < fPass0Size ? cursor0 + 1 : 0;
+                }
+                store(blurred, p, n);
+            }
+        }
+    }
+
+private:
     uint64_t fWeight;
     int      fBorder;
     int      fSlidingWindow;
@@ -294,6 +402,21 @@ static void argb32_to_a8(uint8_t* a8, const uint8_t* from, int width) {
 }
 using ToA8 = decltype(bw_to_a8);
 
+// Converts row y of a BW, ARGB32 or LCD16 mask to A8.
+static void to_a8(const SkMask& mask, int y, uint8_t* a8) {
+    const uint8_t* row = mask.fImage + y * mask.fRowBytes;
+    const int width = mask.fBounds.width();
+    for (int x = 0; x < width; x += 8) {
+        const int n = std::min(8, width - x);
+        switch (mask.fFormat) {
+            case SkMask::kBW_Format:     bw_to_a8(a8 + x, row + x / 8, n);     break;
+            case SkMask::kARGB32_Format: argb32_to_a8(a8 + x, row + 4 * x, n); break;
+            case SkMask::kLCD16_Format:  lcd_to_a8(a8 + x, row + 2 * x, n);    break;
+            default: SK_ABORT("Unhandled format.");
+        }
+    }
+}
+
 using fp88 = skvx::Vec<8, uint16_t>; // 8-wide fixed point 8.8
 
 static fp88 load(const uint8_t* from, int width, ToA8* toA8) {
@@ -950,9 +1073,26 @@ static SkIPoint small_blur(double sigmaX, double sigmaY, const SkMask& src, SkMa
     return {radiusX, radiusY};
 }
 
+// Masks with at least this many pixels are blurred in bands of rows in parallel, when
+// SkGraphics::SetRasterPathExecutor() has set an executor to do it on. Like banded path fills,
+// the output is the same either way.
+static constexpr int64_t kMinParallelBlurArea = 256 * 256;
+static constexpr int kMaxParallelBlurBands = 8;
+
+// For smaller sigmas the windows are short enough that blurring rows one at a time is as fast as
+// PlanGauss::blurRows(). It also only pays off for big masks: until the strided stores of the
+// scalar scans stop fitting in the cache, they cost less than blurRows() spends per group of rows.
+static constexpr double kMinBlurRowsSigma = 16;
+static constexpr int64_t kMinBlurRowsArea = 512 * 512;
+
+SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMask* dst) const {
+    return this->blur(src, dst, gSkRasterPathExecutor.load(std::memory_order_relaxed), true);
+}
+
 // TODO: assuming sigmaW = sigmaH. Allow different sigmas. Right now the
 // API forces the sigmas to be the same.
-SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMask* dst) const {
+SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMask* dst, SkExecutor* executor,
+                                bool blurRows) const {
 
     if (fSigmaW < 2.0 && fSigmaH < 2.0) {
         return small_blur(fSigmaW, fSigmaH, src, dst);
@@ -983,9 +1123,6 @@ SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMask* dst) const {
         dstH = dst->fBounds.height();
     SkASSERT(srcW >= 0 && srcH >= 0 && dstW >= 0 && dstH >= 0);
 
-    auto bufferSize = std::max(planW.bufferSize(), planH.bufferSize());
-    auto buffer = alloc.makeArrayDefault<uint32_t>(bufferSize);
-
     // Blur both directions.
     int tmpW = srcH,
         tmpH = dstW;
@@ -996,59 +1133,112 @@ SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMask* dst) const {
     }
     auto tmp = alloc.makeArrayDefault<uint8_t>(tmpW * tmpH);
 
-    // Blur horizontally, and transpose.
-    const PlanGauss::Scan& scanW = planW.makeBlurScan(srcW, buffer);
-    switch (src.fFormat) {
-        case SkMask::kBW_Format: {
-            const uint8_t* bwStart = src.fImage;
-            auto start = SkMask::AlphaIter<SkMask::kBW_Format>(bwStart, 0);
-            auto end = SkMask::AlphaIter<SkMask::kBW_Format>(bwStart + (srcW / 8), srcW % 8);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
-        } break;
-        case SkMask::kA8_Format: {
-            const uint8_t* a8Start = src.fImage;
-            auto start = SkMask::AlphaIter<SkMask::kA8_Format>(a8Start);
-            auto end = SkMask::AlphaIter<SkMask::kA8_Format>(a8Start + srcW);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
-        } break;
-        case SkMask::kARGB32_Format: {
-            const uint32_t* argbStart = reinterpret_cast<const uint32_t*>(src.fImage);
-            auto start = SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart);
-            auto end = SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart + srcW);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
+    // Big masks are blurred in bands of rows in parallel, if there's an executor to do it on.
+    // Each pass is split up separately, and each band has its own buffers.
+    constexpr int kLanes = PlanGauss::kLanes;
+    const int bands = executor && (int64_t)srcW * srcH >= kMinParallelBlurArea
+                    ? std::min(kMaxParallelBlurBands, std::max(srcH, dstW) / (4 * kLanes))
+                    : 1;
+    auto bufferSize = std::max(planW.bufferSize(), planH.bufferSize()) * kLanes;
+    auto buffers = alloc.makeArrayDefault<uint32_t>(bufferSize * std::max(bands, 1));
+    blurRows = blurRows && (int64_t)srcW * srcH >= kMinBlurRowsArea;
+    uint8_t* a8Rows = nullptr;
+    if (src.fFormat != SkMask::kA8_Format && blurRows && fSigmaW >= kMinBlurRowsSigma) {
+        a8Rows = alloc.makeArrayDefault<uint8_t>(kLanes * srcW * std::max(bands, 1));
+    }
+
+    auto forEachBand = [&](int rows, const std::function<void(int, int, int)>& blurRows) {
+        if (bands <= 1) {
+            blurRows(0, rows, 0);
+            return;
+        }
+        // Bands start on a multiple of kLanes rows, so only the last may have a ragged end.
+        const int groups = (rows + kLanes - 1) / kLanes;
+        SkTaskGroup tasks(*executor);
+        tasks.batch(bands, [&](int band) {
+            const int y0 = std::min(rows, groups *  band      / bands * kLanes),
+                      y1 = std::min(rows, groups * (band + 1) / bands * kLanes);
+            blurRows(y0, y1, band);
+        });
+        tasks.wait();
+    };
+
+    // Blur horizontally, and transpose. Each group of kLanes rows is blurred at once, which also
+    // makes each position's transposed values contiguous.
+    forEachBand(srcH, [&](int y0, int y1, int band) {
+        uint32_t* buffer = buffers + band * bufferSize;
+        int y = y0;
+        if (blurRows && fSigmaW >= kMinBlurRowsSigma && planW.canBlurRows(srcW)) {
+            for (; y + kLanes <= y1; y += kLanes) {
+                const uint8_t* rows = src.fImage + y * src.fRowBytes;
+                size_t rowBytes = src.fRowBytes;
+                if (a8Rows) {
+                    uint8_t* a8 = a8Rows + band * kLanes * srcW;
+                    for (int i = 0; i < kLanes; i++) {
+                        to_a8(src, y + i, a8 + i * srcW);
+                    }
+                    rows = a8;
+                    rowBytes = srcW;
+                }
+                planW.blurRows(rows, rowBytes, srcW, &tmp[y], tmpW, tmpH, buffer);
             }
-        } break;
-        case SkMask::kLCD16_Format: {
-            const uint16_t* lcdStart = reinterpret_cast<const uint16_t*>(src.fImage);
-            auto start = SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart);
-            auto end = SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart + srcW);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
+        }
+
+        const PlanGauss::Scan& scanW = planW.makeBlurScan(srcW, buffer);
+        for (; y < y1; ++y) {
+            const uint8_t* row = src.fImage + y * src.fRowBytes;
+            auto tmpStart = &tmp[y];
+            auto tmpEnd = tmpStart + tmpW * tmpH;
+            switch (src.fFormat) {
+                case SkMask::kBW_Format: {
+                    auto start = SkMask::AlphaIter<SkMask::kBW_Format>(row, 0);
+                    auto end = SkMask::AlphaIter<SkMask::kBW_Format>(row + (srcW / 8), srcW % 8);
+                    scanW.blur(start, end, tmpStart, tmpW, tmpEnd);
+                } break;
+                case SkMask::kA8_Format: {
+                    auto start = SkMask::AlphaIter<SkMask::kA8_Format>(row);
+                    auto end = SkMask::AlphaIter<SkMask::kA8_Format>(row + srcW);
+                    scanW.blur(start, end, tmpStart, tmpW, tmpEnd);
+                } break;
+                case SkMask::kARGB32_Format: {
+                    const uint32_t* argbRow = reinterpret_cast<const uint32_t*>(row);
+                    auto start = SkMask::AlphaIter<SkMask::kARGB32_Format>(argbRow);
+                    auto end = SkMask::AlphaIter<SkMask::kARGB32_Format>(argbRow + srcW);
+                    scanW.blur(start, end, tmpStart, tmpW, tmpEnd);
+                } break;
+                case SkMask::kLCD16_Format: {
+                    const uint16_t* lcdRow = reinterpret_cast<const uint16_t*>(row);
+                    auto start = SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdRow);
+                    auto end = SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdRow + srcW);
+                    scanW.blur(start, end, tmpStart, tmpW, tmpEnd);
+                } break;
+                default:
+                    SK_ABORT("Unhandled format.");
             }
-        } break;
-        default:
-            SK_ABORT("Unhandled format.");
-    }
+        }
+    });
 
     // Blur vertically (scan in memory order because of the transposition),
     // and transpose back to the original orientation.
-    const PlanGauss::Scan& scanH = planH.makeBlurScan(tmpW, buffer);
-    for (int y = 0; y < tmpH; y++) {
-        auto tmpStart = &tmp[y * tmpW];
-        auto dstStart = &dst->fImage[y];
+    forEachBand(tmpH, [&](int y0, int y1, int band) {
+        uint32_t* buffer = buffers + band * bufferSize;
+        int y = y0;
+        if (blurRows && fSigmaH >= kMinBlurRowsSigma && planH.canBlurRows(tmpW)) {
+            for (; y + kLanes <= y1; y += kLanes) {
+                planH.blurRows(&tmp[y * tmpW], tmpW, tmpW,
+                               &dst->fImage[y], dst->fRowBytes, dstH, buffer);
+            }
+        }
 
-        scanH.blur(tmpStart, tmpStart + tmpW,
-                   dstStart, dst->fRowBytes, dstStart + dst->fRowBytes * dstH);
-    }
+        const PlanGauss::Scan& scanH = planH.makeBlurScan(tmpW, buffer);
+        for (; y < y1; y++) {
+            auto tmpStart = &tmp[y * tmpW];
+            auto dstStart = &dst->fImage[y];
+
+            scanH.blur(tmpStart, tmpStart + tmpW,
+                       dstStart, dst->fRowBytes, dstStart + dst->fRowBytes * dstH);
+        }
+    });
 
     return {SkTo<int32_t>(borderW), SkTo<int32_t>(borderH)};
 }
@@ -15,6 +15,8 @@
 #include "include/core/SkTypes.h"
 #include "src/core/SkMask.h"
 
+class SkExecutor;
+
 // Implement a single channel Gaussian blur. The specifics for implementation are taken from:
 // https://drafts.fxtf.org/filters/#feGaussianBlurElement
 class SkMaskBlurFilter {
@@ -29,6 +31,11 @@ public:
     // Given a src SkMask, generate dst SkMask returning the border width and height.
     SkIPoint blur(const SkMask& src, SkMask* dst) const;
 
+    // As above, but big masks are blurred in bands on executor if it is not null, and, if
+    // blurRows, large sigmas blur several rows at a time. The output is the same either way.
+    // blur() above uses SkGraphics::SetRasterPathExecutor()'s executor and blurs rows.
+    SkIPoint blur(const SkMask& src, SkMask* dst, SkExecutor* executor, bool blurRows) const;
+
 private:
     const double fSigmaW;
     const double fSigmaH;
@@ -43,6 +43,7 @@
 #include "src/opts/SkBlitMask_opts.h"
 #include "src/opts/SkBlitRow_opts.h"
 #include "src/opts/SkChecksum_opts.h"
+#include "src/opts/SkPngFilter_opts.h"
 #include "src/opts/SkRasterPipeline_opts.h"
 #include "src/opts/SkSwizzler_opts.h"
 #include "src/opts/SkUtils_opts.h"
@@ -83,6 +84,9 @@ namespace SkOpts {
 
     DEFINE_DEFAULT(cubic_solver);
 
+    DEFINE_DEFAULT(png_filter_row);
+    DEFINE_DEFAULT(png_filter_sum);
+
     DEFINE_DEFAULT(hash_fn);
 
     DEFINE_DEFAULT(S32_alpha_D32_filter_DX);
@@ -13,6 +13,8 @@
 #include "src/core/SkRasterPipelineOpList.h"
 #include "src/core/SkXfermodePriv.h"
 
+#include <cstdlib>
+
 /**
  * SkOpts (short for SkOptimizations) is a mechanism where we can ship with multiple implementations
  * of a set of functions and dynamically choose the best one at runtime (e.g. the call to
@@ -105,6 +107,23 @@ namespace SkOpts {
 
     extern float (*cubic_solver)(float, float, float, float);
 
+    // PNG encoder row filters and libpng's heuristic for choosing between them.
+    extern void (*png_filter_row)(int filter, uint8_t dst[], const uint8_t row[],
+                                  const uint8_t prev[], size_t rowBytes, int bpp);
+    extern uint64_t (*png_filter_sum)(const uint8_t[], size_t);
+
+    // The Paeth filter's predictor for one byte from its left (a), above (b), and above-left (c)
+    // neighbors.  This is the scalar reference every png_filter_row() matches.
+    static inline uint8_t png_paeth_predictor(int a, int b, int c) {
+        int pa = abs(b - c),
+            pb = abs(a - c),
+            pc = abs(a + b - c - c);
+        if (pa <= pb && pa <= pc) {
+            return a;
+        }
+        return pb <= pc ? b : c;
+    }
+
     static inline uint32_t hash(const void* data, size_t bytes, uint32_t seed=0) {
         // hash_fn is defined in SkOpts_spi.h so it can be used by //modules
         return hash_fn(data, bytes, seed);
@@ -128,6 +147,20 @@ namespace SkOpts {
     extern size_t raster_pipeline_lowp_stride;
     extern size_t raster_pipeline_highp_stride;
 
+    // One instruction set's lowp stages, copied out without installing them in the tables above.
+    // Benchmarks use this to run the same pipeline through several instruction sets.
+    struct LowpStages {
+        StageFn ops[kNumRasterPipelineLowpOps];
+        StageFn just_return;
+        void (*start_pipeline)(size_t,size_t,size_t,size_t, SkRasterPipelineStage*);
+    };
+
+#if defined(SK_CPU_X86) && !defined(SK_ENABLE_OPTIMIZE_SIZE)
+    // Defined in src/opts/SkOpts_{hsw,skx}.cpp.  Only call these if SkCpu supports the target.
+    void GetLowpStages_hsw(LowpStages*);
+    void GetLowpStages_skx(LowpStages*);
+#endif
+
     extern void (*interpret_skvm)(const skvm::InterpreterInstruction insts[], int ninsts,
                                   int nregs, int loop, const int strides[],
                                   skvm::TraceHook* traceHooks[], int nTraceHooks,
@@ -13,6 +13,7 @@
 #include "include/private/base/SkTo.h"
 #include "src/base/SkBuffer.h"
 #include "src/base/SkSafeMath.h"
+#include "src/base/SkUtils.h"
 #include "src/core/SkPathPriv.h"
 #include "src/core/SkRRectPriv.h"
 
@@ -223,8 +224,10 @@ size_t SkPath::readFromMemory_EQ4Or5(const void* storage, size_t length) {
         return 0;
     }
 
-    const SkPoint* points = buffer.skipCount<SkPoint>(pts);
-    const SkScalar* conics = buffer.skipCount<SkScalar>(cnx);
+    // storage need not be 4-byte aligned (SkReadBuffer may read a picture in place), so points and
+    // conics are loaded from it rather than dereferenced.
+    const char* points = buffer.skipCount<char>(SkSafeMath::Mul(pts, sizeof(SkPoint)));
+    const char* conics = buffer.skipCount<char>(SkSafeMath::Mul(cnx, sizeof(SkScalar)));
     const uint8_t* verbs = buffer.skipCount<uint8_t>(vbs);
     buffer.skipToAlign4();
     if (!buffer.isValid()) {
@@ -248,6 +251,17 @@ size_t SkPath::readFromMemory_EQ4Or5(const void* storage, size_t length) {
         verbsStep = -1;
     }
 
+    auto nextPoint = [&points] {
+        SkPoint p = sk_unaligned_load<SkPoint>(points);
+        points += sizeof(SkPoint);
+        return p;
+    };
+    auto nextConic = [&conics] {
+        SkScalar w = sk_unaligned_load<SkScalar>(conics);
+        conics += sizeof(SkScalar);
+        return w;
+    };
+
     SkPath tmp;
     tmp.setFillType(extract_filltype(packed));
     tmp.incReserve(pts);
@@ -255,27 +269,27 @@ size_t SkPath::readFromMemory_EQ4Or5(const void* storage, size_t length) {
         switch (*verbs) {
             case kMove_Verb:
                 CHECK_POINTS_CONICS(1, 0);
-                tmp.moveTo(*points++);
+                tmp.moveTo(nextPoint());
                 break;
             case kLine_Verb:
                 CHECK_POINTS_CONICS(1, 0);
-                tmp.lineTo(*points++);
+                tmp.lineTo(nextPoint());
                 break;
-            case kQuad_Verb:
+            case kQuad_Verb: {
                 CHECK_POINTS_CONICS(2, 0);
-                tmp.quadTo(points[0], points[1]);
-                points += 2;
-                break;
-            case kConic_Verb:
+                SkPoint p1 = nextPoint(), p2 = nextPoint();
+                tmp.quadTo(p1, p2);
+            } break;
+            case kConic_Verb: {
                 CHECK_POINTS_CONICS(2, 1);
-                tmp.conicTo(points[0], points[1], *conics++);
-                points += 2;
-                break;
-            case kCubic_Verb:
+                SkPoint p1 = nextPoint(), p2 = nextPoint();
+                tmp.conicTo(p1, p2, nextConic());
+            } break;
+            case kCubic_Verb: {
                 CHECK_POINTS_CONICS(3, 0);
-                tmp.cubicTo(points[0], points[1], points[2]);
-                points += 3;
-                break;
+                SkPoint p1 = nextPoint(), p2 = nextPoint(), p3 = nextPoint();
+                tmp.cubicTo(p1, p2, p3);
+            } break;
             case kClose_Verb:
                 tmp.close();
                 break;
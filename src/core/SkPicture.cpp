@@ -160,14 +160,17 @@ sk_sp<SkPicture> SkPicture::MakeFromData(const SkData* data, const SkDeserialPro
         return nullptr;
     }
     SkMemoryStream stream(data->data(), data->size());
-    return MakeFromStreamPriv(&stream, procs, nullptr, kNestedSKPLimit);
+    return MakeFromStreamPriv(&stream, procs, nullptr, kNestedSKPLimit,
+                              procs && procs->fShareData ? data : nullptr);
 }
 
 sk_sp<SkPicture> SkPicture::MakeFromStreamPriv(SkStream* stream, const SkDeserialProcs* procsPtr,
-                                               SkTypefacePlayback* typefaces, int recursionLimit) {
+                                               SkTypefacePlayback* typefaces, int recursionLimit,
+                                               const SkData* streamData) {
     if (recursionLimit <= 0) {
         return nullptr;
     }
+    SkASSERT(!streamData || stream->getMemoryBase() == streamData->data());
     SkPictInfo info;
     if (!StreamIsSKP(stream, &info)) {
         return nullptr;
@@ -184,7 +187,7 @@ sk_sp<SkPicture> SkPicture::MakeFromStreamPriv(SkStream* stream, const SkDeseria
         case kPictureData_TrailingStreamByteAfterPictInfo: {
             std::unique_ptr<SkPictureData> data(
                     SkPictureData::CreateFromStream(stream, info, procs, typefaces,
-                                                    recursionLimit));
+                                                    recursionLimit, streamData));
             return Forwardport(info, data.get(), nullptr);
         }
         case kCustom_TrailingStreamByteAfterPictInfo: {
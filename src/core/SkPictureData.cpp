@@ -7,10 +7,12 @@
 
 #include "src/core/SkPictureData.h"
 
+#include "include/core/SkData.h"
 #include "include/core/SkFlattenable.h"
 #include "include/core/SkSerialProcs.h"
 #include "include/core/SkString.h"
 #include "include/core/SkTypeface.h"
+#include "include/private/base/SkAlign.h"
 #include "include/private/base/SkDebug.h"
 #include "include/private/base/SkTFitsIn.h"
 #include "include/private/base/SkTemplates.h"
@@ -308,16 +310,31 @@ void SkPictureData::flatten(SkWriteBuffer& buffer) const {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Reads size bytes of op data from stream. If stream reads from streamData, and the bytes are 4-byte
+// aligned, they're shared with streamData instead of copied. (Playback reads ops through pointers
+// into the data, so unlike SkReadBuffer, it needs them aligned.)
+static sk_sp<SkData> read_data(SkStream* stream, size_t size, const SkData* streamData) {
+    if (streamData) {
+        const size_t offset = stream->getPosition();
+        if (offset <= streamData->size() && size <= streamData->size() - offset &&
+            SkIsAlign4((uintptr_t)streamData->bytes() + offset) && stream->skip(size) == size) {
+            return SkData::MakeSubset(streamData, offset, size);
+        }
+    }
+    return SkData::MakeFromStream(stream, size);
+}
+
 bool SkPictureData::parseStreamTag(SkStream* stream,
                                    uint32_t tag,
                                    uint32_t size,
                                    const SkDeserialProcs& procs,
                                    SkTypefacePlayback* topLevelTFPlayback,
-                                   int recursionLimit) {
+                                   int recursionLimit,
+                                   const SkData* streamData) {
     switch (tag) {
         case SK_PICT_READER_TAG:
             SkASSERT(nullptr == fOpData);
-            fOpData = SkData::MakeFromStream(stream, size);
+            fOpData = read_data(stream, size, streamData);
             if (!fOpData) {
                 return false;
             }
@@ -374,7 +391,8 @@ bool SkPictureData::parseStreamTag(SkStream* stream,
 
             for (uint32_t i = 0; i < size; i++) {
                 auto pic = SkPicture::MakeFromStreamPriv(stream, &procs,
-                                                         topLevelTFPlayback, recursionLimit - 1);
+                                                         topLevelTFPlayback, recursionLimit - 1,
+                                                         streamData);
                 if (!pic) {
                     return false;
                 }
@@ -385,13 +403,28 @@ bool SkPictureData::parseStreamTag(SkStream* stream,
             if (StreamRemainingLengthIsBelow(stream, size)) {
                 return false;
             }
-            SkAutoMalloc storage(size);
-            if (stream->read(storage.get(), size) != size) {
-                return false;
+            // SkReadBuffer can read the buffer in place when the stream is in memory, aligned or
+            // not. Otherwise it's copied out.
+            SkAutoMalloc storage;
+            const void* memory = nullptr;
+            const size_t offset = stream->getPosition();
+            if (stream->getMemoryBase() && stream->hasPosition()) {
+                memory = static_cast<const char*>(stream->getMemoryBase()) + offset;
+                if (stream->skip(size) != size) {
+                    return false;
+                }
+            } else {
+                memory = storage.reset(size);
+                if (stream->read(storage.get(), size) != size) {
+                    return false;
+                }
             }
 
-            SkReadBuffer buffer(storage.get(), size);
+            SkReadBuffer buffer(memory, size);
             buffer.setVersion(fInfo.getVersion());
+            if (streamData) {
+                buffer.setBackingData(streamData, offset);
+            }
 
             if (!fFactoryPlayback) {
                 return false;
@@ -525,13 +558,14 @@ SkPictureData* SkPictureData::CreateFromStream(SkStream* stream,
                                                const SkPictInfo& info,
                                                const SkDeserialProcs& procs,
                                                SkTypefacePlayback* topLevelTFPlayback,
-                                               int recursionLimit) {
+                                               int recursionLimit,
+                                               const SkData* streamData) {
     std::unique_ptr<SkPictureData> data(new SkPictureData(info));
     if (!topLevelTFPlayback) {
         topLevelTFPlayback = &data->fTFPlayback;
     }
 
-    if (!data->parseStream(stream, procs, topLevelTFPlayback, recursionLimit)) {
+    if (!data->parseStream(stream, procs, topLevelTFPlayback, recursionLimit, streamData)) {
         return nullptr;
     }
     return data.release();
@@ -551,7 +585,8 @@ SkPictureData* SkPictureData::CreateFromBuffer(SkReadBuffer& buffer,
 bool SkPictureData::parseStream(SkStream* stream,
                                 const SkDeserialProcs& procs,
                                 SkTypefacePlayback* topLevelTFPlayback,
-                                int recursionLimit) {
+                                int recursionLimit,
+                                const SkData* streamData) {
     for (;;) {
         uint32_t tag;
         if (!stream->readU32(&tag)) { return false; }
@@ -561,7 +596,8 @@ bool SkPictureData::parseStream(SkStream* stream,
 
         uint32_t size;
         if (!stream->readU32(&size)) { return false; }
-        if (!this->parseStreamTag(stream, tag, size, procs, topLevelTFPlayback, recursionLimit)) {
+        if (!this->parseStreamTag(stream, tag, size, procs, topLevelTFPlayback, recursionLimit,
+                                  streamData)) {
             return false; // we're invalid
         }
     }
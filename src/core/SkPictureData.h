@@ -89,12 +89,14 @@ T* read_index_base_1_or_null(SkReadBuffer* reader, const SkTArray<sk_sp<T>>& arr
 class SkPictureData {
 public:
     SkPictureData(const SkPictureRecord& record, const SkPictInfo&);
-    // Does not affect ownership of SkStream.
+    // Does not affect ownership of SkStream. If streamData is not null, the stream reads from it,
+    // and the op data and encoded images may share its bytes rather than copy them.
     static SkPictureData* CreateFromStream(SkStream*,
                                            const SkPictInfo&,
                                            const SkDeserialProcs&,
                                            SkTypefacePlayback*,
-                                           int recursionLimit);
+                                           int recursionLimit,
+                                           const SkData* streamData = nullptr);
     static SkPictureData* CreateFromBuffer(SkReadBuffer&, const SkPictInfo&);
 
     void serialize(SkWStream*, const SkSerialProcs&, SkRefCntSet*, bool textBlobsOnly=false) const;
@@ -109,7 +111,7 @@ protected:
 
     // Does not affect ownership of SkStream.
     bool parseStream(SkStream*, const SkDeserialProcs&, SkTypefacePlayback*,
-                     int recursionLimit);
+                     int recursionLimit, const SkData* streamData);
     bool parseBuffer(SkReadBuffer& buffer);
 
 public:
@@ -159,7 +161,7 @@ private:
     // Does not affect ownership of SkStream.
     bool parseStreamTag(SkStream*, uint32_t tag, uint32_t size,
                         const SkDeserialProcs&, SkTypefacePlayback*,
-                        int recursionLimit);
+                        int recursionLimit, const SkData* streamData);
     void parseBufferTag(SkReadBuffer&, uint32_t tag, uint32_t size);
     void flattenToBuffer(SkWriteBuffer&, bool textBlobsOnly) const;
 
@@ -7,153 +7,300 @@
 
 #include "src/core/SkRTree.h"
 
-SkRTree::SkRTree() : fCount(0) {}
+#include "include/private/base/SkFloatingPoint.h"
+#include "include/private/base/SkTemplates.h"
+#include "src/base/SkMathPriv.h"
+#include "src/base/SkVx.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+static_assert(SkRTree::kMaxChildren % 4 == 0, "Nodes are searched four children at a time.");
+
+// Enough to search a tree of 2^31 rects; each level is at least halved.
+static constexpr int kMaxDepth = 32;
+static constexpr int kMaxStack = kMaxDepth * (SkRTree::kMaxChildren - 1) + 1;
+
+static constexpr size_t kMaxBitmapWordsPerResult = 8;
+
+// Ops are sorted if leaves grouping them in order would cover this many times their area.
+static constexpr double kMaxLeafOverlap = 6;
+
+SkRTree::SkRTree() : fCount(0), fDepth(0), fLeafCount(0), fBounds(SkRect::MakeEmpty()) {}
 
 void SkRTree::insert(const SkRect boundsArray[], int N) {
     SkASSERT(0 == fCount);
 
-    std::vector<Branch> branches;
-    branches.reserve(N);
+    // The leaves are built from op indices, and each level above from node indices, which are
+    // sorted rather than copies of the bounds, so that building moves as little memory as possible.
+    std::vector<int32_t> children;
+    children.reserve(N);
 
+    double area = 0;
     for (int i = 0; i < N; i++) {
         const SkRect& bounds = boundsArray[i];
         if (bounds.isEmpty()) {
             continue;
         }
+        children.push_back(i);
+        fBounds.join(bounds);
+        area += (double)bounds.width() * bounds.height();
+    }
 
-        Branch b;
-        b.fBounds = bounds;
-        b.fOpIndex = i;
-        branches.push_back(b);
-    }
-
-    fCount = (int)branches.size();
-    if (fCount) {
-        if (1 == fCount) {
-            fNodes.reserve(1);
-            Node* n = this->allocateNodeAtLevel(0);
-            n->fNumChildren = 1;
-            n->fChildren[0] = branches[0];
-            fRoot.fSubtree = n;
-            fRoot.fBounds  = branches[0].fBounds;
-        } else {
-            fNodes.reserve(CountNodes(fCount));
-            fRoot = this->bulkLoad(&branches);
+    fCount = (int)children.size();
+    if (!fCount) {
+        return;
+    }
+
+    // Sorting never allocates fewer nodes.
+    int nodes = 0;
+    for (int n = fCount; nodes == 0 || n > 1; ) {
+        n = CountNodes(n, true);
+        nodes += n;
+    }
+    fNodes.reserve(nodes);
+
+    skia_private::AutoTMalloc<int32_t> scratch;
+    std::vector<SkRect> childBounds, nodeBounds;
+    childBounds.reserve(CountNodes(fCount, true));
+    nodeBounds.reserve(CountNodes(fCount, true));
+
+    // Pictures are usually recorded in a spatial order, e.g. row by row, and then grouping ops
+    // into leaves in order makes about as good a tree as sorting them, for much less work. If the
+    // leaves overlap much more than their ops do, the ops were not, and every level is sorted.
+    this->pack(boundsArray, 0, children.data(), fCount, nullptr, false, &nodeBounds);
+    double leafArea = 0;
+    for (const SkRect& leaf : nodeBounds) {
+        leafArea += (double)leaf.width() * leaf.height();
+    }
+    const bool sort = leafArea > kMaxLeafOverlap * area;
+    if (sort) {
+        fNodes.clear();
+        nodeBounds.clear();
+        scratch.reset(fCount);
+        this->pack(boundsArray, 0, children.data(), fCount, scratch.get(), true, &nodeBounds);
+    }
+
+    // Even a single entry gets a leaf, so the root is always a node.
+    fDepth = 1;
+    fLeafCount = (int)fNodes.size();
+    while (nodeBounds.size() > 1) {
+        std::swap(childBounds, nodeBounds);
+        children.resize(childBounds.size());
+        for (int i = 0; i < (int)children.size(); i++) {
+            children[i] = i;
         }
+        nodeBounds.clear();
+        this->pack(childBounds.data(), (int)fNodes.size() - (int)childBounds.size(),
+                   children.data(), (int)children.size(), scratch.get(), sort, &nodeBounds);
+        fDepth++;
     }
+    SkASSERT((int)fNodes.size() <= nodes);
+    SkASSERT(fDepth <= kMaxDepth);
+    SkASSERT(fBounds == nodeBounds[0]);
 }
 
-SkRTree::Node* SkRTree::allocateNodeAtLevel(uint16_t level) {
-    SkDEBUGCODE(Node* p = fNodes.data());
-    fNodes.push_back(Node{});
-    Node& out = fNodes.back();
-    SkASSERT(fNodes.data() == p);  // If this fails, we didn't reserve() enough.
-    out.fNumChildren = 0;
-    out.fLevel = level;
-    return &out;
+int SkRTree::CountNodes(int children, bool sort) {
+    const int nodes  = (children + kMaxChildren - 1) / kMaxChildren;
+    if (!sort) {
+        return nodes;
+    }
+    const int slices = (int)std::ceil(std::sqrt((double)nodes)),
+              slice  = slices * kMaxChildren;
+    const int remainder = children % slice;
+    return children / slice * slices + (remainder + kMaxChildren - 1) / kMaxChildren;
 }
 
-// This function parallels bulkLoad, but just counts how many nodes bulkLoad would allocate.
-int SkRTree::CountNodes(int branches) {
-    if (branches == 1) {
-        return 1;
-    }
-    int remainder   = branches % kMaxChildren;
-    if (remainder > 0) {
-        if (remainder >= kMinChildren) {
-            remainder = 0;
-        } else {
-            remainder = kMinChildren - remainder;
+namespace {
+
+// Maps the centers (times two) of bounds in [bounds.fLeft, bounds.fRight] (or top and bottom) to
+// integer sort keys in [0, kMax].
+template <int kMax>
+class Quantizer {
+public:
+    Quantizer(float min, float max) : fMin(2 * min), fScale(kMax / (2 * max - 2 * min)) {
+        if (!sk_float_isfinite(fScale)) {
+            fScale = 0;
         }
     }
-    int currentBranch = 0;
-    int nodes = 0;
-    while (currentBranch < branches) {
-        int incrementBy = kMaxChildren;
-        if (remainder != 0) {
-            if (remainder <= kMaxChildren - kMinChildren) {
-                incrementBy -= remainder;
-                remainder = 0;
-            } else {
-                incrementBy = kMinChildren;
-                remainder -= kMaxChildren - kMinChildren;
+
+    int operator()(float lo, float hi) const {
+        const float q = (lo + hi - fMin) * fScale;
+        return q >= 0 ? (int)std::min(q, (float)kMax) : 0;  // NaN is 0 too.
+    }
+
+private:
+    float fMin, fScale;
+};
+
+// A stable counting sort of values into out, by key(value) in [0, kBuckets).
+template <int kBuckets, typename T, typename Key>
+void counting_sort(const T* values, T* out, int count, Key key) {
+    int offsets[kBuckets] = {};
+    for (int i = 0; i < count; i++) {
+        offsets[key(values[i])]++;
+    }
+    int offset = 0;
+    for (int& bucket : offsets) {
+        offset += std::exchange(bucket, offset);
+    }
+    for (int i = 0; i < count; i++) {
+        out[offsets[key(values[i])]++] = values[i];
+    }
+}
+
+}  // namespace
+
+void SkRTree::pack(const SkRect bounds[], int base, int32_t children[], int count,
+                   int32_t scratch[], bool sort, std::vector<SkRect>* nodeBounds) {
+    const int nodes  = (count + kMaxChildren - 1) / kMaxChildren,
+              slices = sort ? (int)std::ceil(std::sqrt((double)nodes)) : 1,
+              slice  = sort ? slices * kMaxChildren : count;
+
+    // Neither slices nor the nodes within them need to be exactly ordered, so each is sorted by 11
+    // bits of x or y in one pass, which is much cheaper than comparison sorts of the whole level.
+    const Quantizer<0x7ff>  x(fBounds.fLeft, fBounds.fRight);
+    const Quantizer<0x7ff>  y(fBounds.fTop,  fBounds.fBottom);
+    if (sort) {
+        counting_sort<0x800>(children, scratch, count, [&](int32_t child) {
+            return x(bounds[child].fLeft, bounds[child].fRight);
+        });
+    }
+
+    // Each slice's bounds are gathered in order as it is sorted by y, so that filling in its
+    // nodes reads them in order rather than from all over bounds.
+    skia_private::AutoTMalloc<uint16_t> keys(sort ? std::min(slice, count) : 0);
+    skia_private::AutoTMalloc<SkRect> sliceBounds(sort ? std::min(slice, count) : 0);
+    for (int start = 0; start < count; start += slice) {
+        const int n = std::min(slice, count - start),
+                  sliceNodes = (n + kMaxChildren - 1) / kMaxChildren;
+        if (sort) {
+            int offsets[0x800] = {};
+            for (int i = 0; i < n; i++) {
+                const SkRect& child = bounds[scratch[start + i]];
+                keys[i] = (uint16_t)y(child.fTop, child.fBottom);
+                offsets[keys[i]]++;
+            }
+            int offset = 0;
+            for (int& bucket : offsets) {
+                offset += std::exchange(bucket, offset);
+            }
+            for (int i = 0; i < n; i++) {
+                const int j = offsets[keys[i]]++;
+                children[start + j] = scratch[start + i];
+                sliceBounds[j] = bounds[scratch[start + i]];
             }
         }
-        nodes++;
-        currentBranch++;
-        for (int k = 1; k < incrementBy && currentBranch < branches; ++k) {
-            currentBranch++;
+
+        // The children of the last, partial slice are spread evenly over its nodes.
+        for (int i = 0; i < sliceNodes; i++) {
+            Node& node = fNodes.emplace_back();
+            std::fill_n(node.fLeft,   kMaxChildren, +SK_FloatInfinity);
+            std::fill_n(node.fTop,    kMaxChildren, +SK_FloatInfinity);
+            std::fill_n(node.fRight,  kMaxChildren, -SK_FloatInfinity);
+            std::fill_n(node.fBottom, kMaxChildren, -SK_FloatInfinity);
+            std::fill_n(node.fChildren, kMaxChildren, -1);
+
+            SkRect& nodeBound = nodeBounds->emplace_back(SkRect::MakeEmpty());
+            const int first = start + (int)((int64_t)n *  i      / sliceNodes),
+                      last  = start + (int)((int64_t)n * (i + 1) / sliceNodes);
+            for (int j = first, k = 0; j < last; j++, k++) {
+                SkASSERT(k < kMaxChildren);
+                const SkRect& child = sort ? sliceBounds[j - start] : bounds[children[j]];
+                node.fLeft[k]     = child.fLeft;
+                node.fTop[k]      = child.fTop;
+                node.fRight[k]    = child.fRight;
+                node.fBottom[k]   = child.fBottom;
+                node.fChildren[k] = children[j] + base;
+                nodeBound.join(child);
+            }
         }
     }
-    return nodes + CountNodes(nodes);
 }
 
-SkRTree::Branch SkRTree::bulkLoad(std::vector<Branch>* branches, int level) {
-    if (branches->size() == 1) { // Only one branch.  It will be the root.
-        return (*branches)[0];
+// Sorts the (unique) op indices in results, starting at first. Results that are dense enough are
+// sorted by setting their bits in a bitmap and reading them back, which is much faster than
+// comparing them when a query hits many ops.
+static void sort_results(std::vector<int>* results, size_t first) {
+    int* begin = results->data() + first;
+    int* end   = results->data() + results->size();
+    if (std::is_sorted(begin, end)) {
+        return;
+    }
+    const auto [min, max] = std::minmax_element(begin, end);
+    const int base = *min;
+    const size_t words = ((size_t)(*max - base) >> 5) + 1;
+    if (words > (size_t)(end - begin) * kMaxBitmapWordsPerResult) {
+        std::sort(begin, end);
+        return;
     }
 
-    // We might sort our branches here, but we expect Blink gives us a reasonable x,y order.
-    // Skipping a call to sort (in Y) here resulted in a 17% win for recording with negligible
-    // difference in playback speed.
-    int remainder   = (int)branches->size() % kMaxChildren;
-    int newBranches = 0;
-
-    if (remainder > 0) {
-        // If the remainder isn't enough to fill a node, we'll add fewer nodes to other branches.
-        if (remainder >= kMinChildren) {
-            remainder = 0;
-        } else {
-            remainder = kMinChildren - remainder;
+    skia_private::AutoSTMalloc<64, uint32_t> bits(words);
+    sk_bzero(bits.get(), words * sizeof(uint32_t));
+    for (const int* r = begin; r < end; r++) {
+        const int bit = *r - base;
+        bits[bit >> 5] |= 1u << (bit & 31);
+    }
+    for (size_t w = 0; w < words; w++) {
+        for (uint32_t word = bits[w]; word; word &= word - 1) {
+            *begin++ = base + (int)(w << 5) + SkCTZ(word);
         }
     }
+    SkASSERT(begin == end);
+}
 
-    int currentBranch = 0;
-    while (currentBranch < (int)branches->size()) {
-        int incrementBy = kMaxChildren;
-        if (remainder != 0) {
-            // if need be, omit some nodes to make up for remainder
-            if (remainder <= kMaxChildren - kMinChildren) {
-                incrementBy -= remainder;
-                remainder = 0;
-            } else {
-                incrementBy = kMinChildren;
-                remainder -= kMaxChildren - kMinChildren;
+// Returns a bit for each child of node that intersects the query. Children are tested four at a
+// time, the width of SSE and NEON registers.
+template <typename Node>
+static uint32_t intersects(const Node& node, const SkRect& query) {
+    using float4 = skvx::float4;
+    const float4 left(query.fLeft), top(query.fTop), right(query.fRight), bottom(query.fBottom);
+    uint32_t mask = 0;
+    for (int i = 0; i < SkRTree::kMaxChildren; i += 4) {
+        const auto hit = (float4::Load(node.fLeft + i) < right) &
+                         (left < float4::Load(node.fRight + i)) &
+                         (float4::Load(node.fTop + i) < bottom) &
+                         (top < float4::Load(node.fBottom + i));
+        if (skvx::any(hit)) {
+            for (int j = 0; j < 4; j++) {
+                mask |= (uint32_t)(hit[j] & 1) << (i + j);
             }
         }
-        Node* n = allocateNodeAtLevel(level);
-        n->fNumChildren = 1;
-        n->fChildren[0] = (*branches)[currentBranch];
-        Branch b;
-        b.fBounds = (*branches)[currentBranch].fBounds;
-        b.fSubtree = n;
-        ++currentBranch;
-        for (int k = 1; k < incrementBy && currentBranch < (int)branches->size(); ++k) {
-            b.fBounds.join((*branches)[currentBranch].fBounds);
-            n->fChildren[k] = (*branches)[currentBranch];
-            ++n->fNumChildren;
-            ++currentBranch;
-        }
-        (*branches)[newBranches] = b;
-        ++newBranches;
     }
-    branches->resize(newBranches);
-    return this->bulkLoad(branches, level + 1);
+    return mask;
 }
 
 void SkRTree::search(const SkRect& query, std::vector<int>* results) const {
-    if (fCount > 0 && SkRect::Intersects(fRoot.fBounds, query)) {
-        this->search(fRoot.fSubtree, query, results);
+    // SkRect::Intersects() also rejects empty (and NaN) queries, which the child tests don't.
+    if (fCount == 0 || !SkRect::Intersects(fBounds, query)) {
+        return;
     }
+    const size_t first = results->size();
+    this->search((int)fNodes.size() - 1, query, results);
+
+    // Callers play back the results in order.
+    sort_results(results, first);
 }
 
-void SkRTree::search(Node* node, const SkRect& query, std::vector<int>* results) const {
-    for (int i = 0; i < node->fNumChildren; ++i) {
-        if (SkRect::Intersects(node->fChildren[i].fBounds, query)) {
-            if (0 == node->fLevel) {
-                results->push_back(node->fChildren[i].fOpIndex);
-            } else {
-                this->search(node->fChildren[i].fSubtree, query, results);
+void SkRTree::search(int root, const SkRect& query, std::vector<int>* results) const {
+    int stack[kMaxStack];
+    int top = 0;
+    stack[top++] = root;
+    while (top > 0) {
+        const int index = stack[--top];
+        const Node& node = fNodes[index];
+        uint32_t hits = intersects(node, query);
+        if (this->isLeaf(index)) {
+            for (; hits; hits &= hits - 1) {
+                results->push_back(node.fChildren[SkCTZ(hits)]);
+            }
+        } else {
+            // Children are pushed last to first, so they are visited first to last. Trees of ops
+            // grouped in order then find them in order.
+            for (; hits; hits &= ~(1u << (31 - SkCLZ(hits)))) {
+                SkASSERT(top < kMaxStack);
+                stack[top++] = node.fChildren[31 - SkCLZ(hits)];
             }
         }
     }
@@ -11,21 +11,26 @@
 #include "include/core/SkBBHFactory.h"
 #include "include/core/SkRect.h"
 
+#include <cstdint>
+#include <vector>
+
 /**
  * An R-Tree implementation. In short, it is a balanced n-ary tree containing a hierarchy of
  * bounding rectangles.
  *
  * It only supports bulk-loading, i.e. creation from a batch of bounding rectangles.
- * This performs a bottom-up bulk load using the STR (sort-tile-recursive) algorithm.
+ * This performs a bottom-up bulk load. Rectangles that are already in a spatial order, as pictures
+ * are usually recorded, are grouped into nodes in that order. Otherwise they are packed using the
+ * STR (sort-tile-recursive) algorithm: each level is split into vertical slices by x, and each
+ * slice into nodes by y.
  *
- * TODO: Experiment with other bulk-load algorithms (in particular the Hilbert pack variant,
- * which groups rects by position on the Hilbert curve, is probably worth a look). There also
- * exist top-down bulk load variants (VAMSplit, TopDownGreedy, etc).
+ * The nodes are kept in one array, leaves first and the root last, and each node stores the
+ * bounds of its children edge by edge, so that a query is tested against all of them at once.
  *
  * For more details see:
  *
- *  Beckmann, N.; Kriegel, H. P.; Schneider, R.; Seeger, B. (1990). "The R*-tree:
- *      an efficient and robust access method for points and rectangles"
+ *  Leutenegger, S. T.; Lopez, M. A.; Edgington, J. (1997). "STR: A simple and efficient
+ *      algorithm for R-tree packing"
  */
 class SkRTree : public SkBBoxHierarchy {
 public:
@@ -38,44 +43,45 @@ public:
     // Methods and constants below here are only public for tests.
 
     // Return the depth of the tree structure.
-    int getDepth() const { return fCount ? fRoot.fSubtree->fLevel + 1 : 0; }
+    int getDepth() const { return fDepth; }
     // Insertion count (not overall node count, which may be greater).
     int getCount() const { return fCount; }
 
-    // These values were empirically determined to produce reasonable performance in most cases.
-    static const int kMinChildren = 6,
-                     kMaxChildren = 11;
+    // A node's children are tested against a query four at a time. Only the last node in each
+    // slice of a level may have fewer than kMinChildren.
+    static const int kMinChildren = 4,
+                     kMaxChildren = 8;
 
 private:
-    struct Node;
-
-    struct Branch {
-        union {
-            Node* fSubtree;
-            int fOpIndex;
-        };
-        SkRect fBounds;
-    };
-
     struct Node {
-        uint16_t fNumChildren;
-        uint16_t fLevel;
-        Branch fChildren[kMaxChildren];
+        // Unused children have inverted bounds, which never intersect a query.
+        float   fLeft[kMaxChildren],
+                fTop[kMaxChildren],
+                fRight[kMaxChildren],
+                fBottom[kMaxChildren];
+        int32_t fChildren[kMaxChildren];  // Op indices in leaves, node indices otherwise.
     };
 
-    void search(Node* root, const SkRect& query, std::vector<int>* results) const;
+    // Groups count children into nodes, appending the nodes to fNodes and their bounds to
+    // nodeBounds. Child i has bounds[children[i]], and is stored in its node as children[i] + base.
+    // Children are grouped in order, or if sort is true, sorted into slices and nodes first,
+    // using scratch, which must have room for as many.
+    void pack(const SkRect bounds[], int base, int32_t children[], int count, int32_t scratch[],
+              bool sort, std::vector<SkRect>* nodeBounds);
 
-    // Consumes the input array.
-    Branch bulkLoad(std::vector<Branch>* branches, int level = 0);
+    // How many nodes will pack() allocate for this many children?
+    static int CountNodes(int children, bool sort);
 
-    // How many times will bulkLoad() call allocateNodeAtLevel()?
-    static int CountNodes(int branches);
+    // Appends the children of leaves under root that intersect query, in no particular order.
+    void search(int root, const SkRect& query, std::vector<int>* results) const;
 
-    Node* allocateNodeAtLevel(uint16_t level);
+    bool isLeaf(int node) const { return node < fLeafCount; }
 
     // This is the count of data elements (rather than total nodes in the tree)
     int fCount;
-    Branch fRoot;
+    int fDepth;
+    int fLeafCount;
+    SkRect fBounds;
     std::vector<Node> fNodes;
 };
 
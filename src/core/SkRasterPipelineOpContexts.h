@@ -12,7 +12,7 @@
 // of pixels we handle in the highp pipeline. Many of the context structs in this file are only used
 // by stages that have no lowp implementation. They can therefore use the (smaller) highp value to
 // save memory in the arena.
-inline static constexpr int SkRasterPipeline_kMaxStride = 16;
+inline static constexpr int SkRasterPipeline_kMaxStride = 32;
 inline static constexpr int SkRasterPipeline_kMaxStride_highp = 8;
 
 // These structs hold the context data for many of the Raster Pipeline ops.
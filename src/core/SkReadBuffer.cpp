@@ -24,6 +24,7 @@
 #include "src/base/SkAutoMalloc.h"
 #include "src/base/SkMathPriv.h"
 #include "src/base/SkSafeMath.h"
+#include "src/base/SkUtils.h"
 #include "src/core/SkMatrixPriv.h"
 #include "src/core/SkMipmap.h"
 #include "src/core/SkMipmapBuilder.h"
@@ -50,13 +51,19 @@ namespace {
 } // anonymous namespace
 
 void SkReadBuffer::setMemory(const void* data, size_t size) {
-    this->validate(IsPtrAlign4(data) && (SkAlign4(size) == size));
+    this->validate(SkAlign4(size) == size);
     if (!fError) {
         fBase = fCurr = (const char*)data;
         fStop = fBase + size;
     }
 }
 
+void SkReadBuffer::setBackingData(const SkData* data, size_t offset) {
+    SkASSERT(data && offset <= data->size() && this->size() <= data->size() - offset);
+    fBackingData = data;
+    fBackingOffset = offset;
+}
+
 void SkReadBuffer::setInvalid() {
     if (!fError) {
         // When an error is found, send the read cursor to the end of the stream
@@ -69,7 +76,7 @@ const void* SkReadBuffer::skip(size_t size) {
     size_t inc = SkAlign4(size);
     this->validate(inc >= size);
     const void* addr = fCurr;
-    this->validate(IsPtrAlign4(addr) && this->isAvailable(inc));
+    this->validate(this->isAvailable(inc));
     if (fError) {
         return nullptr;
     }
@@ -99,20 +106,20 @@ SkColor SkReadBuffer::readColor() {
 
 int32_t SkReadBuffer::readInt() {
     const size_t inc = sizeof(int32_t);
-    if (!this->validate(IsPtrAlign4(fCurr) && this->isAvailable(inc))) {
+    if (!this->validate(this->isAvailable(inc))) {
         return 0;
     }
-    int32_t value = *((const int32_t*)fCurr);
+    int32_t value = sk_unaligned_load<int32_t>(fCurr);
     fCurr += inc;
     return value;
 }
 
 SkScalar SkReadBuffer::readScalar() {
     const size_t inc = sizeof(SkScalar);
-    if (!this->validate(IsPtrAlign4(fCurr) && this->isAvailable(inc))) {
+    if (!this->validate(this->isAvailable(inc))) {
         return 0;
     }
-    SkScalar value = *((const SkScalar*)fCurr);
+    SkScalar value = sk_unaligned_load<SkScalar>(fCurr);
     fCurr += inc;
     return value;
 }
@@ -181,7 +188,8 @@ void SkReadBuffer::readPoint3(SkPoint3* point) {
 
 void SkReadBuffer::read(SkM44* matrix) {
     if (this->isValid()) {
-        if (const float* m = (const float*)this->skip(sizeof(float) * 16)) {
+        float m[16];
+        if (this->readPad32(m, sizeof(m))) {
             *matrix = SkM44::ColMajor(m);
         }
     }
@@ -325,12 +333,24 @@ sk_sp<SkData> SkReadBuffer::readByteArrayAsData() {
     return SkData::MakeFromMalloc(buffer.release(), numBytes);
 }
 
+sk_sp<SkData> SkReadBuffer::readEncodedData() {
+    if (!fBackingData) {
+        return this->readByteArrayAsData();
+    }
+    const size_t offset = fBackingOffset + this->offset() + sizeof(uint32_t);
+    size_t size;
+    if (!this->skipByteArray(&size) || !this->isValid()) {
+        return nullptr;
+    }
+    return SkData::MakeSubset(fBackingData, offset, size);
+}
+
 uint32_t SkReadBuffer::getArrayCount() {
     const size_t inc = sizeof(uint32_t);
-    if (!this->validate(IsPtrAlign4(fCurr) && this->isAvailable(inc))) {
+    if (!this->validate(this->isAvailable(inc))) {
         return 0;
     }
-    return *((uint32_t*)fCurr);
+    return sk_unaligned_load<uint32_t>(fCurr);
 }
 
 // If we see a corrupt stream, we return null (fail). If we just fail trying to decode
@@ -340,7 +360,7 @@ sk_sp<SkImage> SkReadBuffer::readImage() {
 
     sk_sp<SkImage> image;
     {
-        sk_sp<SkData> data = this->readByteArrayAsData();
+        sk_sp<SkData> data = this->readEncodedData();
         if (!data) {
             this->validate(false);
             return nullptr;
@@ -60,8 +60,16 @@ public:
         this->setMemory(data, size);
     }
 
+    // The memory need not be aligned, but size must be a multiple of 4.
     void setMemory(const void*, size_t);
 
+    /**
+     *  Declares that the buffer's memory holds the same bytes as data does, starting at offset.
+     *  Encoded images are then read as subsets of data rather than copied, so they stay valid (and
+     *  keep data alive) after the buffer's memory is freed. data must outlive the buffer.
+     */
+    void setBackingData(const SkData* data, size_t offset);
+
     /**
      *  Returns true IFF the version is older than the specified version.
      */
@@ -85,11 +93,12 @@ public:
     const void* skip(size_t count, size_t size);    // does safe multiply
     size_t available() const { return fStop - fCurr; }
 
+    // These fail, rather than return a misaligned pointer, if the memory isn't aligned for T.
     template <typename T> const T* skipT() {
-        return static_cast<const T*>(this->skip(sizeof(T)));
+        return this->checkAligned<T>(this->skip(sizeof(T)));
     }
     template <typename T> const T* skipT(size_t count) {
-        return static_cast<const T*>(this->skip(count, sizeof(T)));
+        return this->checkAligned<T>(this->skip(count, sizeof(T)));
     }
 
     // primitives
@@ -232,6 +241,10 @@ public:
 private:
     const char* readString(size_t* length);
 
+    // Like readByteArrayAsData(), but shares the bytes with fBackingData when there is one. They
+    // may not be 4-byte aligned, so this is only for data that's decoded from memory.
+    sk_sp<SkData> readEncodedData();
+
     void setInvalid();
     bool readArray(void* value, size_t size, size_t elementSize);
     bool isAvailable(size_t size) const { return size <= this->available(); }
@@ -254,8 +267,12 @@ private:
 
     SkDeserialProcs fProcs;
 
-    static bool IsPtrAlign4(const void* ptr) {
-        return SkIsAlign4((uintptr_t)ptr);
+    const SkData* fBackingData = nullptr;
+    size_t        fBackingOffset = 0;
+
+    template <typename T> const T* checkAligned(const void* ptr) {
+        return this->validate((uintptr_t)ptr % alignof(T) == 0) ? static_cast<const T*>(ptr)
+                                                                 : nullptr;
     }
 
     bool fError = false;
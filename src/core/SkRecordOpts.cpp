@@ -7,10 +7,20 @@
 
 #include "src/core/SkRecordOpts.h"
 
+#include "include/core/SkImage.h"
+#include "include/core/SkShader.h"
 #include "include/private/base/SkTDArray.h"
+#include "include/private/base/SkTemplates.h"
 #include "src/core/SkCanvasPriv.h"
+#include "src/core/SkRecordDraw.h"
 #include "src/core/SkRecordPattern.h"
 #include "src/core/SkRecords.h"
+#include "src/core/SkRectPriv.h"
+
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 using namespace SkRecords;
 
@@ -280,6 +290,297 @@ void SkRecordMergeSvgOpacityAndFilterLayers(SkRecord* record) {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Does this paint overwrite everything it draws with opaque pixels?
+static bool paint_is_opaque(const SkPaint& paint) {
+    const auto mode = paint.asBlendMode();
+    return mode && (*mode == SkBlendMode::kSrcOver || *mode == SkBlendMode::kSrc) &&
+           paint.getAlphaf() == 1 &&
+           paint.getStyle() == SkPaint::kFill_Style &&
+           (!paint.getShader() || paint.getShader()->isOpaque()) &&
+           !paint.getColorFilter() &&
+           !paint.getMaskFilter() &&
+           !paint.getPathEffect() &&
+           !paint.getImageFilter();
+}
+
+namespace {
+
+// Finds the rect each op is sure to cover with opaque pixels, in the same space as
+// SkRecordFillBounds(). It tracks the matrix like FillBounds does, and a rect that is inside the
+// clip. Only top-level draws cover anything, since layers are blended into what's below them.
+class Occluders {
+public:
+    struct Op {
+        SkRect covered;   // Empty if the op doesn't cover anything.
+        bool   topLevel;  // Not inside any layer.
+        bool   reads;     // May move pixels drawn before it, so nothing before it is occluded.
+    };
+
+    explicit Occluders(Op ops[]) : fOps(ops) {}
+
+    void setCurrentOp(int i) { fOp = &fOps[i]; *fOp = {SkRect::MakeEmpty(), fLayers == 0, false}; }
+
+    template <typename T> void operator()(const T& op) { this->track(op); }
+
+private:
+    struct SaveState {
+        SkRect clip;
+        bool   layer;
+    };
+
+    template <typename T> void track(const T&) {}
+
+    void track(const Save&)                { fSaves.push_back({fClip, false}); }
+    // Layers that start with a copy of what's below them may filter it beyond any later cover.
+    void track(const SaveLayer& op) {
+        this->pushLayer(op.backdrop ||
+                        (op.saveLayerFlags & SkCanvas::kInitWithPrevious_SaveLayerFlag));
+    }
+    void track(const SaveBehind&)          { this->pushLayer(true); }
+    void track(const Restore& op) {
+        fCTM = op.matrix;
+        if (!fSaves.empty()) {
+            fClip = fSaves.back().clip;
+            fLayers -= fSaves.back().layer;
+            fSaves.pop_back();
+        }
+    }
+
+    void track(const SetMatrix& op)        { fCTM = op.matrix; }
+    void track(const SetM44& op)           { fCTM = op.matrix.asM33(); }
+    void track(const Concat44& op)         { fCTM.preConcat(op.matrix.asM33()); }
+    void track(const Concat& op)           { fCTM.preConcat(op.matrix); }
+    void track(const Scale& op)            { fCTM.preScale(op.sx, op.sy); }
+    void track(const Translate& op)        { fCTM.preTranslate(op.dx, op.dy); }
+
+    void track(const ClipRect& op)         { this->clip(op.rect, op.opAA.op()); }
+    void track(const ClipRRect& op) {
+        if (op.rrect.isRect()) {
+            this->clip(op.rrect.rect(), op.opAA.op());
+        } else {
+            fClip.setEmpty();
+        }
+    }
+    void track(const ClipPath& op) {
+        SkRect rect;
+        if (op.path.isRect(&rect) && !op.path.isInverseFillType()) {
+            this->clip(rect, op.opAA.op());
+        } else {
+            fClip.setEmpty();
+        }
+    }
+    void track(const ClipRegion&)          { fClip.setEmpty(); }
+    void track(const ClipShader&)          { fClip.setEmpty(); }
+    void track(const ResetClip&)           { fClip = SkRectPriv::MakeLargest(); }
+
+    void track(const DrawPaint& op) {
+        if (fLayers == 0 && paint_is_opaque(op.paint)) {
+            fOp->covered = fClip;
+        }
+    }
+    void track(const DrawRect& op) {
+        if (paint_is_opaque(op.paint)) {
+            this->cover(op.rect);
+        }
+    }
+    void track(const DrawImageRect& op) {
+        // drawImageRect() shrinks dst along with any part of src outside the image.
+        if (op.image->isOpaque() && SkRect::Make(op.image->bounds()).contains(op.src) &&
+            (!op.paint || paint_is_opaque(*op.paint))) {
+            this->cover(op.dst);
+        }
+    }
+    void track(const DrawBehind&)          { fOp->reads = true; }
+    // Pictures and drawables may contain any of the above.
+    void track(const DrawPicture&)         { fOp->reads = true; }
+    void track(const DrawDrawable&)        { fOp->reads = true; }
+
+    void pushLayer(bool reads) {
+        fSaves.push_back({fClip, true});
+        fLayers++;
+        fOp->reads |= reads;
+    }
+
+    // We only know what's inside the clip after intersecting it with rects.
+    void clip(const SkRect& rect, SkClipOp op) {
+        if (op != SkClipOp::kIntersect || !fCTM.rectStaysRect() ||
+            !fClip.intersect(fCTM.mapRect(rect))) {
+            fClip.setEmpty();
+        }
+    }
+
+    void cover(const SkRect& rect) {
+        SkRect covered;
+        if (fLayers == 0 && fCTM.rectStaysRect() && covered.intersect(fCTM.mapRect(rect), fClip)) {
+            fOp->covered = covered;
+        }
+    }
+
+    Op*                    fOps;
+    Op*                    fOp = nullptr;
+    SkMatrix               fCTM = SkMatrix::I();
+    SkRect                 fClip = SkRectPriv::MakeLargest();
+    int                    fLayers = 0;
+    std::vector<SaveState> fSaves;
+};
+
+// Can this op be skipped if everything it draws is covered? Pictures and drawables may contain
+// annotations, and DrawBehind draws under what's already there.
+struct CanOcclude {
+    template <typename T>
+    bool operator()(const T&) { return T::kTags & kDraw_Tag; }
+
+    bool operator()(const DrawPicture&)  { return false; }
+    bool operator()(const DrawDrawable&) { return false; }
+    bool operator()(const DrawBehind&)   { return false; }
+};
+
+}  // namespace
+
+void SkRecordNoopOccludedDraws(SkRecord* record) {
+    const int count = record->count();
+
+    // Pictures aren't clipped to their cull rect when played back, so neither are these bounds.
+    skia_private::AutoTMalloc<SkRect> bounds(count);
+    skia_private::AutoTMalloc<SkBBoxHierarchy::Metadata> meta(count);
+    SkRecordFillBounds(SkRectPriv::MakeLargest(), *record, bounds, meta);
+
+    skia_private::AutoTMalloc<Occluders::Op> ops(count);
+    Occluders occluders(ops);
+    for (int i = 0; i < count; i++) {
+        occluders.setCurrentOp(i);
+        record->visit(i, occluders);
+    }
+
+    // Walk backwards, remembering the largest rects covered by the ops after the current one.
+    // Anti-aliased edges and hairlines may touch pixels just outside the bounds, so a draw has
+    // to be at least a pixel inside a covered rect.
+    static constexpr int kMaxCovered = 4;
+    SkRect covered[kMaxCovered];
+    int coveredCount = 0;
+    for (int i = count; i --> 0;) {
+        if (ops[i].reads) {
+            coveredCount = 0;
+        }
+
+        if (ops[i].topLevel && record->visit(i, CanOcclude())) {
+            const SkRect draw = bounds[i].makeOutset(1, 1);
+            bool occluded = false;
+            for (int j = 0; j < coveredCount && !occluded; j++) {
+                occluded = covered[j].contains(draw);
+            }
+            if (occluded) {
+                record->replace<NoOp>(i);
+                continue;
+            }
+        }
+
+        const SkRect& rect = ops[i].covered;
+        if (rect.isEmpty()) {
+            continue;
+        }
+        // Replace the smallest rect, unless they are all larger.
+        int smallest = coveredCount;
+        if (coveredCount == kMaxCovered) {
+            smallest = 0;
+            for (int j = 1; j < kMaxCovered; j++) {
+                if (covered[j].width() * covered[j].height() <
+                    covered[smallest].width() * covered[smallest].height()) {
+                    smallest = j;
+                }
+            }
+            if (covered[smallest].width() * covered[smallest].height() >=
+                rect.width() * rect.height()) {
+                continue;
+            }
+        } else {
+            coveredCount++;
+        }
+        covered[smallest] = rect;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+struct AsDrawImageRect {
+    template <typename T>
+    DrawImageRect* operator()(T*) { return nullptr; }
+    DrawImageRect* operator()(DrawImageRect* op) { return op; }
+};
+
+// Can a and b be drawn as entries of one image set? Sets share a paint, and any image filter is
+// applied to the whole set at once.
+bool can_merge(const DrawImageRect& a, const DrawImageRect& b) {
+    const SkPaint* pa = a.paint;
+    const SkPaint* pb = b.paint;
+    if (pa && (pa->getImageFilter() || pa->getMaskFilter() || pa->getPathEffect() ||
+               pa->getStyle() != SkPaint::kFill_Style)) {
+        return false;
+    }
+    return (pa == pb || (pa && pb && *pa == *pb)) &&
+           a.sampling == b.sampling &&
+           a.constraint == b.constraint &&
+           SkRect::Make(a.image->bounds()).contains(a.src) &&
+           SkRect::Make(b.image->bounds()).contains(b.src);
+}
+
+}  // namespace
+
+void SkRecordMergeDrawImageRects(SkRecord* record) {
+    const int count = record->count();
+    std::vector<int> run;
+    for (int i = 0; i < count; i++) {
+        const DrawImageRect* first = record->mutate(i, AsDrawImageRect());
+        if (!first) {
+            continue;
+        }
+
+        // NoOps left by other passes don't break up a run.
+        run.assign(1, i);
+        int next = i + 1;
+        for (; next < count; next++) {
+            if (const DrawImageRect* op = record->mutate(next, AsDrawImageRect())) {
+                if (!can_merge(*first, *op)) {
+                    break;
+                }
+                run.push_back(next);
+            } else if (!record->mutate(next, [](auto* op) {
+                           return std::is_same_v<decltype(op), NoOp*>;
+                       })) {
+                break;
+            }
+        }
+        if (run.size() < 2) {
+            continue;
+        }
+
+        // The set's paint is only for its effects; each entry's anti-aliasing comes from aaFlags.
+        const unsigned aaFlags = first->paint && first->paint->isAntiAlias()
+                                         ? SkCanvas::kAll_QuadAAFlags
+                                         : SkCanvas::kNone_QuadAAFlags;
+        skia_private::AutoTArray<SkCanvas::ImageSetEntry> set(run.size());
+        for (size_t j = 0; j < run.size(); j++) {
+            DrawImageRect* op = record->mutate(run[j], AsDrawImageRect());
+            set[j] = SkCanvas::ImageSetEntry(std::move(op->image), op->src, op->dst, 1, aaFlags);
+        }
+        SkPaint* paint = first->paint ? new (record->alloc<SkPaint>()) SkPaint(*first->paint)
+                                      : nullptr;
+        const SkSamplingOptions sampling = first->sampling;
+        const SkCanvas::SrcRectConstraint constraint = first->constraint;
+
+        for (size_t j = 1; j < run.size(); j++) {
+            record->replace<NoOp>(run[j]);
+        }
+        new (record->replace<DrawEdgeAAImageSet>(i)) DrawEdgeAAImageSet{
+                paint, std::move(set), (int)run.size(), nullptr, nullptr, sampling, constraint};
+        i = next - 1;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
 void SkRecordOptimize(SkRecord* record) {
     // This might be useful  as a first pass in the future if we want to weed
     // out junk for other optimization passes.  Right now, nothing needs it,
@@ -298,6 +599,14 @@ void SkRecordOptimize(SkRecord* record) {
 #endif
     SkRecordMergeSvgOpacityAndFilterLayers(record);
 
+    // Off by default, because recorded pictures may be played back scaled down or by Ganesh.
+#if defined(SK_ENABLE_RECORD_OCCLUSION_CULLING)
+    SkRecordNoopOccludedDraws(record);
+#endif
+#if defined(SK_ENABLE_RECORD_IMAGE_RECT_MERGING)
+    SkRecordMergeDrawImageRects(record);
+#endif
+
     record->defrag();
 }
 
@@ -309,6 +618,10 @@ void SkRecordOptimize2(SkRecord* record) {
     SkRecordNoopSaveLayerDrawRestores(record);
 #endif
     SkRecordMergeSvgOpacityAndFilterLayers(record);
+    // Culling can leave saves with nothing to draw. Image sets aren't occluders, so merge last.
+    SkRecordNoopOccludedDraws(record);
+    SkRecordNoopSaveRestores(record);
+    SkRecordMergeDrawImageRects(record);
 
     record->defrag();
 }
@@ -26,6 +26,17 @@ void SkRecordNoopSaveLayerDrawRestores(SkRecord*);
 // the alpha of the first SaveLayer to the second SaveLayer.
 void SkRecordMergeSvgOpacityAndFilterLayers(SkRecord*);
 
+// Turns draws into no-ops when a later opaque draw covers everything they might draw. Edges are
+// only sure to be covered if the record is not played back scaled down. SkRecordOptimize() runs
+// this only if SK_ENABLE_RECORD_OCCLUSION_CULLING is defined.
+void SkRecordNoopOccludedDraws(SkRecord*);
+
+// Merges runs of DrawImageRects with the same paint, sampling, and constraint into one
+// DrawEdgeAAImageSet, which GPU backends can draw as a single batch. Ganesh may anti-alias the
+// edges of a set differently. SkRecordOptimize() runs this only if
+// SK_ENABLE_RECORD_IMAGE_RECT_MERGING is defined.
+void SkRecordMergeDrawImageRects(SkRecord*);
+
 // Experimental optimizers
 void SkRecordOptimize2(SkRecord*);
 
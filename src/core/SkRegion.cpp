@@ -1298,13 +1298,15 @@ size_t SkRegion::readFromMemory(const void* storage, size_t length) {
                 buffer.available() < count * sizeof(int32_t)) {
                 return 0;
             }
-            if (!validate_run((const int32_t*)((const char*)storage + buffer.pos()), count,
-                              tmp.fBounds, ySpanCount, intervalCount)) {
-                return 0;  // invalid runs, don't even allocate
+            // storage need not be 4-byte aligned, so the runs are validated once they're copied.
+            AutoSTMalloc<kRectRegionRuns * 4, int32_t> runs(count);
+            SkAssertResult(buffer.read(runs.get(), count * sizeof(int32_t)));
+            if (!validate_run(runs.get(), count, tmp.fBounds, ySpanCount, intervalCount)) {
+                return 0;  // invalid runs, don't allocate
             }
             tmp.allocateRuns(count, ySpanCount, intervalCount);
             SkASSERT(tmp.isComplex());
-            SkAssertResult(buffer.read(tmp.fRunHead->writable_runs(), count * sizeof(int32_t)));
+            memcpy(tmp.fRunHead->writable_runs(), runs.get(), count * sizeof(int32_t));
         }
     }
     SkASSERT(tmp.isValid());
@@ -8,7 +8,9 @@
 #include "src/core/SkResourceCache.h"
 
 #include "include/core/SkTraceMemoryDump.h"
+#include "include/private/SkChecksum.h"
 #include "include/private/base/SkMutex.h"
+#include "include/private/base/SkTPin.h"
 #include "include/private/base/SkTo.h"
 #include "include/private/chromium/SkDiscardableMemory.h"
 #include "src/core/SkImageFilter_Base.h"
@@ -16,8 +18,11 @@
 #include "src/core/SkMipmap.h"
 #include "src/core/SkOpts.h"
 
+#include <algorithm>
+#include <cmath>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
 DECLARE_SKMESSAGEBUS_MESSAGE(SkResourceCache::PurgeSharedIDMessage, uint32_t, true)
 
@@ -75,13 +80,91 @@ namespace {
 class SkResourceCache::Hash :
     public SkTHashTable<SkResourceCache::Rec*, SkResourceCache::Key, HashTraits> {};
 
+// The state for kTinyLFU. A count-min sketch of 4 bit counters estimates how often each key was
+// looked up; every kSampleSize increments all the counters are halved, so the estimates favor
+// recent lookups. The share of the budget for the window starts at kMinWindowShare and is adapted
+// by hill climbing: every kClimbSize lookups it steps in the direction that last improved the hit
+// rate. A smaller window lets bursts of new Recs, e.g. images scrolling by, miss more often than
+// they would with kLRU.
+class SkResourceCache::TinyLFU {
+public:
+    void increment(uint32_t hash) {
+        for (int row = 0; row < kDepth; ++row) {
+            uint8_t& counter = fCounters[row][Index(hash, row)];
+            if (counter < kMaxCount) {
+                counter += 1;
+            }
+        }
+        if (++fSamples == kSampleSize) {
+            for (auto& row : fCounters) {
+                for (uint8_t& counter : row) {
+                    counter >>= 1;
+                }
+            }
+            fSamples /= 2;
+        }
+    }
+
+    int frequency(uint32_t hash) const {
+        int frequency = kMaxCount;
+        for (int row = 0; row < kDepth; ++row) {
+            frequency = std::min<int>(frequency, fCounters[row][Index(hash, row)]);
+        }
+        return frequency;
+    }
+
+    void recordLookup(bool hit) {
+        fClimbHits += hit;
+        if (++fClimbLookups < kClimbSize) {
+            return;
+        }
+        float hitRate = (float)fClimbHits / fClimbLookups;
+        float change = hitRate - fPrevHitRate;
+        float step = change >= 0 ? fStep : -fStep;
+        fWindowShare = SkTPin(fWindowShare + step, kMinWindowShare, 1.0f);
+        fStep = std::abs(change) >= kRestartThreshold ? std::copysign(kStepSize, step)
+                                                      : step * kStepDecay;
+        fPrevHitRate = hitRate;
+        fClimbHits = fClimbLookups = 0;
+    }
+
+    size_t windowLimit(size_t limit) const { return (size_t)(limit * fWindowShare); }
+
+private:
+    static constexpr int kDepth = 4;
+    static constexpr int kWidth = 4096;
+    static constexpr int kMaxCount = 15;
+    static constexpr int kSampleSize = 10 * kWidth;
+
+    static constexpr int   kClimbSize = 4096;
+    static constexpr float kStepSize = 0.0625f;
+    static constexpr float kStepDecay = 0.9f;
+    static constexpr float kRestartThreshold = 0.05f;
+    static constexpr float kMinWindowShare = 0.2f;
+
+    static int Index(uint32_t hash, int row) {
+        return SkChecksum::Mix(hash + row * 0x9E3779B9) & (kWidth - 1);
+    }
+
+    uint8_t fCounters[kDepth][kWidth] = {};
+    int     fSamples = 0;
+
+    float   fWindowShare = kMinWindowShare;
+    float   fStep = kStepSize;
+    float   fPrevHitRate = 0;
+    int     fClimbHits = 0;
+    int     fClimbLookups = 0;
+};
+
+// The share of the main (non-window) budget for protected Recs.
+static constexpr int kProtectedPercent = 80;
 
 ///////////////////////////////////////////////////////////////////////////////
 
 void SkResourceCache::init() {
-    fHead = nullptr;
-    fTail = nullptr;
     fHash = new Hash;
+    fTinyLFU = nullptr;
+    fPolicy = Policy::kLRU;
     fTotalBytesUsed = 0;
     fCount = 0;
     fSingleAllocationByteLimit = 0;
@@ -104,13 +187,16 @@ SkResourceCache::SkResourceCache(size_t byteLimit)
 }
 
 SkResourceCache::~SkResourceCache() {
-    Rec* rec = fHead;
-    while (rec) {
-        Rec* next = rec->fNext;
-        delete rec;
-        rec = next;
+    for (const List& list : fLists) {
+        Rec* rec = list.fHead;
+        while (rec) {
+            Rec* next = rec->fNext;
+            delete rec;
+            rec = next;
+        }
     }
     delete fHash;
+    delete fTinyLFU;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -118,19 +204,69 @@ SkResourceCache::~SkResourceCache() {
 bool SkResourceCache::find(const Key& key, FindVisitor visitor, void* context) {
     this->checkMessages();
 
+    if (fTinyLFU) {
+        fTinyLFU->increment(key.hash());
+    }
+
     if (auto found = fHash->find(key)) {
         Rec* rec = *found;
         if (visitor(*rec, context)) {
+            this->statsFor(rec).fHits += 1;
+            if (fTinyLFU) {
+                fTinyLFU->recordLookup(true);
+            }
             this->moveToHead(rec);  // for our LRU
             return true;
         } else {
+            this->statsFor(rec).fMisses += 1;
+            if (fTinyLFU) {
+                fTinyLFU->recordLookup(false);
+            }
             this->remove(rec);  // stale
             return false;
         }
     }
+    fStats[key.getNamespace()].fMisses += 1;
+    if (fTinyLFU) {
+        fTinyLFU->recordLookup(false);
+    }
     return false;
 }
 
+SkResourceCache::NamespaceStats& SkResourceCache::statsFor(const Rec* rec) {
+    NamespaceStats& stats = fStats[rec->getKey().getNamespace()];
+    stats.fCategory = rec->getCategory();
+    return stats;
+}
+
+SkResourceCache::CategoryStats SkResourceCache::getCategoryStats(const char* category) const {
+    CategoryStats total;
+    fStats.foreach([&](void*, const NamespaceStats& stats) {
+        if (stats.fCategory && strcmp(stats.fCategory, category) == 0) {
+            total.fHits += stats.fHits;
+            total.fMisses += stats.fMisses;
+            total.fEvictions += stats.fEvictions;
+        }
+    });
+    return total;
+}
+
+void SkResourceCache::dumpCategoryStats(SkTraceMemoryDump* dump) const {
+    SkTHashMap<SkString, CategoryStats> categories;
+    fStats.foreach([&](void*, const NamespaceStats& stats) {
+        CategoryStats& total = categories[SkString(stats.fCategory ? stats.fCategory : "unknown")];
+        total.fHits += stats.fHits;
+        total.fMisses += stats.fMisses;
+        total.fEvictions += stats.fEvictions;
+    });
+    categories.foreach([&](const SkString& category, CategoryStats* stats) {
+        SkString dumpName = SkStringPrintf("skia/sk_resource_cache/stats/%s", category.c_str());
+        dump->dumpNumericValue(dumpName.c_str(), "hit_count", "objects", stats->fHits);
+        dump->dumpNumericValue(dumpName.c_str(), "miss_count", "objects", stats->fMisses);
+        dump->dumpNumericValue(dumpName.c_str(), "eviction_count", "objects", stats->fEvictions);
+    });
+}
+
 static void make_size_str(size_t size, SkString* str) {
     const char suffix[] = { 'b', 'k', 'm', 'g', 't', 0 };
     int i = 0;
@@ -161,6 +297,11 @@ void SkResourceCache::add(Rec* rec, void* payload) {
         }
     }
 
+    if (fTinyLFU) {
+        fTinyLFU->increment(rec->getHash());
+    }
+    this->statsFor(rec);
+
     this->addToHead(rec);
     fHash->set(rec);
     rec->postAddInstall(payload);
@@ -201,29 +342,100 @@ void SkResourceCache::remove(Rec* rec) {
     delete rec;
 }
 
+void SkResourceCache::evict(Rec* rec) {
+    this->statsFor(rec).fEvictions += 1;
+    this->remove(rec);
+}
+
 void SkResourceCache::purgeAsNeeded(bool forcePurge) {
     size_t byteLimit;
     int    countLimit;
+    size_t limit;  // in the units of budgetUnits()
 
     if (fDiscardableFactory) {
         countLimit = SK_DISCARDABLEMEMORY_SCALEDIMAGECACHE_COUNT_LIMIT;
         byteLimit = UINT32_MAX;  // no limit based on bytes
+        limit = countLimit;
     } else {
         countLimit = SK_MaxS32; // no limit based on count
         byteLimit = fTotalByteLimit;
+        limit = byteLimit;
+    }
+
+    if (!forcePurge && fPolicy == Policy::kTinyLFU) {
+        this->purgeTinyLFU(limit, byteLimit, countLimit);
+        return;
+    }
+
+    for (const List& list : fLists) {
+        Rec* rec = list.fTail;
+        while (rec) {
+            if (!forcePurge && fTotalBytesUsed < byteLimit && fCount < countLimit) {
+                return;
+            }
+
+            Rec* prev = rec->fPrev;
+            if (rec->canBePurged()) {
+                if (forcePurge) {
+                    this->remove(rec);
+                } else {
+                    this->evict(rec);
+                }
+            }
+            rec = prev;
+        }
+    }
+}
+
+void SkResourceCache::purgeTinyLFU(size_t limit, size_t byteLimit, int countLimit) {
+    // Returns the least recently used Rec that can be purged, from rec toward the head.
+    auto last_purgeable = [](Rec* rec, Rec* stop = nullptr) -> Rec* {
+        while (rec != stop && !rec->canBePurged()) {
+            rec = rec->fPrev;
+        }
+        return rec != stop ? rec : nullptr;
+    };
+    const size_t windowLimit = fTinyLFU->windowLimit(limit);
+
+    // Recs that overflow the window go to the head of probation, and are candidates for
+    // admission. Candidate is the least recently used of them; the others are toward the head.
+    Rec* candidate = nullptr;
+    List& window = fLists[kWindow_Segment];
+    while (window.fUsed > windowLimit) {
+        Rec* rec = window.fTail;
+        this->release(rec);
+        this->link(rec, kProbation_Segment);
+        if (!candidate) {
+            candidate = rec;
+        }
     }
 
-    Rec* rec = fTail;
-    while (rec) {
-        if (!forcePurge && fTotalBytesUsed < byteLimit && fCount < countLimit) {
-            break;
+    while (fTotalBytesUsed >= byteLimit || fCount >= countLimit) {
+        // The victim is the least recently used Rec of the main cache that is not a candidate.
+        Rec* victim = last_purgeable(fLists[kProbation_Segment].fTail, candidate);
+        if (!victim) {
+            victim = last_purgeable(fLists[kProtected_Segment].fTail);
         }
+        candidate = last_purgeable(candidate);
 
-        Rec* prev = rec->fPrev;
-        if (rec->canBePurged()) {
-            this->remove(rec);
+        // Admit the candidate only if it has been used more often than the victim.
+        Rec* rec;
+        if (candidate && victim) {
+            int candidateFrequency = fTinyLFU->frequency(candidate->getHash());
+            rec = candidateFrequency > fTinyLFU->frequency(victim->getHash()) ? victim : candidate;
+        } else {
+            rec = candidate ? candidate : victim;
+        }
+        if (!rec) {
+            rec = last_purgeable(window.fTail);
+            if (!rec) {
+                break;
+            }
+        }
+        if (candidate) {
+            candidate = candidate->fPrev;
         }
-        rec = prev;
+        this->evict(rec);
     }
 }
 
@@ -234,6 +446,29 @@ static int gPurgeCallCounter;
 static int gPurgeHitCounter;
 #endif
 
+SkResourceCache::Policy SkResourceCache::setPolicy(Policy policy) {
+    Policy prevPolicy = fPolicy;
+    fPolicy = policy;
+    if (policy == Policy::kTinyLFU) {
+        if (!fTinyLFU) {
+            fTinyLFU = new TinyLFU;
+        }
+    } else {
+        delete fTinyLFU;
+        fTinyLFU = nullptr;
+
+        // Put every Rec back in the window, keeping the protected ones most recently used.
+        for (Segment segment : {kProbation_Segment, kProtected_Segment}) {
+            while (Rec* rec = fLists[segment].fTail) {
+                this->release(rec);
+                this->link(rec, kWindow_Segment);
+            }
+        }
+    }
+    this->purgeAsNeeded();
+    return prevPolicy;
+}
+
 void SkResourceCache::purgeSharedID(uint64_t sharedID) {
     if (0 == sharedID) {
         return;
@@ -245,20 +480,22 @@ void SkResourceCache::purgeSharedID(uint64_t sharedID) {
 #endif
     // go backwards, just like purgeAsNeeded, just to make the code similar.
     // could iterate either direction and still be correct.
-    Rec* rec = fTail;
-    while (rec) {
-        Rec* prev = rec->fPrev;
-        if (rec->getKey().getSharedID() == sharedID) {
-            // even though the "src" is now dead, caches could still be in-flight, so
-            // we have to check if it can be removed.
-            if (rec->canBePurged()) {
-                this->remove(rec);
-            }
+    for (const List& list : fLists) {
+        Rec* rec = list.fTail;
+        while (rec) {
+            Rec* prev = rec->fPrev;
+            if (rec->getKey().getSharedID() == sharedID) {
+                // even though the "src" is now dead, caches could still be in-flight, so
+                // we have to check if it can be removed.
+                if (rec->canBePurged()) {
+                    this->remove(rec);
+                }
 #ifdef SK_TRACK_PURGE_SHAREDID_HITRATE
-            found = true;
+                found = true;
 #endif
+            }
+            rec = prev;
         }
-        rec = prev;
     }
 
 #ifdef SK_TRACK_PURGE_SHAREDID_HITRATE
@@ -274,10 +511,10 @@ void SkResourceCache::purgeSharedID(uint64_t sharedID) {
 void SkResourceCache::visitAll(Visitor visitor, void* context) {
     // go backwards, just like purgeAsNeeded, just to make the code similar.
     // could iterate either direction and still be correct.
-    Rec* rec = fTail;
-    while (rec) {
-        visitor(*rec, context);
-        rec = rec->fPrev;
+    for (const List& list : fLists) {
+        for (const Rec* rec = list.fTail; rec; rec = rec->fPrev) {
+            visitor(*rec, context);
+        }
     }
 }
 
@@ -306,40 +543,72 @@ SkCachedData* SkResourceCache::newCachedData(size_t bytes) {
 ///////////////////////////////////////////////////////////////////////////////
 
 void SkResourceCache::release(Rec* rec) {
+    List& list = fLists[rec->fSegment];
     Rec* prev = rec->fPrev;
     Rec* next = rec->fNext;
 
     if (!prev) {
-        SkASSERT(fHead == rec);
-        fHead = next;
+        SkASSERT(list.fHead == rec);
+        list.fHead = next;
     } else {
         prev->fNext = next;
     }
 
     if (!next) {
-        fTail = prev;
+        list.fTail = prev;
     } else {
         next->fPrev = prev;
     }
 
+    SkASSERT(list.fUsed >= this->budgetUnits(rec));
+    list.fUsed -= this->budgetUnits(rec);
+
     rec->fNext = rec->fPrev = nullptr;
 }
 
-void SkResourceCache::moveToHead(Rec* rec) {
-    if (fHead == rec) {
-        return;
-    }
+void SkResourceCache::link(Rec* rec, Segment segment) {
+    List& list = fLists[segment];
 
-    SkASSERT(fHead);
-    SkASSERT(fTail);
+    rec->fSegment = segment;
+    rec->fPrev = nullptr;
+    rec->fNext = list.fHead;
+    if (list.fHead) {
+        list.fHead->fPrev = rec;
+    }
+    list.fHead = rec;
+    if (!list.fTail) {
+        list.fTail = rec;
+    }
+    list.fUsed += this->budgetUnits(rec);
+}
 
+void SkResourceCache::moveToHead(Rec* rec) {
     this->validate();
 
-    this->release(rec);
+    if (rec->fSegment != kProbation_Segment) {
+        if (fLists[rec->fSegment].fHead != rec) {
+            this->release(rec);
+            this->link(rec, (Segment)rec->fSegment);
+        }
+        this->validate();
+        return;
+    }
 
-    fHead->fPrev = rec;
-    rec->fNext = fHead;
-    fHead = rec;
+    // A probation Rec that is found again is promoted, and the least recently used protected
+    // Recs are demoted to make room for it.
+    this->release(rec);
+    this->link(rec, kProtected_Segment);
+
+    size_t limit = fDiscardableFactory ? SK_DISCARDABLEMEMORY_SCALEDIMAGECACHE_COUNT_LIMIT
+                                       : fTotalByteLimit;
+    size_t mainLimit = limit - fTinyLFU->windowLimit(limit);
+    List& protectedList = fLists[kProtected_Segment];
+    while (protectedList.fUsed > mainLimit / 100 * kProtectedPercent &&
+           protectedList.fTail != rec) {
+        Rec* demoted = protectedList.fTail;
+        this->release(demoted);
+        this->link(demoted, kProbation_Segment);
+    }
 
     this->validate();
 }
@@ -347,15 +616,7 @@ void SkResourceCache::moveToHead(Rec* rec) {
 void SkResourceCache::addToHead(Rec* rec) {
     this->validate();
 
-    rec->fPrev = nullptr;
-    rec->fNext = fHead;
-    if (fHead) {
-        fHead->fPrev = rec;
-    }
-    fHead = rec;
-    if (!fTail) {
-        fTail = rec;
-    }
+    this->link(rec, kWindow_Segment);
     fTotalBytesUsed += rec->bytesUsed();
     fCount += 1;
 
@@ -366,46 +627,44 @@ void SkResourceCache::addToHead(Rec* rec) {
 
 #ifdef SK_DEBUG
 void SkResourceCache::validate() const {
-    if (nullptr == fHead) {
-        SkASSERT(nullptr == fTail);
-        SkASSERT(0 == fTotalBytesUsed);
-        return;
-    }
-
-    if (fHead == fTail) {
-        SkASSERT(nullptr == fHead->fPrev);
-        SkASSERT(nullptr == fHead->fNext);
-        SkASSERT(fHead->bytesUsed() == fTotalBytesUsed);
-        return;
-    }
-
-    SkASSERT(nullptr == fHead->fPrev);
-    SkASSERT(fHead->fNext);
-    SkASSERT(nullptr == fTail->fNext);
-    SkASSERT(fTail->fPrev);
-
     size_t used = 0;
     int count = 0;
-    const Rec* rec = fHead;
-    while (rec) {
-        count += 1;
-        used += rec->bytesUsed();
-        SkASSERT(used <= fTotalBytesUsed);
-        rec = rec->fNext;
-    }
-    SkASSERT(fCount == count);
+    for (int segment = 0; segment < kSegmentCount; ++segment) {
+        const List& list = fLists[segment];
+        if (nullptr == list.fHead) {
+            SkASSERT(nullptr == list.fTail);
+            SkASSERT(0 == list.fUsed);
+            continue;
+        }
 
-    rec = fTail;
-    while (rec) {
-        SkASSERT(count > 0);
-        count -= 1;
-        SkASSERT(used >= rec->bytesUsed());
-        used -= rec->bytesUsed();
-        rec = rec->fPrev;
+        SkASSERT(nullptr == list.fHead->fPrev);
+        SkASSERT(nullptr == list.fTail->fNext);
+
+        size_t listUsed = 0;
+        int listCount = 0;
+        const Rec* rec = list.fHead;
+        while (rec) {
+            SkASSERT(rec->fSegment == segment);
+            listCount += 1;
+            listUsed += this->budgetUnits(rec);
+            used += rec->bytesUsed();
+            SkASSERT(used <= fTotalBytesUsed);
+            rec = rec->fNext;
+        }
+        SkASSERT(listUsed == list.fUsed);
+        count += listCount;
+
+        rec = list.fTail;
+        while (rec) {
+            SkASSERT(listCount > 0);
+            listCount -= 1;
+            rec = rec->fPrev;
+        }
+        SkASSERT(0 == listCount);
     }
 
-    SkASSERT(0 == count);
-    SkASSERT(0 == used);
+    SkASSERT(fCount == count);
+    SkASSERT(fTotalBytesUsed == used);
 }
 #endif
 
@@ -517,6 +776,16 @@ size_t SkResourceCache::GetEffectiveSingleAllocationByteLimit() {
     return get_cache()->getEffectiveSingleAllocationByteLimit();
 }
 
+SkResourceCache::Policy SkResourceCache::GetPolicy() {
+    SkAutoMutexExclusive am(resource_cache_mutex());
+    return get_cache()->getPolicy();
+}
+
+SkResourceCache::Policy SkResourceCache::SetPolicy(Policy policy) {
+    SkAutoMutexExclusive am(resource_cache_mutex());
+    return get_cache()->setPolicy(policy);
+}
+
 void SkResourceCache::PurgeAll() {
     SkAutoMutexExclusive am(resource_cache_mutex());
     return get_cache()->purgeAll();
@@ -573,6 +842,14 @@ size_t SkGraphics::SetResourceCacheSingleAllocationByteLimit(size_t newLimit) {
     return SkResourceCache::SetSingleAllocationByteLimit(newLimit);
 }
 
+SkGraphics::ResourceCachePolicy SkGraphics::GetResourceCachePolicy() {
+    return SkResourceCache::GetPolicy();
+}
+
+SkGraphics::ResourceCachePolicy SkGraphics::SetResourceCachePolicy(ResourceCachePolicy policy) {
+    return SkResourceCache::SetPolicy(policy);
+}
+
 void SkGraphics::PurgeResourceCache() {
     SkImageFilter_Base::PurgeCache();
     return SkResourceCache::PurgeAll();
@@ -609,4 +886,7 @@ void SkResourceCache::DumpMemoryStatistics(SkTraceMemoryDump* dump) {
     // Since resource could be backed by malloc or discardable, the cache always dumps detailed
     // stats to be accurate.
     VisitAll(sk_trace_dump_visitor, dump);
+
+    SkAutoMutexExclusive am(resource_cache_mutex());
+    get_cache()->dumpCategoryStats(dump);
 }
@@ -9,8 +9,10 @@
 #define SkResourceCache_DEFINED
 
 #include "include/core/SkBitmap.h"
+#include "include/core/SkGraphics.h"
 #include "include/private/base/SkTDArray.h"
 #include "src/core/SkMessageBus.h"
+#include "src/core/SkTHash.h"
 
 class SkCachedData;
 class SkDiscardableMemory;
@@ -28,6 +30,8 @@ class SkTraceMemoryDump;
  */
 class SkResourceCache {
 public:
+    using Policy = SkGraphics::ResourceCachePolicy;
+
     struct Key {
         /** Key subclasses must call this after their own fields and data are initialized.
          *  All fields and data must be tightly packed.
@@ -105,6 +109,7 @@ public:
     private:
         Rec*    fNext;
         Rec*    fPrev;
+        uint8_t fSegment;
 
         friend class SkResourceCache;
     };
@@ -117,6 +122,13 @@ public:
 
     typedef const Rec* ID;
 
+    // Counts of find() results and budget purges for entries of one Rec::getCategory().
+    struct CategoryStats {
+        uint64_t fHits = 0;
+        uint64_t fMisses = 0;
+        uint64_t fEvictions = 0;
+    };
+
     /**
      *  Callback function for find(). If called, the cache will have found a match for the
      *  specified Key, and will pass in the corresponding Rec, along with a caller-specified
@@ -160,6 +172,9 @@ public:
     static size_t GetTotalByteLimit();
     static size_t SetTotalByteLimit(size_t newLimit);
 
+    static Policy GetPolicy();
+    static Policy SetPolicy(Policy);
+
     static size_t SetSingleAllocationByteLimit(size_t);
     static size_t GetSingleAllocationByteLimit();
     static size_t GetEffectiveSingleAllocationByteLimit();
@@ -169,8 +184,8 @@ public:
 
     static void TestDumpMemoryStatistics();
 
-    /** Dump memory usage statistics of every Rec in the cache using the
-        SkTraceMemoryDump interface.
+    /** Dump memory usage statistics of every Rec in the cache, and the CategoryStats of each
+        category, using the SkTraceMemoryDump interface.
      */
     static void DumpMemoryStatistics(SkTraceMemoryDump* dump);
 
@@ -224,6 +239,21 @@ public:
     size_t getTotalBytesUsed() const { return fTotalBytesUsed; }
     size_t getTotalByteLimit() const { return fTotalByteLimit; }
 
+    /**
+     *  Set how entries are chosen for purging when the cache is over budget. The default is
+     *  kLRU. Returns the previous policy.
+     */
+    Policy setPolicy(Policy);
+    Policy getPolicy() const { return fPolicy; }
+
+    /**
+     *  Returns the counts for Recs whose getCategory() is category, since the cache was created.
+     *  Misses are attributed by the Key's namespace, to the category of the last Rec added with
+     *  that namespace.
+     */
+    CategoryStats getCategoryStats(const char* category) const;
+    void dumpCategoryStats(SkTraceMemoryDump*) const;
+
     /**
      *  This is respected by SkBitmapProcState::possiblyScaleImage.
      *  0 is no maximum at all; this is the default.
@@ -258,13 +288,41 @@ public:
     void dump() const;
 
 private:
-    Rec*    fHead;
-    Rec*    fTail;
+    // With kLRU every Rec is in the window segment. With kTinyLFU new Recs enter the window;
+    // when it overflows they move to probation if they are used more often than the Recs
+    // they would displace, and probation Recs that are found again move to protected.
+    enum Segment : uint8_t {
+        kWindow_Segment,
+        kProbation_Segment,
+        kProtected_Segment,
+
+        kSegmentCount
+    };
+
+    // A doubly linked list in most to least recently used order, and the budget units its
+    // Recs use (bytes, or the count when the cache is discardable).
+    struct List {
+        Rec*   fHead = nullptr;
+        Rec*   fTail = nullptr;
+        size_t fUsed = 0;
+    };
+    List    fLists[kSegmentCount];
 
     class Hash;
     Hash*   fHash;
 
+    // Estimates how often keys were looked up recently, and sizes the window. Only allocated
+    // for kTinyLFU.
+    class TinyLFU;
+    TinyLFU* fTinyLFU;
+
+    struct NamespaceStats : CategoryStats {
+        const char* fCategory = nullptr;
+    };
+    SkTHashMap<void*, NamespaceStats> fStats;
+
     DiscardableFactory  fDiscardableFactory;
+    Policy  fPolicy;
 
     size_t  fTotalBytesUsed;
     size_t  fTotalByteLimit;
@@ -275,12 +333,19 @@ private:
 
     void checkMessages();
     void purgeAsNeeded(bool forcePurge = false);
+    void purgeTinyLFU(size_t limit, size_t byteLimit, int countLimit);
+    NamespaceStats& statsFor(const Rec*);
+
+    // The units of List::fUsed.
+    size_t budgetUnits(const Rec* rec) const { return fDiscardableFactory ? 1 : rec->bytesUsed(); }
 
     // linklist management
     void moveToHead(Rec*);
     void addToHead(Rec*);
+    void link(Rec*, Segment);
     void release(Rec*);
     void remove(Rec*);
+    void evict(Rec*);
 
     void init();    // called by constructors
 
@@ -6,12 +6,18 @@
  */
 
 
+#include "include/core/SkGraphics.h"
 #include "src/core/SkBlitter.h"
 #include "src/core/SkRasterClip.h"
 #include "src/core/SkScan.h"
 
 std::atomic<bool> gSkUseAnalyticAA{true};
 std::atomic<bool> gSkForceAnalyticAA{false};
+std::atomic<SkExecutor*> gSkRasterPathExecutor{nullptr};
+
+SkExecutor* SkGraphics::SetRasterPathExecutor(SkExecutor* executor) {
+    return gSkRasterPathExecutor.exchange(executor);
+}
 
 static inline void blitrect(SkBlitter* blitter, const SkIRect& r) {
     blitter->blitRect(r.fLeft, r.fTop, r.width(), r.height());
@@ -12,7 +12,10 @@
 #include "include/core/SkRect.h"
 #include "include/private/base/SkFixed.h"
 #include <atomic>
+#include <functional>
 
+class SkArenaAlloc;
+class SkExecutor;
 class SkRasterClip;
 class SkRegion;
 class SkBlitter;
@@ -25,6 +28,7 @@ typedef SkIRect SkXRect;
 
 extern std::atomic<bool> gSkUseAnalyticAA;
 extern std::atomic<bool> gSkForceAnalyticAA;
+extern std::atomic<SkExecutor*> gSkRasterPathExecutor;  // see SkGraphics::SetRasterPathExecutor
 
 class AdditiveBlitter;
 
@@ -56,6 +60,13 @@ public:
     static void AntiFillXRect(const SkXRect&, const SkRasterClip&, SkBlitter*);
     static void FillPath(const SkPath&, const SkRasterClip&, SkBlitter*);
     static void AntiFillPath(const SkPath&, const SkRasterClip&, SkBlitter*);
+    // Same coverage as AntiFillPath, but the path is split into horizontal bands that are scan
+    // converted concurrently on the executor, each drawing through its own blitter made by
+    // makeBlitter. Bands are only cut at rows that no contour crosses. Returns false, having drawn
+    // nothing, if the path is not worth splitting or cannot be split; call AntiFillPath then.
+    using BandBlitterProc = std::function<SkBlitter*(SkArenaAlloc*)>;
+    static bool AntiFillPathBanded(const SkPath&, const SkRasterClip&, SkExecutor*,
+                                   const BandBlitterProc& makeBlitter);
     static void FrameRect(const SkRect&, const SkPoint& strokeSize,
                           const SkRasterClip&, SkBlitter*);
     static void AntiFrameRect(const SkRect&, const SkPoint& strokeSize,
@@ -95,6 +106,9 @@ private:
                             const SkIRect& clipBounds, bool forceRLE);
     static void SAAFillPath(const SkPath& path, SkBlitter* blitter, const SkIRect& pathIR,
                             const SkIRect& clipBounds, bool forceRLE);
+    static bool AAAFillPathBanded(const SkPath& path, const SkRegion& clip,
+                                  const SkIRect& pathIR, SkExecutor*,
+                                  const BandBlitterProc& makeBlitter);
 };
 
 /** Assign an SkXRect from a SkIRect, by promoting the src rect's coordinates
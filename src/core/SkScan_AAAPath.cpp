@@ -7,8 +7,10 @@
 
 #include "include/core/SkPath.h"
 #include "include/core/SkRegion.h"
+#include "include/private/base/SkFloatingPoint.h"
 #include "include/private/base/SkTemplates.h"
 #include "include/private/base/SkTo.h"
+#include "src/base/SkArenaAlloc.h"
 #include "src/base/SkAutoMalloc.h"
 #include "src/base/SkTSort.h"
 #include "src/core/SkAnalyticEdge.h"
@@ -17,18 +19,29 @@
 #include "src/core/SkEdge.h"
 #include "src/core/SkEdgeBuilder.h"
 #include "src/core/SkGeometry.h"
+#include "src/core/SkPathPriv.h"
 #include "src/core/SkQuadClipper.h"
 #include "src/core/SkRasterClip.h"
 #include "src/core/SkScan.h"
 #include "src/core/SkScanPriv.h"
+#include "src/core/SkTaskGroup.h"
 
+#include <algorithm>
+#include <memory>
+#include <numeric>
 #include <utility>
+#include <vector>
 
 #if defined(SK_DISABLE_AAA)
 void SkScan::AAAFillPath(const SkPath&, SkBlitter*, const SkIRect&, const SkIRect&, bool) {
     SkDEBUGFAIL("AAA Disabled");
     return;
 }
+
+bool SkScan::AAAFillPathBanded(const SkPath&, const SkRegion&, const SkIRect&, SkExecutor*,
+                               const BandBlitterProc&) {
+    return false;
+}
 #else
 
 /*
@@ -1031,6 +1044,31 @@ static SkAnalyticEdge* sort_edges(SkAnalyticEdge* list[], int count, SkAnalyticE
     return list[0];
 }
 
+static void link_sentinel_edges(SkAnalyticEdge* headEdge,
+                                SkAnalyticEdge* tailEdge,
+                                SkAnalyticEdge* first,
+                                SkAnalyticEdge* last) {
+    headEdge->fRiteE  = nullptr;
+    headEdge->fPrev   = nullptr;
+    headEdge->fNext   = first;
+    headEdge->fUpperY = headEdge->fLowerY = SK_MinS32;
+    headEdge->fX                          = SK_MinS32;
+    headEdge->fDX                         = 0;
+    headEdge->fDY                         = SK_MaxS32;
+    headEdge->fUpperX                     = SK_MinS32;
+    first->fPrev                          = headEdge;
+
+    tailEdge->fRiteE  = nullptr;
+    tailEdge->fPrev   = last;
+    tailEdge->fNext   = nullptr;
+    tailEdge->fUpperY = tailEdge->fLowerY = SK_MaxS32;
+    tailEdge->fX                          = SK_MaxS32;
+    tailEdge->fDX                         = 0;
+    tailEdge->fDY                         = SK_MaxS32;
+    tailEdge->fUpperX                     = SK_MaxS32;
+    last->fNext                           = tailEdge;
+}
+
 static void validate_sort(const SkAnalyticEdge* edge) {
 #ifdef SK_DEBUG
     SkFixed y = SkIntToFixed(-32768);
@@ -1561,13 +1599,22 @@ static void aaa_walk_edges(SkAnalyticEdge*  prevHead,
                            bool             isUsingMask,
                            bool             forceRLE,
                            bool             useDeferred,
-                           bool             skipIntersect) {
+                           bool             skipIntersect,
+                           bool             resumeAtStartY) {
     prevHead->fX = prevHead->fUpperX = leftClip;
     nextTail->fX = nextTail->fUpperX = rightClip;
-    SkFixed y                        = std::max(prevHead->fNext->fUpperY, SkIntToFixed(start_y));
-    SkFixed nextNextY                = SK_MaxS32;
+    SkFixed y;
+    SkFixed nextNextY = SK_MaxS32;
+
+    if (resumeAtStartY) {
+        // start_y is a row that a walk over the edges above it would reach with no edge active
+        // and all of ours still below. Pick up exactly where that walk would have continued.
+        SkASSERT(prevHead->fNext->fUpperY > SkIntToFixed(start_y));
+        y = SkIntToFixed(start_y);
+        update_next_next_y(prevHead->fNext->fUpperY, y, &nextNextY);
+    } else {
+        y = std::max(prevHead->fNext->fUpperY, SkIntToFixed(start_y));
 
-    {
         SkAnalyticEdge* edge;
         for (edge = prevHead->fNext; edge->fUpperY <= y; edge = edge->fNext) {
             edge->goY(y);
@@ -1885,26 +1932,7 @@ static SK_ALWAYS_INLINE void aaa_fill_path(
     SkAnalyticEdge headEdge, tailEdge, *last;
     // this returns the first and last edge after they're sorted into a dlink list
     SkAnalyticEdge* edge = sort_edges(list, count, &last);
-
-    headEdge.fRiteE  = nullptr;
-    headEdge.fPrev   = nullptr;
-    headEdge.fNext   = edge;
-    headEdge.fUpperY = headEdge.fLowerY = SK_MinS32;
-    headEdge.fX                         = SK_MinS32;
-    headEdge.fDX                        = 0;
-    headEdge.fDY                        = SK_MaxS32;
-    headEdge.fUpperX                    = SK_MinS32;
-    edge->fPrev                         = &headEdge;
-
-    tailEdge.fRiteE  = nullptr;
-    tailEdge.fPrev   = last;
-    tailEdge.fNext   = nullptr;
-    tailEdge.fUpperY = tailEdge.fLowerY = SK_MaxS32;
-    tailEdge.fX                         = SK_MaxS32;
-    tailEdge.fDX                        = 0;
-    tailEdge.fDY                        = SK_MaxS32;
-    tailEdge.fUpperX                    = SK_MaxS32;
-    last->fNext                         = &tailEdge;
+    link_sentinel_edges(&headEdge, &tailEdge, edge, last);
 
     // now edge is the head of the sorted linklist
 
@@ -1950,7 +1978,8 @@ static SK_ALWAYS_INLINE void aaa_fill_path(
                        isUsingMask,
                        forceRLE,
                        useDeferred,
-                       skipIntersect);
+                       skipIntersect,
+                       false);
     }
 }
 
@@ -2012,4 +2041,242 @@ void SkScan::AAAFillPath(const SkPath&  path,
                       forceRLE);
     }
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+// aaa_walk_edges() carries state from one scan line to the next (the active edges and their
+// incrementally stepped positions, and which fractional scan lines to stop at), so it can't start
+// part way down a contour and still produce the serial coverage. Instead we cut the path between
+// groups of contours that are separated by an integer row b: every contour above ends at or above
+// b, and every contour below starts at least half a pixel below b. Edge y values snap to quarter
+// pixels, so the serial walk visits b exactly, with no active edge, and none of the vertical edges
+// on either side of b are close enough to be combined. Each band of contour groups can then be
+// built and walked on its own, resuming at its top row, and blit the same runs as the serial walk.
+// Only the sort in between is shared, so that edges that tie keep their serial order.
+
+// Below this the serial walk is cheap enough that splitting it up isn't worth it.
+static constexpr int kMinBandedPathPoints = 512;
+static constexpr int kMaxBands = 16;
+
+namespace {
+
+struct BandContour {
+    int   fVerb;    // the contour's move verb
+    int   fPoint;   // the contour's first point
+    int   fWeight;  // the contour's first conic weight
+    float fTop;
+    float fBottom;
+};
+
+struct Band {
+    int fTop;     // first row of the band; the serial walk crosses it with no edge active
+    int fBottom;  // first row of the next band
+    int fPoints = 0;
+
+    // Runs of consecutive contours [first, end) in this band, in path order. Each run gets its
+    // own builder, so edges are only ever combined with the neighbors the serial build sees.
+    std::vector<std::pair<int, int>> fRuns;
+
+    std::vector<std::unique_ptr<SkAnalyticEdgeBuilder>> fBuilders;  // one per run
+    std::vector<int>                                     fRunEdges;  // edge count of each run
+    int                                                  fEdgeCount = 0;
+    SkAnalyticEdge*                                      fFirst = nullptr;
+    SkAnalyticEdge*                                      fLast  = nullptr;
+};
+
+}  // namespace
+
+bool SkScan::AAAFillPathBanded(const SkPath&          path,
+                               const SkRegion&        clip,
+                               const SkIRect&         ir,
+                               SkExecutor*            executor,
+                               const BandBlitterProc& makeBlitter) {
+    const SkIRect& clipBounds = clip.getBounds();
+
+    // Only the SafeRLEAdditiveBlitter and aaa_walk_edges() flavor of AAAFillPath is banded.
+    if (path.countPoints() < kMinBandedPathPoints || MaskAdditiveBlitter::CanHandleRect(ir) ||
+        path.isInverseFillType() || path.isConvex()) {
+        return false;
+    }
+
+    const uint8_t*  verbs   = SkPathPriv::VerbData(path);
+    const SkPoint*  pts     = SkPathPriv::PointData(path);
+    const SkScalar* weights = SkPathPriv::ConicWeightData(path);
+    const int       verbCount = path.countVerbs();
+
+    std::vector<BandContour> contours;
+    {
+        int point = 0, weight = 0;
+        for (int verb = 0; verb < verbCount; ++verb) {
+            if (verbs[verb] == SkPath::kMove_Verb) {
+                contours.push_back({verb, point, weight, pts[point].fY, pts[point].fY});
+            }
+            BandContour& contour = contours.back();
+            const int n = SkPathPriv::PtsInVerb(verbs[verb]);
+            for (int i = 0; i < n; ++i) {
+                contour.fTop    = std::min(contour.fTop, pts[point + i].fY);
+                contour.fBottom = std::max(contour.fBottom, pts[point + i].fY);
+            }
+            point += n;
+            weight += verbs[verb] == SkPath::kConic_Verb;
+        }
+        // A sentinel marking where the last contour ends.
+        contours.push_back({verbCount, point, weight, 0, 0});
+    }
+    const int contourCount = SkToInt(contours.size()) - 1;
+    if (contourCount < 2) {
+        return false;
+    }
+
+    // Group the contours top to bottom, cutting wherever they are far enough apart, and deal the
+    // groups out into bands of roughly the same number of points.
+    std::vector<int> order(contourCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return contours[a].fTop < contours[b].fTop;
+    });
+
+    std::vector<Band> bands(1);
+    std::vector<int>  bandOf(contourCount);
+    {
+        const int targetPoints = path.countPoints() / kMaxBands;
+        float     bottom       = contours[order[0]].fBottom;
+        for (int i : order) {
+            const BandContour& contour = contours[i];
+            const float        cut     = sk_float_ceil(bottom);
+            if (bands.back().fPoints >= targetPoints && contour.fTop >= cut + 0.5f &&
+                SkToInt(bands.size()) < kMaxBands) {
+                bands.push_back({});
+                bands.back().fTop = sk_float_saturate2int(cut);
+            }
+            bandOf[i] = SkToInt(bands.size()) - 1;
+            bands.back().fPoints += contours[i + 1].fPoint - contour.fPoint;
+            bottom = std::max(bottom, contour.fBottom);
+        }
+    }
+    const int bandCount = SkToInt(bands.size());
+    if (bandCount < 2) {
+        return false;
+    }
+    for (int i = 0; i < bandCount; ++i) {
+        bands[i].fBottom = i + 1 < bandCount ? bands[i + 1].fTop : SK_MaxS32;
+    }
+    for (int i = 0; i < contourCount; ++i) {
+        std::vector<std::pair<int, int>>& runs = bands[bandOf[i]].fRuns;
+        if (i > 0 && bandOf[i - 1] == bandOf[i]) {
+            runs.back().second = i + 1;
+        } else {
+            runs.push_back({i, i + 1});
+        }
+    }
+
+    const bool containedInClip = clipBounds.contains(ir);
+
+    SkTaskGroup tasks(*executor);
+    tasks.batch(bandCount, [&](int i) {
+        Band& band = bands[i];
+        for (auto [first, end] : band.fRuns) {
+            const BandContour& a = contours[first];
+            const BandContour& b = contours[end];
+            SkPath run = SkPath::Make(pts + a.fPoint, b.fPoint - a.fPoint,
+                                      verbs + a.fVerb, b.fVerb - a.fVerb,
+                                      weights + a.fWeight, b.fWeight - a.fWeight,
+                                      path.getFillType());
+
+            auto& builder = band.fBuilders.emplace_back(std::make_unique<SkAnalyticEdgeBuilder>());
+            int count = builder->buildEdges(run, path, containedInClip ? nullptr : &clipBounds);
+            band.fRunEdges.push_back(count);
+            band.fEdgeCount += count;
+        }
+    });
+    tasks.wait();
+
+    // The sort isn't stable, so edges that compare equal end up in an order that depends on the
+    // whole list. Sorting each band on its own could swap them, and coincident edges in a
+    // different order can accumulate different coverage. Instead gather every edge in the order
+    // the serial build produces them (contour runs in path order) and sort them all at once, just
+    // as AAAFillPath does. Bands are separated in y, so each band's edges stay contiguous.
+    std::vector<SkAnalyticEdge*> edges;
+    {
+        std::vector<int> nextRun(bandCount, 0);
+        for (int i = 0; i < contourCount; ++i) {
+            if (i > 0 && bandOf[i - 1] == bandOf[i]) {
+                continue;
+            }
+            Band& band = bands[bandOf[i]];
+            const int run = nextRun[bandOf[i]]++;
+            SkAnalyticEdge** list = band.fBuilders[run]->analyticEdgeList();
+            edges.insert(edges.end(), list, list + band.fRunEdges[run]);
+        }
+    }
+
+    // What AAAFillPath decides from the whole edge list has to be decided the same way here.
+    const int count = SkToInt(edges.size());
+    if (count == 0) {
+        return true;
+    }
+    SkAnalyticEdge* last;
+    SkAnalyticEdge* first = sort_edges(edges.data(), count, &last);
+    Band* firstBand = nullptr;
+    {
+        int offset = 0;
+        for (Band& band : bands) {
+            if (band.fEdgeCount > 0) {
+                band.fFirst = edges[offset];
+                band.fLast  = edges[offset + band.fEdgeCount - 1];
+                offset += band.fEdgeCount;
+                firstBand = firstBand ? firstBand : &band;
+            }
+        }
+        SkASSERT(offset == count);
+    }
+
+    int start_y = ir.fTop;
+    int stop_y  = ir.fBottom;
+    if (!containedInClip && start_y < clipBounds.fTop) {
+        start_y = clipBounds.fTop;
+    }
+    if (!containedInClip && stop_y > clipBounds.fBottom) {
+        stop_y = clipBounds.fBottom;
+    }
+
+    const bool useDeferred =
+            count > (SkFixedFloorToInt(last->fLowerY - first->fUpperY) + 1) * 4;
+    const bool skipIntersect = path.countPoints() > (stop_y - start_y) * 2;
+
+    tasks.batch(bandCount, [&](int i) {
+        Band& band = bands[i];
+        const bool resume = &band != firstBand;
+        const int  bandStart = resume ? band.fTop : start_y;
+        const int  bandStop  = std::min(band.fBottom, stop_y);
+        if (!band.fFirst || bandStart >= bandStop) {
+            return;
+        }
+
+        SkSTArenaAlloc<kSkBlitterContextSize> alloc;
+        SkScanClipper clipper(makeBlitter(&alloc), &clip, ir);
+        if (!clipper.getBlitter()) {
+            return;
+        }
+        SafeRLEAdditiveBlitter additiveBlitter(clipper.getBlitter(), ir, clipBounds, false);
+
+        SkAnalyticEdge headEdge, tailEdge;
+        link_sentinel_edges(&headEdge, &tailEdge, band.fFirst, band.fLast);
+        aaa_walk_edges(&headEdge,
+                       &tailEdge,
+                       path.getFillType(),
+                       &additiveBlitter,
+                       bandStart,
+                       bandStop,
+                       SkIntToFixed(clipBounds.fLeft),
+                       SkIntToFixed(clipBounds.fRight),
+                       false,
+                       false,
+                       useDeferred,
+                       skipIntersect,
+                       resume);
+    });
+    tasks.wait();
+    return true;
+}
 #endif  // defined(SK_DISABLE_AAA)
@@ -785,3 +785,39 @@ void SkScan::AntiFillPath(const SkPath& path, const SkRasterClip& clip, SkBlitte
         AntiFillPath(path, tmp, &aaBlitter, true); // SkAAClipBlitter can blitMask, why forceRLE?
     }
 }
+
+bool SkScan::AntiFillPathBanded(const SkPath& path, const SkRasterClip& clip,
+                                SkExecutor* executor, const BandBlitterProc& makeBlitter) {
+    // Only the analytic walk over a non-convex, non-inverse path with a BW clip is split into
+    // bands; everything else (including all the trivial cases) is left to AntiFillPath.
+    if (!executor || clip.isEmpty() || !clip.isBW() || !path.isFinite() ||
+        path.isInverseFillType() || path.isConvex() || !ShouldUseAAA(path)) {
+        return false;
+    }
+
+    const SkRegion& origClip = clip.bwRgn();
+    SkIRect ir = safeRoundOut(path.getBounds());
+    SkIRect clippedIR;
+    if (ir.isEmpty() || !clippedIR.intersect(ir, origClip.getBounds()) ||
+        rect_overflows_short_shift(clippedIR, SHIFT)) {
+        return false;
+    }
+
+    // Same clip limit as AntiFillPath.
+    SkRegion tmpClipStorage;
+    const SkRegion* clipRgn = &origClip;
+    {
+        static const int32_t kMaxClipCoord = 32767;
+        const SkIRect& bounds = origClip.getBounds();
+        if (bounds.fRight > kMaxClipCoord || bounds.fBottom > kMaxClipCoord) {
+            SkIRect limit = { 0, 0, kMaxClipCoord, kMaxClipCoord };
+            tmpClipStorage.op(origClip, limit, SkRegion::kIntersect_Op);
+            clipRgn = &tmpClipStorage;
+        }
+    }
+    if (!SkIRect::Intersects(clipRgn->getBounds(), ir)) {
+        return false;
+    }
+
+    return SkScan::AAAFillPathBanded(path, *clipRgn, ir, executor, makeBlitter);
+}
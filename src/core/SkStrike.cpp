@@ -12,6 +12,7 @@
 #include "include/core/SkPath.h"
 #include "include/core/SkTraceMemoryDump.h"
 #include "include/core/SkTypeface.h"
+#include "include/private/base/SkMath.h"
 #include "src/core/SkDistanceFieldGen.h"
 #include "src/core/SkEnumerate.h"
 #include "src/core/SkGlyph.h"
@@ -96,11 +97,26 @@ SkGlyph* SkStrike::mergeGlyphAndImage(SkPackedGlyphID toID, const SkGlyph& fromG
     } else {
         SkGlyph* glyph = fAlloc.make<SkGlyph>(toID);
         fMemoryIncrease += glyph->setMetricsAndImage(&fAlloc, fromGlyph) + sizeof(SkGlyph);
-        (void)this->addGlyphAndDigest(glyph);
+        this->publish(*this->addGlyphAndDigest(glyph), glyph);
         return glyph;
     }
 }
 
+bool SkStrike::mergeGlyphIfAbsent(const SkGlyph& fromGlyph, bool hasPath, const SkPath* path,
+                                  bool hairline) {
+    Monitor m{this};
+    if (fDigestForPackedGlyphID.find(fromGlyph.getPackedID()) != nullptr) {
+        return false;
+    }
+    SkGlyph* glyph = fAlloc.make<SkGlyph>(fromGlyph.getPackedID());
+    fMemoryIncrease += glyph->setMetricsAndImage(&fAlloc, fromGlyph) + sizeof(SkGlyph);
+    if (hasPath && glyph->setPath(&fAlloc, path, hairline)) {
+        fMemoryIncrease += glyph->path()->approximateBytesUsed();
+    }
+    this->publish(*this->addGlyphAndDigest(glyph), glyph);
+    return true;
+}
+
 const SkPath* SkStrike::mergePath(SkGlyph* glyph, const SkPath* path, bool hairline) {
     Monitor m{this};
     if (glyph->setPathHasBeenCalled()) {
@@ -134,8 +150,20 @@ void SkStrike::findIntercepts(const SkScalar bounds[2], SkScalar scale, SkScalar
 
 SkSpan<const SkGlyph*> SkStrike::metrics(
         SkSpan<const SkGlyphID> glyphIDs, const SkGlyph* results[]) {
-    Monitor m{this};
-    return this->internalPrepare(glyphIDs, kMetricsOnly, results);
+    // Every published glyph has its metrics, so only lock the strike if some glyph is missing.
+    size_t found = 0;
+    for (; found < glyphIDs.size(); ++found) {
+        const PublishedGlyph* published = this->findPublished(SkPackedGlyphID{glyphIDs[found]});
+        if (published == nullptr) {
+            break;
+        }
+        results[found] = published->fGlyph;
+    }
+    if (found < glyphIDs.size()) {
+        Monitor m{this};
+        this->internalPrepare(glyphIDs.subspan(found), kMetricsOnly, results + found);
+    }
+    return {results, glyphIDs.size()};
 }
 
 SkSpan<const SkGlyph*> SkStrike::preparePaths(
@@ -191,6 +219,13 @@ void SkStrike::glyphIDsToDrawables(SkSpan<sktext::IDOrDrawable> idsOrDrawables)
     }
 }
 
+void SkStrike::forEachGlyph(std::function<void(const SkGlyph&)> visitor) const {
+    SkAutoMutexExclusive lock{fStrikeLock};
+    for (const SkGlyph* glyph : fGlyphForIndex) {
+        visitor(*glyph);
+    }
+}
+
 void SkStrike::dump() const {
     SkAutoMutexExclusive lock{fStrikeLock};
     const SkTypeface* face = fScalerContext->getTypeface();
@@ -245,6 +280,17 @@ SkGlyph* SkStrike::glyph(SkPackedGlyphID packedGlyphID) {
     return this->glyph(digest);
 }
 
+std::tuple<SkGlyphDigest, SkGlyph*> SkStrike::digestAndGlyphFor(ActionType actionType,
+                                                               SkPackedGlyphID packedID) {
+    const PublishedGlyph* published = this->findPublished(packedID);
+    if (published != nullptr && published->fDigest.actionFor(actionType) != GlyphAction::kUnset) {
+        return {published->fDigest, published->fGlyph};
+    }
+    Monitor m{this};
+    SkGlyphDigest digest = this->digestFor(actionType, packedID);
+    return {digest, this->glyph(digest)};
+}
+
 SkGlyphDigest SkStrike::digestFor(ActionType actionType, SkPackedGlyphID packedGlyphID) {
     SkGlyphDigest* digestPtr = fDigestForPackedGlyphID.find(packedGlyphID);
     if (digestPtr != nullptr && digestPtr->actionFor(actionType) != GlyphAction::kUnset) {
@@ -261,6 +307,7 @@ SkGlyphDigest SkStrike::digestFor(ActionType actionType, SkPackedGlyphID packedG
     }
 
     digestPtr->setActionFor(actionType, glyph, this);
+    this->publish(*digestPtr, glyph);
 
     return *digestPtr;
 }
@@ -273,6 +320,67 @@ SkGlyphDigest* SkStrike::addGlyphAndDigest(SkGlyph* glyph) {
     return newDigest;
 }
 
+SkStrike::PublishedGlyphTable::PublishedGlyphTable(int capacity)
+        : fCapacity{capacity}
+        , fSlots{new std::atomic<const PublishedGlyph*>[capacity]()} {
+    SkASSERT(SkIsPow2(capacity));
+}
+
+const SkStrike::PublishedGlyph* SkStrike::PublishedGlyphTable::find(
+        SkPackedGlyphID packedID) const {
+    const int mask = fCapacity - 1;
+    for (int i = SkPackedGlyphID::Hash()(packedID) & mask;; i = (i + 1) & mask) {
+        const PublishedGlyph* glyph = fSlots[i].load(std::memory_order_acquire);
+        if (glyph == nullptr || glyph->fGlyph->getPackedID() == packedID) {
+            return glyph;
+        }
+    }
+}
+
+bool SkStrike::PublishedGlyphTable::insert(const PublishedGlyph* glyph) {
+    const SkPackedGlyphID packedID = glyph->fGlyph->getPackedID();
+    const int mask = fCapacity - 1;
+    for (int i = SkPackedGlyphID::Hash()(packedID) & mask;; i = (i + 1) & mask) {
+        const PublishedGlyph* old = fSlots[i].load(std::memory_order_relaxed);
+        if (old == nullptr || old->fGlyph->getPackedID() == packedID) {
+            fSlots[i].store(glyph, std::memory_order_release);
+            return old == nullptr;
+        }
+    }
+}
+
+const SkStrike::PublishedGlyph* SkStrike::findPublished(SkPackedGlyphID packedID) const {
+    const PublishedGlyphTable* table = fPublished.load(std::memory_order_acquire);
+    return table != nullptr ? table->find(packedID) : nullptr;
+}
+
+void SkStrike::publish(const SkGlyphDigest& digest, SkGlyph* glyph) {
+    const PublishedGlyph* published = fAlloc.make<PublishedGlyph>(PublishedGlyph{digest, glyph});
+    fMemoryIncrease += sizeof(PublishedGlyph);
+
+    PublishedGlyphTable* table =
+            fPublishedTables.empty() ? nullptr : fPublishedTables.back().get();
+    if (table == nullptr || 2 * (fPublishedCount + 1) > table->fCapacity) {
+        auto grown = std::make_unique<PublishedGlyphTable>(
+                table != nullptr ? 2 * table->fCapacity : SkToInt(kMinGlyphCount) * 2);
+        if (table != nullptr) {
+            for (int i = 0; i < table->fCapacity; ++i) {
+                if (const PublishedGlyph* old = table->fSlots[i].load(std::memory_order_relaxed)) {
+                    grown->insert(old);
+                }
+            }
+        }
+        fMemoryIncrease += sizeof(PublishedGlyphTable) +
+                           grown->fCapacity * sizeof(std::atomic<const PublishedGlyph*>);
+        table = grown.get();
+        fPublishedTables.push_back(std::move(grown));
+        fPublished.store(table, std::memory_order_release);
+    }
+    if (table->insert(published)) {
+        fPublishedCount += 1;
+    }
+}
+
 bool SkStrike::prepareForImage(SkGlyph* glyph) {
     if (glyph->setImage(&fAlloc, fScalerContext.get())) {
         fMemoryIncrease += glyph->imageSize();
@@ -312,12 +420,14 @@ SkSpan<const SkGlyph*> SkStrike::internalPrepare(
 
 void SkStrike::updateMemoryUsage(size_t increase) {
     if (increase > 0) {
-        // fRemoved and the cache's total memory are managed under the cache's lock. This allows
+        // fRemoved and the shard's memory are managed under the shard's lock. This allows
         // them to be accessed under LRU operation.
-        SkAutoMutexExclusive lock{fStrikeCache->fLock};
+        SkStrikeCache::Shard& shard = fStrikeCache->shardFor(this->getDescriptor());
+        SkAutoMutexExclusive lock{shard.fLock};
         fMemoryUsed += increase;
         if (!fRemoved) {
-            fStrikeCache->fTotalMemoryUsed += increase;
+            shard.fMemoryUsed += increase;
+            fStrikeCache->fTotalMemoryUsed.fetch_add(increase, std::memory_order_relaxed);
         }
     }
 }
@@ -19,7 +19,11 @@
 #include "src/core/SkStrikeSpec.h"
 #include "src/core/SkTHash.h"
 
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <tuple>
+#include <vector>
 
 class SkScalerContext;
 class SkStrikeCache;
@@ -64,6 +68,11 @@ public:
     const SkPath* mergePath(
             SkGlyph* glyph, const SkPath* path, bool hairline) SK_EXCLUDES(fStrikeLock);
 
+    // If the strike has no glyph with fromGlyph's ID, add a copy of fromGlyph with its image and,
+    // if hasPath, path. Returns false, changing nothing, if the strike already has the glyph.
+    bool mergeGlyphIfAbsent(const SkGlyph& fromGlyph, bool hasPath, const SkPath* path,
+                            bool hairline) SK_EXCLUDES(fStrikeLock);
+
     // If the drawable has never been set, then add a drawable to glyph.
     const SkDrawable* mergeDrawable(
             SkGlyph* glyph, sk_sp<SkDrawable> drawable) SK_EXCLUDES(fStrikeLock);
@@ -119,11 +128,20 @@ public:
         }
     }
 
+    // Call visitor on every glyph in the strike while holding fStrikeLock.
+    void forEachGlyph(std::function<void(const SkGlyph&)> visitor) const SK_EXCLUDES(fStrikeLock);
+
     void dump() const SK_EXCLUDES(fStrikeLock);
     void dumpMemoryStatistics(SkTraceMemoryDump* dump) const SK_EXCLUDES(fStrikeLock);
 
     SkGlyph* glyph(SkGlyphDigest) SK_REQUIRES(fStrikeLock);
 
+    // Like digestFor() followed by glyph(), but only takes fStrikeLock if packedID has not been
+    // looked up for actionType before. Most glyphs drawn have been drawn before, so this lets
+    // threads drawing with the same strike mostly avoid contending for it.
+    std::tuple<SkGlyphDigest, SkGlyph*> digestAndGlyphFor(
+            skglyph::ActionType actionType, SkPackedGlyphID packedID) SK_EXCLUDES(fStrikeLock);
+
 private:
     friend class SkStrikeCache;
     class Monitor;
@@ -138,6 +156,30 @@ private:
     // Maintain memory use statistics.
     void updateMemoryUsage(size_t increase) SK_EXCLUDES(fStrikeLock);
 
+    // A glyph's digest as of when it was published. Published glyphs can be read without
+    // holding fStrikeLock, so they are never changed; publishing a new digest replaces them.
+    struct PublishedGlyph {
+        SkGlyphDigest fDigest;
+        SkGlyph* fGlyph;
+    };
+
+    // An open addressed hash table of published glyphs that is never more than half full.
+    struct PublishedGlyphTable {
+        explicit PublishedGlyphTable(int capacity);
+        const PublishedGlyph* find(SkPackedGlyphID packedID) const;
+        // Returns true if packedID was not in the table already.
+        bool insert(const PublishedGlyph* glyph);
+
+        const int fCapacity;
+        std::unique_ptr<std::atomic<const PublishedGlyph*>[]> fSlots;
+    };
+
+    // Returns the latest published glyph for packedID, or nullptr. Does not need fStrikeLock.
+    const PublishedGlyph* findPublished(SkPackedGlyphID packedID) const;
+
+    // Makes digest and glyph visible to findPublished().
+    void publish(const SkGlyphDigest& digest, SkGlyph* glyph) SK_REQUIRES(fStrikeLock);
+
     enum PathDetail {
         kMetricsOnly,
         kMetricsAndPath
@@ -169,6 +211,12 @@ private:
     // Maps from a glyphIndex to a glyph
     std::vector<SkGlyph*> fGlyphForIndex SK_GUARDED_BY(fStrikeLock);
 
+    // The table findPublished() searches. Readers may still be using a table after it has been
+    // replaced by a larger one, so all the tables are kept until the strike is deleted.
+    std::atomic<const PublishedGlyphTable*> fPublished{nullptr};
+    std::vector<std::unique_ptr<PublishedGlyphTable>> fPublishedTables SK_GUARDED_BY(fStrikeLock);
+    int fPublishedCount SK_GUARDED_BY(fStrikeLock) {0};
+
     // Context that corresponds to the glyph information in this strike.
     const std::unique_ptr<SkScalerContext> fScalerContext SK_GUARDED_BY(fStrikeLock);
 
@@ -182,7 +230,7 @@ private:
 
     SkArenaAlloc            fAlloc SK_GUARDED_BY(fStrikeLock) {kMinAllocAmount};
 
-    // The following are protected by the SkStrikeCache's mutex.
+    // The following are protected by the mutex of the SkStrikeCache shard holding this strike.
     SkStrike*                       fNext{nullptr};
     SkStrike*                       fPrev{nullptr};
     std::unique_ptr<SkStrikePinner> fPinner;
@@ -8,6 +8,7 @@
 #include "src/core/SkStrikeCache.h"
 
 #include <cctype>
+#include <cmath>
 
 #include "include/core/SkGraphics.h"
 #include "include/core/SkRefCnt.h"
@@ -36,12 +37,14 @@ SkStrikeCache* SkStrikeCache::GlobalStrikeCache() {
 }
 
 auto SkStrikeCache::findOrCreateStrike(const SkStrikeSpec& strikeSpec) -> sk_sp<SkStrike> {
-    SkAutoMutexExclusive ac(fLock);
-    sk_sp<SkStrike> strike = this->internalFindStrikeOrNull(strikeSpec.descriptor());
-    if (strike == nullptr) {
-        strike = this->internalCreateStrike(strikeSpec);
+    sk_sp<SkStrike> strike;
+    {
+        Shard& shard = this->shardFor(strikeSpec.descriptor());
+        SkAutoMutexExclusive ac(shard.fLock);
+        bool created;
+        strike = this->internalFindOrCreateStrike(shard, strikeSpec, nullptr, &created);
     }
-    this->internalPurge();
+    this->purgeIfNeeded();
     return strike;
 }
 
@@ -89,34 +92,46 @@ void SkStrikeCache::DumpMemoryStatistics(SkTraceMemoryDump* dump) {
 }
 
 sk_sp<SkStrike> SkStrikeCache::findStrike(const SkDescriptor& desc) {
-    SkAutoMutexExclusive ac(fLock);
-    sk_sp<SkStrike> result = this->internalFindStrikeOrNull(desc);
-    this->internalPurge();
+    sk_sp<SkStrike> result;
+    {
+        Shard& shard = this->shardFor(desc);
+        SkAutoMutexExclusive ac(shard.fLock);
+        result = this->internalFindStrikeOrNull(shard, desc);
+    }
+    this->purgeIfNeeded();
     return result;
 }
 
-auto SkStrikeCache::internalFindStrikeOrNull(const SkDescriptor& desc) -> sk_sp<SkStrike> {
+auto SkStrikeCache::shardFor(const SkDescriptor& desc) -> Shard& {
+    // The low bits of the checksum pick the bucket in the shard's hash table, so use the high
+    // bits to pick the shard.
+    return fShards[desc.getChecksum() >> 28];
+}
+
+auto SkStrikeCache::internalFindStrikeOrNull(Shard& shard, const SkDescriptor& desc)
+        -> sk_sp<SkStrike> {
+    SkStrike*& head = shard.fHead;
 
     // Check head because it is likely the strike we are looking for.
-    if (fHead != nullptr && fHead->getDescriptor() == desc) { return sk_ref_sp(fHead); }
+    if (head != nullptr && head->getDescriptor() == desc) { return sk_ref_sp(head); }
 
     // Do the heavy search looking for the strike.
-    sk_sp<SkStrike>* strikeHandle = fStrikeLookup.find(desc);
+    sk_sp<SkStrike>* strikeHandle = shard.fStrikeLookup.find(desc);
     if (strikeHandle == nullptr) { return nullptr; }
     SkStrike* strikePtr = strikeHandle->get();
     SkASSERT(strikePtr != nullptr);
-    if (fHead != strikePtr) {
+    if (head != strikePtr) {
         // Make most recently used
         strikePtr->fPrev->fNext = strikePtr->fNext;
         if (strikePtr->fNext != nullptr) {
             strikePtr->fNext->fPrev = strikePtr->fPrev;
         } else {
-            fTail = strikePtr->fPrev;
+            shard.fTail = strikePtr->fPrev;
         }
-        fHead->fPrev = strikePtr;
-        strikePtr->fNext = fHead;
+        head->fPrev = strikePtr;
+        strikePtr->fNext = head;
         strikePtr->fPrev = nullptr;
-        fHead = strikePtr;
+        head = strikePtr;
     }
     return sk_ref_sp(strikePtr);
 }
@@ -125,53 +140,63 @@ sk_sp<SkStrike> SkStrikeCache::createStrike(
         const SkStrikeSpec& strikeSpec,
         SkFontMetrics* maybeMetrics,
         std::unique_ptr<SkStrikePinner> pinner) {
-    SkAutoMutexExclusive ac(fLock);
-    return this->internalCreateStrike(strikeSpec, maybeMetrics, std::move(pinner));
+    Shard& shard = this->shardFor(strikeSpec.descriptor());
+    SkAutoMutexExclusive ac(shard.fLock);
+    return this->internalCreateStrike(shard, strikeSpec, maybeMetrics, std::move(pinner));
 }
 
 auto SkStrikeCache::internalCreateStrike(
+        Shard& shard,
         const SkStrikeSpec& strikeSpec,
         SkFontMetrics* maybeMetrics,
         std::unique_ptr<SkStrikePinner> pinner) -> sk_sp<SkStrike> {
     std::unique_ptr<SkScalerContext> scaler = strikeSpec.createScalerContext();
     auto strike =
         sk_make_sp<SkStrike>(this, strikeSpec, std::move(scaler), maybeMetrics, std::move(pinner));
-    this->internalAttachToHead(strike);
+    this->internalAttachToHead(shard, strike);
+    return strike;
+}
+
+auto SkStrikeCache::internalFindOrCreateStrike(
+        Shard& shard,
+        const SkStrikeSpec& strikeSpec,
+        SkFontMetrics* maybeMetrics,
+        bool* created) -> sk_sp<SkStrike> {
+    sk_sp<SkStrike> strike = this->internalFindStrikeOrNull(shard, strikeSpec.descriptor());
+    *created = strike == nullptr;
+    if (*created) {
+        strike = this->internalCreateStrike(shard, strikeSpec, maybeMetrics);
+    }
     return strike;
 }
 
 void SkStrikeCache::purgeAll() {
-    SkAutoMutexExclusive ac(fLock);
-    this->internalPurge(fTotalMemoryUsed);
+    SkAutoMutexExclusive ac(fPurgeLock);
+    this->internalPurge(fTotalMemoryUsed.load(std::memory_order_relaxed));
 }
 
 size_t SkStrikeCache::getTotalMemoryUsed() const {
-    SkAutoMutexExclusive ac(fLock);
-    return fTotalMemoryUsed;
+    return fTotalMemoryUsed.load(std::memory_order_relaxed);
 }
 
 int SkStrikeCache::getCacheCountUsed() const {
-    SkAutoMutexExclusive ac(fLock);
-    return fCacheCount;
+    return fCacheCount.load(std::memory_order_relaxed);
 }
 
 int SkStrikeCache::getCacheCountLimit() const {
-    SkAutoMutexExclusive ac(fLock);
-    return fCacheCountLimit;
+    return fCacheCountLimit.load(std::memory_order_relaxed);
 }
 
 size_t SkStrikeCache::setCacheSizeLimit(size_t newLimit) {
-    SkAutoMutexExclusive ac(fLock);
+    SkAutoMutexExclusive ac(fPurgeLock);
 
-    size_t prevLimit = fCacheSizeLimit;
-    fCacheSizeLimit = newLimit;
+    size_t prevLimit = fCacheSizeLimit.exchange(newLimit, std::memory_order_relaxed);
     this->internalPurge();
     return prevLimit;
 }
 
 size_t  SkStrikeCache::getCacheSizeLimit() const {
-    SkAutoMutexExclusive ac(fLock);
-    return fCacheSizeLimit;
+    return fCacheSizeLimit.load(std::memory_order_relaxed);
 }
 
 int SkStrikeCache::setCacheCountLimit(int newCount) {
@@ -179,40 +204,59 @@ int SkStrikeCache::setCacheCountLimit(int newCount) {
         newCount = 0;
     }
 
-    SkAutoMutexExclusive ac(fLock);
+    SkAutoMutexExclusive ac(fPurgeLock);
 
-    int prevCount = fCacheCountLimit;
-    fCacheCountLimit = newCount;
+    int prevCount = fCacheCountLimit.exchange(newCount, std::memory_order_relaxed);
     this->internalPurge();
     return prevCount;
 }
 
 void SkStrikeCache::forEachStrike(std::function<void(const SkStrike&)> visitor) const {
-    SkAutoMutexExclusive ac(fLock);
+    for (const Shard& shard : fShards) {
+        SkAutoMutexExclusive ac(shard.fLock);
+
+        this->validate(shard);
 
-    this->validate();
+        for (SkStrike* strike = shard.fHead; strike != nullptr; strike = strike->fNext) {
+            visitor(*strike);
+        }
+    }
+}
 
-    for (SkStrike* strike = fHead; strike != nullptr; strike = strike->fNext) {
-        visitor(*strike);
+void SkStrikeCache::purgeIfNeeded() {
+    if (fTotalMemoryUsed.load(std::memory_order_relaxed) <=
+                fCacheSizeLimit.load(std::memory_order_relaxed) &&
+        fCacheCount.load(std::memory_order_relaxed) <=
+                fCacheCountLimit.load(std::memory_order_relaxed)) {
+        return;
     }
+
+    // A thread that waited here for another thread's purge will usually find nothing to do.
+    SkAutoMutexExclusive ac(fPurgeLock);
+    this->internalPurge();
 }
 
 size_t SkStrikeCache::internalPurge(size_t minBytesNeeded) {
+    const size_t totalMemoryUsed = fTotalMemoryUsed.load(std::memory_order_relaxed);
+    const size_t cacheSizeLimit = fCacheSizeLimit.load(std::memory_order_relaxed);
+    const int32_t cacheCount = fCacheCount.load(std::memory_order_relaxed);
+    const int32_t cacheCountLimit = fCacheCountLimit.load(std::memory_order_relaxed);
+
     size_t bytesNeeded = 0;
-    if (fTotalMemoryUsed > fCacheSizeLimit) {
-        bytesNeeded = fTotalMemoryUsed - fCacheSizeLimit;
+    if (totalMemoryUsed > cacheSizeLimit) {
+        bytesNeeded = totalMemoryUsed - cacheSizeLimit;
     }
     bytesNeeded = std::max(bytesNeeded, minBytesNeeded);
     if (bytesNeeded) {
         // no small purges!
-        bytesNeeded = std::max(bytesNeeded, fTotalMemoryUsed >> 2);
+        bytesNeeded = std::max(bytesNeeded, totalMemoryUsed >> 2);
     }
 
     int countNeeded = 0;
-    if (fCacheCount > fCacheCountLimit) {
-        countNeeded = fCacheCount - fCacheCountLimit;
+    if (cacheCount > cacheCountLimit) {
+        countNeeded = cacheCount - cacheCountLimit;
         // no small purges!
-        countNeeded = std::max(countNeeded, fCacheCount >> 2);
+        countNeeded = std::max(countNeeded, cacheCount >> 2);
     }
 
     // early exit
@@ -223,23 +267,53 @@ size_t SkStrikeCache::internalPurge(size_t minBytesNeeded) {
     size_t  bytesFreed = 0;
     int     countFreed = 0;
 
-    // Start at the tail and proceed backwards deleting; the list is in LRU
-    // order, with unimportant entries at the tail.
-    SkStrike* strike = fTail;
-    while (strike != nullptr && (bytesFreed < bytesNeeded || countFreed < countNeeded)) {
-        SkStrike* prev = strike->fPrev;
-
-        // Only delete if the strike is not pinned.
-        if (strike->fPinner == nullptr || strike->fPinner->canDelete()) {
-            bytesFreed += strike->fMemoryUsed;
-            countFreed += 1;
-            this->internalRemoveStrike(strike);
+    // There is no global LRU order, so take from each shard in proportion to its size. The first
+    // pass takes each shard's share, the second makes up for shards whose strikes were pinned.
+    for (int pass = 0; pass < 2; pass++) {
+        for (Shard& shard : fShards) {
+            if (bytesFreed >= bytesNeeded && countFreed >= countNeeded) {
+                break;
+            }
+
+            SkAutoMutexExclusive ac(shard.fLock);
+
+            size_t shardBytesNeeded = bytesNeeded - std::min(bytesFreed, bytesNeeded);
+            int    shardCountNeeded = countNeeded - std::min(countFreed, countNeeded);
+            if (pass == 0) {
+                double share = totalMemoryUsed ? (double)shard.fMemoryUsed / totalMemoryUsed : 0;
+                shardBytesNeeded = std::min(shardBytesNeeded,
+                                            (size_t)std::ceil(share * bytesNeeded));
+                share = cacheCount ? (double)shard.fCount / cacheCount : 0;
+                shardCountNeeded = std::min(shardCountNeeded,
+                                            (int)std::ceil(share * countNeeded));
+            }
+
+            size_t shardBytesFreed = 0;
+            int    shardCountFreed = 0;
+
+            // Start at the tail and proceed backwards deleting; the list is in LRU
+            // order, with unimportant entries at the tail.
+            SkStrike* strike = shard.fTail;
+            while (strike != nullptr &&
+                   (shardBytesFreed < shardBytesNeeded || shardCountFreed < shardCountNeeded)) {
+                SkStrike* prev = strike->fPrev;
+
+                // Only delete if the strike is not pinned.
+                if (strike->fPinner == nullptr || strike->fPinner->canDelete()) {
+                    shardBytesFreed += strike->fMemoryUsed;
+                    shardCountFreed += 1;
+                    this->internalRemoveStrike(shard, strike);
+                }
+                strike = prev;
+            }
+
+            this->validate(shard);
+
+            bytesFreed += shardBytesFreed;
+            countFreed += shardCountFreed;
         }
-        strike = prev;
     }
 
-    this->validate();
-
 #ifdef SPEW_PURGE_STATUS
     if (countFreed) {
         SkDebugf("purging %dK from font cache [%d entries]\n",
@@ -250,68 +324,72 @@ size_t SkStrikeCache::internalPurge(size_t minBytesNeeded) {
     return bytesFreed;
 }
 
-void SkStrikeCache::internalAttachToHead(sk_sp<SkStrike> strike) {
-    SkASSERT(fStrikeLookup.find(strike->getDescriptor()) == nullptr);
+void SkStrikeCache::internalAttachToHead(Shard& shard, sk_sp<SkStrike> strike) {
+    SkASSERT(shard.fStrikeLookup.find(strike->getDescriptor()) == nullptr);
     SkStrike* strikePtr = strike.get();
-    fStrikeLookup.set(std::move(strike));
+    shard.fStrikeLookup.set(std::move(strike));
     SkASSERT(nullptr == strikePtr->fPrev && nullptr == strikePtr->fNext);
 
-    fCacheCount += 1;
-    fTotalMemoryUsed += strikePtr->fMemoryUsed;
+    shard.fCount += 1;
+    shard.fMemoryUsed += strikePtr->fMemoryUsed;
+    fCacheCount.fetch_add(1, std::memory_order_relaxed);
+    fTotalMemoryUsed.fetch_add(strikePtr->fMemoryUsed, std::memory_order_relaxed);
 
-    if (fHead != nullptr) {
-        fHead->fPrev = strikePtr;
-        strikePtr->fNext = fHead;
+    if (shard.fHead != nullptr) {
+        shard.fHead->fPrev = strikePtr;
+        strikePtr->fNext = shard.fHead;
     }
 
-    if (fTail == nullptr) {
-        fTail = strikePtr;
+    if (shard.fTail == nullptr) {
+        shard.fTail = strikePtr;
     }
 
-    fHead = strikePtr; // Transfer ownership of strike to the cache list.
+    shard.fHead = strikePtr; // Transfer ownership of strike to the cache list.
 }
 
-void SkStrikeCache::internalRemoveStrike(SkStrike* strike) {
-    SkASSERT(fCacheCount > 0);
-    fCacheCount -= 1;
-    fTotalMemoryUsed -= strike->fMemoryUsed;
+void SkStrikeCache::internalRemoveStrike(Shard& shard, SkStrike* strike) {
+    SkASSERT(shard.fCount > 0);
+    shard.fCount -= 1;
+    shard.fMemoryUsed -= strike->fMemoryUsed;
+    fCacheCount.fetch_sub(1, std::memory_order_relaxed);
+    fTotalMemoryUsed.fetch_sub(strike->fMemoryUsed, std::memory_order_relaxed);
 
     if (strike->fPrev) {
         strike->fPrev->fNext = strike->fNext;
     } else {
-        fHead = strike->fNext;
+        shard.fHead = strike->fNext;
     }
     if (strike->fNext) {
         strike->fNext->fPrev = strike->fPrev;
     } else {
-        fTail = strike->fPrev;
+        shard.fTail = strike->fPrev;
     }
 
     strike->fPrev = strike->fNext = nullptr;
     strike->fRemoved = true;
-    fStrikeLookup.remove(strike->getDescriptor());
+    shard.fStrikeLookup.remove(strike->getDescriptor());
 }
 
-void SkStrikeCache::validate() const {
+void SkStrikeCache::validate(const Shard& shard) const {
 #ifdef SK_DEBUG
     size_t computedBytes = 0;
     int computedCount = 0;
 
-    const SkStrike* strike = fHead;
+    const SkStrike* strike = shard.fHead;
     while (strike != nullptr) {
         computedBytes += strike->fMemoryUsed;
         computedCount += 1;
-        SkASSERT(fStrikeLookup.findOrNull(strike->getDescriptor()) != nullptr);
+        SkASSERT(shard.fStrikeLookup.findOrNull(strike->getDescriptor()) != nullptr);
         strike = strike->fNext;
     }
 
-    if (fCacheCount != computedCount) {
-        SkDebugf("fCacheCount: %d, computedCount: %d", fCacheCount, computedCount);
-        SK_ABORT("fCacheCount != computedCount");
+    if (shard.fCount != computedCount) {
+        SkDebugf("fCount: %d, computedCount: %d", shard.fCount, computedCount);
+        SK_ABORT("fCount != computedCount");
     }
-    if (fTotalMemoryUsed != computedBytes) {
-        SkDebugf("fTotalMemoryUsed: %zu, computedBytes: %zu", fTotalMemoryUsed, computedBytes);
-        SK_ABORT("fTotalMemoryUsed == computedBytes");
+    if (shard.fMemoryUsed != computedBytes) {
+        SkDebugf("fMemoryUsed: %zu, computedBytes: %zu", shard.fMemoryUsed, computedBytes);
+        SK_ABORT("fMemoryUsed == computedBytes");
     }
 #endif
 }
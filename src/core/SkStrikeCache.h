@@ -9,6 +9,7 @@
 #define SkStrikeCache_DEFINED
 
 #include "include/core/SkDrawable.h"
+#include "include/core/SkSpan.h"
 #include "include/private/SkSpinlock.h"
 #include "include/private/base/SkLoadUserConfig.h" // IWYU pragma: keep
 #include "include/private/base/SkMutex.h"
@@ -16,9 +17,14 @@
 #include "src/core/SkStrikeSpec.h"
 #include "src/text/StrikeForGPU.h"
 
+#include <atomic>
+
+class SkStream;
 class SkStrike;
 class SkStrikePinner;
 class SkTraceMemoryDump;
+class SkTypeface;
+class SkWStream;
 
 //  SK_DEFAULT_FONT_CACHE_COUNT_LIMIT and SK_DEFAULT_FONT_CACHE_LIMIT can be set using -D on your
 //  compiler commandline, or by using the defines in SkUserConfig.h
@@ -32,23 +38,26 @@ class SkTraceMemoryDump;
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Strikes are split into shards by the hash of their descriptor, each with its own lock, hash
+// table and LRU list, so that threads looking up different strikes rarely contend. The budgets
+// are for the whole cache; purging takes the least recently used strikes from every shard.
 class SkStrikeCache final : public sktext::StrikeForGPUCacheInterface {
 public:
     SkStrikeCache() = default;
 
     static SkStrikeCache* GlobalStrikeCache();
 
-    sk_sp<SkStrike> findStrike(const SkDescriptor& desc) SK_EXCLUDES(fLock);
+    sk_sp<SkStrike> findStrike(const SkDescriptor& desc);
 
     sk_sp<SkStrike> createStrike(
             const SkStrikeSpec& strikeSpec,
             SkFontMetrics* maybeMetrics = nullptr,
-            std::unique_ptr<SkStrikePinner> = nullptr) SK_EXCLUDES(fLock);
+            std::unique_ptr<SkStrikePinner> = nullptr);
 
-    sk_sp<SkStrike> findOrCreateStrike(const SkStrikeSpec& strikeSpec) SK_EXCLUDES(fLock);
+    sk_sp<SkStrike> findOrCreateStrike(const SkStrikeSpec& strikeSpec);
 
     sk_sp<sktext::StrikeForGPU> findOrCreateScopedStrike(
-            const SkStrikeSpec& strikeSpec) override SK_EXCLUDES(fLock);
+            const SkStrikeSpec& strikeSpec) override;
 
     static void PurgeAll();
     static void Dump();
@@ -57,52 +66,94 @@ public:
     // SkTraceMemoryDump interface.
     static void DumpMemoryStatistics(SkTraceMemoryDump* dump);
 
-    void purgeAll() SK_EXCLUDES(fLock); // does not change budget
+    void purgeAll() SK_EXCLUDES(fPurgeLock); // does not change budget
+
+    int getCacheCountLimit() const;
+    int setCacheCountLimit(int limit) SK_EXCLUDES(fPurgeLock);
+    int getCacheCountUsed() const;
+
+    size_t getCacheSizeLimit() const;
+    size_t setCacheSizeLimit(size_t limit) SK_EXCLUDES(fPurgeLock);
+    size_t getTotalMemoryUsed() const;
 
-    int getCacheCountLimit() const SK_EXCLUDES(fLock);
-    int setCacheCountLimit(int limit) SK_EXCLUDES(fLock);
-    int getCacheCountUsed() const SK_EXCLUDES(fLock);
+    // Write the metrics, masks and paths of the cached glyphs to stream, so that a later process
+    // can start with them already rasterized by calling readSnapshot(). Strikes with path effects
+    // or mask filters, and glyph drawables, are not written. The typefaces are written by
+    // reference, not with their data.
+    // The snapshot uses the SkStrikeServer encoding, so these are in SkChromeRemoteGlyphCache.cpp.
+    void writeSnapshot(SkWStream* stream) const;
 
-    size_t getCacheSizeLimit() const SK_EXCLUDES(fLock);
-    size_t setCacheSizeLimit(size_t limit) SK_EXCLUDES(fLock);
-    size_t getTotalMemoryUsed() const SK_EXCLUDES(fLock);
+    // Add the strikes written by writeSnapshot() to the cache. Each snapshot typeface is matched
+    // against typefaces, and then against the typeface the font manager finds for it; a strike
+    // is only loaded if the glyph count, units per em, table sizes, 'head' table, serialized
+    // descriptor and variation design position of the match are the same as when the snapshot
+    // was written, and the cache doesn't have that strike already. Returns the number of
+    // strikes loaded, or -1 if the snapshot is malformed.
+    int readSnapshot(SkStream* stream, SkSpan<const sk_sp<SkTypeface>> typefaces = {});
 
 private:
     friend class SkStrike;  // for SkStrike::updateDelta
     static constexpr char kGlyphCacheDumpName[] = "skia/sk_glyph_cache";
-    sk_sp<SkStrike> internalFindStrikeOrNull(const SkDescriptor& desc) SK_REQUIRES(fLock);
+    static constexpr int kShardCount = 16;
+
+    struct StrikeTraits {
+        static const SkDescriptor& GetKey(const sk_sp<SkStrike>& strike);
+        static uint32_t Hash(const SkDescriptor& descriptor);
+    };
+
+    struct Shard {
+        mutable SkMutex fLock;
+        SkStrike* fHead SK_GUARDED_BY(fLock) {nullptr};
+        SkStrike* fTail SK_GUARDED_BY(fLock) {nullptr};
+        SkTHashTable<sk_sp<SkStrike>, SkDescriptor, StrikeTraits> fStrikeLookup
+                SK_GUARDED_BY(fLock);
+        size_t  fMemoryUsed SK_GUARDED_BY(fLock) {0};
+        int32_t fCount SK_GUARDED_BY(fLock) {0};
+    };
+
+    Shard& shardFor(const SkDescriptor& desc);
+
+    sk_sp<SkStrike> internalFindStrikeOrNull(Shard& shard, const SkDescriptor& desc)
+            SK_REQUIRES(shard.fLock);
     sk_sp<SkStrike> internalCreateStrike(
+            Shard& shard,
             const SkStrikeSpec& strikeSpec,
             SkFontMetrics* maybeMetrics = nullptr,
-            std::unique_ptr<SkStrikePinner> = nullptr) SK_REQUIRES(fLock);
+            std::unique_ptr<SkStrikePinner> = nullptr) SK_REQUIRES(shard.fLock);
+    // Find the strike, or create it with maybeMetrics if the shard doesn't have it. Sets
+    // *created to whether the strike was created.
+    sk_sp<SkStrike> internalFindOrCreateStrike(
+            Shard& shard,
+            const SkStrikeSpec& strikeSpec,
+            SkFontMetrics* maybeMetrics,
+            bool* created) SK_REQUIRES(shard.fLock);
 
-    // The following methods can only be called when mutex is already held.
-    void internalRemoveStrike(SkStrike* strike) SK_REQUIRES(fLock);
-    void internalAttachToHead(sk_sp<SkStrike> strike) SK_REQUIRES(fLock);
+    // The following methods can only be called when the shard's mutex is already held.
+    void internalRemoveStrike(Shard& shard, SkStrike* strike) SK_REQUIRES(shard.fLock);
+    void internalAttachToHead(Shard& shard, sk_sp<SkStrike> strike) SK_REQUIRES(shard.fLock);
+
+    // Purge if over budget. Cheap when under budget, so it can be called after every lookup.
+    void purgeIfNeeded() SK_EXCLUDES(fPurgeLock);
 
     // Checkout budgets, modulated by the specified min-bytes-needed-to-purge,
     // and attempt to purge caches to match.
     // Returns number of bytes freed.
-    size_t internalPurge(size_t minBytesNeeded = 0) SK_REQUIRES(fLock);
+    size_t internalPurge(size_t minBytesNeeded = 0) SK_REQUIRES(fPurgeLock);
 
-    // A simple accounting of what each glyph cache reports and the strike cache total.
-    void validate() const SK_REQUIRES(fLock);
+    // A simple accounting of what each glyph cache reports and the shard totals.
+    void validate(const Shard& shard) const SK_REQUIRES(shard.fLock);
 
-    void forEachStrike(std::function<void(const SkStrike&)> visitor) const SK_EXCLUDES(fLock);
+    void forEachStrike(std::function<void(const SkStrike&)> visitor) const;
 
-    mutable SkMutex fLock;
-    SkStrike* fHead SK_GUARDED_BY(fLock) {nullptr};
-    SkStrike* fTail SK_GUARDED_BY(fLock) {nullptr};
-    struct StrikeTraits {
-        static const SkDescriptor& GetKey(const sk_sp<SkStrike>& strike);
-        static uint32_t Hash(const SkDescriptor& descriptor);
-    };
-    SkTHashTable<sk_sp<SkStrike>, SkDescriptor, StrikeTraits> fStrikeLookup SK_GUARDED_BY(fLock);
+    Shard fShards[kShardCount];
+
+    // Only one thread purges at a time; the shards are locked one after another.
+    SkMutex fPurgeLock;
 
-    size_t  fCacheSizeLimit{SK_DEFAULT_FONT_CACHE_LIMIT};
-    size_t  fTotalMemoryUsed SK_GUARDED_BY(fLock) {0};
-    int32_t fCacheCountLimit{SK_DEFAULT_FONT_CACHE_COUNT_LIMIT};
-    int32_t fCacheCount SK_GUARDED_BY(fLock) {0};
+    std::atomic<size_t>  fCacheSizeLimit{SK_DEFAULT_FONT_CACHE_LIMIT};
+    std::atomic<size_t>  fTotalMemoryUsed{0};
+    std::atomic<int32_t> fCacheCountLimit{SK_DEFAULT_FONT_CACHE_COUNT_LIMIT};
+    std::atomic<int32_t> fCacheCount{0};
 };
 
 #endif  // SkStrikeCache_DEFINED
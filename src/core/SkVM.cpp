@@ -5,10 +5,13 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkData.h"
+#include "include/core/SkMilestone.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkString.h"
 #include "include/private/base/SkTFitsIn.h"
 #include "include/private/base/SkThreadID.h"
+#include "src/base/SkBuffer.h"
 #include "src/base/SkHalf.h"
 #include "src/core/SkColorSpacePriv.h"
 #include "src/core/SkColorSpaceXformSteps.h"
@@ -2714,6 +2717,153 @@ namespace skvm {
     int  Program::loop () const { return fImpl->loop; }
     bool Program::empty() const { return fImpl->instructions.empty(); }
 
+    // Serialized Programs are only valid for the build and CPU that wrote them.  Rather than trust
+    // a version number to be bumped, fold in everything the interpreter and JIT formats depend on.
+    static uint32_t serialization_fingerprint() {
+        static const uint32_t fingerprint = [] {
+            static const char kOps[] =
+            #define M(op) #op ","
+                SKVM_OPS(M)
+            #undef M
+            ;
+            const uint32_t parts[] = {
+                1,  // Bump when changing the layout written by Program::serialize().
+                SK_MILESTONE,
+                SkOpts::hash(kOps, sizeof(kOps)),
+                (uint32_t)sizeof(InterpreterInstruction),
+                (uint32_t)sizeof(void*),
+            #if defined(SK_CPU_X86)
+                SkCpu::Supports(SkCpu::HSW),
+            #elif defined(SK_CPU_ARM64)
+                2,
+            #else
+                3,
+            #endif
+            };
+            return SkOpts::hash(parts, sizeof(parts));
+        }();
+        return fingerprint;
+    }
+
+    static constexpr uint32_t kSerializedProgramMagic = SkSetFourByteTag('s','k','v','m');
+    static constexpr int kOpCount = 0
+    #define M(op) + 1
+        SKVM_OPS(M)
+    #undef M
+    ;
+
+    sk_sp<SkData> Program::serialize() const {
+        if (this->hasTraceHooks() || fImpl->dylib) {
+            return nullptr;
+        }
+        const void* jit_entry = fImpl->jit_entry.load();
+        const uint32_t jit_size = jit_entry ? SkToU32(fImpl->jit_size) : 0;
+
+        SkDynamicMemoryWStream body;
+        body.write32(SkToU32(fImpl->regs));
+        body.write32(SkToU32(fImpl->loop));
+        body.write32(SkToU32(fImpl->strides.size()));
+        body.write32(SkToU32(fImpl->instructions.size()));
+        body.write32(jit_size);
+        for (int stride : fImpl->strides) {
+            body.write32(SkToU32(stride));
+        }
+        for (const InterpreterInstruction& inst : fImpl->instructions) {
+            const int32_t fields[] = {
+                (int32_t)inst.op, inst.d, inst.x, inst.y, inst.z, inst.w,
+                inst.immA, inst.immB, inst.immC,
+            };
+            body.write(fields, sizeof(fields));
+        }
+        body.write(jit_entry, jit_size);
+        sk_sp<SkData> bodyData = body.detachAsData();
+
+        SkDynamicMemoryWStream out;
+        out.write32(kSerializedProgramMagic);
+        out.write32(serialization_fingerprint());
+        out.write32(SkOpts::hash(bodyData->data(), bodyData->size()));
+        out.write(bodyData->data(), bodyData->size());
+        return out.detachAsData();
+    }
+
+    Program Program::Deserialize(const void* data, size_t size, bool allow_jit) {
+        SkRBuffer header(data, size);
+        uint32_t magic = 0, fingerprint = 0, checksum = 0;
+        if (!header.readU32(&magic)       || magic       != kSerializedProgramMagic ||
+            !header.readU32(&fingerprint) || fingerprint != serialization_fingerprint() ||
+            !header.readU32(&checksum)    ||
+            checksum != SkOpts::hash(header.skip(0), header.available())) {
+            return {};
+        }
+
+        SkRBuffer buffer(header.skip(0), header.available());
+        int32_t regs = 0, loop = 0, nargs = 0, ninstructions = 0;
+        uint32_t jit_size = 0;
+        if (!buffer.readS32(&regs)  || regs  < 0 ||
+            !buffer.readS32(&loop)  || loop  < 0 ||
+            !buffer.readS32(&nargs) || nargs < 0 ||
+            !buffer.readS32(&ninstructions) || ninstructions <= 0 || loop > ninstructions ||
+            !buffer.readU32(&jit_size)) {
+            return {};
+        }
+
+        Program program;
+        Impl* impl = program.fImpl.get();
+        impl->regs = regs;
+        impl->loop = loop;
+        impl->strides.resize(nargs);
+        for (int& stride : impl->strides) {
+            if (!buffer.readS32(&stride)) {
+                return {};
+            }
+        }
+
+        // Make sure every register we'll index is one the interpreter will allocate, and every
+        // argument pointer one the caller will pass.  Trace ops index trace hooks, which
+        // serialized programs never have.
+        auto valid_reg = [&](int32_t reg) { return reg == 0 || (reg > 0 && reg < regs); };
+        auto valid_ptr = [&](const InterpreterInstruction& inst) {
+            const bool uses_ptr = touches_varying_memory(inst.op) ||
+                                  (Op::gather8 <= inst.op && inst.op <= Op::array32);
+            return !uses_ptr || (inst.immA >= 0 && inst.immA < nargs);
+        };
+        impl->instructions.resize(ninstructions);
+        for (InterpreterInstruction& inst : impl->instructions) {
+            int32_t fields[9];
+            if (!buffer.read(fields, sizeof(fields)) ||
+                fields[0] < 0 || fields[0] >= kOpCount) {
+                return {};
+            }
+            inst = {(Op)fields[0], fields[1], fields[2], fields[3], fields[4], fields[5],
+                    fields[6], fields[7], fields[8]};
+            if (is_trace(inst.op) || !valid_ptr(inst)) {
+                return {};
+            }
+            for (Reg reg : {inst.d, inst.x, inst.y, inst.z, inst.w}) {
+                if (!valid_reg(reg)) {
+                    return {};
+                }
+            }
+        }
+
+        const void* jit_code = buffer.skip(jit_size);
+        if (!jit_code || !buffer.eof()) {
+            return {};
+        }
+        if (jit_size && gSkVMAllowJIT && allow_jit) {
+        #if defined(SKVM_JIT) && !defined(SKVM_JIT_BUT_IGNORE_IT)
+            size_t len = jit_size;
+            if (void* jit_entry = alloc_jit_buffer(&len)) {
+                memcpy(jit_entry, jit_code, jit_size);
+                remap_as_executable(jit_entry, len);
+                impl->jit_size = len;
+                impl->jit_entry.store(jit_entry);
+            }
+        #endif
+        }
+        return program;
+    }
+
     // Translate OptimizedInstructions to InterpreterInstructions.
     void Program::setupInterpreter(const std::vector<OptimizedInstruction>& instructions) {
         // Register each instruction is assigned to.
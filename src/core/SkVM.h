@@ -11,6 +11,7 @@
 #include "include/core/SkBlendMode.h"
 #include "include/core/SkColor.h"
 #include "include/core/SkColorType.h"
+#include "include/core/SkRefCnt.h"
 #include "include/core/SkSpan.h"
 #include "include/private/base/SkMacros.h"
 #include "include/private/base/SkTArray.h"
@@ -18,6 +19,7 @@
 #include "src/core/SkVM_fwd.h"
 #include <vector>      // std::vector
 
+class SkData;
 class SkWStream;
 
 #if defined(SKVM_JIT_WHEN_POSSIBLE) && !defined(SK_BUILD_FOR_IOS)
@@ -1080,6 +1082,16 @@ namespace skvm {
         void disassemble(SkWStream* = nullptr) const;
         viz::Visualizer* visualizer();
 
+        // Serializes the Program, with its JIT code if it has any, so a later process running
+        // this same build of Skia can skip building, optimizing, and JIT-compiling it again.
+        // Returns nullptr for Programs that can't be reloaded (those with trace hooks).
+        sk_sp<SkData> serialize() const;
+
+        // Reloads a Program from serialize(). Returns an empty Program if the data was written
+        // with a different instruction set or for a different CPU, or fails its checksum. JIT code
+        // is reused as is: only load data from a location that only trusted processes can write.
+        static Program Deserialize(const void* data, size_t size, bool allow_jit=true);
+
     private:
         void setupInterpreter(const std::vector<OptimizedInstruction>&);
         void setupJIT        (const std::vector<OptimizedInstruction>&, const char* debug_name);
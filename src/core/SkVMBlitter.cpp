@@ -5,7 +5,11 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkData.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkStream.h"
 #include "include/private/base/SkMacros.h"
+#include "include/private/base/SkMutex.h"
 #include "src/base/SkArenaAlloc.h"
 #include "src/core/SkBlendModePriv.h"
 #include "src/core/SkBlenderBase.h"
@@ -23,6 +27,8 @@
 #include "src/shaders/SkColorFilterShader.h"
 
 #include <cinttypes>
+#include <cstdio>
+#include <random>
 
 #define SK_BLITTER_TRACE_IS_SKVM
 #include "src/utils/SkBlitterTrace.h"
@@ -607,6 +613,64 @@ SkString SkVMBlitter::DebugName(const Key& key) {
 
 void SkVMBlitter::ReleaseProgramCache() {}
 
+static SkMutex& program_cache_directory_mutex() {
+    static SkMutex& mutex = *(new SkMutex);
+    return mutex;
+}
+
+static SkString& program_cache_directory() {
+    static SkString& directory = *(new SkString);
+    return directory;
+}
+
+void SkGraphics::SetProgramCacheDirectory(const char* path) {
+    SkAutoMutexExclusive lock(program_cache_directory_mutex());
+    program_cache_directory().set(path ? path : "");
+}
+
+SkString SkVMBlitter::DiskCachePath(const Key& key) {
+    SkAutoMutexExclusive lock(program_cache_directory_mutex());
+    const SkString& directory = program_cache_directory();
+    if (directory.isEmpty()) {
+        return SkString();
+    }
+    return SkStringPrintf("%s/%016" PRIx64 "-%016" PRIx64 "-%016" PRIx64 "-%016" PRIx64
+                          "-%02x%02x%02x.skvm",
+                          directory.c_str(),
+                          key.shader,
+                          key.clip,
+                          key.blender,
+                          key.colorSpace,
+                          key.colorType,
+                          key.alphaType,
+                          key.coverage);
+}
+
+static skvm::Program load_program(const SkString& path) {
+    if (sk_sp<SkData> data = SkData::MakeFromFileName(path.c_str())) {
+        return skvm::Program::Deserialize(data->data(), data->size());
+    }
+    return {};
+}
+
+static void store_program(const SkString& path, const skvm::Program& program) {
+    sk_sp<SkData> data = program.serialize();
+    if (!data) {
+        return;
+    }
+    // Write to a file of our own and rename it into place, so that concurrent writers and
+    // readers of the same program (other threads or processes) never see a partial file.
+    SkString tmp = SkStringPrintf("%s.%08x.tmp", path.c_str(), std::random_device{}());
+    bool written;
+    {
+        SkFILEWStream stream(tmp.c_str());
+        written = stream.isValid() && stream.write(data->data(), data->size());
+    }
+    if (!written || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+    }
+}
+
 skvm::Program* SkVMBlitter::buildProgram(Coverage coverage) {
     // eg, blitter re-use...
     if (fProgramPtrs[coverage]) {
@@ -628,8 +692,18 @@ skvm::Program* SkVMBlitter::buildProgram(Coverage coverage) {
         }
     }
 
-    // Okay, let's build it...
+    // Next, a program saved by an earlier process...
     fStoreToCache = true;
+    SkString diskCachePath = DiskCachePath(key);
+    if (!diskCachePath.isEmpty()) {
+        skvm::Program program = load_program(diskCachePath);
+        if (!program.empty()) {
+            fProgramPtrs[coverage] = fPrograms[coverage].set(std::move(program));
+            return fProgramPtrs[coverage];
+        }
+    }
+
+    // Okay, let's build it...
 
     // We don't really _need_ to rebuild fUniforms here.
     // It's just more natural to have effects unconditionally emit them,
@@ -658,6 +732,9 @@ skvm::Program* SkVMBlitter::buildProgram(Coverage coverage) {
                                 total.load(), missed.load()); });
         }
     }
+    if (!diskCachePath.isEmpty()) {
+        store_program(diskCachePath, program);
+    }
     fProgramPtrs[coverage] = fPrograms[coverage].set(std::move(program));
     return fProgramPtrs[coverage];
 }
@@ -85,6 +85,9 @@ private:
     static SkLRUCache<Key, skvm::Program>* TryAcquireProgramCache();
     static SkString DebugName(const Key& key);
     static void ReleaseProgramCache();
+    // Where the program for key lives in the SkGraphics::SetProgramCacheDirectory() directory,
+    // or empty if no directory is set.
+    static SkString DiskCachePath(const Key& key);
 
     skvm::Program* buildProgram(Coverage coverage);
     void updateUniforms(int right, int y);
@@ -6,14 +6,19 @@
  */
 
 #include "include/core/SkBitmap.h"
+#include "include/core/SkBlendMode.h"
+#include "include/core/SkCanvas.h"
 #include "include/core/SkColorType.h"
 #include "include/core/SkFlattenable.h"
+#include "include/core/SkImage.h"
 #include "include/core/SkImageFilter.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkMatrix.h"
+#include "include/core/SkPaint.h"
 #include "include/core/SkPoint.h"
 #include "include/core/SkRect.h"
 #include "include/core/SkRefCnt.h"
+#include "include/core/SkSamplingOptions.h"
 #include "include/core/SkScalar.h"
 #include "include/core/SkSize.h"
 #include "include/core/SkTileMode.h"
@@ -22,8 +27,10 @@
 #include "include/private/base/SkFloatingPoint.h"
 #include "src/base/SkVx.h"
 #include "include/private/base/SkMalloc.h"
+#include "include/private/base/SkTemplates.h"
 #include "src/base/SkArenaAlloc.h"
 #include "src/core/SkImageFilter_Base.h"
+#include "src/core/SkPicturePriv.h"
 #include "src/core/SkReadBuffer.h"
 #include "src/core/SkSpecialImage.h"
 #include "src/core/SkWriteBuffer.h"
@@ -56,10 +63,12 @@ namespace {
 class SkBlurImageFilter final : public SkImageFilter_Base {
 public:
     SkBlurImageFilter(SkScalar sigmaX, SkScalar sigmaY,  SkTileMode tileMode,
+                      SkImageFilters::BlurQuality quality,
                       sk_sp<SkImageFilter> input, const SkRect* cropRect)
             : INHERITED(&input, 1, cropRect)
             , fSigma{sigmaX, sigmaY}
-            , fTileMode(tileMode) {}
+            , fTileMode(tileMode)
+            , fQuality(quality) {}
 
     SkRect computeFastBounds(const SkRect&) const override;
 
@@ -82,6 +91,7 @@ private:
 
     SkSize     fSigma;
     SkTileMode fTileMode;
+    SkImageFilters::BlurQuality fQuality;
 
     using INHERITED = SkImageFilter_Base;
 };
@@ -89,13 +99,19 @@ private:
 } // end namespace
 
 sk_sp<SkImageFilter> SkImageFilters::Blur(
-        SkScalar sigmaX, SkScalar sigmaY, SkTileMode tileMode, sk_sp<SkImageFilter> input,
-        const CropRect& cropRect) {
+        SkScalar sigmaX, SkScalar sigmaY, SkTileMode tileMode, BlurQuality quality,
+        sk_sp<SkImageFilter> input, const CropRect& cropRect) {
     if (sigmaX < SK_ScalarNearlyZero && sigmaY < SK_ScalarNearlyZero && !cropRect) {
         return input;
     }
     return sk_sp<SkImageFilter>(
-          new SkBlurImageFilter(sigmaX, sigmaY, tileMode, input, cropRect));
+          new SkBlurImageFilter(sigmaX, sigmaY, tileMode, quality, input, cropRect));
+}
+
+sk_sp<SkImageFilter> SkImageFilters::Blur(
+        SkScalar sigmaX, SkScalar sigmaY, SkTileMode tileMode, sk_sp<SkImageFilter> input,
+        const CropRect& cropRect) {
+    return Blur(sigmaX, sigmaY, tileMode, BlurQuality::kExact, std::move(input), cropRect);
 }
 
 void SkRegisterBlurImageFilterFlattenable() {
@@ -108,8 +124,12 @@ sk_sp<SkFlattenable> SkBlurImageFilter::CreateProc(SkReadBuffer& buffer) {
     SkScalar sigmaX = buffer.readScalar();
     SkScalar sigmaY = buffer.readScalar();
     SkTileMode tileMode = buffer.read32LE(SkTileMode::kLastTileMode);
+    SkImageFilters::BlurQuality quality = SkImageFilters::BlurQuality::kExact;
+    if (!buffer.isVersionLT(SkPicturePriv::kBlurImageFilterQuality)) {
+        quality = buffer.read32LE(SkImageFilters::BlurQuality::kLast);
+    }
     return SkImageFilters::Blur(
-          sigmaX, sigmaY, tileMode, common.getInput(0), common.cropRect());
+          sigmaX, sigmaY, tileMode, quality, common.getInput(0), common.cropRect());
 }
 
 void SkBlurImageFilter::flatten(SkWriteBuffer& buffer) const {
@@ -119,6 +139,7 @@ void SkBlurImageFilter::flatten(SkWriteBuffer& buffer) const {
 
     SkASSERT(fTileMode <= SkTileMode::kLastTileMode);
     buffer.writeInt(static_cast<int>(fTileMode));
+    buffer.writeInt(static_cast<int>(fQuality));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -795,66 +816,39 @@ sk_sp<SkSpecialImage> copy_image_with_bounds(
                                           dst, ctx.surfaceProps());
 }
 
-// TODO: Implement CPU backend for different fTileMode.
-sk_sp<SkSpecialImage> cpu_blur(
-        const SkImageFilter_Base::Context& ctx,
-        SkVector sigma, const sk_sp<SkSpecialImage> &input,
-        SkIRect srcBounds, SkIRect dstBounds) {
-    // map_sigma limits sigma to 532 to match 1000px box filter limit of WebKit and Firefox.
-    // Since this does not exceed the limits of the TentPass (2183), there won't be overflow when
-    // computing a kernel over a pixel window filled with 255.
-    static_assert(kMaxSigma <= 2183.0f);
-
-    SkSTArenaAlloc<1024> alloc;
-    auto makeMaker = [&](double sigma) -> PassMaker* {
-        SkASSERT(0 <= sigma && sigma <= 2183); // should be guaranteed after map_sigma
-        if (PassMaker* maker = GaussPass::MakeMaker(sigma, &alloc)) {
+// Blurs with three box filters where that does not overflow, and with two tent filters otherwise.
+// useTent forces the latter.
+PassMaker* make_pass_maker(double sigma, SkArenaAlloc* alloc, bool useTent = false) {
+    SkASSERT(0 <= sigma && sigma <= 2183); // should be guaranteed after map_sigma
+    if (!useTent) {
+        if (PassMaker* maker = GaussPass::MakeMaker(sigma, alloc)) {
             return maker;
         }
-        if (PassMaker* maker = TentPass::MakeMaker(sigma, &alloc)) {
-            return maker;
-        }
-        SK_ABORT("Sigma is out of range.");
-    };
-
-    PassMaker* makerX = makeMaker(sigma.x());
-    PassMaker* makerY = makeMaker(sigma.y());
-
-    if (makerX->window() <= 1 && makerY->window() <= 1) {
-        return copy_image_with_bounds(ctx, input, srcBounds, dstBounds);
-    }
-
-    SkBitmap inputBM;
-
-    if (!input->getROPixels(&inputBM)) {
-        return nullptr;
     }
-
-    if (inputBM.colorType() != kN32_SkColorType) {
-        return nullptr;
+    if (PassMaker* maker = TentPass::MakeMaker(sigma, alloc)) {
+        return maker;
     }
+    SK_ABORT("Sigma is out of range.");
+}
 
-    SkBitmap src;
-    inputBM.extractSubset(&src, srcBounds);
-
-    // Make everything relative to the destination bounds.
-    srcBounds.offset(-dstBounds.x(), -dstBounds.y());
-    dstBounds.offset(-dstBounds.x(), -dstBounds.y());
-
+// Blurs src, whose pixels cover srcBounds, into dst, which is allocated to cover dstBounds. Both
+// bounds are relative to the top left of dstBounds, and srcBounds is inside dstBounds.
+bool blur_bitmap(const PassMaker* makerX, const PassMaker* makerY,
+                 const SkBitmap& src, SkIRect srcBounds, SkIRect dstBounds,
+                 SkArenaAlloc* alloc, SkBitmap* dst) {
     auto srcW = srcBounds.width(),
          srcH = srcBounds.height(),
          dstW = dstBounds.width(),
          dstH = dstBounds.height();
 
-    SkImageInfo dstInfo = inputBM.info().makeWH(dstW, dstH);
+    SkImageInfo dstInfo = src.info().makeWH(dstW, dstH);
 
-    SkBitmap dst;
-    if (!dst.tryAllocPixels(dstInfo)) {
-        return nullptr;
+    if (!dst->tryAllocPixels(dstInfo)) {
+        return false;
     }
 
     size_t bufferSizeBytes = std::max(makerX->bufferSizeBytes(), makerY->bufferSizeBytes());
-    auto buffer = alloc.makeBytesAlignedTo(bufferSizeBytes, alignof(skvx::Vec<4, uint32_t>));
+    auto buffer = alloc->makeBytesAlignedTo(bufferSizeBytes, alignof(skvx::Vec<4, uint32_t>));
 
     // Basic Plan: The three cases to handle
     // * Horizontal and Vertical - blur horizontally while copying values from the source to
@@ -873,29 +867,29 @@ sk_sp<SkSpecialImage> cpu_blur(
     // src and dst left values are the same. If sigma is small resulting in a window size of
     // 1, then border calculations add some pixels which will always be zero. Inset the
     // destination by those zero pixels. This case is very rare.
-    auto intermediateDst = dst.getAddr32(srcBounds.left(), 0);
+    auto intermediateDst = dst->getAddr32(srcBounds.left(), 0);
 
     // The following code is executed very rarely, I have never seen it in a real web
     // page. If sigma is small but not zero then shared GPU/CPU border calculation
     // code adds extra pixels for the border. Just clear everything to clear those pixels.
     // This solution is overkill, but very simple.
     if (makerX->window() == 1 || makerY->window() == 1) {
-        dst.eraseColor(0);
+        dst->eraseColor(0);
     }
 
     if (makerX->window() > 1) {
-        Pass* pass = makerX->makePass(buffer, &alloc);
+        Pass* pass = makerX->makePass(buffer, alloc);
         // Make int64 to avoid overflow in multiplication below.
         int64_t shift = srcBounds.top() - dstBounds.top();
 
         // For the horizontal blur, starts part way down in anticipation of the vertical blur.
         // For a vertical sigma of zero shift should be zero. But, for small sigma,
         // shift may be > 0 but the vertical window could be 1.
-        intermediateSrc = static_cast<uint32_t *>(dst.getPixels())
-                          + (shift > 0 ? shift * dst.rowBytesAsPixels() : 0);
-        intermediateRowBytesAsPixels = dst.rowBytesAsPixels();
+        intermediateSrc = static_cast<uint32_t *>(dst->getPixels())
+                          + (shift > 0 ? shift * dst->rowBytesAsPixels() : 0);
+        intermediateRowBytesAsPixels = dst->rowBytesAsPixels();
         intermediateWidth = dstW;
-        intermediateDst = static_cast<uint32_t *>(dst.getPixels());
+        intermediateDst = static_cast<uint32_t *>(dst->getPixels());
 
         const uint32_t* srcCursor = static_cast<uint32_t*>(src.getPixels());
         uint32_t* dstCursor = intermediateSrc;
@@ -908,18 +902,164 @@ sk_sp<SkSpecialImage> cpu_blur(
     }
 
     if (makerY->window() > 1) {
-        Pass* pass = makerY->makePass(buffer, &alloc);
+        Pass* pass = makerY->makePass(buffer, alloc);
         const uint32_t* srcCursor = intermediateSrc;
         uint32_t* dstCursor = intermediateDst;
         for (auto x = 0; x < intermediateWidth; x++) {
             pass->blur(srcBounds.top(), srcBounds.bottom(), dstBounds.bottom(),
                        srcCursor, intermediateRowBytesAsPixels,
-                       dstCursor, dst.rowBytesAsPixels());
+                       dstCursor, dst->rowBytesAsPixels());
             srcCursor += 1;
             dstCursor += 1;
         }
     }
 
+    return true;
+}
+
+// With SkImageFilters::BlurQuality::kFast, big sigmas are blurred at a lower resolution: the image
+// is box filtered down by a power of two along each axis, blurred there with a correspondingly
+// smaller sigma, and scaled back up with bilinear filtering. Each axis is scaled down as far as
+// it can be while its sigma stays at least kMinDownscaledSigma. Below that, the coarser steps
+// between box window sizes at low resolution start to show: with 8, high contrast content stays
+// within 6 of the full resolution blur in every channel, for sigmas up to kMaxSigma.
+static constexpr double kMinDownscaledSigma = 8;
+
+// log2 of the factor to scale down by to blur with sigma.
+int downscale_shift(double sigma) {
+    int shift = 0;
+    while (sigma >= kMinDownscaledSigma * (2 << shift)) {
+        shift++;
+    }
+    return shift;
+}
+
+// The sigma to blur with after scaling down by 1 << shift, to blur by sigma overall. The box
+// filter down and the bilinear filter back up each blur the image a little themselves.
+double downscaled_sigma(double sigma, int shift) {
+    const double scale = 1 << shift;
+    const double resamplingVariance = (scale * scale - 1) / 12  // box filter
+                                    + (scale * scale - 1) / 6;  // tent filter
+    return std::sqrt(std::max(0.0, sigma * sigma - resamplingVariance)) / scale;
+}
+
+// Averages each (1 << shiftX) x (1 << shiftY) block of src, whose pixels cover srcBounds, into a
+// pixel of dst. Pixels outside srcBounds are transparent black.
+void downscale(const SkBitmap& src, SkIRect srcBounds, int shiftX, int shiftY, SkBitmap* dst) {
+    using U32 = skvx::Vec<4, uint32_t>;
+    const int shift = shiftX + shiftY;
+    const U32 half = (1u << shift) >> 1;
+
+    skia_private::AutoTMalloc<U32> sums(dst->width());
+    for (int j = 0; j < dst->height(); j++) {
+        std::fill_n(sums.get(), dst->width(), U32(0));
+        const int top    = std::max(j << shiftY, srcBounds.top()),
+                  bottom = std::min((j + 1) << shiftY, srcBounds.bottom());
+        for (int y = top; y < bottom; y++) {
+            const uint32_t* row = src.getAddr32(0, y - srcBounds.top());
+            for (int x = srcBounds.left(); x < srcBounds.right(); x++) {
+                sums[x >> shiftX] += skvx::cast<uint32_t>(skvx::byte4::Load(row++));
+            }
+        }
+
+        uint32_t* dstRow = dst->getAddr32(0, j);
+        for (int i = 0; i < dst->width(); i++) {
+            skvx::cast<uint8_t>((sums[i] + half) >> shift).store(dstRow + i);
+        }
+    }
+}
+
+// Blurs src into dst at a lower resolution, as described above kMinDownscaledSigma. Returns false
+// if sigma is too small to bother.
+bool downscaled_blur(SkVector sigma, const SkBitmap& src, SkIRect srcBounds, SkIRect dstBounds,
+                     SkBitmap* dst) {
+    const int shiftX = downscale_shift(sigma.x()),
+              shiftY = downscale_shift(sigma.y());
+    if (shiftX == 0 && shiftY == 0) {
+        return false;
+    }
+
+    // Every pixel of dst is covered, so that the blur spreads into its margins at low resolution.
+    SkBitmap small;
+    const SkIRect smallBounds = SkIRect::MakeWH(((dstBounds.width()  - 1) >> shiftX) + 1,
+                                                ((dstBounds.height() - 1) >> shiftY) + 1);
+    if (!small.tryAllocPixels(src.info().makeDimensions(smallBounds.size()))) {
+        return false;
+    }
+    downscale(src, srcBounds, shiftX, shiftY, &small);
+
+    // Use the same kind of pass as a full resolution blur would, so that the two stay close.
+    SkSTArenaAlloc<1024> alloc;
+    auto makeMaker = [&alloc](double sigma, int shift) {
+        return make_pass_maker(downscaled_sigma(sigma, shift), &alloc,
+                               /*useTent=*/calculate_window(sigma) >= 255);
+    };
+    SkBitmap blurred;
+    if (!blur_bitmap(makeMaker(sigma.x(), shiftX), makeMaker(sigma.y(), shiftY),
+                     small, smallBounds, smallBounds, &alloc, &blurred)) {
+        return false;
+    }
+
+    if (!dst->tryAllocPixels(src.info().makeDimensions(dstBounds.size()))) {
+        return false;
+    }
+    // Each small pixel is centered on the block of dst pixels it was averaged from.
+    SkPaint paint;
+    paint.setBlendMode(SkBlendMode::kSrc);
+    SkCanvas canvas(*dst);
+    canvas.drawImageRect(blurred.asImage(),
+                         SkRect::Make(smallBounds),
+                         SkRect::MakeIWH(smallBounds.width()  << shiftX,
+                                         smallBounds.height() << shiftY),
+                         SkSamplingOptions(SkFilterMode::kLinear),
+                         &paint,
+                         SkCanvas::kStrict_SrcRectConstraint);
+    return true;
+}
+
+// TODO: Implement CPU backend for different fTileMode.
+sk_sp<SkSpecialImage> cpu_blur(
+        const SkImageFilter_Base::Context& ctx,
+        SkVector sigma, SkImageFilters::BlurQuality quality, const sk_sp<SkSpecialImage> &input,
+        SkIRect srcBounds, SkIRect dstBounds) {
+    // map_sigma limits sigma to 532 to match 1000px box filter limit of WebKit and Firefox.
+    // Since this does not exceed the limits of the TentPass (2183), there won't be overflow when
+    // computing a kernel over a pixel window filled with 255.
+    static_assert(kMaxSigma <= 2183.0f);
+
+    SkSTArenaAlloc<1024> alloc;
+    PassMaker* makerX = make_pass_maker(sigma.x(), &alloc);
+    PassMaker* makerY = make_pass_maker(sigma.y(), &alloc);
+
+    if (makerX->window() <= 1 && makerY->window() <= 1) {
+        return copy_image_with_bounds(ctx, input, srcBounds, dstBounds);
+    }
+
+    SkBitmap inputBM;
+
+    if (!input->getROPixels(&inputBM)) {
+        return nullptr;
+    }
+
+    if (inputBM.colorType() != kN32_SkColorType) {
+        return nullptr;
+    }
+
+    SkBitmap src;
+    inputBM.extractSubset(&src, srcBounds);
+
+    // Make everything relative to the destination bounds.
+    srcBounds.offset(-dstBounds.x(), -dstBounds.y());
+    dstBounds.offset(-dstBounds.x(), -dstBounds.y());
+
+    SkBitmap dst;
+    if (quality != SkImageFilters::BlurQuality::kFast ||
+        !downscaled_blur(sigma, src, srcBounds, dstBounds, &dst)) {
+        if (!blur_bitmap(makerX, makerY, src, srcBounds, dstBounds, &alloc, &dst)) {
+            return nullptr;
+        }
+    }
+
     return SkSpecialImage::MakeFromRaster(SkIRect::MakeWH(dstBounds.width(),
                                                           dstBounds.height()),
                                           dst, ctx.surfaceProps());
@@ -970,7 +1110,7 @@ sk_sp<SkSpecialImage> SkBlurImageFilter::onFilterImage(const Context& ctx,
     } else
 #endif
     {
-        result = cpu_blur(ctx, sigma, input, inputBounds, dstBounds);
+        result = cpu_blur(ctx, sigma, fQuality, input, inputBounds, dstBounds);
     }
 
     // Return the resultOffset if the blur succeeded.
@@ -32,6 +32,16 @@ bool SkJpegEncoder::Encode(SkWStream*, const SkPixmap&, const Options&) { return
 std::unique_ptr<SkEncoder> SkJpegEncoder::Make(SkWStream*, const SkPixmap&, const Options&) {
     return nullptr;
 }
+bool SkJpegEncoder::Encode(SkWStream*, const SkImageInfo&, int, const RowProc&, const Options&) {
+    return false;
+}
+std::unique_ptr<SkEncoder> SkJpegEncoder::Make(SkWStream*,
+                                               const SkImageInfo&,
+                                               int,
+                                               RowProc,
+                                               const Options&) {
+    return nullptr;
+}
 #endif
 
 #if !defined(SK_ENCODE_PNG)
@@ -23,17 +23,22 @@
 #include "include/private/base/SkNoncopyable.h"
 #include "include/private/base/SkTemplates.h"
 #include "src/base/SkMSAN.h"
+#include "src/core/SkAutoPixmapStorage.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/codec/SkJpegConstants.h"
 #include "src/codec/SkJpegPriv.h"
 #include "src/encode/SkImageEncoderFns.h"
 #include "src/encode/SkImageEncoderPriv.h"
 #include "src/encode/SkJPEGWriteUtility.h"
 
+#include <algorithm>
+#include <atomic>
 #include <csetjmp>
 #include <cstdint>
 #include <cstring>
 #include <memory>
 #include <utility>
+#include <vector>
 
 class SkColorSpace;
 
@@ -61,6 +66,38 @@ public:
 
     transform_scanline_proc proc() const { return fProc; }
 
+    // Writes one row of a source with |width| pixels, converting it in |storage| if needed.
+    void writeRow(const void* srcRow, int width, uint8_t* storage);
+
+    /*
+     * If |options| has an executor, and |srcInfo| is tall enough to split into several strips,
+     * prepares to encode them in parallel with writeRowsInParallel(). This must be called before
+     * jpeg_start_compress().
+     */
+    void setExecutor(const SkImageInfo& srcInfo, const SkJpegEncoder::Options& options);
+
+    bool canWriteRowsInParallel() const { return fExecutor != nullptr; }
+
+    // Encodes every row of |src|, and finishes the file.
+    bool writeRowsInParallel(const SkPixmap& src);
+
+    /*
+     * Makes this encode rows pulled from |rowProc|, |stripHeight| at a time, rather than from a
+     * pixmap holding the whole image.
+     */
+    bool setRowProc(const SkImageInfo& srcInfo, int stripHeight, SkJpegEncoder::RowProc rowProc);
+
+    bool isStreaming() const { return fRowProc != nullptr; }
+
+    // The dimensions and format of a streaming source. It has no pixels.
+    const SkPixmap& streamingSrc() const { return fStreamingSrc; }
+
+    /*
+     * Returns row |y| of a streaming source, first asking the RowProc to fill the strip that
+     * holds it if needed, or nullptr if the RowProc fails. Rows must be requested in order.
+     */
+    const void* streamingRow(int y);
+
     ~SkJpegEncoderMgr() {
         jpeg_destroy_compress(&fCInfo);
     }
@@ -77,8 +114,199 @@ private:
     skjpeg_error_mgr        fErrMgr;
     skjpeg_destination_mgr  fDstMgr;
     transform_scanline_proc fProc;
+    SkColorType             fColorType = kUnknown_SkColorType;
+
+    SkExecutor*             fExecutor = nullptr;
+    SkJpegEncoder::Options  fOptions;
+    int                     fParallelStripHeight = 0;
+
+    SkJpegEncoder::RowProc  fRowProc;
+    SkPixmap                fStreamingSrc;
+    SkAutoPixmapStorage     fStrip;
+    int                     fStripTop = 0;
+    int                     fStripRows = 0;
 };
 
+bool SkJpegEncoderMgr::setRowProc(const SkImageInfo& srcInfo,
+                                  int stripHeight,
+                                  SkJpegEncoder::RowProc rowProc) {
+    const int stripRows = std::min(stripHeight, srcInfo.height());
+    if (!fStrip.tryAlloc(srcInfo.makeWH(srcInfo.width(), stripRows))) {
+        return false;
+    }
+    fRowProc = std::move(rowProc);
+    fStreamingSrc.reset(srcInfo, nullptr, srcInfo.minRowBytes());
+
+    // Optimized Huffman tables can only be computed once every coefficient of the image has been
+    // buffered, and only then is any scan data written out.
+    fCInfo.optimize_coding = FALSE;
+    return true;
+}
+
+const void* SkJpegEncoderMgr::streamingRow(int y) {
+    SkASSERT(y >= fStripTop);
+    if (y >= fStripTop + fStripRows) {
+        const int rows = std::min(fStrip.height(), fStreamingSrc.height() - y);
+        const SkPixmap strip(
+                fStrip.info().makeWH(fStrip.width(), rows), fStrip.addr(), fStrip.rowBytes());
+        if (!fRowProc(y, strip)) {
+            return nullptr;
+        }
+        fStripTop = y;
+        fStripRows = rows;
+    }
+    return fStrip.addr(0, y - fStripTop);
+}
+
+void SkJpegEncoderMgr::writeRow(const void* srcRow, int width, uint8_t* storage) {
+    const size_t jpegSrcBytes = fCInfo.input_components * width;
+    JSAMPLE* jpegSrcRow = (JSAMPLE*)srcRow;
+    if (fProc) {
+        const size_t srcBytes = SkColorTypeBytesPerPixel(fColorType) * width;
+        sk_msan_assert_initialized(srcRow, SkTAddOffset<const void>(srcRow, srcBytes));
+        fProc((char*)storage, (const char*)srcRow, width, fCInfo.input_components);
+        jpegSrcRow = storage;
+        sk_msan_assert_initialized(jpegSrcRow,
+                                   SkTAddOffset<const void>(jpegSrcRow, jpegSrcBytes));
+    } else {
+        // Same as above, but this repetition allows determining whether a
+        // proc was used when msan asserts.
+        sk_msan_assert_initialized(jpegSrcRow,
+                                   SkTAddOffset<const void>(jpegSrcRow, jpegSrcBytes));
+    }
+
+    jpeg_write_scanlines(&fCInfo, &jpegSrcRow, 1);
+}
+
+// Each strip is encoded as a standalone jpeg, from which only the entropy-coded data is kept.
+// Strips are a whole number of MCU rows tall, so that they encode to the same coefficients as
+// they would in a serial encode, and each restarts the DC prediction just as it would after a
+// restart marker.
+static constexpr size_t kParallelStripPixels = 256 * 1024;
+
+void SkJpegEncoderMgr::setExecutor(const SkImageInfo& srcInfo,
+                                   const SkJpegEncoder::Options& options) {
+    if (!options.fExecutor) {
+        return;
+    }
+    // The luma (or only) component has the largest sampling factors.
+    const int mcuWidth = DCTSIZE * fCInfo.comp_info[0].h_samp_factor,
+              mcuHeight = DCTSIZE * fCInfo.comp_info[0].v_samp_factor;
+    const int mcusPerRow = (srcInfo.width() + mcuWidth - 1) / mcuWidth;
+    // The restart interval, which is a strip's MCU count, is a 16 bit field.
+    const int mcuRowsPerStrip =
+            std::clamp<int>(kParallelStripPixels / ((size_t)srcInfo.width() * mcuHeight),
+                            1,
+                            std::max(1, 0xFFFF / mcusPerRow));
+    if (mcuRowsPerStrip * mcuHeight >= srcInfo.height()) {
+        return;
+    }
+
+    fExecutor = options.fExecutor;
+    fOptions = options;
+    fParallelStripHeight = mcuRowsPerStrip * mcuHeight;
+    fCInfo.restart_interval = mcuRowsPerStrip * mcusPerRow;
+    // Every strip has to share the same tables, and optimizing them would need all of the strips'
+    // statistics before any of them could be encoded.
+    fCInfo.optimize_coding = FALSE;
+}
+
+// Returns the entropy-coded data of a jpeg written by libjpeg, which follows the one SOS segment
+// and ends with the EOI marker.
+static sk_sp<SkData> entropy_coded_data(sk_sp<SkData> jpeg) {
+    const uint8_t* bytes = jpeg->bytes();
+    size_t offset = 2;  // SOI
+    while (offset + 4 <= jpeg->size() && bytes[offset] == 0xFF) {
+        const uint8_t marker = bytes[offset + 1];
+        offset += 2 + (bytes[offset + 2] << 8 | bytes[offset + 3]);
+        if (marker == 0xDA) {  // SOS
+            if (offset + 2 > jpeg->size()) {
+                return nullptr;
+            }
+            return SkData::MakeSubset(jpeg.get(), offset, jpeg->size() - offset - 2);
+        }
+    }
+    return nullptr;
+}
+
+static sk_sp<SkData> encode_strip(const SkPixmap& strip, const SkJpegEncoder::Options& options) {
+    SkDynamicMemoryWStream stream;
+    std::unique_ptr<SkJpegEncoderMgr> encoderMgr = SkJpegEncoderMgr::Make(&stream);
+
+    skjpeg_error_mgr::AutoPushJmpBuf jmp(encoderMgr->errorMgr());
+    if (setjmp(jmp)) {
+        return nullptr;
+    }
+
+    if (!encoderMgr->setParams(strip.info(), options)) {
+        return nullptr;
+    }
+    jpeg_compress_struct* cinfo = encoderMgr->cinfo();
+    cinfo->optimize_coding = FALSE;
+    cinfo->write_JFIF_header = FALSE;
+    jpeg_set_quality(cinfo, options.fQuality, TRUE);
+    jpeg_start_compress(cinfo, TRUE);
+
+    skia_private::AutoTMalloc<uint8_t> storage(
+            encoderMgr->proc() ? cinfo->input_components * strip.width() : 0);
+    for (int y = 0; y < strip.height(); y++) {
+        encoderMgr->writeRow(strip.addr(0, y), strip.width(), storage.get());
+    }
+    jpeg_finish_compress(cinfo);
+
+    return entropy_coded_data(stream.detachAsData());
+}
+
+bool SkJpegEncoderMgr::writeRowsInParallel(const SkPixmap& src) {
+    SkASSERT(this->canWriteRowsInParallel());
+
+    // Have libjpeg write the frame and scan headers, which it does before the first row, and take
+    // them out of its buffer. This may longjmp, so it comes before any strips are in flight.
+    JSAMPROW noRows = nullptr;
+    jpeg_write_scanlines(&fCInfo, &noRows, 0);
+    const size_t headerBytes = skjpeg_destination_mgr::kBufferSize - fDstMgr.free_in_buffer;
+    SkWStream* stream = fDstMgr.fStream;
+    if (!stream->write(fDstMgr.fBuffer, headerBytes)) {
+        return false;
+    }
+    fDstMgr.next_output_byte = fDstMgr.fBuffer;
+    fDstMgr.free_in_buffer = skjpeg_destination_mgr::kBufferSize;
+
+    const int stripCount = (src.height() + fParallelStripHeight - 1) / fParallelStripHeight;
+    std::vector<sk_sp<SkData>> strips(stripCount);
+    std::atomic<bool> success{true};
+    SkTaskGroup tg(*fExecutor);
+    tg.batch(stripCount, [&](int i) {
+        const int top = i * fParallelStripHeight;
+        SkPixmap strip;
+        SkAssertResult(src.extractSubset(
+                &strip,
+                SkIRect::MakeLTRB(0, top, src.width(),
+                                  std::min(top + fParallelStripHeight, src.height()))));
+        strips[i] = encode_strip(strip, fOptions);
+        if (!strips[i]) {
+            success = false;
+        }
+    });
+    tg.wait();
+    if (!success) {
+        return false;
+    }
+
+    for (int i = 0; i < stripCount; i++) {
+        if (!stream->write(strips[i]->data(), strips[i]->size())) {
+            return false;
+        }
+        // RST0 through RST7 between strips, then EOI.
+        const uint8_t marker[2] = {0xFF, (uint8_t)(i < stripCount - 1 ? 0xD0 + i % 8 : 0xD9)};
+        if (!stream->write(marker, sizeof(marker))) {
+            return false;
+        }
+    }
+    stream->flush();
+    return true;
+}
+
 bool SkJpegEncoderMgr::setParams(const SkImageInfo& srcInfo, const SkJpegEncoder::Options& options)
 {
     auto chooseProc8888 = [&]() {
@@ -136,6 +364,7 @@ bool SkJpegEncoderMgr::setParams(const SkImageInfo& srcInfo, const SkJpegEncoder
             return false;
     }
 
+    fColorType = srcInfo.colorType();
     fCInfo.image_width = srcInfo.width();
     fCInfo.image_height = srcInfo.height();
     fCInfo.in_color_space = jpegColorType;
@@ -269,20 +498,38 @@ std::unique_ptr<SkEncoder> SkJpegEncoder::Make(SkWStream* dst,
     return Make(dst, nullptr, &src, srcColorSpace, options);
 }
 
+std::unique_ptr<SkEncoder> SkJpegEncoder::Make(SkWStream* dst,
+                                               const SkImageInfo& srcInfo,
+                                               int stripHeight,
+                                               RowProc rowProc,
+                                               const Options& options) {
+    if (!rowProc || stripHeight < 1) {
+        return nullptr;
+    }
+    // The pixels come from |rowProc|, so |src| only describes them.
+    SkPixmap src(srcInfo, nullptr, srcInfo.minRowBytes());
+    return Make(dst, &src, nullptr, nullptr, options, std::move(rowProc), stripHeight);
+}
+
 std::unique_ptr<SkEncoder> SkJpegEncoder::Make(SkWStream* dst,
                                                const SkPixmap* src,
                                                const SkYUVAPixmaps* srcYUVA,
                                                const SkColorSpace* srcYUVAColorSpace,
-                                               const Options& options) {
+                                               const Options& options,
+                                               RowProc rowProc,
+                                               int stripHeight) {
     // Exactly one of |src| or |srcYUVA| should be specified.
     if (srcYUVA) {
-        SkASSERT(!src);
+        SkASSERT(!src && !rowProc);
         if (!srcYUVA->isValid()) {
             return nullptr;
         }
     } else {
         SkASSERT(src);
-        if (!src || !SkPixmapIsValid(*src)) {
+        if (!src) {
+            return nullptr;
+        }
+        if (rowProc ? !SkImageInfoIsValid(src->info()) : !SkPixmapIsValid(*src)) {
             return nullptr;
         }
     }
@@ -302,6 +549,13 @@ std::unique_ptr<SkEncoder> SkJpegEncoder::Make(SkWStream* dst,
         if (!encoderMgr->setParams(src->info(), options)) {
             return nullptr;
         }
+        if (rowProc) {
+            if (!encoderMgr->setRowProc(src->info(), stripHeight, std::move(rowProc))) {
+                return nullptr;
+            }
+        } else {
+            encoderMgr->setExecutor(src->info(), options);
+        }
     }
 
     jpeg_set_quality(encoderMgr->cinfo(), options.fQuality, TRUE);
@@ -340,6 +594,12 @@ std::unique_ptr<SkEncoder> SkJpegEncoder::Make(SkWStream* dst,
     if (srcYUVA) {
         return std::unique_ptr<SkJpegEncoder>(new SkJpegEncoder(std::move(encoderMgr), srcYUVA));
     }
+    if (encoderMgr->isStreaming()) {
+        // |src| does not outlive this call, so the encoder refers to the manager's copy.
+        const SkPixmap& streamingSrc = encoderMgr->streamingSrc();
+        return std::unique_ptr<SkJpegEncoder>(
+                new SkJpegEncoder(std::move(encoderMgr), streamingSrc));
+    }
     return std::unique_ptr<SkJpegEncoder>(new SkJpegEncoder(std::move(encoderMgr), *src));
 }
 
@@ -361,6 +621,11 @@ bool SkJpegEncoder::onEncodeRows(int numRows) {
         return false;
     }
 
+    if (0 == fCurrRow && numRows == fSrc.height() && fEncoderMgr->canWriteRowsInParallel()) {
+        fCurrRow = fSrc.height();
+        return fEncoderMgr->writeRowsInParallel(fSrc);
+    }
+
     if (fSrcYUVA) {
         // TODO(ccameron): Consider using jpeg_write_raw_data, to avoid having to re-pack the data.
         for (int i = 0; i < numRows; i++) {
@@ -369,29 +634,14 @@ bool SkJpegEncoder::onEncodeRows(int numRows) {
             jpeg_write_scanlines(fEncoderMgr->cinfo(), &jpegSrcRow, 1);
         }
     } else {
-        const size_t srcBytes = SkColorTypeBytesPerPixel(fSrc.colorType()) * fSrc.width();
-        const size_t jpegSrcBytes = fEncoderMgr->cinfo()->input_components * fSrc.width();
-        const void* srcRow = fSrc.addr(0, fCurrRow);
         for (int i = 0; i < numRows; i++) {
-            JSAMPLE* jpegSrcRow = (JSAMPLE*)srcRow;
-            if (fEncoderMgr->proc()) {
-                sk_msan_assert_initialized(srcRow, SkTAddOffset<const void>(srcRow, srcBytes));
-                fEncoderMgr->proc()((char*)fStorage.get(),
-                                    (const char*)srcRow,
-                                    fSrc.width(),
-                                    fEncoderMgr->cinfo()->input_components);
-                jpegSrcRow = fStorage.get();
-                sk_msan_assert_initialized(jpegSrcRow,
-                                           SkTAddOffset<const void>(jpegSrcRow, jpegSrcBytes));
-            } else {
-                // Same as above, but this repetition allows determining whether a
-                // proc was used when msan asserts.
-                sk_msan_assert_initialized(jpegSrcRow,
-                                           SkTAddOffset<const void>(jpegSrcRow, jpegSrcBytes));
+            const void* srcRow = fEncoderMgr->isStreaming()
+                                         ? fEncoderMgr->streamingRow(fCurrRow + i)
+                                         : fSrc.addr(0, fCurrRow + i);
+            if (!srcRow) {
+                return false;
             }
-
-            jpeg_write_scanlines(fEncoderMgr->cinfo(), &jpegSrcRow, 1);
-            srcRow = SkTAddOffset<const void>(srcRow, fSrc.rowBytes());
+            fEncoderMgr->writeRow(srcRow, fSrc.width(), fStorage.get());
         }
     }
 
@@ -408,6 +658,15 @@ bool SkJpegEncoder::Encode(SkWStream* dst, const SkPixmap& src, const Options& o
     return encoder.get() && encoder->encodeRows(src.height());
 }
 
+bool SkJpegEncoder::Encode(SkWStream* dst,
+                           const SkImageInfo& srcInfo,
+                           int stripHeight,
+                           const RowProc& rowProc,
+                           const Options& options) {
+    auto encoder = SkJpegEncoder::Make(dst, srcInfo, stripHeight, rowProc, options);
+    return encoder.get() && encoder->encodeRows(srcInfo.height());
+}
+
 bool SkJpegEncoder::Encode(SkWStream* dst,
                            const SkYUVAPixmaps& src,
                            const SkColorSpace* srcColorSpace,
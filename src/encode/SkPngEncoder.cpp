@@ -22,17 +22,24 @@
 #include "include/encode/SkEncoder.h"
 #include "include/encode/SkPngEncoder.h"
 #include "include/private/base/SkDebug.h"
+#include "include/private/base/SkMath.h"
 #include "include/private/base/SkNoncopyable.h"
 #include "include/private/base/SkTemplates.h"
+#include "include/private/base/SkTo.h"
 #include "modules/skcms/skcms.h"
 #include "src/base/SkMSAN.h"
 #include "src/codec/SkPngPriv.h"
+#include "src/core/SkOpts.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/encode/SkImageEncoderFns.h"
 #include "src/encode/SkImageEncoderPriv.h"
 
 #include <algorithm>
+#include <atomic>
 #include <csetjmp>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
@@ -41,6 +48,8 @@
 #include <png.h>
 #include <pngconf.h>
 
+#include "zlib.h"
+
 static_assert(PNG_FILTER_NONE  == (int)SkPngEncoder::FilterFlag::kNone,  "Skia libpng filter err.");
 static_assert(PNG_FILTER_SUB   == (int)SkPngEncoder::FilterFlag::kSub,   "Skia libpng filter err.");
 static_assert(PNG_FILTER_UP    == (int)SkPngEncoder::FilterFlag::kUp,    "Skia libpng filter err.");
@@ -79,16 +88,30 @@ public:
     bool writeInfo(const SkImageInfo& srcInfo);
     void chooseProc(const SkImageInfo& srcInfo);
 
+    // Returns true if we can filter and deflate the rows ourselves, with writeRows() or
+    // writeRowsInParallel(), rather than handing them to libpng.  We can't when libpng would
+    // transform the rows we hand it, e.g. to strip a filler channel.
+    bool canWriteRows(const SkImageInfo& srcInfo) const;
+    // Writes |numRows| rows of |src| starting at |top|, which must follow the rows written before.
+    bool writeRows(const SkPixmap& src, int top, int numRows);
+    // Writes all of |src| at once, split into bands across fExecutor.
+    bool writeRowsInParallel(const SkPixmap& src);
+
     png_structp pngPtr() { return fPngPtr; }
     png_infop infoPtr() { return fInfoPtr; }
     int pngBytesPerPixel() const { return fPngBytesPerPixel; }
     transform_scanline_proc proc() const { return fProc; }
+    SkExecutor* executor() const { return fExecutor; }
 
     ~SkPngEncoderMgr() {
+        if (fDeflating) {
+            deflateEnd(&fZStream);
+        }
         png_destroy_write_struct(&fPngPtr, &fInfoPtr);
     }
 
 private:
+    bool deflateRows(const uint8_t* bytes, size_t len, int flush);
 
     SkPngEncoderMgr(png_structp pngPtr, png_infop infoPtr)
         : fPngPtr(pngPtr)
@@ -99,6 +122,17 @@ private:
     png_infop               fInfoPtr;
     int                     fPngBytesPerPixel;
     transform_scanline_proc fProc;
+    SkExecutor*             fExecutor = nullptr;
+    int                     fFilters = PNG_ALL_FILTERS;
+    int                     fZLibLevel = 6;
+
+    // State for writeRows().
+    z_stream                           fZStream;
+    bool                               fDeflating = false;
+    skia_private::AutoTMalloc<uint8_t> fRowStorage;
+    uint8_t*                           fPrevRow = nullptr;
+    uint8_t*                           fRow = nullptr;
+    skia_private::AutoTMalloc<uint8_t> fIdat;
 };
 
 std::unique_ptr<SkPngEncoderMgr> SkPngEncoderMgr::Make(SkWStream* stream) {
@@ -222,6 +256,10 @@ bool SkPngEncoderMgr::setHeader(const SkImageInfo& srcInfo, const SkPngEncoder::
     SkASSERT(zlibLevel == options.fZLibLevel);
     png_set_compression_level(fPngPtr, zlibLevel);
 
+    fExecutor = options.fExecutor;
+    fFilters = filters;
+    fZLibLevel = zlibLevel;
+
     // Set comments in tEXt chunk
     const sk_sp<SkDataTable>& comments = options.fComments;
     if (comments != nullptr) {
@@ -423,6 +461,267 @@ void SkPngEncoderMgr::chooseProc(const SkImageInfo& srcInfo) {
     fProc = choose_proc(srcInfo);
 }
 
+bool SkPngEncoderMgr::canWriteRows(const SkImageInfo& srcInfo) const {
+    return fProc && fFilters != 0 &&
+           png_get_rowbytes(fPngPtr, fInfoPtr) == (size_t)fPngBytesPerPixel * srcInfo.width();
+}
+
+// See https://www.w3.org/TR/png/#9Filter-types.
+enum PngFilterType : uint8_t {
+    kNone_PngFilterType  = 0,
+    kSub_PngFilterType   = 1,
+    kUp_PngFilterType    = 2,
+    kAvg_PngFilterType   = 3,
+    kPaeth_PngFilterType = 4,
+};
+
+// Writes the filter type byte followed by |row| filtered against |prev|.
+static void filter_row(PngFilterType type, uint8_t* dst, const uint8_t* row, const uint8_t* prev,
+                       size_t rowBytes, int bpp) {
+    *dst++ = type;
+    SkOpts::png_filter_row(type, dst, row, prev, rowBytes, bpp);
+}
+
+// Like libpng, when more than one filter is allowed, pick the one whose output has the smallest
+// sum of absolute values, treating each byte as signed.
+static void filter_row_adaptive(int filters, uint8_t* dst, uint8_t* scratch, const uint8_t* row,
+                                const uint8_t* prev, size_t rowBytes, int bpp) {
+    uint64_t bestSum = UINT64_MAX;
+    for (int type = kNone_PngFilterType; type <= kPaeth_PngFilterType; type++) {
+        if (!(filters & (PNG_FILTER_NONE << type))) {
+            continue;
+        }
+        uint8_t* out = bestSum == UINT64_MAX ? dst : scratch;
+        filter_row((PngFilterType)type, out, row, prev, rowBytes, bpp);
+        if (SkIsPow2(filters)) {
+            return;
+        }
+        uint64_t sum = SkOpts::png_filter_sum(out + 1, rowBytes);
+        if (sum < bestSum) {
+            bestSum = sum;
+            if (out != dst) {
+                memcpy(dst, out, rowBytes + 1);
+            }
+        }
+    }
+}
+
+// Each band of filtered rows is deflated on its own, primed with the tail of the band before it
+// as a preset dictionary.  All bands but the last end in a sync flush so that the raw deflate
+// streams concatenate into one.
+static constexpr size_t kParallelBandBytes = 256 * 1024;
+static constexpr size_t kDeflateWindowBytes = 32 * 1024;
+
+static bool deflate_band(const uint8_t* start, size_t len, size_t dictLen, bool last, int level,
+                         int strategy, std::vector<uint8_t>* out) {
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    if (Z_OK != deflateInit2(&z, level, Z_DEFLATED, -MAX_WBITS, 8, strategy)) {
+        return false;
+    }
+    bool ok = 0 == dictLen ||
+              Z_OK == deflateSetDictionary(&z, start - dictLen, SkToUInt(dictLen));
+
+    // A sync flush adds an empty stored block on top of deflateBound().
+    out->resize(deflateBound(&z, len) + 16);
+    z.next_in   = const_cast<uint8_t*>(start);
+    z.avail_in  = SkToUInt(len);
+    z.next_out  = out->data();
+    z.avail_out = SkToUInt(out->size());
+    if (ok) {
+        int result = deflate(&z, last ? Z_FINISH : Z_SYNC_FLUSH);
+        ok = (last ? Z_STREAM_END : Z_OK) == result && 0 == z.avail_in;
+    }
+    out->resize(out->size() - z.avail_out);
+    deflateEnd(&z);
+    return ok;
+}
+
+// libpng deflates with Z_FILTERED unless rows are left unfiltered.
+static int deflate_strategy(int filters) {
+    return filters == PNG_FILTER_NONE ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+}
+
+static constexpr png_byte kIDAT[5] = {'I', 'D', 'A', 'T', '\0'},
+                          kIEND[5] = {'I', 'E', 'N', 'D', '\0'};
+
+static bool write_idat_chunks(png_structp pngPtr, const std::vector<std::vector<uint8_t>>& idats) {
+    if (setjmp(png_jmpbuf(pngPtr))) {
+        return false;
+    }
+
+    for (const std::vector<uint8_t>& idat : idats) {
+        png_write_chunk(pngPtr, kIDAT, idat.data(), idat.size());
+    }
+    // png_write_end() insists on IDATs written through png_write_rows(), and we have no chunks to
+    // write after the image data, so end the file ourselves.
+    png_write_chunk(pngPtr, kIEND, nullptr, 0);
+    return true;
+}
+
+// Like libpng, split the zlib stream into IDAT chunks of at most 8K.
+static constexpr size_t kIdatBytes = 8192;
+
+// Deflates |len| bytes into fIdat, writing an IDAT chunk each time it fills up.  May longjmp().
+bool SkPngEncoderMgr::deflateRows(const uint8_t* bytes, size_t len, int flush) {
+    fZStream.next_in  = const_cast<uint8_t*>(bytes);
+    fZStream.avail_in = SkToUInt(len);
+    while (true) {
+        const int result = deflate(&fZStream, flush);
+        if (Z_OK != result && Z_STREAM_END != result && Z_BUF_ERROR != result) {
+            return false;
+        }
+        const bool done = Z_FINISH == flush ? Z_STREAM_END == result
+                                            : 0 == fZStream.avail_in && 0 != fZStream.avail_out;
+        if (0 == fZStream.avail_out || (done && Z_FINISH == flush)) {
+            png_write_chunk(fPngPtr, kIDAT, fIdat.get(), kIdatBytes - fZStream.avail_out);
+            fZStream.next_out  = fIdat.get();
+            fZStream.avail_out = SkToUInt(kIdatBytes);
+        }
+        if (done) {
+            return true;
+        }
+    }
+}
+
+bool SkPngEncoderMgr::writeRows(const SkPixmap& src, int top, int numRows) {
+    SkASSERT(this->canWriteRows(src.info()));
+    const int bpp = fPngBytesPerPixel;
+    const size_t rowBytes = (size_t)bpp * src.width();
+
+    if (0 == top) {
+        SkASSERT(!fDeflating);
+        memset(&fZStream, 0, sizeof(fZStream));
+        if (Z_OK != deflateInit2(&fZStream, fZLibLevel, Z_DEFLATED, MAX_WBITS, 8,
+                                 deflate_strategy(fFilters))) {
+            return false;
+        }
+        fDeflating = true;
+
+        // The previous and current rows, then the filtered row and a scratch row for choosing
+        // among filters.  The row above the first is all zeros.
+        fRowStorage.reset(4 * rowBytes + 2);
+        memset(fRowStorage.get(), 0, rowBytes);
+        fPrevRow = fRowStorage.get();
+        fRow     = fRowStorage.get() + rowBytes;
+        fIdat.reset(kIdatBytes);
+        fZStream.next_out  = fIdat.get();
+        fZStream.avail_out = SkToUInt(kIdatBytes);
+    }
+    if (!fDeflating) {
+        return false;
+    }
+
+    if (setjmp(png_jmpbuf(fPngPtr))) {
+        return false;
+    }
+
+    uint8_t* filtered = fRowStorage.get() + 2 * rowBytes;
+    uint8_t* scratch  = filtered + rowBytes + 1;
+    for (int y = top; y < top + numRows; y++) {
+        sk_msan_assert_initialized(src.addr(0, y),
+                                   (const uint8_t*)src.addr(0, y) + src.info().minRowBytes());
+        fProc((char*)fRow, (const char*)src.addr(0, y), src.width(),
+              SkColorTypeBytesPerPixel(src.colorType()));
+        filter_row_adaptive(fFilters, filtered, scratch, fRow, fPrevRow, rowBytes, bpp);
+        if (!this->deflateRows(filtered, rowBytes + 1, Z_NO_FLUSH)) {
+            return false;
+        }
+        std::swap(fPrevRow, fRow);
+    }
+
+    if (top + numRows == src.height()) {
+        if (!this->deflateRows(nullptr, 0, Z_FINISH)) {
+            return false;
+        }
+        deflateEnd(&fZStream);
+        fDeflating = false;
+        // png_write_end() insists on IDATs written through png_write_rows(), and we have no
+        // chunks to write after the image data, so end the file ourselves.
+        png_write_chunk(fPngPtr, kIEND, nullptr, 0);
+    }
+    return true;
+}
+
+bool SkPngEncoderMgr::writeRowsInParallel(const SkPixmap& src) {
+    SkASSERT(fExecutor && this->canWriteRows(src.info()));
+    const int height = src.height();
+    const int bpp = fPngBytesPerPixel;
+    const size_t rowBytes = (size_t)bpp * src.width(),
+                 filteredRowBytes = rowBytes + 1;
+
+    const int rowsPerBand = std::max<int>(1, kParallelBandBytes / filteredRowBytes);
+    const int bandCount = (height + rowsPerBand - 1) / rowsPerBand;
+
+    skia_private::AutoTMalloc<uint8_t> rows(rowBytes * height),
+                                       filtered(filteredRowBytes * height),
+                                       zeroRow(rowBytes);
+    memset(zeroRow.get(), 0, rowBytes);
+
+    SkTaskGroup tg(*fExecutor);
+    tg.batch(bandCount, [&](int band) {
+        const int top = band * rowsPerBand,
+                  bottom = std::min(top + rowsPerBand, height);
+        for (int y = top; y < bottom; y++) {
+            sk_msan_assert_initialized(src.addr(0, y),
+                                       (const uint8_t*)src.addr(0, y) + src.info().minRowBytes());
+            fProc((char*)rows.get() + y * rowBytes, (const char*)src.addr(0, y), src.width(),
+                  SkColorTypeBytesPerPixel(src.colorType()));
+        }
+    });
+    tg.wait();
+
+    // Filtering reads the row above, so it waits for every band to be transformed.
+    tg.batch(bandCount, [&](int band) {
+        const int top = band * rowsPerBand,
+                  bottom = std::min(top + rowsPerBand, height);
+        skia_private::AutoTMalloc<uint8_t> scratch(filteredRowBytes);
+        for (int y = top; y < bottom; y++) {
+            const uint8_t* prev = y > 0 ? rows.get() + (y - 1) * rowBytes : zeroRow.get();
+            filter_row_adaptive(fFilters, filtered.get() + y * filteredRowBytes, scratch.get(),
+                                rows.get() + y * rowBytes, prev, rowBytes, bpp);
+        }
+    });
+    tg.wait();
+
+    const int strategy = deflate_strategy(fFilters);
+    std::vector<std::vector<uint8_t>> idats(bandCount);
+    std::vector<uLong> adlers(bandCount);
+    std::atomic<bool> success{true};
+    tg.batch(bandCount, [&](int band) {
+        const size_t start = band * rowsPerBand * filteredRowBytes,
+                     end = std::min<size_t>(start + rowsPerBand * filteredRowBytes,
+                                            filteredRowBytes * height);
+        const uint8_t* bytes = filtered.get() + start;
+        adlers[band] = adler32(adler32(0, Z_NULL, 0), bytes, SkToUInt(end - start));
+        if (!deflate_band(bytes, end - start, std::min(start, kDeflateWindowBytes),
+                          band == bandCount - 1, fZLibLevel, strategy, &idats[band])) {
+            success = false;
+        }
+    });
+    tg.wait();
+    if (!success) {
+        return false;
+    }
+
+    // Wrap the raw deflate data in a zlib header and Adler-32 trailer.
+    uLong adler = adlers[0];
+    for (int band = 1; band < bandCount; band++) {
+        const size_t len = std::min<size_t>(rowsPerBand, height - band * rowsPerBand) *
+                           filteredRowBytes;
+        adler = adler32_combine(adler, adlers[band], len);
+    }
+    const uint8_t level = fZLibLevel < 2 ? 0 : fZLibLevel < 6 ? 1 : fZLibLevel == 6 ? 2 : 3;
+    uint8_t header[2] = {0x78, (uint8_t)(level << 6)};
+    header[1] += (31 - (header[0] * 256 + header[1]) % 31) % 31;
+    idats.front().insert(idats.front().begin(), header, header + 2);
+    const uint8_t trailer[4] = {(uint8_t)(adler >> 24), (uint8_t)(adler >> 16),
+                                (uint8_t)(adler >>  8), (uint8_t)(adler >>  0)};
+    idats.back().insert(idats.back().end(), trailer, trailer + 4);
+
+    return write_idat_chunks(fPngPtr, idats);
+}
+
 std::unique_ptr<SkEncoder> SkPngEncoder::Make(SkWStream* dst, const SkPixmap& src,
                                               const Options& options) {
     if (!SkPixmapIsValid(src)) {
@@ -459,6 +758,16 @@ SkPngEncoder::SkPngEncoder(std::unique_ptr<SkPngEncoderMgr> encoderMgr, const Sk
 SkPngEncoder::~SkPngEncoder() {}
 
 bool SkPngEncoder::onEncodeRows(int numRows) {
+    if (fEncoderMgr->canWriteRows(fSrc.info())) {
+        if (0 == fCurrRow && numRows == fSrc.height() && fEncoderMgr->executor()) {
+            fCurrRow = fSrc.height();
+            return fEncoderMgr->writeRowsInParallel(fSrc);
+        }
+        const int top = fCurrRow;
+        fCurrRow += numRows;
+        return fEncoderMgr->writeRows(fSrc, top, numRows);
+    }
+
     if (setjmp(png_jmpbuf(fEncoderMgr->pngPtr()))) {
         return false;
     }
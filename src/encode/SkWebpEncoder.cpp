@@ -74,8 +74,7 @@ static bool preprocess_webp_picture(WebPPicture* pic,
 
     // Set compression, method, and pixel format.
     // libwebp recommends using BGRA for lossless and YUV for lossy.
-    // The choices of |webp_config.method| currently just match Chrome's defaults.  We
-    // could potentially expose this decision to the client.
+    // The default choices of |webp_config.method| currently just match Chrome's defaults.
     if (SkWebpEncoder::Compression::kLossy == opts.fCompression) {
         webp_config->lossless = 0;
 #ifndef SK_WEBP_ENCODER_USE_DEFAULT_METHOD
@@ -87,6 +86,10 @@ static bool preprocess_webp_picture(WebPPicture* pic,
         webp_config->method = 0;
         pic->use_argb = 1;
     }
+    if (opts.fMethod >= 0) {
+        webp_config->method = opts.fMethod;
+    }
+    webp_config->thread_level = opts.fMultithreaded ? 1 : 0;
 
     {
         const SkColorType ct = pixmap.colorType();
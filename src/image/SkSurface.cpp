@@ -109,6 +109,14 @@ void SkSurface_Base::onDraw(SkCanvas* canvas, SkScalar x, SkScalar y,
     }
 }
 
+bool SkSurface_Base::onPeekPixels(SkPixmap* pmap) {
+    return this->getCachedCanvas()->peekPixels(pmap);
+}
+
+bool SkSurface_Base::onReadPixels(const SkPixmap& pm, int srcX, int srcY) {
+    return this->getCachedCanvas()->readPixels(pm, srcX, srcY);
+}
+
 void SkSurface_Base::onAsyncRescaleAndReadPixels(const SkImageInfo& info,
                                                  SkIRect origSrcRect,
                                                  SkSurface::RescaleGamma rescaleGamma,
@@ -289,11 +297,11 @@ void SkSurface::draw(SkCanvas* canvas, SkScalar x, SkScalar y, const SkSamplingO
 }
 
 bool SkSurface::peekPixels(SkPixmap* pmap) {
-    return this->getCanvas()->peekPixels(pmap);
+    return asSB(this)->onPeekPixels(pmap);
 }
 
 bool SkSurface::readPixels(const SkPixmap& pm, int srcX, int srcY) {
-    return this->getCanvas()->readPixels(pm, srcX, srcY);
+    return asSB(this)->onReadPixels(pm, srcX, srcY);
 }
 
 bool SkSurface::readPixels(const SkImageInfo& dstInfo, void* dstPixels, size_t dstRowBytes,
@@ -77,6 +77,13 @@ public:
 
     virtual void onWritePixels(const SkPixmap&, int x, int y) = 0;
 
+    /**
+     *  Default implementations forward to the cached canvas. Surfaces whose canvas does not draw
+     *  directly into their backing store (e.g. deferred or recording surfaces) override these.
+     */
+    virtual bool onPeekPixels(SkPixmap*);
+    virtual bool onReadPixels(const SkPixmap&, int srcX, int srcY);
+
     /**
      * Default implementation does a rescale/read and then calls the callback.
      */
@@ -0,0 +1,404 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkCapabilities.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkMallocPixelRef.h"
+#include "include/core/SkPixelRef.h"
+#include "include/core/SkRect.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkSamplingOptions.h"
+#include "include/core/SkSurface.h"
+#include "include/utils/SkPaintFilterCanvas.h"
+#include "src/core/SkBigPicture.h"
+#include "src/core/SkBitmapDevice.h"
+#include "src/core/SkImagePriv.h"
+#include "src/core/SkPicturePriv.h"
+#include "src/core/SkRTree.h"
+#include "src/core/SkRecord.h"
+#include "src/core/SkRecordDraw.h"
+#include "src/core/SkRecordOpts.h"
+#include "src/core/SkRecorder.h"
+#include "src/core/SkRecords.h"
+#include "src/core/SkSurfacePriv.h"
+#include "src/core/SkTaskGroup.h"
+#include "src/image/SkSurface_Base.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Tiles are full-width bands of rows. Every tile scan converts the whole of each op that touches
+// it (only its blits are clipped to the tile), so full-width bands mean a wide op is converted
+// once per band instead of once per square tile. 256 rows still leaves enough bands to keep every
+// thread of a typical pool busy on the large surfaces this is meant for.
+constexpr int kTileHeight = 256;
+
+// Forwards everything to an SkRecorder, and tells the surface about each draw so that outstanding
+// snapshots are copied-on-write exactly as they would be for a raster SkCanvas.
+class ThreadedRasterCanvas final : public SkPaintFilterCanvas {
+public:
+    ThreadedRasterCanvas(SkRecorder* recorder, SkSurface* surface)
+            : SkPaintFilterCanvas(recorder), fSurface(surface) {}
+
+protected:
+    bool onFilter(SkPaint&) const override {
+        fSurface->notifyContentWillChange(SkSurface::kRetain_ContentChangeMode);
+        return true;
+    }
+
+    // SkPaintFilterCanvas does not filter shadows, but they still draw.
+    void onDrawShadowRec(const SkPath& path, const SkDrawShadowRec& rec) override {
+        fSurface->notifyContentWillChange(SkSurface::kRetain_ContentChangeMode);
+        this->SkPaintFilterCanvas::onDrawShadowRec(path, rec);
+    }
+
+    SkImageInfo onImageInfo() const override { return fSurface->imageInfo(); }
+
+    bool onGetProps(SkSurfaceProps* props, bool) const override {
+        if (props) {
+            *props = fSurface->props();
+        }
+        return true;
+    }
+
+    sk_sp<SkSurface> onNewSurface(const SkImageInfo& info, const SkSurfaceProps& props) override {
+        return SkSurface::MakeRaster(info, &props);
+    }
+
+private:
+    SkSurface* fSurface;
+};
+
+// Classifies the ops that change the save stack.
+struct SaveStackOp {
+    enum Kind { kNone, kSave, kSaveLayer, kRestore };
+
+    Kind operator()(const SkRecords::Save&)       { return kSave; }
+    Kind operator()(const SkRecords::SaveLayer&)  { return kSaveLayer; }
+    Kind operator()(const SkRecords::SaveBehind&) { return kSaveLayer; }
+    Kind operator()(const SkRecords::Restore&)    { return kRestore; }
+    template <typename T>
+    Kind operator()(const T&) { return kNone; }
+};
+
+// Replays only the ops that affect matrix, clip and save stack. Layers are replaced by plain
+// saves so that the save count is preserved without compositing anything.
+class ReplayState {
+public:
+    ReplayState(SkCanvas* canvas, SkRecords::Draw* draw) : fCanvas(canvas), fDraw(draw) {}
+
+    void operator()(const SkRecords::SaveLayer&)      { fCanvas->save(); }
+    void operator()(const SkRecords::SaveBehind&)     { fCanvas->save(); }
+    void operator()(const SkRecords::Flush&)          {}
+    void operator()(const SkRecords::DrawAnnotation&) {}
+    template <typename T>
+    void operator()(const T& op) {
+        if constexpr (!(T::kTags & SkRecords::kDraw_Tag)) {
+            (*fDraw)(op);
+        }
+    }
+
+private:
+    SkCanvas*        fCanvas;
+    SkRecords::Draw* fDraw;
+};
+
+// Finds ops that read back pixels of the surface they draw into. Another tile may be writing
+// those pixels at the same time, so a record containing any of them is drawn on one thread.
+struct ReadsSurface {
+    bool operator()(const SkRecords::SaveLayer& op) {
+        return op.backdrop || (op.saveLayerFlags & SkCanvas::kInitWithPrevious_SaveLayerFlag);
+    }
+    bool operator()(const SkRecords::SaveBehind&) { return true; }
+    bool operator()(const SkRecords::DrawPicture& op) {
+        return picture_reads_surface(op.picture.get());
+    }
+    template <typename T>
+    bool operator()(const T&) { return false; }
+
+    static bool picture_reads_surface(const SkPicture* picture) {
+        const SkBigPicture* big = SkPicturePriv::AsSkBigPicture(sk_ref_sp(picture));
+        return big && record_reads_surface(*big->record(), big->record()->count());
+    }
+
+    static bool record_reads_surface(const SkRecord& record, int count) {
+        for (int i = 0; i < count; i++) {
+            if (record.visit(i, ReadsSurface())) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// Returns the index of the outermost SaveLayer (or SaveBehind) that has not been restored yet, or
+// record.count() if there is none.
+int first_open_layer(const SkRecord& record) {
+    std::vector<std::pair<int, bool>> stack;  // (op index, is layer)
+    for (int i = 0; i < record.count(); i++) {
+        switch (record.visit(i, SaveStackOp())) {
+            case SaveStackOp::kSave:      stack.push_back({i, false}); break;
+            case SaveStackOp::kSaveLayer: stack.push_back({i, true});  break;
+            case SaveStackOp::kRestore:   if (!stack.empty()) { stack.pop_back(); } break;
+            case SaveStackOp::kNone:      break;
+        }
+    }
+    for (const auto& [index, isLayer] : stack) {
+        if (isLayer) {
+            return index;
+        }
+    }
+    return record.count();
+}
+
+}  // namespace
+
+class SkSurface_ThreadedRaster : public SkSurface_Base {
+public:
+    SkSurface_ThreadedRaster(const SkImageInfo&, sk_sp<SkPixelRef>, SkExecutor*,
+                             const SkSurfaceProps*);
+
+    SkImageInfo imageInfo() const override { return fBitmap.info(); }
+
+    SkCanvas* onNewCanvas() override;
+    sk_sp<SkSurface> onNewSurface(const SkImageInfo&) override;
+    sk_sp<SkImage> onNewImageSnapshot(const SkIRect* subset) override;
+    void onWritePixels(const SkPixmap&, int x, int y) override;
+    bool onPeekPixels(SkPixmap*) override;
+    bool onReadPixels(const SkPixmap&, int srcX, int srcY) override;
+    void onDraw(SkCanvas*, SkScalar, SkScalar, const SkSamplingOptions&, const SkPaint*) override;
+    bool onCopyOnWrite(ContentChangeMode) override;
+    void onRestoreBackingMutability() override;
+    sk_sp<const SkCapabilities> onCapabilities() override;
+
+private:
+    // Rasterizes every recorded draw that is visible in the surface right now into fBitmap.
+    void flushRecording();
+
+    SkBitmap                  fBitmap;
+    SkExecutor*               fExecutor;
+    std::unique_ptr<SkRecord> fRecord;
+    SkRecorder                fRecorder;
+
+    using INHERITED = SkSurface_Base;
+};
+
+SkSurface_ThreadedRaster::SkSurface_ThreadedRaster(const SkImageInfo& info,
+                                                   sk_sp<SkPixelRef> pr,
+                                                   SkExecutor* executor,
+                                                   const SkSurfaceProps* props)
+        : INHERITED(pr->width(), pr->height(), props)
+        , fExecutor(executor)
+        , fRecord(std::make_unique<SkRecord>())
+        , fRecorder(fRecord.get(), SkRect::MakeIWH(info.width(), info.height())) {
+    fBitmap.setInfo(info, pr->rowBytes());
+    fBitmap.setPixelRef(std::move(pr), 0, 0);
+}
+
+SkCanvas* SkSurface_ThreadedRaster::onNewCanvas() {
+    return new ThreadedRasterCanvas(&fRecorder, this);
+}
+
+sk_sp<SkSurface> SkSurface_ThreadedRaster::onNewSurface(const SkImageInfo& info) {
+    return SkSurface::MakeRasterThreaded(info, fExecutor, &this->props());
+}
+
+void SkSurface_ThreadedRaster::flushRecording() {
+    const int count = fRecord->count();
+    if (count == 0) {
+        return;
+    }
+
+    // Draws inside a layer that is still open are not visible yet; they stay recorded until the
+    // layer is restored, just as they would stay in the layer's device for a raster SkCanvas.
+    const int visibleCount = first_open_layer(*fRecord);
+
+    // Parallel playback needs thread-safe drawables, so replay snapshots of them instead.
+    std::unique_ptr<SkDrawableList> drawables = fRecorder.detachDrawableList();
+    std::unique_ptr<SkBigPicture::SnapshotArray> drawablePicts;
+    if (drawables) {
+        drawablePicts.reset(drawables->newDrawableSnapshot());
+    }
+
+    const SkIRect bounds = fBitmap.bounds();
+    bool serial = ReadsSurface::record_reads_surface(*fRecord, visibleCount);
+    if (drawablePicts) {
+        for (int i = 0; i < drawablePicts->count(); i++) {
+            serial = serial || ReadsSurface::picture_reads_surface(drawablePicts->begin()[i]);
+        }
+    }
+
+    if (serial) {
+        SkCanvas canvas(fBitmap, this->props());
+        SkRecords::Draw draw(&canvas,
+                             drawablePicts ? drawablePicts->begin() : nullptr,
+                             nullptr,
+                             drawablePicts ? drawablePicts->count() : 0);
+        for (int i = 0; i < visibleCount; i++) {
+            fRecord->visit(i, draw);
+        }
+    } else {
+        std::unique_ptr<SkRect[]> opBounds(new SkRect[count]);
+        std::unique_ptr<SkBBoxHierarchy::Metadata[]> opMeta(new SkBBoxHierarchy::Metadata[count]);
+        SkRecordFillBounds(SkRect::Make(bounds), *fRecord, opBounds.get(), opMeta.get());
+        SkRTree rtree;
+        rtree.insert(opBounds.get(), count);
+
+        const int tiles = (bounds.height() + kTileHeight - 1) / kTileHeight;
+        SkTaskGroup tasks(*fExecutor);
+        tasks.batch(tiles, [&](int i) {
+            SkIRect tile = SkIRect::MakeXYWH(0, i * kTileHeight, bounds.width(), kTileHeight);
+            if (!tile.intersect(bounds)) {
+                return;
+            }
+            // Clipping the canvas to the tile would also clip the geometry it scan converts,
+            // which changes anti-aliased coverage along the tile's edges. Clip only the blits,
+            // so every pixel in the tile is exactly what one canvas over the surface would write.
+            // Op bounds include the image filters of the layers they are in, so a filtered layer
+            // still gets every op that reaches the tile once filtered. Layers are sized by the
+            // clip, not the tile, for the same reason.
+            auto device = sk_make_sp<SkBitmapDevice>(fBitmap, this->props());
+            device->setBlitClip(tile);
+            SkCanvas canvas(std::move(device));
+
+            std::vector<int> ops;
+            rtree.search(SkRect::Make(tile), &ops);
+
+            SkRecords::Draw draw(&canvas,
+                                 drawablePicts ? drawablePicts->begin() : nullptr,
+                                 nullptr,
+                                 drawablePicts ? drawablePicts->count() : 0);
+            for (int op : ops) {
+                // search() returns ops in record order.
+                if (op >= visibleCount) {
+                    break;
+                }
+                fRecord->visit(op, draw);
+            }
+        });
+        tasks.wait();
+    }
+
+    // Start a new record that carries over the recorder's matrix, clip and save stack, followed
+    // by any ops still waiting on an open layer.
+    std::unique_ptr<SkRecord> prev = std::move(fRecord);
+    fRecord = std::make_unique<SkRecord>();
+    fRecorder.reset(fRecord.get(), SkRect::Make(bounds));
+
+    const SkM44 identity;
+    SkRecords::Draw copy(&fRecorder, nullptr,
+                         drawables ? drawables->begin() : nullptr,
+                         drawables ? drawables->count() : 0,
+                         &identity);
+    ReplayState replayState(&fRecorder, &copy);
+    for (int i = 0; i < visibleCount; i++) {
+        prev->visit(i, replayState);
+    }
+    for (int i = visibleCount; i < count; i++) {
+        prev->visit(i, copy);
+    }
+    SkRecordNoopSaveRestores(fRecord.get());
+    fRecord->defrag();
+}
+
+void SkSurface_ThreadedRaster::onDraw(SkCanvas* canvas, SkScalar x, SkScalar y,
+                                      const SkSamplingOptions& sampling, const SkPaint* paint) {
+    this->flushRecording();
+    canvas->drawImage(fBitmap.asImage().get(), x, y, sampling, paint);
+}
+
+sk_sp<SkImage> SkSurface_ThreadedRaster::onNewImageSnapshot(const SkIRect* subset) {
+    this->flushRecording();
+
+    if (subset) {
+        SkASSERT(fBitmap.bounds().contains(*subset));
+        SkBitmap dst;
+        dst.allocPixels(fBitmap.info().makeDimensions(subset->size()));
+        SkAssertResult(fBitmap.readPixels(dst.pixmap(), subset->left(), subset->top()));
+        dst.setImmutable(); // key, so MakeFromBitmap doesn't make a copy of the buffer
+        return dst.asImage();
+    }
+
+    // SkImage_raster requires these pixels are immutable for its full lifetime.
+    // We'll undo this via onRestoreBackingMutability() if we can avoid the COW.
+    if (SkPixelRef* pr = fBitmap.pixelRef()) {
+        pr->setTemporarilyImmutable();
+    }
+    return SkMakeImageFromRasterBitmap(fBitmap, kIfMutable_SkCopyPixelsMode);
+}
+
+void SkSurface_ThreadedRaster::onWritePixels(const SkPixmap& src, int x, int y) {
+    this->flushRecording();
+    fBitmap.writePixels(src, x, y);
+}
+
+bool SkSurface_ThreadedRaster::onPeekPixels(SkPixmap* pmap) {
+    this->flushRecording();
+    return fBitmap.peekPixels(pmap);
+}
+
+bool SkSurface_ThreadedRaster::onReadPixels(const SkPixmap& dst, int srcX, int srcY) {
+    this->flushRecording();
+    return dst.addr() && fBitmap.readPixels(dst, srcX, srcY);
+}
+
+void SkSurface_ThreadedRaster::onRestoreBackingMutability() {
+    SkASSERT(!this->hasCachedImage());  // Shouldn't be any snapshots out there.
+    if (SkPixelRef* pr = fBitmap.pixelRef()) {
+        pr->restoreMutability();
+    }
+}
+
+bool SkSurface_ThreadedRaster::onCopyOnWrite(ContentChangeMode mode) {
+    // Snapshots always flush, and any draw since drops the cached image, so there is never
+    // anything recorded to preserve here.
+    sk_sp<SkImage> cached(this->refCachedImage());
+    SkASSERT(cached);
+    if (SkBitmapImageGetPixelRef(cached.get()) == fBitmap.pixelRef()) {
+        if (kDiscard_ContentChangeMode == mode) {
+            if (!fBitmap.tryAllocPixels()) {
+                return false;
+            }
+        } else {
+            SkBitmap prev(fBitmap);
+            if (!fBitmap.tryAllocPixels()) {
+                return false;
+            }
+            SkASSERT(prev.info() == fBitmap.info());
+            SkASSERT(prev.rowBytes() == fBitmap.rowBytes());
+            memcpy(fBitmap.getPixels(), prev.getPixels(), fBitmap.computeByteSize());
+        }
+        // Playback makes a new SkCanvas over fBitmap on each flush, so there is no device to
+        // update here.
+    }
+    return true;
+}
+
+sk_sp<const SkCapabilities> SkSurface_ThreadedRaster::onCapabilities() {
+    return SkCapabilities::RasterBackend();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+sk_sp<SkSurface> SkSurface::MakeRasterThreaded(const SkImageInfo& info,
+                                               SkExecutor* executor,
+                                               const SkSurfaceProps* props) {
+    if (!executor || !SkSurfaceValidateRasterInfo(info)) {
+        return nullptr;
+    }
+
+    sk_sp<SkPixelRef> pr = SkMallocPixelRef::MakeAllocate(info, 0);
+    if (!pr) {
+        return nullptr;
+    }
+    return sk_make_sp<SkSurface_ThreadedRaster>(info, std::move(pr), executor, props);
+}
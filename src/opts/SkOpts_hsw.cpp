@@ -13,6 +13,7 @@
 #include "src/core/SkCubicSolver.h"
 #include "src/opts/SkBitmapProcState_opts.h"
 #include "src/opts/SkBlitRow_opts.h"
+#include "src/opts/SkPngFilter_opts.h"
 #include "src/opts/SkRasterPipeline_opts.h"
 #include "src/opts/SkSwizzler_opts.h"
 #include "src/opts/SkUtils_opts.h"
@@ -27,6 +28,9 @@ namespace SkOpts {
 
         cubic_solver = SK_OPTS_NS::cubic_solver;
 
+        png_filter_row = SK_OPTS_NS::png_filter_row;
+        png_filter_sum = SK_OPTS_NS::png_filter_sum;
+
         RGBA_to_BGRA          = SK_OPTS_NS::RGBA_to_BGRA;
         RGBA_to_rgbA          = SK_OPTS_NS::RGBA_to_rgbA;
         RGBA_to_bgrA          = SK_OPTS_NS::RGBA_to_bgrA;
@@ -53,6 +57,14 @@ namespace SkOpts {
 
         interpret_skvm = SK_OPTS_NS::interpret_skvm;
     }
+
+    void GetLowpStages_hsw(LowpStages* stages) {
+    #define M(st) stages->ops[(int)SkRasterPipelineOp::st] = (StageFn)SK_OPTS_NS::lowp::st;
+        SK_RASTER_PIPELINE_OPS_LOWP(M)
+        stages->just_return = (StageFn)SK_OPTS_NS::lowp::just_return;
+        stages->start_pipeline = SK_OPTS_NS::lowp::start_pipeline;
+    #undef M
+    }
 }  // namespace SkOpts
 
 #endif // SK_ENABLE_OPTIMIZE_SIZE
@@ -10,12 +10,37 @@
 #if !defined(SK_ENABLE_OPTIMIZE_SIZE)
 
 #define SK_OPTS_NS skx
+#include "src/opts/SkRasterPipeline_opts.h"
 #include "src/opts/SkVM_opts.h"
 
 namespace SkOpts {
     void Init_skx() {
+        // The highp stages are the same width as hsw's; the lowp stages run 32 pixels at a time.
+        raster_pipeline_lowp_stride  = SK_OPTS_NS::raster_pipeline_lowp_stride();
+        raster_pipeline_highp_stride = SK_OPTS_NS::raster_pipeline_highp_stride();
+
+    #define M(st) ops_highp[(int)SkRasterPipelineOp::st] = (StageFn)SK_OPTS_NS::st;
+        SK_RASTER_PIPELINE_OPS_ALL(M)
+        just_return_highp = (StageFn)SK_OPTS_NS::just_return;
+        start_pipeline_highp = SK_OPTS_NS::start_pipeline;
+    #undef M
+
+    #define M(st) ops_lowp[(int)SkRasterPipelineOp::st] = (StageFn)SK_OPTS_NS::lowp::st;
+        SK_RASTER_PIPELINE_OPS_LOWP(M)
+        just_return_lowp = (StageFn)SK_OPTS_NS::lowp::just_return;
+        start_pipeline_lowp = SK_OPTS_NS::lowp::start_pipeline;
+    #undef M
+
         interpret_skvm = SK_OPTS_NS::interpret_skvm;
     }
+
+    void GetLowpStages_skx(LowpStages* stages) {
+    #define M(st) stages->ops[(int)SkRasterPipelineOp::st] = (StageFn)SK_OPTS_NS::lowp::st;
+        SK_RASTER_PIPELINE_OPS_LOWP(M)
+        stages->just_return = (StageFn)SK_OPTS_NS::lowp::just_return;
+        stages->start_pipeline = SK_OPTS_NS::lowp::start_pipeline;
+    #undef M
+    }
 }  // namespace SkOpts
 
 #endif // SK_ENABLE_OPTIMIZE_SIZE
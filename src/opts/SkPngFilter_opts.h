@@ -0,0 +1,250 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPngFilter_opts_DEFINED
+#define SkPngFilter_opts_DEFINED
+
+#include "include/core/SkTypes.h"
+#include "src/core/SkOpts.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    #include <immintrin.h>
+#elif defined(SK_ARM_HAS_NEON)
+    #include <arm_neon.h>
+#endif
+
+// PNG row filters, as used by the encoder.  Each filter predicts a byte from its neighbors to the
+// left (a), above (b) and above-left (c) and stores the difference.  Encoding only ever reads the
+// unfiltered rows, so unlike decoding every byte can be filtered independently.
+// See https://www.w3.org/TR/png/#9Filter-types.
+
+namespace SK_OPTS_NS {
+
+    // Each platform below provides PngV, a vector of kPngN bytes, and the handful of operations
+    // on it that png_filter_row() needs.
+
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+    using PngV = __m256i;
+    static constexpr int kPngN = 32;
+
+    static inline PngV png_load(const uint8_t* p) { return _mm256_loadu_si256((const PngV*)p); }
+    static inline void png_store(uint8_t* p, PngV v) { _mm256_storeu_si256((PngV*)p, v); }
+    static inline PngV png_sub(PngV x, PngV y) { return _mm256_sub_epi8(x, y); }
+
+    // avg_epu8 rounds up; we want floor((a + b) / 2).
+    static inline PngV png_avg(PngV a, PngV b) {
+        return _mm256_sub_epi8(_mm256_avg_epu8(a, b),
+                               _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_set1_epi8(1)));
+    }
+
+    static inline PngV png_paeth_16(PngV a, PngV b, PngV c) {
+        PngV pa = _mm256_sub_epi16(b, c),
+             pb = _mm256_sub_epi16(a, c),
+             pc = _mm256_add_epi16(pa, pb);
+        pa = _mm256_abs_epi16(pa);
+        pb = _mm256_abs_epi16(pb);
+        pc = _mm256_abs_epi16(pc);
+        PngV notA = _mm256_or_si256(_mm256_cmpgt_epi16(pa, pb), _mm256_cmpgt_epi16(pa, pc)),
+             useC = _mm256_cmpgt_epi16(pb, pc);
+        return _mm256_blendv_epi8(a, _mm256_blendv_epi8(b, c, useC), notA);
+    }
+
+    static inline PngV png_paeth(PngV a, PngV b, PngV c) {
+        // Unpacking and packing both work within 128-bit lanes, so the bytes end up in order.
+        const PngV z = _mm256_setzero_si256();
+        PngV lo = png_paeth_16(_mm256_unpacklo_epi8(a, z),
+                               _mm256_unpacklo_epi8(b, z),
+                               _mm256_unpacklo_epi8(c, z)),
+             hi = png_paeth_16(_mm256_unpackhi_epi8(a, z),
+                               _mm256_unpackhi_epi8(b, z),
+                               _mm256_unpackhi_epi8(c, z));
+        return _mm256_packus_epi16(lo, hi);
+    }
+
+#elif SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    using PngV = __m128i;
+    static constexpr int kPngN = 16;
+
+    static inline PngV png_load(const uint8_t* p) { return _mm_loadu_si128((const PngV*)p); }
+    static inline void png_store(uint8_t* p, PngV v) { _mm_storeu_si128((PngV*)p, v); }
+    static inline PngV png_sub(PngV x, PngV y) { return _mm_sub_epi8(x, y); }
+
+    static inline PngV png_avg(PngV a, PngV b) {
+        return _mm_sub_epi8(_mm_avg_epu8(a, b),
+                            _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+    }
+
+    static inline PngV png_paeth_16(PngV a, PngV b, PngV c) {
+        const PngV z = _mm_setzero_si128();
+        PngV pa = _mm_sub_epi16(b, c),
+             pb = _mm_sub_epi16(a, c),
+             pc = _mm_add_epi16(pa, pb);
+        // SSE2 has no abs_epi16.
+        pa = _mm_max_epi16(pa, _mm_sub_epi16(z, pa));
+        pb = _mm_max_epi16(pb, _mm_sub_epi16(z, pb));
+        pc = _mm_max_epi16(pc, _mm_sub_epi16(z, pc));
+        PngV notA = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc)),
+             useC = _mm_cmpgt_epi16(pb, pc);
+        PngV bc = _mm_or_si128(_mm_andnot_si128(useC, b), _mm_and_si128(useC, c));
+        return _mm_or_si128(_mm_andnot_si128(notA, a), _mm_and_si128(notA, bc));
+    }
+
+    static inline PngV png_paeth(PngV a, PngV b, PngV c) {
+        const PngV z = _mm_setzero_si128();
+        PngV lo = png_paeth_16(_mm_unpacklo_epi8(a, z),
+                               _mm_unpacklo_epi8(b, z),
+                               _mm_unpacklo_epi8(c, z)),
+             hi = png_paeth_16(_mm_unpackhi_epi8(a, z),
+                               _mm_unpackhi_epi8(b, z),
+                               _mm_unpackhi_epi8(c, z));
+        return _mm_packus_epi16(lo, hi);
+    }
+
+#elif defined(SK_ARM_HAS_NEON)
+    using PngV = uint8x16_t;
+    static constexpr int kPngN = 16;
+
+    static inline PngV png_load(const uint8_t* p) { return vld1q_u8(p); }
+    static inline void png_store(uint8_t* p, PngV v) { vst1q_u8(p, v); }
+    static inline PngV png_sub(PngV x, PngV y) { return vsubq_u8(x, y); }
+    static inline PngV png_avg(PngV a, PngV b) { return vhaddq_u8(a, b); }
+
+    static inline uint8x8_t png_paeth_8(uint8x8_t a, uint8x8_t b, uint8x8_t c) {
+        // |b - c| and |a - c| fit in 8 bits; |a + b - 2c| needs 16.
+        uint8x8_t  pa = vabd_u8(b, c),
+                   pb = vabd_u8(a, c);
+        uint16x8_t pc = vabdq_u16(vaddl_u8(a, b), vshll_n_u8(c, 1));
+        uint8x8_t useA = vand_u8(vcle_u8(pa, pb), vmovn_u16(vcleq_u16(vmovl_u8(pa), pc))),
+                  useB = vmovn_u16(vcleq_u16(vmovl_u8(pb), pc));
+        return vbsl_u8(useA, a, vbsl_u8(useB, b, c));
+    }
+
+    static inline PngV png_paeth(PngV a, PngV b, PngV c) {
+        return vcombine_u8(png_paeth_8(vget_low_u8 (a), vget_low_u8 (b), vget_low_u8 (c)),
+                           png_paeth_8(vget_high_u8(a), vget_high_u8(b), vget_high_u8(c)));
+    }
+
+#else
+    using PngV = uint8_t;
+    static constexpr int kPngN = 1;
+
+    static inline PngV png_load(const uint8_t* p) { return *p; }
+    static inline void png_store(uint8_t* p, PngV v) { *p = v; }
+    static inline PngV png_sub(PngV x, PngV y) { return x - y; }
+    static inline PngV png_avg(PngV a, PngV b) { return (a + b) >> 1; }
+    static inline PngV png_paeth(PngV a, PngV b, PngV c) {
+        return SkOpts::png_paeth_predictor(a, b, c);
+    }
+#endif
+
+    // Filters rowBytes bytes of row against prev, the unfiltered row above it, into dst.  filter
+    // is one of the PNG filter type bytes, 0 (None) through 4 (Paeth).
+    /*not static*/ inline void png_filter_row(int filter, uint8_t dst[], const uint8_t row[],
+                                              const uint8_t prev[], size_t rowBytes, int bpp) {
+        // The first pixel has no left neighbor, so its a and c are zero.
+        const size_t first = std::min((size_t)bpp, rowBytes);
+        size_t i = first;
+        switch (filter) {
+            case 0:  // None
+                memcpy(dst, row, rowBytes);
+                return;
+            case 1:  // Sub
+                memcpy(dst, row, first);
+                for (; i + kPngN <= rowBytes; i += kPngN) {
+                    png_store(dst + i, png_sub(png_load(row + i), png_load(row + i - bpp)));
+                }
+                for (; i < rowBytes; i++) {
+                    dst[i] = row[i] - row[i - bpp];
+                }
+                return;
+            case 2:  // Up
+                for (i = 0; i + kPngN <= rowBytes; i += kPngN) {
+                    png_store(dst + i, png_sub(png_load(row + i), png_load(prev + i)));
+                }
+                for (; i < rowBytes; i++) {
+                    dst[i] = row[i] - prev[i];
+                }
+                return;
+            case 3:  // Avg
+                for (size_t j = 0; j < first; j++) {
+                    dst[j] = row[j] - (prev[j] >> 1);
+                }
+                for (; i + kPngN <= rowBytes; i += kPngN) {
+                    PngV avg = png_avg(png_load(row + i - bpp), png_load(prev + i));
+                    png_store(dst + i, png_sub(png_load(row + i), avg));
+                }
+                for (; i < rowBytes; i++) {
+                    dst[i] = row[i] - ((row[i - bpp] + prev[i]) >> 1);
+                }
+                return;
+            case 4:  // Paeth
+                for (size_t j = 0; j < first; j++) {
+                    dst[j] = row[j] - prev[j];
+                }
+                for (; i + kPngN <= rowBytes; i += kPngN) {
+                    PngV pred = png_paeth(png_load(row + i - bpp),
+                                          png_load(prev + i),
+                                          png_load(prev + i - bpp));
+                    png_store(dst + i, png_sub(png_load(row + i), pred));
+                }
+                for (; i < rowBytes; i++) {
+                    dst[i] = row[i] - SkOpts::png_paeth_predictor(row[i - bpp], prev[i],
+                                                                  prev[i - bpp]);
+                }
+                return;
+        }
+        SkDEBUGFAIL("Unknown PNG filter type.");
+    }
+
+    // libpng's heuristic for choosing a filter: the sum of the filtered bytes' magnitudes, treating
+    // each byte as signed.  |x| for a signed byte x is min(x, -x) when both are viewed as unsigned.
+    /*not static*/ inline uint64_t png_filter_sum(const uint8_t bytes[], size_t len) {
+        uint64_t sum = 0;
+        size_t i = 0;
+    #if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+        __m256i acc = _mm256_setzero_si256();
+        for (; i + 32 <= len; i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(bytes + i));
+            v = _mm256_min_epu8(v, _mm256_sub_epi8(_mm256_setzero_si256(), v));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(v, _mm256_setzero_si256()));
+        }
+        uint64_t lanes[4];
+        _mm256_storeu_si256((__m256i*)lanes, acc);
+        sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    #elif SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+        __m128i acc = _mm_setzero_si128();
+        for (; i + 16 <= len; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(bytes + i));
+            v = _mm_min_epu8(v, _mm_sub_epi8(_mm_setzero_si128(), v));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(v, _mm_setzero_si128()));
+        }
+        uint64_t lanes[2];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        sum = lanes[0] + lanes[1];
+    #elif defined(SK_ARM_HAS_NEON)
+        uint64x2_t acc = vdupq_n_u64(0);
+        for (; i + 16 <= len; i += 16) {
+            uint8x16_t v = vld1q_u8(bytes + i);
+            v = vminq_u8(v, vreinterpretq_u8_s8(vnegq_s8(vreinterpretq_s8_u8(v))));
+            acc = vpadalq_u32(acc, vpaddlq_u16(vpaddlq_u8(v)));
+        }
+        sum = vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+    #endif
+        for (; i < len; i++) {
+            sum += std::min(bytes[i], (uint8_t)(0 - bytes[i]));
+        }
+        return sum;
+    }
+
+}  // namespace SK_OPTS_NS
+
+#endif // SkPngFilter_opts_DEFINED
@@ -10,7 +10,6 @@
 #include "include/core/SkBitmap.h"
 #include "include/core/SkData.h"
 #include "include/core/SkEncodedImageFormat.h"
-#include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkStream.h"
 #include "include/private/SkColorData.h"
@@ -159,14 +158,12 @@ static void do_deflated_alpha(const SkPixmap& pm, SkPDFDocument* doc, SkPDFIndir
                       length, format);
 }
 
+// The image has a soft mask exactly when sMask is set.
 static void do_deflated_image(const SkPixmap& pm,
                               SkPDFDocument* doc,
-                              bool isOpaque,
-                              SkPDFIndirectReference ref) {
-    SkPDFIndirectReference sMask;
-    if (!isOpaque) {
-        sMask = doc->reserveRef();
-    }
+                              SkPDFIndirectReference ref,
+                              SkPDFIndirectReference sMask) {
+    const bool isOpaque = !sMask;
     SkPDF::Metadata::CompressionLevel compressionLevel = doc->metadata().fCompressionLevel;
     SkPDFStreamFormat format = compressionLevel == SkPDF::Metadata::CompressionLevel::None
                              ? SkPDFStreamFormat::Uncompressed
@@ -282,30 +279,44 @@ static SkBitmap to_pixels(const SkImage* image) {
     return bm;
 }
 
+// Whether the image is written with a soft mask.  This is decided before its pixels are read, so
+// that the mask's reference can be reserved in the same order whether or not the image is
+// serialized on another thread.  Raster images are checked for transparent pixels; others can only
+// be judged by their alpha type, so one that turns out to be opaque gets an opaque soft mask.
+static bool needs_smask(const SkImage* img) {
+    if (img->isOpaque()) {
+        return false;
+    }
+    SkPixmap pm;
+    return !img->peekPixels(&pm) || !pm.computeIsOpaque();
+}
+
 void serialize_image(const SkImage* img,
                      int encodingQuality,
                      SkPDFDocument* doc,
-                     SkPDFIndirectReference ref) {
+                     SkPDFIndirectReference ref,
+                     SkPDFIndirectReference sMask) {
     SkASSERT(img);
     SkASSERT(doc);
     SkASSERT(encodingQuality >= 0);
     SkISize dimensions = img->dimensions();
-    if (sk_sp<SkData> data = img->refEncodedData()) {
-        if (do_jpeg(std::move(data), doc, dimensions, ref)) {
-            return;
+    if (!sMask) {
+        if (sk_sp<SkData> data = img->refEncodedData()) {
+            if (do_jpeg(std::move(data), doc, dimensions, ref)) {
+                return;
+            }
         }
     }
     SkBitmap bm = to_pixels(img);
     const SkPixmap& pm = bm.pixmap();
-    bool isOpaque = pm.isOpaque() || pm.computeIsOpaque();
-    if (encodingQuality <= 100 && isOpaque) {
+    if (encodingQuality <= 100 && !sMask) {
         if (sk_sp<SkData> data = img->encodeToData(SkEncodedImageFormat::kJPEG, encodingQuality)) {
             if (do_jpeg(std::move(data), doc, dimensions, ref)) {
                 return;
             }
         }
     }
-    do_deflated_image(pm, doc, isOpaque, ref);
+    do_deflated_image(pm, doc, ref, sMask);
 }
 
 SkPDFIndirectReference SkPDFSerializeImage(const SkImage* img,
@@ -313,17 +324,19 @@ SkPDFIndirectReference SkPDFSerializeImage(const SkImage* img,
                                            int encodingQuality) {
     SkASSERT(img);
     SkASSERT(doc);
-    SkPDFIndirectReference ref = doc->reserveRef();
-    if (SkExecutor* executor = doc->executor()) {
+    SkPDFIndirectReference refs[2] = {doc->reserveRef(), SkPDFIndirectReference()};
+    if (needs_smask(img)) {
+        refs[1] = doc->reserveRef();
+    }
+    SkPDFIndirectReference ref = refs[0], sMask = refs[1];
+    if (doc->executor()) {
         SkRef(img);
-        doc->incrementJobCount();
-        executor->add([img, encodingQuality, doc, ref]() {
-            serialize_image(img, encodingQuality, doc, ref);
+        doc->addJob({refs, sMask ? 2u : 1u}, [img, encodingQuality, doc, ref, sMask]() {
+            serialize_image(img, encodingQuality, doc, ref, sMask);
             SkSafeUnref(img);
-            doc->signalJobComplete();
         });
         return ref;
     }
-    serialize_image(img, encodingQuality, doc, ref);
+    serialize_image(img, encodingQuality, doc, ref, sMask);
     return ref;
 }
@@ -8,10 +8,12 @@
 #include "include/docs/SkPDFDocument.h"
 #include "src/pdf/SkPDFDocumentPriv.h"
 
+#include "include/core/SkExecutor.h"
 #include "include/core/SkStream.h"
 #include "include/docs/SkPDFDocument.h"
 #include "include/private/base/SkTo.h"
 #include "src/base/SkUTF.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/pdf/SkPDFDevice.h"
 #include "src/pdf/SkPDFFont.h"
 #include "src/pdf/SkPDFGradientShader.h"
@@ -135,68 +137,100 @@ static void serialize_footer(const SkPDFOffsetMap& offsetMap,
     wStream->writeText("\n%%EOF");
 }
 
+// PDF wants a tree describing all the pages in the document.  We arbitrary
+// choose 8 (kMaxPageTreeNodeSize) as the number of allowed children.  The internal
+// nodes have type "Pages" with an array of children, a parent pointer, and
+// the number of leaves below the node as "Count."  The leaves have type "Page"
+// and need a parent pointer.
+static constexpr size_t kMaxPageTreeNodeSize = 8;
+
+namespace {
+struct PageTreeNode {
+    std::unique_ptr<SkPDFDict> fNode;
+    SkPDFIndirectReference fReservedRef;
+    int fPageObjectDescendantCount;
+
+    static std::vector<PageTreeNode> Layer(std::vector<PageTreeNode> vec, SkPDFDocument* doc) {
+        std::vector<PageTreeNode> result;
+        const size_t n = vec.size();
+        SkASSERT(n >= 1);
+        const size_t result_len = (n - 1) / kMaxPageTreeNodeSize + 1;
+        SkASSERT(result_len >= 1);
+        SkASSERT(n == 1 || result_len < n);
+        result.reserve(result_len);
+        size_t index = 0;
+        for (size_t i = 0; i < result_len; ++i) {
+            if (n != 1 && index + 1 == n) {  // No need to create a new node.
+                result.push_back(std::move(vec[index++]));
+                continue;
+            }
+            SkPDFIndirectReference parent = doc->reserveRef();
+            auto kids_list = SkPDFMakeArray();
+            int descendantCount = 0;
+            for (size_t j = 0; j < kMaxPageTreeNodeSize && index < n; ++j) {
+                PageTreeNode& node = vec[index++];
+                node.fNode->insertRef("Parent", parent);
+                kids_list->appendRef(doc->emit(*node.fNode, node.fReservedRef));
+                descendantCount += node.fPageObjectDescendantCount;
+            }
+            auto next = SkPDFMakeDict("Pages");
+            next->insertInt("Count", descendantCount);
+            next->insertObject("Kids", std::move(kids_list));
+            result.push_back(PageTreeNode{std::move(next), parent, descendantCount});
+        }
+        return result;
+    }
+};
+}  // namespace
+
+// Builds the rest of the tree bottom up from a layer of "Pages" nodes, skipping internal
+// nodes that would have only one child.
+static SkPDFIndirectReference emit_page_tree(SkPDFDocument* doc,
+                                             std::vector<PageTreeNode> currentLayer) {
+    while (currentLayer.size() > 1) {
+        currentLayer = PageTreeNode::Layer(std::move(currentLayer), doc);
+    }
+    SkASSERT(currentLayer.size() == 1);
+    const PageTreeNode& root = currentLayer[0];
+    return doc->emit(*root.fNode, root.fReservedRef);
+}
+
 static SkPDFIndirectReference generate_page_tree(
         SkPDFDocument* doc,
         std::vector<std::unique_ptr<SkPDFDict>> pages,
         const std::vector<SkPDFIndirectReference>& pageRefs) {
-    // PDF wants a tree describing all the pages in the document.  We arbitrary
-    // choose 8 (kNodeSize) as the number of allowed children.  The internal
-    // nodes have type "Pages" with an array of children, a parent pointer, and
-    // the number of leaves below the node as "Count."  The leaves are passed
-    // into the method, have type "Page" and need a parent pointer. This method
-    // builds the tree bottom up, skipping internal nodes that would have only
-    // one child.
     SkASSERT(pages.size() > 0);
-    struct PageTreeNode {
-        std::unique_ptr<SkPDFDict> fNode;
-        SkPDFIndirectReference fReservedRef;
-        int fPageObjectDescendantCount;
-
-        static std::vector<PageTreeNode> Layer(std::vector<PageTreeNode> vec, SkPDFDocument* doc) {
-            std::vector<PageTreeNode> result;
-            static constexpr size_t kMaxNodeSize = 8;
-            const size_t n = vec.size();
-            SkASSERT(n >= 1);
-            const size_t result_len = (n - 1) / kMaxNodeSize + 1;
-            SkASSERT(result_len >= 1);
-            SkASSERT(n == 1 || result_len < n);
-            result.reserve(result_len);
-            size_t index = 0;
-            for (size_t i = 0; i < result_len; ++i) {
-                if (n != 1 && index + 1 == n) {  // No need to create a new node.
-                    result.push_back(std::move(vec[index++]));
-                    continue;
-                }
-                SkPDFIndirectReference parent = doc->reserveRef();
-                auto kids_list = SkPDFMakeArray();
-                int descendantCount = 0;
-                for (size_t j = 0; j < kMaxNodeSize && index < n; ++j) {
-                    PageTreeNode& node = vec[index++];
-                    node.fNode->insertRef("Parent", parent);
-                    kids_list->appendRef(doc->emit(*node.fNode, node.fReservedRef));
-                    descendantCount += node.fPageObjectDescendantCount;
-                }
-                auto next = SkPDFMakeDict("Pages");
-                next->insertInt("Count", descendantCount);
-                next->insertObject("Kids", std::move(kids_list));
-                result.push_back(PageTreeNode{std::move(next), parent, descendantCount});
-            }
-            return result;
-        }
-    };
     std::vector<PageTreeNode> currentLayer;
     currentLayer.reserve(pages.size());
     SkASSERT(pages.size() == pageRefs.size());
     for (size_t i = 0; i < pages.size(); ++i) {
         currentLayer.push_back(PageTreeNode{std::move(pages[i]), pageRefs[i], 1});
     }
-    currentLayer = PageTreeNode::Layer(std::move(currentLayer), doc);
-    while (currentLayer.size() > 1) {
-        currentLayer = PageTreeNode::Layer(std::move(currentLayer), doc);
+    return emit_page_tree(doc, PageTreeNode::Layer(std::move(currentLayer), doc));
+}
+
+// When pages are streamed, each one has already been written with a parent reserved for
+// every kMaxPageTreeNodeSize pages, so only the "Pages" nodes are left.
+static SkPDFIndirectReference generate_streamed_page_tree(
+        SkPDFDocument* doc,
+        const std::vector<SkPDFIndirectReference>& parentRefs,
+        const std::vector<SkPDFIndirectReference>& pageRefs) {
+    SkASSERT(parentRefs.size() == (pageRefs.size() - 1) / kMaxPageTreeNodeSize + 1);
+    std::vector<PageTreeNode> currentLayer;
+    currentLayer.reserve(parentRefs.size());
+    for (size_t i = 0; i < parentRefs.size(); ++i) {
+        auto kids_list = SkPDFMakeArray();
+        size_t begin = i * kMaxPageTreeNodeSize,
+               end = std::min(begin + kMaxPageTreeNodeSize, pageRefs.size());
+        for (size_t j = begin; j < end; ++j) {
+            kids_list->appendRef(pageRefs[j]);
+        }
+        auto node = SkPDFMakeDict("Pages");
+        node->insertInt("Count", SkToInt(end - begin));
+        node->insertObject("Kids", std::move(kids_list));
+        currentLayer.push_back(PageTreeNode{std::move(node), parentRefs[i], SkToInt(end - begin)});
     }
-    SkASSERT(currentLayer.size() == 1);
-    const PageTreeNode& root = currentLayer[0];
-    return doc->emit(*root.fNode, root.fReservedRef);
+    return emit_page_tree(doc, std::move(currentLayer));
 }
 
 template<typename T, typename... Args>
@@ -235,12 +269,79 @@ SkPDFIndirectReference SkPDFDocument::emit(const SkPDFObject& object, SkPDFIndir
 }
 
 SkWStream* SkPDFDocument::beginObject(SkPDFIndirectReference ref) SK_REQUIRES(fMutex) {
-    begin_indirect_object(&fOffsetMap, ref, this->getStream());
-    return this->getStream();
+    // If this object belongs to a job, or something ahead of it is still waiting on a job,
+    // hold on to it until everything ahead of it has been written.
+    if (int* index = fPendingIndexForRef.find(ref.fValue)) {
+        fBufferedIndex = *index;
+    } else if (!fPendingObjects.empty()) {
+        if (!fPendingObjects.back().fDone) {
+            fPendingObjects.emplace_back().fDone = true;
+        }
+        fBufferedIndex = fFirstPendingIndex + SkToInt(fPendingObjects.size()) - 1;
+    } else {
+        begin_indirect_object(&fOffsetMap, ref, this->getStream());
+        return this->getStream();
+    }
+    fBufferedRef = ref;
+    return &fObjectBuffer;
 }
 
 void SkPDFDocument::endObject() SK_REQUIRES(fMutex) {
-    end_indirect_object(this->getStream());
+    if (fBufferedIndex < 0) {
+        end_indirect_object(this->getStream());
+        return;
+    }
+    PendingObjects& pending = fPendingObjects[fBufferedIndex - fFirstPendingIndex];
+    pending.fObjects.emplace_back(fBufferedRef, fObjectBuffer.detachAsData());
+    fBufferedIndex = -1;
+}
+
+void SkPDFDocument::addJob(SkSpan<const SkPDFIndirectReference> refs, std::function<void()> job) {
+    if (!fExecutor) {
+        job();
+        return;
+    }
+    int index;
+    {
+        SkAutoMutexExclusive lock(fMutex);
+        index = fFirstPendingIndex + SkToInt(fPendingObjects.size());
+        fPendingObjects.emplace_back();
+        for (SkPDFIndirectReference ref : refs) {
+            fPendingIndexForRef.set(ref.fValue, index);
+        }
+    }
+    this->incrementJobCount();
+    fExecutor->add([this, index, refs = std::vector<SkPDFIndirectReference>(refs.begin(),
+                                                                              refs.end()),
+                    job = std::move(job)]() {
+        job();
+        {
+            SkAutoMutexExclusive lock(fMutex);
+            for (SkPDFIndirectReference ref : refs) {
+                fPendingIndexForRef.remove(ref.fValue);
+            }
+            this->finishJob(index);
+        }
+        this->signalJobComplete();
+    });
+}
+
+void SkPDFDocument::finishJob(int pendingIndex) SK_REQUIRES(fMutex) {
+    fPendingObjects[pendingIndex - fFirstPendingIndex].fDone = true;
+    this->flushPendingObjects();
+}
+
+void SkPDFDocument::flushPendingObjects() SK_REQUIRES(fMutex) {
+    SkWStream* stream = this->getStream();
+    while (!fPendingObjects.empty() && fPendingObjects.front().fDone) {
+        for (const auto& [ref, data] : fPendingObjects.front().fObjects) {
+            begin_indirect_object(&fOffsetMap, ref, stream);
+            stream->write(data->data(), data->size());
+            end_indirect_object(stream);
+        }
+        fPendingObjects.pop_front();
+        ++fFirstPendingIndex;
+    }
 }
 
 static SkSize operator*(SkISize u, SkScalar s) { return SkSize{u.width() * s, u.height() * s}; }
@@ -248,7 +349,7 @@ static SkSize operator*(SkSize u, SkScalar s) { return SkSize{u.width() * s, u.h
 
 SkCanvas* SkPDFDocument::onBeginPage(SkScalar width, SkScalar height) {
     SkASSERT(fCanvas.imageInfo().dimensions().isZero());
-    if (fPages.empty()) {
+    if (fPageRefs.empty()) {
         // if this is the first page if the document.
         {
             SkAutoMutexExclusive autoMutexAcquire(fMutex);
@@ -376,7 +477,16 @@ void SkPDFDocument::onEndPage() {
     // The StructParents unique identifier for each page is just its
     // 0-based page index.
     page->insertInt("StructParents", SkToInt(this->currentPageIndex()));
-    fPages.emplace_back(std::move(page));
+    if (fMetadata.fStreamPages) {
+        if (this->currentPageIndex() % kMaxPageTreeNodeSize == 0) {
+            fPageTreeParentRefs.push_back(this->reserveRef());
+        }
+        page->insertRef("Parent", fPageTreeParentRefs.back());
+        this->emit(*page, fPageRefs.back());
+    } else {
+        fPages.emplace_back(std::move(page));
+    }
+    fFinishedPageCount++;
 }
 
 void SkPDFDocument::onAbort() {
@@ -535,13 +645,11 @@ int SkPDFDocument::createStructParentKeyForNodeId(int nodeId) {
     return fTagTree.createStructParentKeyForNodeId(nodeId, SkToUInt(this->currentPageIndex()));
 }
 
-static std::vector<const SkPDFFont*> get_fonts(const SkPDFDocument& canon) {
-    std::vector<const SkPDFFont*> fonts;
-    fonts.reserve(canon.fFontMap.count());
+static std::vector<SkPDFFont*> get_fonts(SkPDFDocument* canon) {
+    std::vector<SkPDFFont*> fonts;
+    fonts.reserve(canon->fFontMap.count());
     // Sort so the output PDF is reproducible.
-    for (const auto& [unused, font] : canon.fFontMap) {
-        fonts.push_back(&font);
-    }
+    canon->fFontMap.foreach([&fonts](uint64_t, SkPDFFont* font) { fonts.push_back(font); });
     std::sort(fonts.begin(), fonts.end(), [](const SkPDFFont* u, const SkPDFFont* v) {
         return u->indirectReference().fValue < v->indirectReference().fValue;
     });
@@ -567,7 +675,7 @@ SkString SkPDFDocument::nextFontSubsetTag() {
 
 void SkPDFDocument::onClose(SkWStream* stream) {
     SkASSERT(fCanvas.imageInfo().dimensions().isZero());
-    if (fPages.empty()) {
+    if (fPageRefs.empty()) {
         this->waitForJobs();
         return;
     }
@@ -580,7 +688,10 @@ void SkPDFDocument::onClose(SkWStream* stream) {
         docCatalog->insertObject("OutputIntents", make_srgb_output_intents(this));
     }
 
-    docCatalog->insertRef("Pages", generate_page_tree(this, std::move(fPages), fPageRefs));
+    docCatalog->insertRef("Pages",
+                          fMetadata.fStreamPages
+                          ? generate_streamed_page_tree(this, fPageTreeParentRefs, fPageRefs)
+                          : generate_page_tree(this, std::move(fPages), fPageRefs));
 
     if (!fNamedDestinations.empty()) {
         docCatalog->insertRef("Dests", append_destinations(this, fNamedDestinations));
@@ -598,7 +709,22 @@ void SkPDFDocument::onClose(SkWStream* stream) {
 
     auto docCatalogRef = this->emit(*docCatalog);
 
-    for (const SkPDFFont* f : get_fonts(*this)) {
+    std::vector<SkPDFFont*> fonts = get_fonts(this);
+    if (fExecutor) {
+        // Subsetting fonts and building their ToUnicode CMaps only reads from the document's
+        // caches once they're warm, so do that for all fonts at once.
+        for (const SkPDFFont* f : fonts) {
+            if (SkPDFFont::GetMetrics(f->typeface(), this) && f->multiByteGlyphs()) {
+                SkPDFFont::GetUnicodeMap(f->typeface(), this);
+            }
+        }
+        SkTaskGroup group(*fExecutor);
+        group.batch(SkToInt(fonts.size()), [&fonts, this](int i) {
+            fonts[i]->prepareSubset(this);
+        });
+        group.wait();
+    }
+    for (const SkPDFFont* f : fonts) {
         f->emitSubset(this);
     }
 
@@ -8,6 +8,8 @@
 #define SkPDFDocumentPriv_DEFINED
 
 #include "include/core/SkCanvas.h"
+#include "include/core/SkData.h"
+#include "include/core/SkSpan.h"
 #include "include/core/SkStream.h"
 #include "include/docs/SkPDFDocument.h"
 #include "include/private/base/SkMutex.h"
@@ -16,6 +18,8 @@
 #include "src/pdf/SkPDFTag.h"
 
 #include <atomic>
+#include <deque>
+#include <functional>
 #include <vector>
 #include <memory>
 
@@ -133,9 +137,15 @@ public:
     SkString nextFontSubsetTag();
 
     SkExecutor* executor() const { return fExecutor; }
-    void incrementJobCount();
-    void signalJobComplete();
-    size_t currentPageIndex() { return fPages.size(); }
+
+    /** Runs job on the executor, or right away if there is none.  The objects the job emits are
+        written to the stream where they would have been had it run right away, so the document
+        comes out the same no matter how many threads there are or when the jobs finish.  refs
+        must list every object the job emits, and the job must not reserve any refs itself.
+     */
+    void addJob(SkSpan<const SkPDFIndirectReference> refs, std::function<void()> job);
+
+    size_t currentPageIndex() { return fFinishedPageCount; }
     size_t pageCount() { return fPageRefs.size(); }
 
     const SkMatrix& currentPageTransform() const;
@@ -163,6 +173,9 @@ private:
     SkCanvas fCanvas;
     std::vector<std::unique_ptr<SkPDFDict>> fPages;
     std::vector<SkPDFIndirectReference> fPageRefs;
+    size_t fFinishedPageCount = 0;
+    // With fMetadata.fStreamPages, the "Pages" node reserved for each group of pages.
+    std::vector<SkPDFIndirectReference> fPageTreeParentRefs;
 
     sk_sp<SkPDFDevice> fPageDevice;
     std::atomic<int> fNextObjectNumber = {1};
@@ -182,6 +195,23 @@ private:
     SkMutex fMutex;
     SkSemaphore fSemaphore;
 
+    // Objects waiting on jobs that were added before them, in the order they'll be written.
+    // Each entry holds one job's objects, or objects emitted directly after that job.
+    struct PendingObjects {
+        std::vector<std::pair<SkPDFIndirectReference, sk_sp<SkData>>> fObjects;
+        bool fDone = false;
+    };
+    std::deque<PendingObjects> fPendingObjects;
+    int fFirstPendingIndex = 0;  // The index of fPendingObjects.front() among all entries.
+    SkTHashMap<int, int> fPendingIndexForRef;
+    SkDynamicMemoryWStream fObjectBuffer;
+    SkPDFIndirectReference fBufferedRef;
+    int fBufferedIndex = -1;
+
+    void incrementJobCount();
+    void signalJobComplete();
+    void finishJob(int pendingIndex);
+    void flushPendingObjects();
     void waitForJobs();
     SkWStream* beginObject(SkPDFIndirectReference);
     void endObject();
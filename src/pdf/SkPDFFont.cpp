@@ -296,7 +296,31 @@ static sk_sp<SkData> stream_to_data(std::unique_ptr<SkStreamAsset> stream) {
     return SkData::MakeFromStream(stream.get(), size);
 }
 
-static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc) {
+static sk_sp<SkData> subset_font_data(const SkPDFFont& font,
+                                      const SkAdvancedTypefaceMetrics& metrics,
+                                      std::unique_ptr<SkStreamAsset> fontAsset,
+                                      int ttcIndex,
+                                      SkPDFDocument* doc) {
+    SkASSERT(font.firstGlyphID() == 1);
+    return SkPDFSubsetFont(stream_to_data(std::move(fontAsset)), font.glyphUsage(),
+                           doc->metadata().fSubsetter, metrics.fFontName.c_str(), ttcIndex);
+}
+
+static sk_sp<SkData> to_unicode_cmap_data(const SkPDFFont& font, SkPDFDocument* doc) {
+    const std::vector<SkUnichar>& glyphToUnicode =
+        SkPDFFont::GetUnicodeMap(font.typeface(), doc);
+    SkASSERT(SkToSizeT(font.typeface()->countGlyphs()) == glyphToUnicode.size());
+    return stream_to_data(SkPDFMakeToUnicodeCmap(glyphToUnicode.data(),
+                                                 &font.glyphUsage(),
+                                                 font.multiByteGlyphs(),
+                                                 font.firstGlyphID(),
+                                                 font.lastGlyphID()));
+}
+
+static void emit_subset_type0(const SkPDFFont& font,
+                              SkPDFDocument* doc,
+                              sk_sp<SkData> subsetFontData,
+                              sk_sp<SkData> toUnicodeCmap) {
     const SkAdvancedTypefaceMetrics* metricsPtr =
         SkPDFFont::GetMetrics(font.typeface(), doc);
     SkASSERT(metricsPtr);
@@ -323,11 +347,10 @@ static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc) {
             case SkAdvancedTypefaceMetrics::kTrueType_Font: {
                 if (!SkToBool(metrics.fFlags &
                               SkAdvancedTypefaceMetrics::kNotSubsettable_FontFlag)) {
-                    SkASSERT(font.firstGlyphID() == 1);
-                    sk_sp<SkData> subsetFontData = SkPDFSubsetFont(
-                            stream_to_data(std::move(fontAsset)), font.glyphUsage(),
-                            doc->metadata().fSubsetter,
-                            metrics.fFontName.c_str(), ttcIndex);
+                    if (!subsetFontData) {
+                        subsetFontData = subset_font_data(font, metrics, std::move(fontAsset),
+                                                          ttcIndex, doc);
+                    }
                     if (subsetFontData) {
                         std::unique_ptr<SkPDFDict> tmp = SkPDFMakeDict();
                         tmp->insertInt("Length1", SkToInt(subsetFontData->size()));
@@ -406,16 +429,12 @@ static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc) {
     descendantFonts->appendRef(doc->emit(*newCIDFont));
     fontDict.insertObject("DescendantFonts", std::move(descendantFonts));
 
-    const std::vector<SkUnichar>& glyphToUnicode =
-        SkPDFFont::GetUnicodeMap(font.typeface(), doc);
-    SkASSERT(SkToSizeT(font.typeface()->countGlyphs()) == glyphToUnicode.size());
-    std::unique_ptr<SkStreamAsset> toUnicode =
-            SkPDFMakeToUnicodeCmap(glyphToUnicode.data(),
-                                   &font.glyphUsage(),
-                                   font.multiByteGlyphs(),
-                                   font.firstGlyphID(),
-                                   font.lastGlyphID());
-    fontDict.insertRef("ToUnicode", SkPDFStreamOut(nullptr, std::move(toUnicode), doc));
+    if (!toUnicodeCmap) {
+        toUnicodeCmap = to_unicode_cmap_data(font, doc);
+    }
+    fontDict.insertRef("ToUnicode",
+                       SkPDFStreamOut(nullptr, SkMemoryStream::Make(std::move(toUnicodeCmap)),
+                                      doc));
 
     doc->emit(fontDict, font.indirectReference());
 }
@@ -701,11 +720,32 @@ static void emit_subset_type3(const SkPDFFont& pdfFont, SkPDFDocument* doc) {
     doc->emit(font, pdfFont.indirectReference());
 }
 
+void SkPDFFont::prepareSubset(SkPDFDocument* doc) {
+    if (fFontType != SkAdvancedTypefaceMetrics::kType1CID_Font &&
+        fFontType != SkAdvancedTypefaceMetrics::kTrueType_Font) {
+        return;
+    }
+    const SkAdvancedTypefaceMetrics* metrics = SkPDFFont::GetMetrics(fTypeface.get(), doc);
+    if (!metrics) {
+        return;
+    }
+    if (fFontType == SkAdvancedTypefaceMetrics::kTrueType_Font &&
+        !SkToBool(metrics->fFlags & SkAdvancedTypefaceMetrics::kNotSubsettable_FontFlag)) {
+        int ttcIndex;
+        std::unique_ptr<SkStreamAsset> fontAsset = fTypeface->openStream(&ttcIndex);
+        if (fontAsset && fontAsset->getLength() > 0) {
+            fSubsetFontData = subset_font_data(*this, *metrics, std::move(fontAsset), ttcIndex,
+                                               doc);
+        }
+    }
+    fToUnicodeCmap = to_unicode_cmap_data(*this, doc);
+}
+
 void SkPDFFont::emitSubset(SkPDFDocument* doc) const {
     switch (fFontType) {
         case SkAdvancedTypefaceMetrics::kType1CID_Font:
         case SkAdvancedTypefaceMetrics::kTrueType_Font:
-            return emit_subset_type0(*this, doc);
+            return emit_subset_type0(*this, doc, fSubsetFontData, fToUnicodeCmap);
 #ifndef SK_PDF_DO_NOT_SUPPORT_TYPE_1_FONTS
         case SkAdvancedTypefaceMetrics::kType1_Font:
             return SkPDFEmitType1Font(*this, doc);
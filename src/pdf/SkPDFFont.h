@@ -7,6 +7,7 @@
 #ifndef SkPDFFont_DEFINED
 #define SkPDFFont_DEFINED
 
+#include "include/core/SkData.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkTypeface.h"
 #include "include/core/SkTypes.h"
@@ -106,6 +107,13 @@ public:
                                              uint16_t emSize,
                                              int16_t defaultWidth);
 
+    /** Subsets the font program and builds the ToUnicode CMap of a Type0 font ahead of
+     *  emitSubset(), which then only has to write them out.  Different fonts may be prepared
+     *  on different threads, once GetMetrics() and GetUnicodeMap() have been called for
+     *  their typefaces.
+     */
+    void prepareSubset(SkPDFDocument*);
+
     void emitSubset(SkPDFDocument*) const;
 
     /**
@@ -124,6 +132,9 @@ private:
     SkPDFGlyphUse fGlyphUsage;
     SkPDFIndirectReference fIndirectReference;
     SkAdvancedTypefaceMetrics::FontType fFontType;
+    // Set by prepareSubset(); nullptr if not prepared, or if subsetting failed.
+    sk_sp<SkData> fSubsetFontData;
+    sk_sp<SkData> fToUnicodeCmap;
 
     SkPDFFont(sk_sp<SkTypeface>,
               SkGlyphID firstGlyphID,
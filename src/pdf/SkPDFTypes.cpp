@@ -8,7 +8,6 @@
 #include "src/pdf/SkPDFTypes.h"
 
 #include "include/core/SkData.h"
-#include "include/core/SkExecutor.h"
 #include "include/core/SkStream.h"
 #include "include/private/base/SkTo.h"
 #include "src/core/SkStreamPriv.h"
@@ -583,17 +582,15 @@ SkPDFIndirectReference SkPDFStreamOut(std::unique_ptr<SkPDFDict> dict,
                                       SkPDFDocument* doc,
                                       SkPDFSteamCompressionEnabled compress) {
     SkPDFIndirectReference ref = doc->reserveRef();
-    if (SkExecutor* executor = doc->executor()) {
+    if (doc->executor()) {
         SkPDFDict* dictPtr = dict.release();
         SkStreamAsset* contentPtr = content.release();
         // Pass ownership of both pointers into a std::function, which should
         // only be executed once.
-        doc->incrementJobCount();
-        executor->add([dictPtr, contentPtr, compress, doc, ref]() {
+        doc->addJob({&ref, 1}, [dictPtr, contentPtr, compress, doc, ref]() {
             serialize_stream(dictPtr, contentPtr, compress, doc, ref);
             delete dictPtr;
             delete contentPtr;
-            doc->signalJobComplete();
         });
         return ref;
     }
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/utils/SkAnimCodecFrameCache.h"
+
+#include "include/codec/SkCodecAnimation.h"
+#include "include/core/SkAlphaType.h"
+#include "include/core/SkData.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkPixmap.h"
+#include "include/core/SkTypes.h"
+
+#include <algorithm>
+#include <utility>
+
+SkAnimCodecFrameCache::SkAnimCodecFrameCache(SkCodec* codec, size_t budgetBytes)
+        : fCodec(codec)
+        , fImageInfo(codec->getInfo())
+        , fFrameInfos(codec->getFrameInfo()) {
+    // Every frame is decoded to the same info, so that each can be drawn on top of any other.
+    if (fImageInfo.isOpaque()) {
+        for (const SkCodec::FrameInfo& info : fFrameInfos) {
+            if (info.fAlphaType != kOpaque_SkAlphaType) {
+                fImageInfo = fImageInfo.makeAlphaType(kPremul_SkAlphaType);
+                break;
+            }
+        }
+    }
+
+    // Spread as many keyframes as fit in the budget evenly through the animation. Each is the
+    // first frame in its interval that others can be drawn on, unless every frame fits.
+    const int frameCount = std::max(this->frameCount(), 1);
+    const size_t frameBytes = std::max<size_t>(fImageInfo.computeMinByteSize(), 1);
+    const int keyframes = SkToInt(std::clamp<size_t>(budgetBytes / frameBytes, 1, frameCount));
+    const int interval = (frameCount + keyframes - 1) / keyframes;
+    fIsKeyframe.resize(fFrameInfos.size(), interval == 1);
+    for (int start = 0; interval > 1 && start < this->frameCount(); start += interval) {
+        const int end = std::min(start + interval, this->frameCount());
+        for (int i = start; i < end; ++i) {
+            if (this->canDrawOn(i)) {
+                fIsKeyframe[i] = true;
+                break;
+            }
+        }
+    }
+    fKeyframes.resize(fFrameInfos.size());
+}
+
+SkAnimCodecFrameCache::~SkAnimCodecFrameCache() {}
+
+sk_sp<SkImage> SkAnimCodecFrameCache::snapshot(int index) const {
+    return index == fLastIndex ? fLastFrame : fKeyframes[index];
+}
+
+int SkAnimCodecFrameCache::findSnapshot(int first, int end) const {
+    for (int i = end - 1; i >= first; --i) {
+        if (this->canDrawOn(i) && this->snapshot(i)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool SkAnimCodecFrameCache::canDrawOn(int index) const {
+    // The codec cannot draw on top of a frame that is disposed of by restoring the one before.
+    return fFrameInfos[index].fDisposalMethod !=
+           SkCodecAnimation::DisposalMethod::kRestorePrevious;
+}
+
+int SkAnimCodecFrameCache::findKeyframe(int first, int end) const {
+    for (int i = end - 1; i >= first; --i) {
+        if (fIsKeyframe[i] && this->canDrawOn(i)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+sk_sp<SkImage> SkAnimCodecFrameCache::getFrame(int index) {
+    SkASSERT(0 <= index && index < this->frameCount());
+
+    if (sk_sp<SkImage> image = this->snapshot(index)) {
+        return image;
+    }
+
+    // Walk back through the frames that index depends on, until reaching one that is independent
+    // or can be drawn on top of a snapshot.
+    std::vector<int> chain;
+    int start = SkCodec::kNoFrame;
+    for (int frame = index;;) {
+        chain.push_back(frame);
+        const int requiredFrame = fFrameInfos[frame].fRequiredFrame;
+        if (requiredFrame == SkCodec::kNoFrame) {
+            break;
+        }
+        start = this->findSnapshot(requiredFrame, frame);
+        if (start >= 0) {
+            break;
+        }
+        // Decode through a keyframe on the way, if there is one, so the next seek can start there.
+        frame = std::max(requiredFrame, this->findKeyframe(requiredFrame, frame));
+    }
+
+    const size_t rowBytes = fImageInfo.minRowBytes();
+    sk_sp<SkData> data = SkData::MakeUninitialized(fImageInfo.computeByteSize(rowBytes));
+    const SkPixmap pixmap(fImageInfo, data->writable_data(), rowBytes);
+    if (start >= 0 && !this->snapshot(start)->readPixels(nullptr, pixmap, 0, 0)) {
+        return nullptr;
+    }
+
+    // Then decode forward, each frame on top of the last.
+    int priorFrame = start;
+    for (auto frame = chain.rbegin(); frame != chain.rend(); ++frame) {
+        SkCodec::Options options;
+        options.fFrameIndex = *frame;
+        options.fPriorFrame = priorFrame;
+        fDecodeCount++;
+        if (SkCodec::kSuccess != fCodec->getPixels(pixmap, &options)) {
+            return nullptr;
+        }
+        priorFrame = *frame;
+
+        if (*frame != index && fIsKeyframe[*frame]) {
+            fKeyframes[*frame] = SkImage::MakeRasterCopy(pixmap);
+        }
+    }
+
+    sk_sp<SkImage> image = SkImage::MakeRasterData(fImageInfo, std::move(data), rowBytes);
+    if (fIsKeyframe[index]) {
+        fKeyframes[index] = image;
+    }
+    fLastFrame = image;
+    fLastIndex = index;
+    return image;
+}
+
+size_t SkAnimCodecFrameCache::bytesUsed() const {
+    size_t bytes = 0;
+    for (int i = 0; i < this->frameCount(); ++i) {
+        if (sk_sp<SkImage> image = this->snapshot(i)) {
+            bytes += image->imageInfo().computeMinByteSize();
+        }
+    }
+    return bytes;
+}
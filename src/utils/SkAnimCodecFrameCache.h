@@ -0,0 +1,76 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkAnimCodecFrameCache_DEFINED
+#define SkAnimCodecFrameCache_DEFINED
+
+#include "include/codec/SkCodec.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkRefCnt.h"
+#include "include/private/base/SkTo.h"
+
+#include <cstddef>
+#include <vector>
+
+class SkImage;
+
+/**
+ *  Decodes the frames of an animated SkCodec on demand, for random access.
+ *
+ *  Most frames of an animation are drawn on top of an earlier one, so decoding frame N from
+ *  scratch means decoding the whole chain of frames it depends on. Instead, this keeps full-canvas
+ *  snapshots of evenly spaced keyframes, as many as fit in a byte budget, plus the most recently
+ *  decoded frame. Any frame is then decoded forward from the nearest snapshot it can be drawn
+ *  on, so seeking costs at most about frameCount / (budgetBytes / frameBytes) frame decodes, and
+ *  playing forward costs one.
+ *
+ *  Frames are decoded without applying the codec's origin.
+ */
+class SkAnimCodecFrameCache {
+public:
+    // codec must outlive the cache, and is only used by it.
+    SkAnimCodecFrameCache(SkCodec* codec, size_t budgetBytes);
+    ~SkAnimCodecFrameCache();
+
+    int frameCount() const { return SkToInt(fFrameInfos.size()); }
+    const SkCodec::FrameInfo& frameInfo(int index) const { return fFrameInfos[index]; }
+
+    // The info frames are decoded to. It is premul if any frame is not opaque.
+    const SkImageInfo& imageInfo() const { return fImageInfo; }
+
+    // Returns frame index, or null if it (or a frame it depends on) fails to decode.
+    sk_sp<SkImage> getFrame(int index);
+
+    // Bytes held by keyframe snapshots and the most recent frame.
+    size_t bytesUsed() const;
+
+    // Frames decoded so far, including those only decoded on the way to another one.
+    int decodeCount() const { return fDecodeCount; }
+
+private:
+    // Whether another frame can be decoded on top of frame index.
+    bool canDrawOn(int index) const;
+
+    // These return the latest frame in [first, end) that is a keyframe, or that can be drawn on
+    // and has a snapshot, respectively, or -1.
+    int findKeyframe(int first, int end) const;
+    int findSnapshot(int first, int end) const;
+
+    sk_sp<SkImage> snapshot(int index) const;
+
+    SkCodec*                        fCodec;
+    SkImageInfo                     fImageInfo;
+    std::vector<SkCodec::FrameInfo> fFrameInfos;
+    std::vector<bool>               fIsKeyframe;
+
+    std::vector<sk_sp<SkImage>>     fKeyframes;  // Indexed by frame; null unless decoded.
+    sk_sp<SkImage>                  fLastFrame;
+    int                             fLastIndex = -1;
+    int                             fDecodeCount = 0;
+};
+
+#endif
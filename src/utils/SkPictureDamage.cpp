@@ -0,0 +1,227 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/utils/SkPictureDamage.h"
+
+#include "include/core/SkCanvas.h"
+#include "include/core/SkColor.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkRect.h"
+#include "src/core/SkBigPicture.h"
+#include "src/core/SkPicturePriv.h"
+#include "src/core/SkRecord.h"
+#include "src/core/SkRecords.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+using namespace SkRecords;
+
+namespace {
+
+// Field comparisons. Ref-counted objects are compared by identity.
+template <typename T>
+bool same(const sk_sp<T>& a, const sk_sp<T>& b) { return a.get() == b.get(); }
+
+template <typename T>
+bool same(const Optional<T>& a, const Optional<T>& b) {
+    const T* pa = a;
+    const T* pb = b;
+    return pa == pb || (pa && pb && *pa == *pb);
+}
+
+template <typename T>
+bool same(const PODArray<T>& a, const PODArray<T>& b, size_t count) {
+    const T* pa = a;
+    const T* pb = b;
+    return pa == pb || (pa && pb && 0 == memcmp(pa, pb, count * sizeof(T)));
+}
+
+bool same(const ClipOpAndAA& a, const ClipOpAndAA& b) {
+    return a.op() == b.op() && a.aa() == b.aa();
+}
+
+// Returns true if two ops of the same type are known to draw the same thing. Ops that we don't
+// know how to compare are never the same, which only costs some damage.
+template <typename T>
+bool same(const T&, const T&) { return false; }
+
+#define SAME(T, expr) bool same(const T& a, const T& b) { return expr; }
+
+SAME(NoOp,       true)
+SAME(Flush,      true)
+SAME(Save,       true)
+SAME(ResetClip,  true)
+SAME(Restore,    (const SkMatrix&)a.matrix == b.matrix)
+SAME(SaveLayer,  same(a.bounds, b.bounds) && same(a.paint, b.paint) &&
+                 same(a.backdrop, b.backdrop) && a.saveLayerFlags == b.saveLayerFlags &&
+                 a.backdropScale == b.backdropScale)
+SAME(SaveBehind, same(a.subset, b.subset))
+SAME(SetMatrix,  (const SkMatrix&)a.matrix == b.matrix)
+SAME(SetM44,     a.matrix == b.matrix)
+SAME(Concat,     (const SkMatrix&)a.matrix == b.matrix)
+SAME(Concat44,   a.matrix == b.matrix)
+SAME(Translate,  a.dx == b.dx && a.dy == b.dy)
+SAME(Scale,      a.sx == b.sx && a.sy == b.sy)
+
+SAME(ClipPath,   (const SkPath&)a.path == b.path && same(a.opAA, b.opAA))
+SAME(ClipRRect,  a.rrect == b.rrect && same(a.opAA, b.opAA))
+SAME(ClipRect,   a.rect == b.rect && same(a.opAA, b.opAA))
+SAME(ClipRegion, a.region == b.region && a.op == b.op)
+SAME(ClipShader, same(a.shader, b.shader) && a.op == b.op)
+
+SAME(DrawArc,       a.paint == b.paint && a.oval == b.oval && a.startAngle == b.startAngle &&
+                    a.sweepAngle == b.sweepAngle && a.useCenter == b.useCenter)
+SAME(DrawDRRect,    a.paint == b.paint && a.outer == b.outer && a.inner == b.inner)
+SAME(DrawImage,     same(a.paint, b.paint) && same(a.image, b.image) && a.left == b.left &&
+                    a.top == b.top && a.sampling == b.sampling)
+SAME(DrawImageRect, same(a.paint, b.paint) && same(a.image, b.image) && a.src == b.src &&
+                    a.dst == b.dst && a.sampling == b.sampling && a.constraint == b.constraint)
+SAME(DrawOval,      a.paint == b.paint && a.oval == b.oval)
+SAME(DrawPaint,     a.paint == b.paint)
+SAME(DrawBehind,    a.paint == b.paint)
+SAME(DrawPath,      a.paint == b.paint && (const SkPath&)a.path == b.path)
+SAME(DrawPicture,   same(a.paint, b.paint) && same(a.picture, b.picture) &&
+                    (const SkMatrix&)a.matrix == b.matrix)
+SAME(DrawPoints,    a.paint == b.paint && a.mode == b.mode && a.count == b.count &&
+                    same(a.pts, b.pts, a.count))
+SAME(DrawRRect,     a.paint == b.paint && a.rrect == b.rrect)
+SAME(DrawRect,      a.paint == b.paint && a.rect == b.rect)
+SAME(DrawRegion,    a.paint == b.paint && a.region == b.region)
+SAME(DrawTextBlob,  a.paint == b.paint && same(a.blob, b.blob) && a.x == b.x && a.y == b.y)
+SAME(DrawVertices,  a.paint == b.paint && same(a.vertices, b.vertices) && a.bmode == b.bmode)
+SAME(DrawEdgeAAQuad, a.rect == b.rect && same(a.clip, b.clip, a.clip ? 4 : 0) &&
+                     a.aa == b.aa && a.color == b.color && a.mode == b.mode)
+SAME(DrawAnnotation, a.rect == b.rect && a.key == b.key && same(a.value, b.value))
+
+#undef SAME
+
+// The ops of one picture, with their bounds in picture space.
+struct Ops {
+    explicit Ops(const SkPicture* picture) {
+        if (!picture) {
+            return;
+        }
+        if (const SkBigPicture* big = SkPicturePriv::AsSkBigPicture(sk_ref_sp(picture))) {
+            fRecord = big->record();
+            fBounds = big->opBounds();
+            fCount = fRecord->count();
+        } else if (picture->approximateOpCount() > 0) {
+            // We can't look inside other pictures, so they damage everything they might draw.
+            fWhole = picture->cullRect();
+        }
+    }
+
+    const SkRecord* fRecord = nullptr;
+    const SkRect*   fBounds = nullptr;
+    int             fCount = 0;
+    SkRect          fWhole = SkRect::MakeEmpty();
+};
+
+bool same_op(const Ops& prev, int i, const Ops& next, int j) {
+    if (prev.fBounds[i] != next.fBounds[j]) {
+        return false;
+    }
+    return prev.fRecord->visit(i, [&](const auto& a) {
+        return next.fRecord->visit(j, [&](const auto& b) {
+            if constexpr (std::is_same_v<decltype(a), decltype(b)>) {
+                return same(a, b);
+            } else {
+                return false;
+            }
+        });
+    });
+}
+
+// Unions the bounds of changed ops. Past kMaxRects the damage is just their bounding box, so
+// that adding is not quadratic, and so that Redraw() doesn't replay the same ops for many rects.
+class Damage {
+public:
+    explicit Damage(const SkMatrix& matrix) : fMatrix(matrix) {}
+
+    void add(const SkRect& bounds) {
+        if (bounds.isEmpty()) {
+            return;
+        }
+        // Outset for anti-aliasing and filtering that reaches just outside the bounds.
+        SkIRect rect = fMatrix.mapRect(bounds).roundOut().makeOutset(1, 1);
+        fBounds.join(rect);
+        if (++fCount <= kMaxRects) {
+            fRegion.op(rect, SkRegion::kUnion_Op);
+        }
+    }
+
+    SkRegion region() const { return fCount <= kMaxRects ? fRegion : SkRegion(fBounds); }
+
+private:
+    static constexpr int kMaxRects = 16;
+
+    const SkMatrix& fMatrix;
+    SkRegion        fRegion;
+    SkIRect         fBounds = SkIRect::MakeEmpty();
+    int             fCount = 0;
+};
+
+}  // namespace
+
+SkRegion SkPictureDamage::Compute(const SkPicture* prev, const SkPicture* next,
+                                  const SkMatrix& matrix) {
+    if (prev == next) {
+        return SkRegion();
+    }
+
+    Damage damage(matrix);
+    const Ops prevOps(prev), nextOps(next);
+    damage.add(prevOps.fWhole);
+    damage.add(nextOps.fWhole);
+
+    // Skip the ops that are the same at the start and at the end; everything in between is
+    // damaged. Changing a matrix or clip changes the bounds of the ops it affects, so those
+    // are not the same either.
+    int prefix = 0;
+    int count = std::min(prevOps.fCount, nextOps.fCount);
+    while (prefix < count && same_op(prevOps, prefix, nextOps, prefix)) {
+        prefix++;
+    }
+    int prevEnd = prevOps.fCount,
+        nextEnd = nextOps.fCount;
+    while (prevEnd > prefix && nextEnd > prefix &&
+           same_op(prevOps, prevEnd - 1, nextOps, nextEnd - 1)) {
+        prevEnd--;
+        nextEnd--;
+    }
+
+    // Ops in the middle that are the same (e.g. unchanged ops between two changes) still have to
+    // be redrawn if they overlap the damage, but they don't add any.
+    for (int i = prefix, j = prefix; i < prevEnd || j < nextEnd; i++, j++) {
+        if (i < prevEnd && j < nextEnd && same_op(prevOps, i, nextOps, j)) {
+            continue;
+        }
+        if (i < prevEnd) {
+            damage.add(prevOps.fBounds[i]);
+        }
+        if (j < nextEnd) {
+            damage.add(nextOps.fBounds[j]);
+        }
+    }
+    return damage.region();
+}
+
+void SkPictureDamage::Redraw(SkCanvas* canvas, const SkPicture* picture, const SkRegion& damage,
+                             const SkMatrix& matrix) {
+    // Replaying each rect separately lets the picture's BBH skip the ops between them.
+    for (SkRegion::Iterator iter(damage); !iter.done(); iter.next()) {
+        SkAutoCanvasRestore acr(canvas, true);
+        canvas->clipRegion(SkRegion(iter.rect()));
+        canvas->clear(SK_ColorTRANSPARENT);
+        if (picture) {
+            canvas->concat(matrix);
+            picture->playback(canvas);
+        }
+    }
+}
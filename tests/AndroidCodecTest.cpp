@@ -7,24 +7,37 @@
 
 #include "include/codec/SkAndroidCodec.h"
 #include "include/codec/SkCodec.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkColor.h"
 #include "include/core/SkColorSpace.h"
 #include "include/core/SkData.h"
 #include "include/core/SkEncodedImageFormat.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImageInfo.h"
+#include "include/core/SkPixmap.h"
+#include "include/core/SkRect.h"
 #include "include/core/SkRefCnt.h"
+#include "include/core/SkSamplingOptions.h"
 #include "include/core/SkSize.h"
+#include "include/core/SkStream.h"
 #include "include/core/SkString.h"
 #include "include/core/SkTypes.h"
+#include "include/encode/SkPngEncoder.h"
 #include "include/private/SkGainmapInfo.h"  // IWYU pragma: keep
 #include "modules/skcms/skcms.h"
 #include "tests/Test.h"
 #include "tools/Resources.h"
+#include "tools/ToolUtils.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <initializer_list>
 #include <memory>
+#include <thread>
 #include <utility>
+#include <vector>
 
 static SkISize times(const SkISize& size, float factor) {
     return { (int) (size.width() * factor), (int) (size.height() * factor) };
@@ -272,3 +285,215 @@ DEF_TEST(AndroidCodec_PQ, r) {
     static constexpr skcms_Matrix3x3 kExpected = SkNamedGamut::kRec2020;
     REPORTER_ASSERT(r, 0 == memcmp(&matrix, &kExpected, sizeof(skcms_Matrix3x3)));
 }
+
+DEF_TEST(AndroidCodec_DecodeBatch, r) {
+    if (GetResourcePath().isEmpty()) {
+        return;
+    }
+
+    const char* paths[] = {
+        "images/mandrill_128.png",
+        "images/color_wheel.jpg",
+        "images/yellow_rose.png",
+        "images/randPixels.bmp",
+    };
+
+    std::vector<SkBitmap> expected, actual;
+    std::vector<SkAndroidCodec::BatchDecodeRequest> requests;
+    for (int i = 0; i < 16; i++) {
+        const char* path = paths[i % std::size(paths)];
+        auto data = GetResourceAsData(path);
+        if (!data) {
+            ERRORF(r, "Missing file %s", path);
+            return;
+        }
+        auto codec = SkAndroidCodec::MakeFromData(data);
+        if (!codec) {
+            ERRORF(r, "Failed to create codec from %s", path);
+            return;
+        }
+        const int sampleSize = 1 + (i & 3);
+        SkImageInfo info = codec->getInfo().makeDimensions(codec->getSampledDimensions(sampleSize))
+                                           .makeColorType(kN32_SkColorType);
+
+        SkAndroidCodec::AndroidOptions options;
+        options.fSampleSize = sampleSize;
+        expected.emplace_back().allocPixels(info);
+        REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                           codec->getAndroidPixels(info, expected.back().getPixels(),
+                                                   expected.back().rowBytes(), &options));
+
+        actual.emplace_back().allocPixels(info);
+        SkAndroidCodec::BatchDecodeRequest req;
+        req.fData       = std::move(data);
+        req.fDst        = actual.back().pixmap();
+        req.fSampleSize = sampleSize;
+        requests.push_back(req);
+    }
+
+    // Undecodable data should fail on its own without affecting the rest of the batch.
+    SkBitmap unused;
+    unused.allocN32Pixels(1, 1);
+    SkAndroidCodec::BatchDecodeRequest garbage;
+    garbage.fData = SkData::MakeWithCString("not an image");
+    garbage.fDst  = unused.pixmap();
+    requests.push_back(garbage);
+
+    auto executor = SkExecutor::MakeFIFOThreadPool(2);
+    SkAndroidCodec::DecodeBatch(requests, executor.get());
+
+    REPORTER_ASSERT(r, requests.back().fResult == SkCodec::kInvalidInput);
+    for (size_t i = 0; i < expected.size(); i++) {
+        REPORTER_ASSERT(r, requests[i].fResult == SkCodec::kSuccess, "request %zu", i);
+        REPORTER_ASSERT(r, ToolUtils::equal_pixels(expected[i], actual[i]), "request %zu", i);
+    }
+
+    // The batch is spread over at most one worker per core, not one task per request.
+    ToolUtils::CountingExecutor counting;
+    for (auto& req : requests) {
+        req.fResult = SkCodec::kUnimplemented;
+    }
+    SkAndroidCodec::DecodeBatch(requests, &counting);
+    const int cores = std::max(1, (int)std::thread::hardware_concurrency());
+    REPORTER_ASSERT(r, counting.taskCount() <= std::min(cores, (int)requests.size()),
+                    "%d tasks", counting.taskCount());
+    for (size_t i = 0; i < expected.size(); i++) {
+        REPORTER_ASSERT(r, requests[i].fResult == SkCodec::kSuccess, "request %zu", i);
+    }
+}
+
+// Mean absolute difference between the channels of a and the same size area of b at (x, y).
+static float mean_difference(const SkBitmap& a, const SkBitmap& b, int x, int y) {
+    int64_t sum = 0;
+    for (int row = 0; row < a.height(); row++) {
+        const uint8_t* pa = static_cast<const uint8_t*>(a.getAddr(0, row));
+        const uint8_t* pb = static_cast<const uint8_t*>(b.getAddr(x, y + row));
+        for (size_t i = 0; i < a.info().minRowBytes(); i++) {
+            sum += std::abs(pa[i] - pb[i]);
+        }
+    }
+    return (float)sum / (a.height() * a.info().minRowBytes());
+}
+
+DEF_TEST(AndroidCodec_getResizedPixels, r) {
+    if (GetResourcePath().isEmpty()) {
+        return;
+    }
+
+    for (const char* path : { "images/mandrill_512.png",
+                              "images/mandrill_512_q075.jpg",
+                              "images/rle.bmp" }) {
+        auto codec = SkAndroidCodec::MakeFromData(GetResourceAsData(path));
+        if (!codec) {
+            ERRORF(r, "Failed to create codec from %s", path);
+            continue;
+        }
+        const SkISize dims = codec->getInfo().dimensions();
+        const SkImageInfo info = codec->getInfo().makeColorType(kN32_SkColorType)
+                                                 .makeAlphaType(kPremul_SkAlphaType);
+
+        // The filter does not depend on the subset, so decoding a subset that lines up with
+        // output pixels matches that part of the whole image.
+        SkBitmap whole;
+        whole.allocPixels(info.makeWH(dims.width() / 4, dims.height() / 4));
+        REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                           codec->getResizedPixels(whole.info(), whole.getPixels(),
+                                                   whole.rowBytes()), "%s", path);
+
+        const SkIRect subset = SkIRect::MakeXYWH(dims.width() / 4, dims.height() / 2,
+                                                 dims.width() / 2, dims.height() / 2);
+        SkBitmap part;
+        part.allocPixels(info.makeWH(dims.width() / 8, dims.height() / 8));
+        REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                           codec->getResizedPixels(part.info(), part.getPixels(),
+                                                   part.rowBytes(), &subset), "%s", path);
+        REPORTER_ASSERT(r, mean_difference(part, whole, subset.x() / 4, subset.y() / 4) == 0,
+                        "%s", path);
+
+        // Any ratio is supported, and is close to a mipmapped downscale of the whole image.
+        SkBitmap full;
+        full.allocPixels(info);
+        REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                           codec->getAndroidPixels(full.info(), full.getPixels(),
+                                                   full.rowBytes()), "%s", path);
+        SkBitmap resized, expected;
+        resized.allocPixels(info.makeWH(dims.width() * 10 / 37, dims.height() * 5 / 23));
+        expected.allocPixels(resized.info());
+        REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                           codec->getResizedPixels(resized.info(), resized.getPixels(),
+                                                   resized.rowBytes()), "%s", path);
+        full.pixmap().scalePixels(expected.pixmap(),
+                                  SkSamplingOptions(SkFilterMode::kLinear, SkMipmapMode::kLinear));
+        const float difference = mean_difference(resized, expected, 0, 0);
+        REPORTER_ASSERT(r, difference < 4, "%s differs by %g", path, difference);
+    }
+
+    // A solid, translucent image resizes to exactly the same color.
+    SkBitmap solid;
+    solid.allocPixels(SkImageInfo::MakeN32(37, 23, kPremul_SkAlphaType));
+    solid.eraseColor(SkColorSetARGB(0x80, 0x10, 0x60, 0xC0));
+    SkDynamicMemoryWStream stream;
+    REPORTER_ASSERT(r, SkPngEncoder::Encode(&stream, solid.pixmap(), {}));
+    auto codec = SkAndroidCodec::MakeFromData(stream.detachAsData());
+    REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                       codec->getAndroidPixels(solid.info(), solid.getPixels(), solid.rowBytes()));
+    SkBitmap resized;
+    resized.allocPixels(solid.info().makeWH(5, 3));
+    REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                       codec->getResizedPixels(resized.info(), resized.getPixels(),
+                                               resized.rowBytes()));
+    REPORTER_ASSERT(r, mean_difference(resized, solid, 0, 0) == 0);
+
+    // Filtering unpremultiplied pixels is not supported, nor are other depths.
+    REPORTER_ASSERT(r, SkCodec::kInvalidConversion ==
+                       codec->getResizedPixels(resized.info().makeAlphaType(kUnpremul_SkAlphaType),
+                                               resized.getPixels(), resized.rowBytes()));
+    SkBitmap f16;
+    f16.allocPixels(resized.info().makeColorType(kRGBA_F16_SkColorType));
+    REPORTER_ASSERT(r, SkCodec::kInvalidConversion ==
+                       codec->getResizedPixels(f16.info(), f16.getPixels(), f16.rowBytes()));
+    const SkIRect outside = SkIRect::MakeXYWH(30, 20, 10, 10);
+    REPORTER_ASSERT(r, SkCodec::kInvalidParameters ==
+                       codec->getResizedPixels(resized.info(), resized.getPixels(),
+                                               resized.rowBytes(), &outside));
+}
+
+// A request for a size the codec produces natively is not filtered.
+DEF_TEST(AndroidCodec_getResizedPixels_native, r) {
+    if (GetResourcePath().isEmpty()) {
+        return;
+    }
+
+    for (const char* path : { "images/mandrill_512.png",
+                              "images/mandrill_512_q075.jpg",
+                              "images/color_wheel.jpg" }) {
+        auto codec = SkAndroidCodec::MakeFromData(GetResourceAsData(path));
+        if (!codec) {
+            ERRORF(r, "Failed to create codec from %s", path);
+            continue;
+        }
+        const SkImageInfo info = codec->getInfo().makeColorType(kN32_SkColorType)
+                                                 .makeAlphaType(kPremul_SkAlphaType);
+        for (int sampleSize : {1, 2, 4}) {
+            if (sampleSize > 1 && codec->getEncodedFormat() != SkEncodedImageFormat::kJPEG) {
+                continue;
+            }
+            const SkISize dims = codec->getSampledDimensions(sampleSize);
+            SkBitmap expected;
+            expected.allocPixels(info.makeDimensions(dims));
+            SkAndroidCodec::AndroidOptions options;
+            options.fSampleSize = sampleSize;
+            REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                               codec->getAndroidPixels(expected.info(), expected.getPixels(),
+                                                       expected.rowBytes(), &options));
+
+            SkBitmap actual;
+            actual.allocPixels(expected.info());
+            REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                               codec->getResizedPixels(actual.info(), actual.getPixels(),
+                                                       actual.rowBytes()));
+            REPORTER_ASSERT(r, ToolUtils::equal_pixels(expected, actual),
+                            "%s, sample size %d", path, sampleSize);
+        }
+    }
+}
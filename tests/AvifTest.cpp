@@ -10,6 +10,9 @@
 #ifdef SK_CODEC_DECODES_AVIF
 #include "include/codec/SkCodec.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkYUVAInfo.h"
+#include "include/core/SkYUVAPixmaps.h"
+#include "tests/CodecPriv.h"
 #include "tests/Test.h"
 #include "tools/Resources.h"
 #include "tools/ToolUtils.h"
@@ -230,4 +233,86 @@ DEF_TEST(AvifDecodeAnimationWithAlpha, r) {
     run_avif_test(r, t);
 }
 
+// The SkYUVColorSpace is not part of the expectations: it's checked by comparing the planes with the
+// codec's RGBA decode.
+struct AvifYUVATestCase {
+    const char* path;
+    SkISize dimensions;
+    SkYUVAInfo::PlaneConfig planeConfig;
+    SkYUVAInfo::Subsampling subsampling;
+    SkYUVAPixmapInfo::DataType dataType;
+};
+
+static void run_avif_yuva_test(skiatest::Reporter* r, const AvifYUVATestCase& t) {
+    auto data = GetResourceAsData(t.path);
+    if (!data) {
+        ERRORF(r, "failed to find %s", t.path);
+        return;
+    }
+
+    auto codec = SkCodec::MakeFromData(std::move(data));
+    if (!codec) {
+        ERRORF(r, "Could not create codec from %s", t.path);
+        return;
+    }
+
+    SkYUVAPixmapInfo yuvaPixmapInfo;
+    bool success =
+            codec->queryYUVAInfo(SkYUVAPixmapInfo::SupportedDataTypes::All(), &yuvaPixmapInfo);
+    REPORTER_ASSERT(r, success, "%s", t.path);
+    if (!success) {
+        return;
+    }
+    const SkYUVAInfo& yuvaInfo = yuvaPixmapInfo.yuvaInfo();
+    REPORTER_ASSERT(r, yuvaInfo.dimensions() == t.dimensions, "%s", t.path);
+    REPORTER_ASSERT(r, yuvaInfo.planeConfig() == t.planeConfig, "%s", t.path);
+    REPORTER_ASSERT(r, yuvaInfo.subsampling() == t.subsampling, "%s", t.path);
+    REPORTER_ASSERT(r, yuvaInfo.origin() == kTopLeft_SkEncodedOrigin, "%s", t.path);
+    REPORTER_ASSERT(r, yuvaPixmapInfo.dataType() == t.dataType, "%s", t.path);
+
+    // 10 and 12 bit images need 16 bit planes, so they fail if only 8 bit planes are supported.
+    SkYUVAPixmapInfo::SupportedDataTypes unorm8Only;
+    for (int numChannels = 1; numChannels <= 4; ++numChannels) {
+        unorm8Only.enableDataType(SkYUVAPixmapInfo::DataType::kUnorm8, numChannels);
+    }
+    SkYUVAPixmapInfo unorm8Info;
+    success = codec->queryYUVAInfo(unorm8Only, &unorm8Info);
+    REPORTER_ASSERT(r, success == (t.dataType == SkYUVAPixmapInfo::DataType::kUnorm8), "%s",
+                    t.path);
+
+    auto pixmaps = SkYUVAPixmaps::Allocate(yuvaPixmapInfo);
+    REPORTER_ASSERT(r, pixmaps.isValid());
+    auto result = codec->getYUVAPlanes(pixmaps);
+    if (result != SkCodec::kSuccess) {
+        ERRORF(r, "Failed to decode planes of %s - error %s", t.path,
+               SkCodec::ResultToString(result));
+        return;
+    }
+    check_yuva_planes_match_rgba(r, codec.get(), pixmaps, t.path);
+}
+
+DEF_TEST(AvifDecodeYUVAPlanes, r) {
+    constexpr auto kUnorm8 = SkYUVAPixmapInfo::DataType::kUnorm8;
+    constexpr auto kUnorm16 = SkYUVAPixmapInfo::DataType::kUnorm16;
+    constexpr auto kY_U_V = SkYUVAInfo::PlaneConfig::kY_U_V;
+    constexpr auto kY_U_V_A = SkYUVAInfo::PlaneConfig::kY_U_V_A;
+    constexpr auto k444 = SkYUVAInfo::Subsampling::k444;
+    constexpr auto k420 = SkYUVAInfo::Subsampling::k420;
+
+    run_avif_yuva_test(r, {"images/dog.avif", {180, 180}, kY_U_V, k444, kUnorm8});
+    run_avif_yuva_test(r, {"images/ducky.avif", {489, 537}, kY_U_V, k420, kUnorm8});
+    run_avif_yuva_test(r, {"images/example_3_10bit.avif", {512, 512}, kY_U_V, k444, kUnorm16});
+    run_avif_yuva_test(r, {"images/example_3_12bit.avif", {512, 512}, kY_U_V, k444, kUnorm16});
+    run_avif_yuva_test(r, {"images/baby_tux.avif", {240, 246}, kY_U_V_A, k444, kUnorm8});
+
+    // Identity matrix coefficients store G, B and R, which SkYUVColorSpace cannot describe.
+    auto codec = SkCodec::MakeFromData(GetResourceAsData("images/alphabetAnim.avif"));
+    REPORTER_ASSERT(r, codec);
+    if (codec) {
+        SkYUVAPixmapInfo yuvaPixmapInfo;
+        REPORTER_ASSERT(r, !codec->queryYUVAInfo(SkYUVAPixmapInfo::SupportedDataTypes::All(),
+                                                 &yuvaPixmapInfo));
+    }
+}
+
 #endif  // SK_CODEC_DECODES_AVIF
@@ -12,6 +12,7 @@
 #include "include/core/SkColor.h"
 #include "include/core/SkColorPriv.h"
 #include "include/core/SkColorType.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkMaskFilter.h"
 #include "include/core/SkPaint.h"
@@ -32,9 +33,11 @@
 #include "include/private/base/SkFloatBits.h"
 #include "include/private/base/SkTPin.h"
 #include "src/base/SkMathPriv.h"
+#include "src/base/SkRandom.h"
 #include "src/core/SkBlurMask.h"
 #include "src/core/SkGpuBlurUtils.h"
 #include "src/core/SkMask.h"
+#include "src/core/SkMaskBlurFilter.h"
 #include "src/core/SkMaskFilterBase.h"
 #include "src/effects/SkEmbossMaskFilter.h"
 #include "tests/CtsEnforcement.h"
@@ -47,6 +50,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <initializer_list>
+#include <memory>
 
 struct GrContextOptions;
 
@@ -587,3 +591,56 @@ DEF_TEST(zero_blur, reporter) {
     SkIPoint offset;
     bitmap.extractAlpha(&alpha, &paint, nullptr, &offset);
 }
+
+// Large sigmas blur eight rows at a time, and big masks are blurred in bands when there is an
+// executor. All of these must match blurring one row at a time on the calling thread.
+DEF_TEST(BlurMaskRowsAndBands, reporter) {
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    SkRandom rand;
+
+    auto blur = [](const SkMaskBlurFilter& filter, const SkMask& src, bool blurRows,
+                   SkExecutor* executor, SkMask* dst) {
+        filter.blur(src, dst, executor, blurRows);
+        return SkAutoMaskFreeImage(dst->fImage);
+    };
+
+    for (SkMask::Format format : {SkMask::kA8_Format, SkMask::kBW_Format,
+                                  SkMask::kARGB32_Format, SkMask::kLCD16_Format}) {
+        for (SkISize size : {SkISize{530, 517}, SkISize{61, 4500}, SkISize{300, 270}}) {
+            SkMask src;
+            src.fBounds = SkIRect::MakeSize(size);
+            src.fFormat = format;
+            switch (format) {
+                case SkMask::kBW_Format:     src.fRowBytes = (size.width() + 7) / 8; break;
+                case SkMask::kARGB32_Format: src.fRowBytes = 4 * size.width();       break;
+                case SkMask::kLCD16_Format:  src.fRowBytes = 2 * size.width();       break;
+                default:                     src.fRowBytes = size.width();           break;
+            }
+            const size_t srcSize = src.computeImageSize();
+            src.fImage = SkMask::AllocImage(srcSize);
+            SkAutoMaskFreeImage srcImage(src.fImage);
+            for (size_t i = 0; i < srcSize; ++i) {
+                // Mostly solid or empty runs, with noise in between.
+                src.fImage[i] = (i / 97) % 3 == 0 ? rand.nextU() : (i / 97) % 3 == 1 ? 0xFF : 0;
+            }
+
+            for (double sigma : {16.0, 23.5, 58.5}) {
+                const SkMaskBlurFilter filter(sigma, sigma);
+                SkMask expected, rows, bands, scalarBands;
+                SkAutoMaskFreeImage e = blur(filter, src, false, nullptr,        &expected),
+                                    a = blur(filter, src, true,  nullptr,        &rows),
+                                    b = blur(filter, src, true,  executor.get(), &bands),
+                                    c = blur(filter, src, false, executor.get(), &scalarBands);
+                const size_t dstSize = expected.computeImageSize();
+                for (const SkMask* actual : {&rows, &bands, &scalarBands}) {
+                    REPORTER_ASSERT(reporter,
+                                    actual->fBounds == expected.fBounds &&
+                                    actual->fRowBytes == expected.fRowBytes &&
+                                    0 == memcmp(actual->fImage, expected.fImage, dstSize),
+                                    "format %d, %dx%d, sigma %g", format, size.width(),
+                                    size.height(), sigma);
+                }
+            }
+        }
+    }
+}
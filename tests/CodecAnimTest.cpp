@@ -22,6 +22,8 @@
 #include "include/core/SkString.h"
 #include "include/core/SkTypes.h"
 #include "include/utils/SkAnimCodecPlayer.h"
+#include "src/base/SkRandom.h"
+#include "src/utils/SkAnimCodecFrameCache.h"
 #include "tests/CodecPriv.h"
 #include "tests/Test.h"
 #include "tools/Resources.h"
@@ -626,3 +628,59 @@ DEF_TEST(AnimCodecPlayer, r) {
                         "Mismatched size for frame at 500 ms of %s", test.fFile);
     }
 }
+
+DEF_TEST(AnimCodecFrameCache, r) {
+    for (const char* file : { "images/required.gif",
+                              "images/required.webp",
+                              "images/alphabetAnim.gif",
+                              "images/flightAnim.gif",
+                              "images/stoplight.webp" }) {
+        auto codec = SkCodec::MakeFromData(GetResourceAsData(file));
+        if (!codec) {
+            ERRORF(r, "Could not create codec for %s", file);
+            continue;
+        }
+        // The reference decodes every frame the slow way, letting the codec decode the frames
+        // it depends on.
+        auto refCodec = SkCodec::MakeFromData(GetResourceAsData(file));
+
+        // Budget for two keyframes, so most seeks decode forward from one of them.
+        const size_t frameBytes = codec->getInfo().computeMinByteSize();
+        SkAnimCodecFrameCache cache(codec.get(), 2 * frameBytes);
+        const int frameCount = cache.frameCount();
+        REPORTER_ASSERT(r, frameCount == refCodec->getFrameCount());
+
+        std::vector<SkBitmap> expected(frameCount);
+        for (int i = 0; i < frameCount; ++i) {
+            expected[i].allocPixels(cache.imageInfo());
+            SkCodec::Options options;
+            options.fFrameIndex = i;
+            REPORTER_ASSERT(r, SkCodec::kSuccess == refCodec->getPixels(expected[i].pixmap(),
+                                                                        &options));
+        }
+
+        std::vector<int> order;
+        for (int i = frameCount - 1; i >= 0; --i) {
+            order.push_back(i);
+        }
+        SkRandom rand;
+        for (int i = 0; i < 2 * frameCount; ++i) {
+            order.push_back(rand.nextULessThan(frameCount));
+        }
+
+        for (int i : order) {
+            sk_sp<SkImage> frame = cache.getFrame(i);
+            if (!frame) {
+                ERRORF(r, "Failed to decode frame %i of %s", i, file);
+                continue;
+            }
+            SkBitmap actual;
+            actual.allocPixels(cache.imageInfo());
+            REPORTER_ASSERT(r, frame->readPixels(nullptr, actual.pixmap(), 0, 0));
+            if (!ToolUtils::equal_pixels(expected[i], actual)) {
+                ERRORF(r, "Mismatch in frame %i of %s", i, file);
+            }
+            REPORTER_ASSERT(r, cache.bytesUsed() <= 3 * frameBytes);
+        }
+    }
+}
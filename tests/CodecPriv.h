@@ -13,9 +13,16 @@
 #include "include/core/SkEncodedImageFormat.h"
 #include "include/core/SkImageEncoder.h"
 #include "include/core/SkStream.h"
+#include "include/core/SkYUVAPixmaps.h"
+#include "include/effects/SkColorMatrix.h"
+#include "include/private/base/SkTPin.h"
+#include "src/core/SkYUVAInfoLocation.h"
 #include "src/utils/SkOSPath.h"
+#include "tests/Test.h"
 #include "tools/flags/CommandLineFlags.h"
 
+#include <cmath>
+
 static DEFINE_string(codecWritePath, "",
                      "Dump image decodes from codec unit tests here.");
 
@@ -44,4 +51,79 @@ inline void write_bm(const char* name, const SkBitmap& bm) {
     }
 }
 
+// Returns the mean absolute difference, in 8 bit units, between rgba (unpremul, in the encoded color
+// space) and the planes converted to RGBA with colorSpace. Chroma is sampled at the nearest sample,
+// which codecs need not do, so this is small rather than 0 when colorSpace is right.
+inline float yuva_to_rgba_error(const SkYUVAPixmaps& planes,
+                                SkYUVColorSpace colorSpace,
+                                const SkPixmap& rgba) {
+    float m[20];
+    SkColorMatrix::YUVtoRGB(colorSpace).getRowMajor(m);
+    const SkYUVAInfo::YUVALocations locations = planes.toYUVALocations();
+    const SkISize dims = planes.plane(0).dimensions();
+    auto sample = [&](SkYUVAInfo::YUVAChannels channel, int x, int y) {
+        const auto [plane, c] = locations[channel];
+        if (plane < 0) {
+            return 1.0f;  // opaque
+        }
+        const SkPixmap& pixmap = planes.plane(plane);
+        const SkColor4f color = pixmap.getColor4f(x * pixmap.width() / dims.width(),
+                                                  y * pixmap.height() / dims.height());
+        return color.vec()[static_cast<int>(c)];
+    };
+
+    double error = 0;
+    for (int y = 0; y < dims.height(); ++y) {
+        for (int x = 0; x < dims.width(); ++x) {
+            const float yuva[4] = {sample(SkYUVAInfo::YUVAChannels::kY, x, y),
+                                   sample(SkYUVAInfo::YUVAChannels::kU, x, y),
+                                   sample(SkYUVAInfo::YUVAChannels::kV, x, y),
+                                   sample(SkYUVAInfo::YUVAChannels::kA, x, y)};
+            const SkColor4f expected = rgba.getColor4f(x, y);
+            for (int i = 0; i < 3; ++i) {
+                const float c = m[5*i + 0] * yuva[0] + m[5*i + 1] * yuva[1] +
+                                m[5*i + 2] * yuva[2] + m[5*i + 4];
+                error += std::fabs(SkTPin(c, 0.0f, 1.0f) - expected.vec()[i]);
+            }
+            error += std::fabs(yuva[3] - expected.fA);
+        }
+    }
+    return static_cast<float>(255 * error / (4.0 * dims.width() * dims.height()));
+}
+
+// Checks that planes, which codec decoded, match the codec's own RGBA decode when converted with
+// their SkYUVColorSpace, and match it better than with any other SkYUVColorSpace.
+inline void check_yuva_planes_match_rgba(skiatest::Reporter* r,
+                                         SkCodec* codec,
+                                         const SkYUVAPixmaps& planes,
+                                         const char* path) {
+    SkBitmap rgba;
+    rgba.allocPixels(codec->getInfo().makeColorType(kRGBA_8888_SkColorType)
+                                     .makeAlphaType(kUnpremul_SkAlphaType)
+                                     .makeColorSpace(nullptr));
+    if (codec->getPixels(rgba.pixmap()) != SkCodec::kSuccess) {
+        ERRORF(r, "Failed to decode %s to RGBA", path);
+        return;
+    }
+    if (rgba.dimensions() != planes.plane(0).dimensions()) {
+        ERRORF(r, "%s: RGBA and Y plane dimensions differ", path);
+        return;
+    }
+
+    const SkYUVColorSpace colorSpace = planes.yuvaInfo().yuvColorSpace();
+    const float error = yuva_to_rgba_error(planes, colorSpace, rgba.pixmap());
+    REPORTER_ASSERT(r, error < 3, "%s: mean error %g", path, error);
+    for (int i = 0; i <= kLastEnum_SkYUVColorSpace; ++i) {
+        const auto other = static_cast<SkYUVColorSpace>(i);
+        if (other == colorSpace || other == kIdentity_SkYUVColorSpace) {
+            continue;
+        }
+        // Some color spaces differ only in rounding (e.g. 8 and 10 bit BT.2020), hence the slack.
+        const float otherError = yuva_to_rgba_error(planes, other, rgba.pixmap());
+        REPORTER_ASSERT(r, error <= otherError + 0.05f,
+                        "%s: color space %d (mean error %g) fits better than %d (%g)",
+                        path, i, otherError, colorSpace, error);
+    }
+}
+
 #endif  // CodecPriv_DEFINED
@@ -1018,6 +1018,34 @@ DEF_TEST(Codec_wbmp_max_size, r) {
     REPORTER_ASSERT(r, !codec);
 }
 
+DEF_TEST(Codec_jpegRestartIntervalsParallel, r) {
+    // This image has a restart interval of 189 MCUs, which does not line up with its 252 MCU wide
+    // rows, and 2x2 chroma subsampling, so bands need overlap for identical upsampling.
+    const char* path = "images/iphone_13_pro.jpeg";
+    auto data = GetResourceAsData(path);
+    if (!data) {
+        return;
+    }
+
+    auto codec = SkCodec::MakeFromData(data);
+    REPORTER_ASSERT(r, codec);
+    const SkImageInfo info = codec->getInfo().makeColorType(kN32_SkColorType);
+
+    SkBitmap serial, parallel;
+    serial.allocPixels(info);
+    parallel.allocPixels(info);
+    REPORTER_ASSERT(r, SkCodec::kSuccess == codec->getPixels(serial.pixmap()));
+
+    ToolUtils::CountingExecutor executor;
+    SkCodec::Options options;
+    options.fExecutor = &executor;
+    codec = SkCodec::MakeFromData(data);
+    REPORTER_ASSERT(r, SkCodec::kSuccess == codec->getPixels(parallel.pixmap(), &options));
+
+    REPORTER_ASSERT(r, executor.taskCount() > 1);
+    REPORTER_ASSERT(r, ToolUtils::equal_pixels(serial, parallel));
+}
+
 DEF_TEST(Codec_jpeg_rewind, r) {
     const char* path = "images/mandrill_512_q075.jpg";
     sk_sp<SkData> data(GetResourceAsData(path));
@@ -1471,6 +1499,100 @@ DEF_TEST(Codec_rowsDecoded, r) {
     REPORTER_ASSERT(r, rowsDecoded == 0);
 }
 
+static SkBitmap decode_png_subset(skiatest::Reporter* r, sk_sp<SkData> encoded,
+                                  sk_sp<SkData> rowIndex, const SkIRect& subset, int sampleSize) {
+    std::unique_ptr<SkAndroidCodec> codec(SkAndroidCodec::MakeFromData(std::move(encoded)));
+    REPORTER_ASSERT(r, codec->codec()->setRowIndex(std::move(rowIndex)));
+
+    SkAndroidCodec::AndroidOptions options;
+    options.fSubset = &subset;
+    options.fSampleSize = sampleSize;
+    const SkImageInfo info = codec->getInfo()
+            .makeDimensions(codec->getSampledSubsetDimensions(sampleSize, subset))
+            .makeColorType(kN32_SkColorType);
+    SkBitmap bm;
+    bm.allocPixels(info);
+    const auto result = codec->getAndroidPixels(info, bm.getPixels(), bm.rowBytes(), &options);
+    REPORTER_ASSERT(r, result == SkCodec::kSuccess, "%s", SkCodec::ResultToString(result));
+    return bm;
+}
+
+DEF_TEST(Codec_pngRowIndex, r) {
+    // Alternate bands of noise and gradients, so the image data has both stored and compressed
+    // deflate blocks, and the rows use different filters.
+    SkBitmap src;
+    src.allocPixels(SkImageInfo::Make(301, 900, kRGBA_8888_SkColorType, kUnpremul_SkAlphaType));
+    SkRandom rand;
+    for (int y = 0; y < src.height(); ++y) {
+        for (int x = 0; x < src.width(); ++x) {
+            *src.getAddr32(x, y) = (y / 50) % 2 ? rand.nextU()
+                                                : SkColorSetARGB(0xFF - y / 4, x % 256, y % 256, (x + y) % 256);
+        }
+    }
+    SkDynamicMemoryWStream stream;
+    REPORTER_ASSERT(r, SkPngEncoder::Encode(&stream, src.pixmap(), {}));
+    sk_sp<SkData> encoded = stream.detachAsData();
+
+    sk_sp<SkData> rowIndex = SkCodec::MakeFromData(encoded)->buildRowIndex(64);
+    if (!rowIndex) {
+        ERRORF(r, "Failed to build a row index");
+        return;
+    }
+
+    // An index only works for the image it was built for.
+    {
+        auto codec = SkCodec::MakeFromData(encoded);
+        REPORTER_ASSERT(r, !codec->setRowIndex(SkData::MakeSubset(rowIndex.get(), 0,
+                                                                  rowIndex->size() - 1)));
+        SkPixmap top;
+        REPORTER_ASSERT(r, src.pixmap().extractSubset(&top, SkIRect::MakeWH(301, 600)));
+        SkDynamicMemoryWStream shorter;
+        REPORTER_ASSERT(r, SkPngEncoder::Encode(&shorter, top, {}));
+        REPORTER_ASSERT(r, !SkCodec::MakeFromData(shorter.detachAsData())->setRowIndex(rowIndex));
+    }
+
+    for (int top : {0, 1, 63, 64, 65, 333, 850, 899}) {
+        for (int sampleSize : {1, 3}) {
+            const SkIRect subset = SkIRect::MakeLTRB(7, top, 250, std::min(top + 50, 900));
+            SkBitmap expected = decode_png_subset(r, encoded, nullptr, subset, sampleSize);
+            SkBitmap actual = decode_png_subset(r, encoded, rowIndex, subset, sampleSize);
+            REPORTER_ASSERT(r, ToolUtils::equal_pixels(expected, actual),
+                            "top %d sampleSize %d", top, sampleSize);
+        }
+    }
+
+    // Decoding from a checkpoint would skip over the image data above it, so an index must not be
+    // used once the image data has changed, even where the header still matches.
+    sk_sp<SkData> corrupt = SkData::MakeWithCopy(encoded->data(), encoded->size());
+    uint8_t* bytes = static_cast<uint8_t*>(corrupt->writable_data());
+    const char kIDAT[] = "IDAT";
+    uint8_t* idat = std::search(bytes, bytes + corrupt->size(), kIDAT, kIDAT + 4);
+    REPORTER_ASSERT(r, idat + 200 < bytes + corrupt->size());
+    memset(idat + 100, 0xFF, 100);
+    {
+        auto codec = SkCodec::MakeFromData(corrupt);
+        REPORTER_ASSERT(r, !codec->setRowIndex(rowIndex));
+
+        // Nor if the image data is incomplete.
+        auto partial = SkCodec::MakeFromData(SkData::MakeSubset(encoded.get(), 0,
+                                                                encoded->size() / 2));
+        REPORTER_ASSERT(r, !partial->setRowIndex(rowIndex));
+    }
+
+    // Checking the index reads the stream, which the next decode must rewind.
+    {
+        auto codec = SkCodec::MakeFromData(encoded);
+        REPORTER_ASSERT(r, codec->setRowIndex(rowIndex));
+        SkBitmap actual, expected;
+        actual.allocPixels(codec->getInfo().makeColorType(kN32_SkColorType));
+        expected.allocPixels(actual.info());
+        REPORTER_ASSERT(r, SkCodec::kSuccess == codec->getPixels(actual.pixmap()));
+        REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                           SkCodec::MakeFromData(encoded)->getPixels(expected.pixmap()));
+        REPORTER_ASSERT(r, ToolUtils::equal_pixels(expected, actual));
+    }
+}
+
 static void test_invalid_images(skiatest::Reporter* r, const char* path,
                                 SkCodec::Result expectedResult) {
     auto stream = GetResourceAsStream(path);
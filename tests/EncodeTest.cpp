@@ -15,6 +15,7 @@
 #include "include/core/SkData.h"
 #include "include/core/SkDataTable.h"
 #include "include/core/SkEncodedImageFormat.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageEncoder.h"
 #include "include/core/SkImageInfo.h"
@@ -29,7 +30,9 @@
 #include "include/encode/SkWebpEncoder.h"
 #include "include/private/base/SkTemplates.h"
 #include "include/private/base/SkMalloc.h"
+#include "src/base/SkRandom.h"
 #include "src/core/SkImageInfoPriv.h"
+#include "src/core/SkOpts.h"
 #include "tests/Test.h"
 #include "tools/Resources.h"
 
@@ -38,6 +41,8 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <initializer_list>
 #include <memory>
 #include <string>
@@ -230,6 +235,72 @@ DEF_TEST(Encode_JpegDownsample, r) {
     REPORTER_ASSERT(r, almost_equals(bm1, bm2, 60));
 }
 
+DEF_TEST(Encode_JpegStreaming, r) {
+    SkBitmap bitmap;
+    if (!GetResourceAsBitmap("images/mandrill_512.png", &bitmap)) {
+        return;
+    }
+    const SkImageInfo& info = bitmap.info();
+
+    SkBitmap expected;
+    {
+        SkDynamicMemoryWStream dst;
+        REPORTER_ASSERT(r, SkJpegEncoder::Encode(&dst, bitmap.pixmap(), {}));
+        SkImage::MakeFromEncoded(dst.detachAsData())->asLegacyBitmap(&expected);
+    }
+
+    for (int stripHeight : {1, 7, 16, 512, 1000}) {
+        int nextRow = 0;
+        auto rowProc = [&](int firstRow, const SkPixmap& rows) {
+            // Rows are requested once each, in order, a strip at a time.
+            REPORTER_ASSERT(r, firstRow == nextRow, "strip height %d", stripHeight);
+            REPORTER_ASSERT(r, rows.height() == std::min(stripHeight, info.height() - firstRow));
+            REPORTER_ASSERT(r, rows.width() == info.width());
+            nextRow = firstRow + rows.height();
+            return bitmap.readPixels(rows, 0, firstRow);
+        };
+
+        SkDynamicMemoryWStream dst;
+        REPORTER_ASSERT(r, SkJpegEncoder::Encode(&dst, info, stripHeight, rowProc, {}));
+        REPORTER_ASSERT(r, nextRow == info.height());
+
+        // Only the Huffman tables differ, so the pixels should be identical.
+        auto image = SkImage::MakeFromEncoded(dst.detachAsData());
+        if (!image) {
+            ERRORF(r, "failed to decode, strip height %d", stripHeight);
+            continue;
+        }
+        SkBitmap actual;
+        image->asLegacyBitmap(&actual);
+        REPORTER_ASSERT(r, almost_equals(expected, actual, 0), "strip height %d", stripHeight);
+    }
+
+    // Output is written as rows are encoded, rather than all at the end.
+    {
+        auto rowProc = [&](int firstRow, const SkPixmap& rows) {
+            return bitmap.readPixels(rows, 0, firstRow);
+        };
+        SkDynamicMemoryWStream dst;
+        auto encoder = SkJpegEncoder::Make(&dst, info, 16, rowProc, {});
+        REPORTER_ASSERT(r, encoder && encoder->encodeRows(info.height() / 2));
+        const size_t halfway = dst.bytesWritten();
+        REPORTER_ASSERT(r, encoder->encodeRows(info.height() / 2));
+        REPORTER_ASSERT(r, halfway > dst.bytesWritten() / 4,
+                        "%zu of %zu bytes", halfway, dst.bytesWritten());
+    }
+
+    // A failing RowProc fails the encode.
+    SkNullWStream ignored;
+    auto failingRowProc = [](int firstRow, const SkPixmap&) { return firstRow < 100; };
+    REPORTER_ASSERT(r, !SkJpegEncoder::Encode(&ignored, info, 16, failingRowProc, {}));
+
+    auto unusedRowProc = [](int, const SkPixmap&) { return true; };
+    REPORTER_ASSERT(r, !SkJpegEncoder::Encode(&ignored, info, 0, unusedRowProc, {}));
+    REPORTER_ASSERT(r, !SkJpegEncoder::Encode(&ignored, info, 16, nullptr, {}));
+    REPORTER_ASSERT(r, !SkJpegEncoder::Encode(
+            &ignored, info.makeColorType(kUnknown_SkColorType), 16, unusedRowProc, {}));
+}
+
 static inline void pushComment(
         std::vector<std::string>& comments, const char* keyword, const char* text) {
     comments.push_back(keyword);
@@ -344,6 +415,150 @@ DEF_TEST(Encode_PngOptions, r) {
     REPORTER_ASSERT(r, almost_equals(bm0, bm2, 0));
 }
 
+DEF_TEST(Encode_PngExecutor, r) {
+    // Large enough to be split into several bands.
+    SkBitmap bitmap;
+    if (!GetResourceAsBitmap("images/mandrill_512.png", &bitmap)) {
+        return;
+    }
+
+    auto executor = SkExecutor::MakeFIFOThreadPool(2);
+    for (auto filters : {SkPngEncoder::FilterFlag::kAll,
+                         SkPngEncoder::FilterFlag::kNone,
+                         SkPngEncoder::FilterFlag::kPaeth,
+                         SkPngEncoder::FilterFlag::kSub | SkPngEncoder::FilterFlag::kAvg}) {
+        for (int zlibLevel : {0, 1, 6, 9}) {
+            SkPngEncoder::Options options;
+            options.fFilterFlags = filters;
+            options.fZLibLevel = zlibLevel;
+
+            SkDynamicMemoryWStream serial, incremental, parallel;
+            REPORTER_ASSERT(r, SkPngEncoder::Encode(&serial, bitmap.pixmap(), options));
+            // Encoding a few rows at a time keeps one deflate stream going across calls.
+            auto encoder = SkPngEncoder::Make(&incremental, bitmap.pixmap(), options);
+            REPORTER_ASSERT(r, encoder);
+            for (int y = 0; encoder && y < bitmap.height(); y += 100) {
+                REPORTER_ASSERT(r, encoder->encodeRows(100));
+            }
+            options.fExecutor = executor.get();
+            REPORTER_ASSERT(r, SkPngEncoder::Encode(&parallel, bitmap.pixmap(), options));
+
+            SkBitmap bm0, bm1, bm2;
+            auto img0 = SkImage::MakeFromEncoded(serial.detachAsData()),
+                 img1 = SkImage::MakeFromEncoded(incremental.detachAsData()),
+                 img2 = SkImage::MakeFromEncoded(parallel.detachAsData());
+            if (!img0 || !img1 || !img2) {
+                ERRORF(r, "failed to decode, filters %d, level %d", (int)filters, zlibLevel);
+                continue;
+            }
+            img0->asLegacyBitmap(&bm0);
+            img1->asLegacyBitmap(&bm1);
+            img2->asLegacyBitmap(&bm2);
+            REPORTER_ASSERT(r, almost_equals(bm0, bm1, 0),
+                            "filters %d, level %d", (int)filters, zlibLevel);
+            REPORTER_ASSERT(r, almost_equals(bm0, bm2, 0),
+                            "filters %d, level %d", (int)filters, zlibLevel);
+        }
+    }
+}
+
+DEF_TEST(Encode_JpegExecutor, r) {
+    SkBitmap tile;
+    if (!GetResourceAsBitmap("images/mandrill_512.png", &tile)) {
+        return;
+    }
+    // Large enough to be split into several strips, the last of them a partial MCU row.
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(1000, 1001);
+    SkCanvas canvas(bitmap);
+    for (int y = 0; y < bitmap.height(); y += tile.height()) {
+        for (int x = 0; x < bitmap.width(); x += tile.width()) {
+            canvas.drawImage(tile.asImage(), x, y);
+        }
+    }
+
+    auto executor = SkExecutor::MakeFIFOThreadPool(2);
+    for (auto ct : {kN32_SkColorType, kRGB_565_SkColorType, kGray_8_SkColorType}) {
+        SkBitmap src;
+        src.allocPixels(bitmap.info().makeColorType(ct));
+        REPORTER_ASSERT(r, bitmap.readPixels(src.pixmap()));
+        for (auto downsample : {SkJpegEncoder::Downsample::k420,
+                                SkJpegEncoder::Downsample::k422,
+                                SkJpegEncoder::Downsample::k444}) {
+            for (int quality : {50, 100}) {
+                SkJpegEncoder::Options options;
+                options.fDownsample = downsample;
+                options.fQuality = quality;
+
+                SkDynamicMemoryWStream serial, parallel, incremental;
+                REPORTER_ASSERT(r, SkJpegEncoder::Encode(&serial, src.pixmap(), options));
+                options.fExecutor = executor.get();
+                REPORTER_ASSERT(r, SkJpegEncoder::Encode(&parallel, src.pixmap(), options));
+                // Encoding a few rows at a time falls back to a serial encode.
+                auto encoder = SkJpegEncoder::Make(&incremental, src.pixmap(), options);
+                REPORTER_ASSERT(r, encoder);
+                for (int y = 0; encoder && y < src.height(); y += 100) {
+                    REPORTER_ASSERT(r, encoder->encodeRows(100));
+                }
+
+                // Only the Huffman tables and restart markers differ, so the pixels should be
+                // identical.
+                auto img0 = SkImage::MakeFromEncoded(serial.detachAsData()),
+                     img1 = SkImage::MakeFromEncoded(parallel.detachAsData()),
+                     img2 = SkImage::MakeFromEncoded(incremental.detachAsData());
+                if (!img0 || !img1 || !img2) {
+                    ERRORF(r, "failed to decode, ct %d, downsample %d, quality %d", ct,
+                           (int)downsample, quality);
+                    continue;
+                }
+                SkBitmap bm0, bm1, bm2;
+                img0->asLegacyBitmap(&bm0);
+                img1->asLegacyBitmap(&bm1);
+                img2->asLegacyBitmap(&bm2);
+                REPORTER_ASSERT(r, almost_equals(bm0, bm1, 0),
+                                "ct %d, downsample %d, quality %d", ct, (int)downsample, quality);
+                REPORTER_ASSERT(r, almost_equals(bm0, bm2, 0),
+                                "ct %d, downsample %d, quality %d", ct, (int)downsample, quality);
+            }
+        }
+    }
+}
+
+DEF_TEST(Encode_PngFilterOpts, r) {
+    // Odd lengths and every bpp up to 8 bytes exercise the SIMD loops' heads and tails.
+    static constexpr size_t kMaxRowBytes = 257;
+    uint8_t row[kMaxRowBytes], prev[kMaxRowBytes], expected[kMaxRowBytes], actual[kMaxRowBytes];
+
+    SkRandom rand;
+    for (size_t rowBytes : {0, 1, 15, 16, 17, 31, 32, 33, 64, 100, 257}) {
+        for (int bpp = 1; bpp <= 8; bpp++) {
+            for (size_t i = 0; i < rowBytes; i++) {
+                row[i]  = rand.nextU() >> 24;
+                prev[i] = rand.nextU() >> 24;
+            }
+            for (int filter = 0; filter <= 4; filter++) {
+                for (size_t i = 0; i < rowBytes; i++) {
+                    int a = i >= (size_t)bpp ? row[i - bpp] : 0,
+                        b = prev[i],
+                        c = i >= (size_t)bpp ? prev[i - bpp] : 0;
+                    int pred[] = {0, a, b, (a + b) >> 1,
+                                  SkOpts::png_paeth_predictor(a, b, c)};
+                    expected[i] = row[i] - pred[filter];
+                }
+                SkOpts::png_filter_row(filter, actual, row, prev, rowBytes, bpp);
+                REPORTER_ASSERT(r, 0 == memcmp(expected, actual, rowBytes),
+                                "filter %d, rowBytes %zu, bpp %d", filter, rowBytes, bpp);
+            }
+
+            uint64_t sum = 0;
+            for (size_t i = 0; i < rowBytes; i++) {
+                sum += row[i] < 128 ? row[i] : 256 - row[i];
+            }
+            REPORTER_ASSERT(r, sum == SkOpts::png_filter_sum(row, rowBytes));
+        }
+    }
+}
+
 #ifndef SK_BUILD_FOR_GOOGLE3
 DEF_TEST(Encode_WebpQuality, r) {
     SkBitmap bm;
@@ -445,6 +660,46 @@ DEF_TEST(Encode_WebpOptions, r) {
     REPORTER_ASSERT(r, almost_equals(bm2, bm3, 50));
 }
 
+DEF_TEST(Encode_WebpMethod, r) {
+    SkBitmap bitmap;
+    if (!GetResourceAsBitmap("images/mandrill_128.png", &bitmap)) {
+        return;
+    }
+
+    for (auto compression : {SkWebpEncoder::Compression::kLossless,
+                             SkWebpEncoder::Compression::kLossy}) {
+        for (bool multithreaded : {false, true}) {
+            for (int method : {-1, 0, 3, 6}) {
+                SkWebpEncoder::Options options;
+                options.fCompression = compression;
+                options.fMethod = method;
+                options.fMultithreaded = multithreaded;
+
+                SkDynamicMemoryWStream dst;
+                REPORTER_ASSERT(r, SkWebpEncoder::Encode(&dst, bitmap.pixmap(), options));
+                auto image = SkImage::MakeFromEncoded(dst.detachAsData());
+                if (!image) {
+                    ERRORF(r, "failed to decode, compression %d, threads %d, method %d",
+                           (int)compression, multithreaded, method);
+                    continue;
+                }
+                SkBitmap decoded;
+                image->asLegacyBitmap(&decoded);
+                const int tolerance = compression == SkWebpEncoder::Compression::kLossless ? 0
+                                                                                           : 90;
+                REPORTER_ASSERT(r, almost_equals(bitmap, decoded, tolerance),
+                                "compression %d, threads %d, method %d", (int)compression,
+                                multithreaded, method);
+            }
+        }
+    }
+
+    SkWebpEncoder::Options options;
+    options.fMethod = 7;
+    SkNullWStream ignored;
+    REPORTER_ASSERT(r, !SkWebpEncoder::Encode(&ignored, bitmap.pixmap(), options));
+}
+
 DEF_TEST(Encode_WebpAnimated, r) {
     const int frameCount = 3;
     const int width = 16;
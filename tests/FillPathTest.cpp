@@ -5,17 +5,26 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkBitmap.h"
 #include "include/core/SkColor.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkMatrix.h"
+#include "include/core/SkPaint.h"
 #include "include/core/SkPath.h"
 #include "include/core/SkPathTypes.h"
 #include "include/core/SkRect.h"
 #include "include/core/SkScalar.h"
+#include "include/core/SkSurfaceProps.h"
 #include "include/core/SkTypes.h"
+#include "src/base/SkArenaAlloc.h"
 #include "src/core/SkBlitter.h"
+#include "src/core/SkRasterClip.h"
 #include "src/core/SkScan.h"
 #include "tests/Test.h"
+#include "tools/ToolUtils.h"
 
 #include <cstdint>
+#include <memory>
 
 struct FakeBlitter : public SkBlitter {
     FakeBlitter()
@@ -52,3 +61,58 @@ DEF_TEST(FillPathInverse, reporter) {
 
     REPORTER_ASSERT(reporter, blitter.m_blitCount == expected_lines);
 }
+
+// Many small self-intersecting contours, listed out of y order so that bands hold several runs of
+// contours, with curves and touching vertical edges thrown in.
+static SkPath make_banded_path(SkPathFillType fillType) {
+    SkPath path;
+    for (int i = 0; i < 40; ++i) {
+        const int row = (i * 7) % 40;
+        const SkScalar top = 8 + row * 50.25f;
+        const SkScalar left = 10 + (i % 5) * 45.5f;
+        path.moveTo(left, top);
+        for (int j = 1; j < 8; ++j) {
+            path.lineTo(left + (j * 37 % 40), top + (j * 23 % 40) + 0.3f * j);
+        }
+        path.quadTo(left + 20, top + 45, left + 2, top + 30);
+        path.conicTo(left - 5, top + 20, left, top + 10, 0.7f);
+        path.close();
+
+        path.addRect(SkRect::MakeXYWH(left + 1, top + 1, 12, 10));
+        path.addRect(SkRect::MakeXYWH(left + 1, top + 11, 12, 10.5f), SkPathDirection::kCCW);
+    }
+    path.setFillType(fillType);
+    return path;
+}
+
+DEF_TEST(FillPathBanded, reporter) {
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+
+    for (SkPathFillType fillType : {SkPathFillType::kWinding, SkPathFillType::kEvenOdd}) {
+        const SkPath path = make_banded_path(fillType);
+        for (SkIRect clip : {SkIRect::MakeWH(256, 2048), SkIRect::MakeLTRB(40, 300, 200, 1500)}) {
+            SkBitmap serial, banded;
+            serial.allocN32Pixels(256, 2048);
+            banded.allocN32Pixels(256, 2048);
+            serial.eraseColor(SK_ColorWHITE);
+            banded.eraseColor(SK_ColorWHITE);
+
+            SkPaint paint;
+            paint.setAntiAlias(true);
+            paint.setColor(0x80102030);
+            const SkRasterClip rc(clip);
+            auto blitter = [&](const SkBitmap& bitmap, SkArenaAlloc* alloc) {
+                return SkBlitter::Choose(bitmap.pixmap(), SkMatrix::I(), paint, alloc, false,
+                                         nullptr, SkSurfaceProps());
+            };
+
+            SkSTArenaAlloc<kSkBlitterContextSize> alloc;
+            SkScan::AntiFillPath(path, rc, blitter(serial, &alloc));
+            REPORTER_ASSERT(reporter, SkScan::AntiFillPathBanded(
+                    path, rc, executor.get(), [&](SkArenaAlloc* bandAlloc) {
+                        return blitter(banded, bandAlloc);
+                    }));
+            REPORTER_ASSERT(reporter, ToolUtils::equal_pixels(serial, banded));
+        }
+    }
+}
@@ -59,6 +59,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <utility>
 #include <limits>
@@ -1742,6 +1743,68 @@ DEF_TEST(ImageFilterBlurLargeImage, reporter) {
     test_large_blur_input(reporter, surface->getCanvas());
 }
 
+// Blurring at a lower resolution should stay close to the full resolution blur, and survive
+// serialization.
+DEF_TEST(ImageFilterBlurFastQuality, reporter) {
+    SkBitmap source;
+    source.allocN32Pixels(64, 64);
+    source.eraseColor(SK_ColorTRANSPARENT);
+    {
+        SkCanvas canvas(source);
+        SkPaint paint;
+        for (int y = 0; y < 64; y += 8) {
+            for (int x = (y / 8) % 2 * 8; x < 64; x += 16) {
+                paint.setColor(x % 32 ? SK_ColorWHITE : SK_ColorRED);
+                canvas.drawRect(SkRect::MakeXYWH(x, y, 8, 8), paint);
+            }
+        }
+    }
+    sk_sp<SkImage> image = source.asImage();
+
+    auto draw = [&](sk_sp<SkImageFilter> filter) {
+        SkBitmap bm;
+        bm.allocN32Pixels(400, 400);
+        bm.eraseColor(SK_ColorTRANSPARENT);
+        SkPaint paint;
+        paint.setImageFilter(std::move(filter));
+        SkCanvas canvas(bm);
+        canvas.drawImage(image, 168, 168, SkSamplingOptions(), &paint);
+        return bm;
+    };
+
+    using Quality = SkImageFilters::BlurQuality;
+    const SkSize kSigmas[] = {{16, 16}, {40, 5}, {50, 50}, {150, 150}};
+    for (SkSize sigma : kSigmas) {
+        SkBitmap exact = draw(SkImageFilters::Blur(sigma.width(), sigma.height(),
+                                                   SkTileMode::kDecal, Quality::kExact, nullptr));
+        sk_sp<SkImageFilter> fastFilter = SkImageFilters::Blur(
+                sigma.width(), sigma.height(), SkTileMode::kDecal, Quality::kFast, nullptr);
+        SkBitmap fast = draw(fastFilter);
+
+        int maxError = 0;
+        for (int y = 0; y < exact.height(); ++y) {
+            for (int x = 0; x < exact.width(); ++x) {
+                uint32_t e = *exact.getAddr32(x, y),
+                         f = *fast.getAddr32(x, y);
+                for (int shift = 0; shift < 32; shift += 8) {
+                    maxError = std::max(maxError, std::abs(int((e >> shift) & 0xFF) -
+                                                           int((f >> shift) & 0xFF)));
+                }
+            }
+        }
+        REPORTER_ASSERT(reporter, maxError <= SkImageFilters::kFastBlurMaxError,
+                        "sigma %g x %g: error %d", sigma.width(), sigma.height(), maxError);
+
+        sk_sp<SkData> data(fastFilter->serialize());
+        sk_sp<SkImageFilter> unflattened = SkImageFilter::Deserialize(data->data(),
+                                                                      data->size());
+        REPORTER_ASSERT(reporter, unflattened);
+        SkBitmap roundTrip = draw(std::move(unflattened));
+        REPORTER_ASSERT(reporter, 0 == memcmp(roundTrip.getPixels(), fast.getPixels(),
+                                              fast.computeByteSize()));
+    }
+}
+
 static void test_make_with_filter(skiatest::Reporter* reporter, GrRecordingContext* rContext) {
     sk_sp<SkSurface> surface(create_surface(rContext, 192, 128));
     surface->getCanvas()->clear(SK_ColorRED);
@@ -9,6 +9,7 @@
 #include "include/core/SkColor.h"
 #include "include/core/SkData.h"
 #include "include/core/SkDocument.h"
+#include "include/core/SkEncodedImageFormat.h"
 #include "include/core/SkExecutor.h"
 #include "include/core/SkFont.h"
 #include "include/core/SkImage.h" // IWYU pragma: keep
@@ -16,14 +17,18 @@
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkString.h"
+#include "include/core/SkTypeface.h"
 #include "include/docs/SkPDFDocument.h"
 #include "src/utils/SkOSPath.h"
 #include "tests/Test.h"
+#include "tools/Resources.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <memory>
+#include <string>
 
 static void test_empty(skiatest::Reporter* reporter) {
     SkDynamicMemoryWStream stream;
@@ -264,3 +269,108 @@ DEF_TEST(SkPDF_abort_jobs, rep) {
     doc->abort();
 }
 
+static sk_sp<SkData> make_pdf_with_executor(SkExecutor* executor) {
+    sk_sp<SkTypeface> typefaces[] = {
+        nullptr,
+        MakeResourceAsTypeface("fonts/Roboto-Regular.ttf"),
+        MakeResourceAsTypeface("fonts/Em.ttf"),
+    };
+    SkBitmap opaque, translucent, unpremulButOpaque;
+    opaque.allocN32Pixels(64, 64, true);
+    translucent.allocN32Pixels(64, 64);
+    unpremulButOpaque.allocN32Pixels(64, 64);
+    unpremulButOpaque.eraseColor(SK_ColorCYAN);
+
+    // Encoded images can't be checked for transparent pixels before they're decoded.
+    sk_sp<SkImage> encodedButOpaque = SkImage::MakeFromEncoded(
+            unpremulButOpaque.asImage()->encodeToData(SkEncodedImageFormat::kPNG, 100));
+
+    SkPDF::Metadata metadata;
+    metadata.fExecutor = executor;
+    SkDynamicMemoryWStream stream;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    for (int i = 0; i < 8; ++i) {
+        opaque.eraseColor(SkColorSetRGB(0x10 * i, 0x80, 0xFF - 0x10 * i));
+        translucent.eraseColor(SkColorSetARGB(0x20 * i, 0xFF, 0x00, 0x80));
+        SkCanvas* canvas = doc->beginPage(612, 792);
+        canvas->drawImage(opaque.asImage(), 10, 10);
+        canvas->drawImage(translucent.asImage(), 100, 10);
+        canvas->drawImage(unpremulButOpaque.asImage(), 200, 10);
+        canvas->drawImage(SkImage::MakeFromEncoded(
+                translucent.asImage()->encodeToData(SkEncodedImageFormat::kPNG, 100)), 300, 10);
+        canvas->drawImage(encodedButOpaque, 400, 10);
+        SkString text = SkStringPrintf("Page %d of a document with several fonts.", i);
+        SkScalar y = 120;
+        for (const sk_sp<SkTypeface>& typeface : typefaces) {
+            canvas->drawString(text, 20, y, SkFont(typeface, 12 + 2 * i), SkPaint());
+            y += 40;
+        }
+        doc->endPage();
+    }
+    doc->close();
+    return stream.detachAsData();
+}
+
+// The output should not depend on whether there is an executor, or how many threads it has.
+DEF_TEST(SkPDF_executor_deterministic, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_executor_deterministic, r);
+    sk_sp<SkData> serial = make_pdf_with_executor(nullptr);
+    // Every reserved object is a real one, with no empty placeholders.
+    static constexpr char kEmptyObject[] = "obj\n<<>>\nendobj";
+    const char* bytes = static_cast<const char*>(serial->data());
+    REPORTER_ASSERT(r, std::search(bytes, bytes + serial->size(), kEmptyObject,
+                                   kEmptyObject + strlen(kEmptyObject)) == bytes + serial->size());
+    for (int threads : {1, 4}) {
+        std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(threads);
+        sk_sp<SkData> threaded = make_pdf_with_executor(executor.get());
+        REPORTER_ASSERT(r, serial->equals(threaded.get()), "threads: %d", threads);
+    }
+}
+
+// Remembers only the end of what was written, so that checking which objects have been
+// flushed doesn't hold on to the whole document.
+class TailWStream final : public SkWStream {
+public:
+    bool write(const void* buffer, size_t size) override {
+        fTail.append(static_cast<const char*>(buffer), size);
+        if (fTail.size() > kTailSize) {
+            fTail.erase(0, fTail.size() - kTailSize);
+        }
+        fBytesWritten += size;
+        return true;
+    }
+    size_t bytesWritten() const override { return fBytesWritten; }
+    bool tailContains(const char* text) const { return fTail.find(text) != std::string::npos; }
+
+private:
+    static constexpr size_t kTailSize = 256;
+    std::string fTail;
+    size_t fBytesWritten = 0;
+};
+
+// With fStreamPages, nothing about a finished page should be left to write at close, so
+// a long document doesn't need more memory than a short one.
+DEF_TEST(SkPDF_stream_pages, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_stream_pages, r);
+    constexpr int kPageCount = 10000;
+    TailWStream stream;
+    SkPDF::Metadata metadata;
+    metadata.fStreamPages = true;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    for (int i = 0; i < kPageCount; ++i) {
+        SkCanvas* canvas = doc->beginPage(612, 792);
+        canvas->drawRect(SkRect::MakeLTRB(72, 72, SkIntToScalar(72 + i % 256), 144), SkPaint());
+        doc->endPage();
+        SkString pageEnd = SkStringPrintf("/StructParents %d\n/Parent ", i);
+        if (!stream.tailContains(pageEnd.c_str())) {
+            ERRORF(r, "page %d was not written when it ended", i);
+            break;
+        }
+    }
+    size_t bytesBeforeClose = stream.bytesWritten();
+    doc->close();
+    REPORTER_ASSERT(r, stream.tailContains("%%EOF"));
+    // Only the page tree and the cross-reference table should be left to write.  Holding on
+    // to the page dictionaries until now would need several times this.
+    REPORTER_ASSERT(r, stream.bytesWritten() - bytesBeforeClose < 80 * kPageCount);
+}
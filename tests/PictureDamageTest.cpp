@@ -0,0 +1,124 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkBBHFactory.h"
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkColor.h"
+#include "include/core/SkMatrix.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/core/SkRect.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkRegion.h"
+#include "include/utils/SkPictureDamage.h"
+#include "tests/Test.h"
+
+#include <cstring>
+#include <functional>
+
+static sk_sp<SkPicture> record(const std::function<void(SkCanvas*)>& draw) {
+    SkRTreeFactory factory;
+    SkPictureRecorder recorder;
+    draw(recorder.beginRecording(SkRect::MakeWH(256, 256), &factory));
+    return recorder.finishRecordingAsPicture();
+}
+
+// A grid of 16x16 rects, with one drawn in a different color, and optionally one translated.
+static sk_sp<SkPicture> grid(int highlight, SkScalar dx = 0) {
+    return record([=](SkCanvas* canvas) {
+        // Unlike drawColor(), this doesn't draw outside the picture's cull rect.
+        canvas->drawRect(SkRect::MakeWH(256, 256), SkPaint(SkColors::kWhite));
+        for (int i = 0; i < 256; i++) {
+            SkPaint paint;
+            paint.setAntiAlias(true);
+            paint.setColor(i == highlight ? SK_ColorRED : SK_ColorBLUE);
+            canvas->save();
+            canvas->translate(i == 0 ? dx : 0, 0);
+            canvas->drawRect(SkRect::MakeXYWH(16 * (i % 16) + 2, 16 * (i / 16) + 2, 12, 12),
+                             paint);
+            canvas->restore();
+        }
+    });
+}
+
+static void check_redraw(skiatest::Reporter* reporter, const SkPicture* prev,
+                         const SkPicture* next, const SkMatrix& matrix) {
+    SkRegion damage = SkPictureDamage::Compute(prev, next, matrix);
+
+    SkBitmap partial, full;
+    partial.allocN32Pixels(512, 512);
+    full.allocN32Pixels(512, 512);
+    partial.eraseColor(SK_ColorTRANSPARENT);
+    full.eraseColor(SK_ColorTRANSPARENT);
+
+    SkCanvas partialCanvas(partial);
+    partialCanvas.drawPicture(prev, &matrix, nullptr);
+    SkPictureDamage::Redraw(&partialCanvas, next, damage, matrix);
+
+    SkCanvas fullCanvas(full);
+    fullCanvas.drawPicture(next, &matrix, nullptr);
+
+    for (int y = 0; y < 512; y++) {
+        if (0 != memcmp(partial.getAddr32(0, y), full.getAddr32(0, y), 512 * 4)) {
+            ERRORF(reporter, "row %d differs after redrawing the damage", y);
+            return;
+        }
+    }
+}
+
+DEF_TEST(PictureDamage, reporter) {
+    sk_sp<SkPicture> a = grid(-1),
+                     b = grid(37),
+                     c = grid(-1);
+
+    // Identical pictures have no damage, even if they were recorded separately.
+    REPORTER_ASSERT(reporter, SkPictureDamage::Compute(a.get(), a.get()).isEmpty());
+    REPORTER_ASSERT(reporter, SkPictureDamage::Compute(a.get(), c.get()).isEmpty());
+
+    // Changing one rect damages just that rect (outset for anti-aliasing).
+    SkRegion damage = SkPictureDamage::Compute(a.get(), b.get());
+    REPORTER_ASSERT(reporter, damage.isRect());
+    REPORTER_ASSERT(reporter, damage.getBounds() == SkIRect::MakeXYWH(81, 33, 14, 14));
+
+    // The damage is in device space.
+    SkMatrix matrix = SkMatrix::Scale(2, 2).postTranslate(10, 20);
+    damage = SkPictureDamage::Compute(a.get(), b.get(), matrix);
+    REPORTER_ASSERT(reporter, damage.getBounds() == SkIRect::MakeXYWH(2 * 82 + 10 - 1,
+                                                                       2 * 34 + 20 - 1,
+                                                                       26, 26));
+
+    // Moving a rect damages where it was and where it is.
+    sk_sp<SkPicture> moved = grid(-1, 100);
+    damage = SkPictureDamage::Compute(a.get(), moved.get());
+    REPORTER_ASSERT(reporter, damage.contains(SkIRect::MakeXYWH(2, 2, 12, 12)));
+    REPORTER_ASSERT(reporter, damage.contains(SkIRect::MakeXYWH(102, 2, 12, 12)));
+    REPORTER_ASSERT(reporter, !damage.contains(SkIRect::MakeXYWH(18, 2, 12, 12)));
+
+    // Inserting an op damages only what it draws.
+    sk_sp<SkPicture> inserted = record([](SkCanvas* canvas) {
+        grid(-1)->playback(canvas);
+        canvas->drawCircle(128, 128, 4, SkPaint());
+    });
+    REPORTER_ASSERT(reporter, SkPictureDamage::Compute(a.get(), inserted.get()).getBounds()
+                              == SkIRect::MakeLTRB(123, 123, 133, 133));
+
+    // Nothing to something damages everything that's drawn.
+    damage = SkPictureDamage::Compute(nullptr, a.get());
+    REPORTER_ASSERT(reporter, damage.contains(SkIRect::MakeWH(256, 256)));
+
+    // Clipping can change how rotated edges are rasterized, so stick to axis-aligned matrices
+    // when comparing pixels exactly.
+    for (const SkMatrix& m : {SkMatrix::I(), matrix, SkMatrix::Translate(0.5f, 0.25f)}) {
+        check_redraw(reporter, a.get(), b.get(), m);
+        check_redraw(reporter, b.get(), a.get(), m);
+        check_redraw(reporter, a.get(), moved.get(), m);
+        check_redraw(reporter, moved.get(), inserted.get(), m);
+        check_redraw(reporter, nullptr, b.get(), m);
+    }
+}
@@ -26,9 +26,11 @@
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkSamplingOptions.h"
 #include "include/core/SkScalar.h"
+#include "include/core/SkSerialProcs.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkTypeface.h"
 #include "include/core/SkTypes.h"
+#include "include/encode/SkPngEncoder.h"
 #include "src/base/SkRandom.h"
 #include "src/core/SkBigPicture.h"
 #include "src/core/SkPicturePriv.h"
@@ -36,6 +38,7 @@
 #include "tests/Test.h"
 
 #include <cstddef>
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -945,3 +948,77 @@ DEF_TEST(Picture_nested_op_count, r) {
     check(make_pic(10, leaf1),  10,  10);
     check(make_pic(10, leaf10), 10, 100);
 }
+
+DEF_TEST(Picture_MakeFromDataSharesEncodedImages, r) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(16, 16);
+    bitmap.eraseColor(SK_ColorBLUE);
+    bitmap.erase(SK_ColorRED, SkIRect::MakeWH(8, 8));
+    SkDynamicMemoryWStream png;
+    REPORTER_ASSERT(r, SkPngEncoder::Encode(&png, bitmap.pixmap(), {}));
+    sk_sp<SkImage> image = SkImage::MakeFromEncoded(png.detachAsData());
+
+    // A nested picture has its own images. (It needs two ops not to be inlined instead.)
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(32, 32));
+    canvas->drawImage(image, 16, 0);
+    canvas->drawImage(image, 16, 16);
+    sk_sp<SkPicture> nested = recorder.finishRecordingAsPicture();
+    canvas = recorder.beginRecording(SkRect::MakeWH(32, 32));
+    canvas->drawImage(image, 0, 0);
+    canvas->drawPicture(nested);
+    // The top-level buffer follows the 29-byte SkPictInfo header, so this path is read in place
+    // from unaligned memory.
+    SkPath path;
+    path.moveTo(0, 16).conicTo(8, 32, 16, 16, 0.5f).cubicTo(4, 20, 12, 28, 0, 32).close();
+    SkPaint paint;
+    paint.setColor(SK_ColorGREEN);
+    canvas->drawPath(path, paint);
+    sk_sp<SkPicture> picture = recorder.finishRecordingAsPicture();
+
+    SkBitmap expected;
+    expected.allocN32Pixels(32, 32);
+    expected.eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas(expected).drawPicture(picture);
+    auto check = [&](const SkPicture* back) {
+        SkBitmap actual;
+        actual.allocN32Pixels(32, 32);
+        actual.eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas(actual).drawPicture(back);
+        for (int y = 0; y < 32; y++) {
+            REPORTER_ASSERT(r, 0 == memcmp(expected.getAddr32(0, y), actual.getAddr32(0, y),
+                                           32 * 4));
+        }
+        REPORTER_ASSERT(r, *actual.getAddr32(20, 20) == SkPreMultiplyColor(SK_ColorRED));
+    };
+
+    sk_sp<SkData> data = picture->serialize();
+    struct Range { const void* fBegin; const void* fEnd; int fImages, fInside; } range = {
+        data->bytes(), data->bytes() + data->size(), 0, 0};
+    SkDeserialProcs procs;
+    procs.fImageCtx = &range;
+    procs.fImageProc = [](const void* encoded, size_t, void* ctx) -> sk_sp<SkImage> {
+        auto range = static_cast<Range*>(ctx);
+        range->fImages++;
+        range->fInside += encoded >= range->fBegin && encoded < range->fEnd;
+        return nullptr;  // Decode as usual.
+    };
+
+    // By default, the images are copied out of data.
+    sk_sp<SkPicture> back = SkPicture::MakeFromData(data.get(), &procs);
+    REPORTER_ASSERT(r, back);
+    REPORTER_ASSERT(r, range.fImages == 2);
+    REPORTER_ASSERT(r, range.fInside == 0);
+    check(back.get());
+
+    range.fImages = 0;
+    procs.fShareData = true;
+    back = SkPicture::MakeFromData(data.get(), &procs);
+    REPORTER_ASSERT(r, back);
+    REPORTER_ASSERT(r, range.fImages == 2);
+    REPORTER_ASSERT(r, range.fInside == 2);
+
+    // The images keep what they need of data alive.
+    data = nullptr;
+    check(back.get());
+}
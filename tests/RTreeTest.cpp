@@ -14,6 +14,7 @@
 
 #include <cmath>
 #include <cstddef>
+#include <utility>
 #include <vector>
 
 using namespace skia_private;
@@ -98,3 +99,55 @@ DEF_TEST(RTree, reporter) {
                                   expectedDepthMax >= rtree.getDepth());
     }
 }
+
+// Rects recorded in spatial order are grouped in that order, and others are sorted first. Both
+// must find the same rects.
+DEF_TEST(RTree_Order, reporter) {
+    SkRandom rand;
+    AutoTMalloc<SkRect> ordered(NUM_RECTS), shuffled(NUM_RECTS);
+    for (int i = 0; i < NUM_RECTS; i++) {
+        ordered[i] = SkRect::MakeXYWH((i % 20) * 50 + rand.nextRangeF(0, 10),
+                                      (i / 20) * 50 + rand.nextRangeF(0, 10),
+                                      1 + rand.nextRangeF(0, 60), 1 + rand.nextRangeF(0, 60));
+    }
+    ordered[7].setEmpty();  // Never found.
+    std::vector<int> order(NUM_RECTS);
+    for (int i = 0; i < NUM_RECTS; i++) {
+        order[i] = i;
+    }
+    for (int i = NUM_RECTS - 1; i > 0; i--) {
+        std::swap(order[i], order[rand.nextULessThan(i + 1)]);
+    }
+    for (int i = 0; i < NUM_RECTS; i++) {
+        shuffled[i] = ordered[order[i]];
+    }
+
+    SkRTree orderedTree, shuffledTree;
+    orderedTree.insert(ordered.get(), NUM_RECTS);
+    shuffledTree.insert(shuffled.get(), NUM_RECTS);
+    REPORTER_ASSERT(reporter, NUM_RECTS - 1 == orderedTree.getCount());
+    REPORTER_ASSERT(reporter, NUM_RECTS - 1 == shuffledTree.getCount());
+
+    for (size_t i = 0; i < NUM_QUERIES; ++i) {
+        const SkRect query = random_rect(rand);
+        std::vector<int> orderedHits, shuffledHits;
+        orderedTree.search(query, &orderedHits);
+        shuffledTree.search(query, &shuffledHits);
+        REPORTER_ASSERT(reporter, verify_query(query, ordered, orderedHits));
+        REPORTER_ASSERT(reporter, verify_query(query, shuffled, shuffledHits));
+        REPORTER_ASSERT(reporter, orderedHits.size() == shuffledHits.size());
+    }
+
+    // Empty queries and those that miss everything find nothing.
+    std::vector<int> found;
+    orderedTree.search(SkRect::MakeEmpty(), &found);
+    shuffledTree.search(SkRect::MakeXYWH(2000, 2000, 10, 10), &found);
+    REPORTER_ASSERT(reporter, found.empty());
+
+    // A single rect still gets a leaf.
+    SkRTree single;
+    single.insert(ordered.get(), 1);
+    REPORTER_ASSERT(reporter, 1 == single.getDepth());
+    single.search(ordered[0], &found);
+    REPORTER_ASSERT(reporter, found == std::vector<int>{0});
+}
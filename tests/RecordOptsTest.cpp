@@ -5,21 +5,27 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkBitmap.h"
 #include "include/core/SkBlendMode.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkColor.h"
 #include "include/core/SkColorFilter.h"
+#include "include/core/SkDrawable.h"
+#include "include/core/SkImage.h"
 #include "include/core/SkImageFilter.h"
 #include "include/core/SkImageInfo.h"
+#include "include/core/SkMatrix.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkPicture.h"
 #include "include/core/SkPictureRecorder.h"
 #include "include/core/SkRect.h"
 #include "include/core/SkRefCnt.h"
+#include "include/core/SkSamplingOptions.h"
 #include "include/core/SkScalar.h"
 #include "include/core/SkSurface.h"
 #include "include/effects/SkImageFilters.h"
 #include "src/core/SkRecord.h"
+#include "src/core/SkRecordDraw.h"
 #include "src/core/SkRecordOpts.h"
 #include "src/core/SkRecorder.h"
 #include "src/core/SkRecords.h"
@@ -28,6 +34,8 @@
 
 #include <array>
 #include <cstddef>
+#include <cstring>
+#include <functional>
 
 static const int W = 1920, H = 1080;
 
@@ -426,3 +434,201 @@ DEF_TEST(savelayer_srcmode_alpha, r) {
     do_savelayer_srcmode(r, 0x80FF0000);
 }
 
+
+// Records the same draws twice, optimizes one record, and checks that both draw the same pixels.
+static void check_same_pixels(skiatest::Reporter* r, void (*optimize)(SkRecord*),
+                              const std::function<void(SkCanvas*)>& draw, const SkMatrix& matrix,
+                              SkRecord* optimized) {
+    SkRecord original;
+    SkRecorder recorder(&original, 256, 256);
+    draw(&recorder);
+    SkRecorder optimizedRecorder(optimized, 256, 256);
+    draw(&optimizedRecorder);
+    optimize(optimized);
+
+    SkBitmap expected, actual;
+    for (SkBitmap* bitmap : {&expected, &actual}) {
+        bitmap->allocN32Pixels(256, 256);
+        bitmap->eraseColor(SK_ColorTRANSPARENT);
+    }
+    SkCanvas expectedCanvas(expected), actualCanvas(actual);
+    expectedCanvas.concat(matrix);
+    actualCanvas.concat(matrix);
+    auto play = [](const SkRecord& record, const SkRecorder& recorder, SkCanvas* canvas) {
+        const SkDrawableList* drawables = recorder.getDrawableList();
+        SkRecordDraw(record, canvas, nullptr, drawables ? drawables->begin() : nullptr,
+                     drawables ? drawables->count() : 0, nullptr, nullptr);
+    };
+    play(original, recorder, &expectedCanvas);
+    play(*optimized, optimizedRecorder, &actualCanvas);
+    REPORTER_ASSERT(r, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                   expected.computeByteSize()));
+}
+
+DEF_TEST(RecordOpts_NoopOccludedDraws, r) {
+    SkPaint opaque(SkColors::kBlue), translucent(SkColor4f{0, 0, 1, 0.5f});
+    opaque.setAntiAlias(true);
+    SkPaint stroke(SkColors::kRed);
+    stroke.setStyle(SkPaint::kStroke_Style);
+    stroke.setStrokeWidth(4);
+
+    auto draw = [&](SkCanvas* canvas) {
+        canvas->drawRect(SkRect::MakeXYWH(20, 20, 50, 50), stroke);           // 0: occluded
+        canvas->drawCircle(120, 120, 30, translucent);                       // 1: occluded
+        canvas->drawRect(SkRect::MakeXYWH(5, 5, 20, 20), opaque);            // 2: too close to edge
+        canvas->drawAnnotation(SkRect::MakeXYWH(50, 50, 10, 10), "key", nullptr);  // 3: not a draw
+        canvas->save();                                                      // 4
+            canvas->clipRect(SkRect::MakeLTRB(0, 0, 180, 180));              // 5
+            canvas->translate(0.5f, 0.5f);                                   // 6
+            canvas->drawRect(SkRect::MakeXYWH(5, 5, 300, 300), opaque);      // 7: clipped cover
+        canvas->restore();                                                   // 8
+        canvas->drawRect(SkRect::MakeXYWH(190, 190, 20, 20), stroke);        // 9: outside the cover
+        canvas->drawRect(SkRect::MakeXYWH(180, 180, 40, 40), translucent);   // 10: not a cover
+    };
+
+    for (const SkMatrix& m : {SkMatrix::I(), SkMatrix::Scale(1.5f, 1.5f),
+                              SkMatrix::Translate(0.25f, 3)}) {
+        SkRecord record;
+        check_same_pixels(r, SkRecordNoopOccludedDraws, draw, m, &record);
+        assert_type<SkRecords::NoOp>(r, record, 0);
+        assert_type<SkRecords::NoOp>(r, record, 1);
+        assert_type<SkRecords::DrawRect>(r, record, 2);
+        assert_type<SkRecords::DrawAnnotation>(r, record, 3);
+        assert_type<SkRecords::DrawRect>(r, record, 7);
+        assert_type<SkRecords::DrawRect>(r, record, 9);
+        assert_type<SkRecords::DrawRect>(r, record, 10);
+    }
+
+    // A backdrop filter may spread what's under the layer, so nothing before it is occluded.
+    SkRecord backdrop;
+    check_same_pixels(r, SkRecordNoopOccludedDraws, [&](SkCanvas* canvas) {
+        canvas->drawRect(SkRect::MakeXYWH(100, 100, 20, 20), stroke);
+        auto blur = SkImageFilters::Blur(10, 10, nullptr);
+        canvas->saveLayer(SkCanvas::SaveLayerRec(nullptr, nullptr, blur.get(), 0));
+        canvas->restore();
+        canvas->drawRect(SkRect::MakeXYWH(50, 50, 100, 100), opaque);
+    }, SkMatrix::I(), &backdrop);
+    assert_type<SkRecords::DrawRect>(r, backdrop, 0);
+
+    // Draws in layers don't cover anything below them.
+    SkRecord layer;
+    check_same_pixels(r, SkRecordNoopOccludedDraws, [&](SkCanvas* canvas) {
+        canvas->drawRect(SkRect::MakeXYWH(100, 100, 20, 20), stroke);
+        canvas->saveLayerAlpha(nullptr, 0x80);
+        canvas->drawRect(SkRect::MakeXYWH(50, 50, 100, 100), opaque);
+        canvas->restore();
+    }, SkMatrix::I(), &layer);
+    assert_type<SkRecords::DrawRect>(r, layer, 0);
+
+    // A layer that starts with a copy of what's below it may spread it beyond the cover.
+    SkRecord initWithPrevious;
+    check_same_pixels(r, SkRecordNoopOccludedDraws, [&](SkCanvas* canvas) {
+        canvas->drawRect(SkRect::MakeXYWH(100, 100, 20, 20), stroke);
+        SkPaint blur;
+        blur.setImageFilter(SkImageFilters::Blur(20, 20, nullptr));
+        canvas->saveLayer(SkCanvas::SaveLayerRec(nullptr, &blur, nullptr,
+                                                 SkCanvas::kInitWithPrevious_SaveLayerFlag));
+        canvas->restore();
+        canvas->drawRect(SkRect::MakeXYWH(50, 50, 100, 100), opaque);
+    }, SkMatrix::I(), &initWithPrevious);
+    assert_type<SkRecords::DrawRect>(r, initWithPrevious, 0);
+
+    // Pictures and drawables may hold backdrop filters.
+    auto drawBackdrop = [](SkCanvas* canvas) {
+        auto blur = SkImageFilters::Blur(20, 20, nullptr);
+        canvas->saveLayer(SkCanvas::SaveLayerRec(nullptr, nullptr, blur.get(), 0));
+        canvas->drawRect(SkRect::MakeXYWH(0, 0, 1, 1), SkPaint());
+        canvas->restore();
+    };
+    SkPictureRecorder pictureRecorder;
+    drawBackdrop(pictureRecorder.beginRecording(SkRect::MakeWH(256, 256)));
+    sk_sp<SkPicture> picture = pictureRecorder.finishRecordingAsPicture();
+    SkRecord pictureBackdrop;
+    check_same_pixels(r, SkRecordNoopOccludedDraws, [&](SkCanvas* canvas) {
+        canvas->drawRect(SkRect::MakeXYWH(100, 100, 20, 20), stroke);
+        canvas->drawPicture(picture);
+        canvas->drawRect(SkRect::MakeXYWH(50, 50, 100, 100), opaque);
+    }, SkMatrix::I(), &pictureBackdrop);
+    assert_type<SkRecords::DrawPicture>(r, pictureBackdrop, 1);
+    assert_type<SkRecords::DrawRect>(r, pictureBackdrop, 0);
+
+    class BackdropDrawable : public SkDrawable {
+    public:
+        explicit BackdropDrawable(void (*draw)(SkCanvas*)) : fDraw(draw) {}
+
+    private:
+        SkRect onGetBounds() override { return SkRect::MakeWH(256, 256); }
+        void onDraw(SkCanvas* canvas) override { fDraw(canvas); }
+
+        void (*fDraw)(SkCanvas*);
+    };
+    auto drawable = sk_make_sp<BackdropDrawable>(drawBackdrop);
+    SkRecord drawableBackdrop;
+    check_same_pixels(r, SkRecordNoopOccludedDraws, [&](SkCanvas* canvas) {
+        canvas->drawRect(SkRect::MakeXYWH(100, 100, 20, 20), stroke);
+        canvas->drawDrawable(drawable.get());
+        canvas->drawRect(SkRect::MakeXYWH(50, 50, 100, 100), opaque);
+    }, SkMatrix::I(), &drawableBackdrop);
+    assert_type<SkRecords::DrawRect>(r, drawableBackdrop, 0);
+}
+
+DEF_TEST(RecordOpts_MergeDrawImageRects, r) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(16, 16);
+    bitmap.eraseColor(SK_ColorGREEN);
+    sk_sp<SkImage> image = bitmap.asImage();
+
+    SkPaint paint;
+    paint.setAlphaf(0.75f);
+    const SkSamplingOptions sampling(SkFilterMode::kLinear);
+
+    SkRecord record;
+    check_same_pixels(r, SkRecordMergeDrawImageRects, [&](SkCanvas* canvas) {
+        for (int i = 0; i < 3; i++) {
+            canvas->drawImageRect(image, SkRect::MakeWH(16, 16),
+                                  SkRect::MakeXYWH(10 + 20 * i, 10, 30, 30), sampling, &paint,
+                                  SkCanvas::kFast_SrcRectConstraint);
+        }
+        canvas->drawImageRect(image, SkRect::MakeWH(8, 8), SkRect::MakeXYWH(10, 50, 30, 30),
+                              sampling, nullptr, SkCanvas::kFast_SrcRectConstraint);
+        canvas->drawImageRect(image, SkRect::MakeWH(16, 16), SkRect::MakeXYWH(40, 50, 30, 30),
+                              sampling, nullptr, SkCanvas::kFast_SrcRectConstraint);
+        canvas->drawImageRect(image, SkRect::MakeWH(16, 16), SkRect::MakeXYWH(70, 50, 30, 30),
+                              sampling, nullptr, SkCanvas::kStrict_SrcRectConstraint);
+    }, SkMatrix::I(), &record);
+
+    auto set = assert_type<SkRecords::DrawEdgeAAImageSet>(r, record, 0);
+    REPORTER_ASSERT(r, set && set->count == 3);
+    assert_type<SkRecords::NoOp>(r, record, 1);
+    assert_type<SkRecords::NoOp>(r, record, 2);
+    set = assert_type<SkRecords::DrawEdgeAAImageSet>(r, record, 3);
+    REPORTER_ASSERT(r, set && set->count == 2);
+    assert_type<SkRecords::DrawImageRect>(r, record, 5);
+}
+
+DEF_TEST(RecordOpts_RecorderRunsDrawPasses, r) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(16, 16);
+    bitmap.eraseColor(SK_ColorGREEN);
+    sk_sp<SkImage> image = bitmap.asImage();
+
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(200, 200));
+    canvas->drawRect(SkRect::MakeXYWH(100, 100, 20, 20), SkPaint(SkColors::kRed));
+    canvas->drawRect(SkRect::MakeXYWH(50, 50, 100, 100), SkPaint(SkColors::kBlue));
+    for (int i = 0; i < 3; i++) {
+        canvas->drawImageRect(image, SkRect::MakeWH(16, 16), SkRect::MakeXYWH(20 * i, 0, 16, 16),
+                              SkSamplingOptions(), nullptr, SkCanvas::kFast_SrcRectConstraint);
+    }
+    sk_sp<SkPicture> picture = recorder.finishRecordingAsPicture();
+
+    // The red rect is covered, and the three image rects can be one image set.
+    int ops = 5;
+#if defined(SK_ENABLE_RECORD_OCCLUSION_CULLING)
+    ops -= 1;
+#endif
+#if defined(SK_ENABLE_RECORD_IMAGE_RECT_MERGING)
+    ops -= 2;
+#endif
+    REPORTER_ASSERT(r, picture->approximateOpCount() == ops);
+}
@@ -2336,6 +2336,40 @@ DEF_TEST(SkRasterPipeline_lowp_clamp01, r) {
     p.run(0,0,1,1);
 }
 
+DEF_TEST(SkRasterPipeline_lowp_tail, r) {
+    // Run srcover at every width up to a few full strides, so each possible tail is hit for
+    // whichever lowp stride (8, 16, or 32) we're running. Opaque and transparent sources blend
+    // exactly, and nothing past the end of the row may be touched.
+    constexpr int kMaxWidth = 3*SkRasterPipeline_kMaxStride + 1;
+    uint32_t src[kMaxWidth],
+             dst[kMaxWidth + 1];
+    for (int w = 1; w <= kMaxWidth; w++) {
+        for (int i = 0; i < kMaxWidth; i++) {
+            src[i] = (i % 3) ? 0xff000000 | (uint32_t)(i * 0x030507) : 0;
+            dst[i] = 0xff000000 | (uint32_t)(i * 0x070503);
+        }
+        dst[kMaxWidth] = 0xdeadbeef;
+
+        SkRasterPipeline_MemoryCtx srcCtx = { src, 0 },
+                                   dstCtx = { dst, 0 };
+
+        SkRasterPipeline_<256> p;
+        p.append(SkRasterPipelineOp::load_8888_dst, &dstCtx);
+        p.append(SkRasterPipelineOp::load_8888, &srcCtx);
+        p.append(SkRasterPipelineOp::srcover);
+        p.append(SkRasterPipelineOp::store_8888, &dstCtx);
+        p.run(0,0,w,1);
+
+        for (int i = 0; i < kMaxWidth; i++) {
+            uint32_t want = (i < w && (i % 3)) ? src[i] : 0xff000000 | (uint32_t)(i * 0x070503);
+            if (dst[i] != want) {
+                ERRORF(r, "width %d, pixel %d: got %08x, want %08x\n", w, i, dst[i], want);
+            }
+        }
+        REPORTER_ASSERT(r, dst[kMaxWidth] == 0xdeadbeef);
+    }
+}
+
 // Helper struct that can be used to scrape stack addresses at different points in a pipeline
 class StackCheckerCtx : SkRasterPipeline_CallbackCtx {
 public:
@@ -17,7 +17,9 @@
 #include "include/core/SkSize.h"
 #include "include/core/SkSurface.h"
 #include "include/core/SkTypes.h"
+#include "include/private/base/SkTo.h"
 #include "include/private/chromium/SkDiscardableMemory.h"
+#include "src/base/SkRandom.h"
 #include "src/core/SkBitmapCache.h"
 #include "src/core/SkCachedData.h"
 #include "src/core/SkMipmap.h"
@@ -26,11 +28,13 @@
 #include "src/lazy/SkDiscardableMemoryPool.h"
 #include "tests/Test.h"
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstdint>
 #include <initializer_list>
 #include <memory>
+#include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////////////
 
@@ -238,13 +242,14 @@ struct TestRec : SkResourceCache::Rec {
     TestKey fKey;
     int*    fFlags;
     bool    fCanBePurged;
+    size_t  fBytes = 1024;
 
     TestRec(int sharedID, int32_t data, int* flagPtr) : fKey(sharedID, data), fFlags(flagPtr) {
         fCanBePurged = false;
     }
 
     const Key& getKey() const override { return fKey; }
-    size_t bytesUsed() const override { return 1024; /* just need a value */ }
+    size_t bytesUsed() const override { return fBytes; }
     bool canBePurged() override { return fCanBePurged; }
     void postAddInstall(void*) override {
         *fFlags |= kDidInstall;
@@ -302,3 +307,123 @@ DEF_TEST(ResourceCache_purge, reporter) {
         }
     }
 }
+
+static bool test_rec_visitor(const SkResourceCache::Rec&, void*) { return true; }
+
+// Finds or adds the Rec for data, the way SkBitmapCache and SkMipmapCache use the cache.
+static bool find_or_add(SkResourceCache* cache, int32_t data, size_t bytes = 1024) {
+    if (cache->find(TestKey(0, data), test_rec_visitor, nullptr)) {
+        return true;
+    }
+    int flags = 0;
+    auto rec = std::make_unique<TestRec>(0, data, &flags);
+    rec->fCanBePurged = true;
+    rec->fBytes = bytes;
+    cache->add(rec.release(), nullptr);
+    return false;
+}
+
+/*
+ *  Test that kTinyLFU keeps Recs that are found often when many Recs are used once.
+ */
+DEF_TEST(ResourceCache_TinyLFU, reporter) {
+    constexpr int kHotCount = 8;
+    constexpr int kScanCount = 256;
+
+    for (auto policy : {SkResourceCache::Policy::kLRU, SkResourceCache::Policy::kTinyLFU}) {
+        SkResourceCache cache(64 * 1024);  // 64 TestRecs
+        cache.setPolicy(policy);
+
+        for (int i = 0; i < 4; ++i) {
+            for (int32_t hot = 0; hot < kHotCount; ++hot) {
+                find_or_add(&cache, hot);
+            }
+        }
+        for (int32_t cold = 0; cold < kScanCount; ++cold) {
+            find_or_add(&cache, 1000 + cold);
+        }
+
+        int hotFound = 0;
+        for (int32_t hot = 0; hot < kHotCount; ++hot) {
+            hotFound += find_or_add(&cache, hot);
+        }
+        if (policy == SkResourceCache::Policy::kLRU) {
+            REPORTER_ASSERT(reporter, hotFound == 0);
+        } else {
+            REPORTER_ASSERT(reporter, hotFound == kHotCount);
+        }
+        REPORTER_ASSERT(reporter, cache.getTotalBytesUsed() <= cache.getTotalByteLimit());
+
+        SkResourceCache::CategoryStats stats = cache.getCategoryStats("test-category");
+        REPORTER_ASSERT(reporter, stats.fHits == SkToU64(3 * kHotCount + hotFound));
+        REPORTER_ASSERT(reporter,
+                        stats.fMisses == SkToU64(kHotCount + kScanCount + kHotCount - hotFound));
+        // Every Rec that was added and is no longer in the cache was evicted for the budget.
+        size_t added = 2 * kHotCount + kScanCount - hotFound;
+        REPORTER_ASSERT(reporter, stats.fEvictions == added - cache.getTotalBytesUsed() / 1024);
+
+        // Switching back to kLRU keeps everything that was cached.
+        size_t used = cache.getTotalBytesUsed();
+        cache.setPolicy(SkResourceCache::Policy::kLRU);
+        REPORTER_ASSERT(reporter, cache.getTotalBytesUsed() == used);
+    }
+}
+
+/*
+ *  Test that kTinyLFU finds at least as many Recs as kLRU in a shorter version of the synthetic
+ *  trace in tools/resource_cache_sim: Recs that are found every frame, and bursts of Recs that
+ *  are each found for a few frames.
+ */
+DEF_TEST(ResourceCache_TinyLFUvsLRU, reporter) {
+    // 400 masks and mipmaps of 4K-256K, found with a Zipf distribution.
+    constexpr int kHotCount = 400;
+    SkRandom random;
+    std::array<size_t, kHotCount> hotBytes;
+    std::array<double, kHotCount> hotWeights;  // cumulative
+    double weight = 0;
+    for (int i = 0; i < kHotCount; ++i) {
+        hotBytes[i] = size_t(4096) << random.nextULessThan(7);
+        weight += 1.0 / (i + 1);
+        hotWeights[i] = weight;
+    }
+
+    struct Access {
+        int32_t fData;
+        size_t  fBytes;
+    };
+    std::vector<Access> trace;
+    int32_t galleryImage = kHotCount;
+    for (int frame = 0; frame < 1200; ++frame) {
+        for (int i = 0; i < 40; ++i) {
+            int hot = std::upper_bound(hotWeights.begin(), hotWeights.end(),
+                                       random.nextF() * weight) - hotWeights.begin();
+            hot = std::min(hot, kHotCount - 1);
+            trace.push_back({hot, hotBytes[hot]});
+        }
+        // While flinging, 12 gallery thumbnails of 192K are visible, and two scroll in every
+        // frame.
+        if ((frame / 200) % 2 == 1) {
+            galleryImage += 2;
+            for (int32_t image = galleryImage; image < galleryImage + 12; ++image) {
+                trace.push_back({image, 192 * 1024});
+            }
+        }
+    }
+
+    for (size_t limit : {4 << 20, 8 << 20, 16 << 20}) {
+        float hitRate[2];
+        for (auto policy : {SkResourceCache::Policy::kLRU, SkResourceCache::Policy::kTinyLFU}) {
+            SkResourceCache cache(limit);
+            cache.setPolicy(policy);
+            for (const Access& access : trace) {
+                find_or_add(&cache, access.fData, access.fBytes);
+            }
+            SkResourceCache::CategoryStats stats = cache.getCategoryStats("test-category");
+            hitRate[policy == SkResourceCache::Policy::kTinyLFU] =
+                    100.0f * stats.fHits / (stats.fHits + stats.fMisses);
+        }
+        REPORTER_ASSERT(reporter, hitRate[1] >= hitRate[0],
+                        "limit %zuK: kTinyLFU found %.1f%%, kLRU %.1f%%",
+                        limit >> 10, hitRate[1], hitRate[0]);
+    }
+}
@@ -5,20 +5,31 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkData.h"
 #include "include/core/SkFont.h"
+#include "include/core/SkFontArguments.h"
 #include "include/core/SkFontStyle.h"
 #include "include/core/SkMatrix.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkRefCnt.h"
+#include "include/core/SkStream.h"
 #include "include/core/SkSurfaceProps.h"
 #include "include/core/SkTypeface.h"
+#include "src/core/SkGlyph.h"
 #include "src/core/SkScalerContext.h"
 #include "src/core/SkStrike.h"  // IWYU pragma: keep
 #include "src/core/SkStrikeCache.h"
 #include "src/core/SkStrikeSpec.h"
 #include "tests/Test.h"
+#include "tools/Resources.h"
 #include "tools/ToolUtils.h"
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <thread>
+#include <vector>
+
 DEF_TEST(SkStrikeCache_CachePurge, Reporter) {
     SkStrikeCache cache;
 
@@ -60,3 +71,254 @@ DEF_TEST(SkStrikeCache_CachePurge, Reporter) {
 
 
 }
+
+DEF_TEST(SkStrikeCache_Threaded, reporter) {
+    SkStrikeCache cache;
+
+    sk_sp<SkTypeface> typeface =
+            ToolUtils::create_portable_typeface("serif", SkFontStyle::Italic());
+
+    static constexpr int kThreadCount = 8;
+    static constexpr int kSizeCount = 12;
+    auto strikeSpecForSize = [&](int size) {
+        SkFont font{typeface, SkIntToScalar(8 + size)};
+        font.setEdging(SkFont::Edging::kAntiAlias);
+        return SkStrikeSpec::MakeMask(
+                font, SkPaint{}, SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+                SkScalerContextFlags::kNone, SkMatrix::I());
+    };
+
+    // Every thread asks for the same strikes and glyphs; they must all see the same glyphs.
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreadCount; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < kSizeCount; ++i) {
+                sk_sp<SkStrike> strike =
+                        strikeSpecForSize((i + t) % kSizeCount).findOrCreateStrike(&cache);
+                for (SkGlyphID glyphID = 0; glyphID < 64; ++glyphID) {
+                    SkPackedGlyphID packedID{glyphID};
+                    auto [digest, glyph] =
+                            strike->digestAndGlyphFor(skglyph::kDirectMask, packedID);
+                    auto [digest2, glyph2] =
+                            strike->digestAndGlyphFor(skglyph::kDirectMask, packedID);
+                    REPORTER_ASSERT(reporter, glyph != nullptr);
+                    REPORTER_ASSERT(reporter, glyph == glyph2);
+                    REPORTER_ASSERT(reporter, glyph->getPackedID() == packedID);
+                    REPORTER_ASSERT(reporter, digest.index() == digest2.index());
+                    REPORTER_ASSERT(reporter, digest.actionFor(skglyph::kDirectMask) !=
+                                              skglyph::GlyphAction::kUnset);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    REPORTER_ASSERT(reporter, cache.getCacheCountUsed() == kSizeCount);
+    REPORTER_ASSERT(reporter, cache.getTotalMemoryUsed() > 0);
+
+    cache.purgeAll();
+    REPORTER_ASSERT(reporter, cache.getCacheCountUsed() == 0);
+    REPORTER_ASSERT(reporter, cache.getTotalMemoryUsed() == 0);
+}
+
+DEF_TEST(SkStrikeCache_Snapshot, reporter) {
+    sk_sp<SkTypeface> typeface =
+            ToolUtils::create_portable_typeface("serif", SkFontStyle::Italic());
+    SkFont font{typeface, 24};
+    font.setEdging(SkFont::Edging::kAntiAlias);
+    SkStrikeSpec strikeSpec = SkStrikeSpec::MakeMask(
+            font, SkPaint{}, SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+            SkScalerContextFlags::kNone, SkMatrix::I());
+
+    SkPackedGlyphID glyphIDs[16];
+    for (int i = 0; i < 16; ++i) {
+        glyphIDs[i] = SkPackedGlyphID{font.unicharToGlyph('a' + i)};
+    }
+
+    SkStrikeCache writer;
+    const SkGlyph* written[16];
+    strikeSpec.findOrCreateStrike(&writer)->prepareImages(glyphIDs, written);
+    SkDynamicMemoryWStream stream;
+    writer.writeSnapshot(&stream);
+    sk_sp<SkData> snapshot = stream.detachAsData();
+
+    {
+        SkStrikeCache reader;
+        SkMemoryStream readStream(snapshot);
+        REPORTER_ASSERT(reporter, reader.readSnapshot(&readStream, {&typeface, 1}) == 1);
+        sk_sp<SkStrike> strike = reader.findStrike(strikeSpec.descriptor());
+        REPORTER_ASSERT(reporter, strike != nullptr);
+        if (strike == nullptr) {
+            return;
+        }
+
+        const SkGlyph* read[16];
+        strike->prepareImages(glyphIDs, read);
+        for (int i = 0; i < 16; ++i) {
+            REPORTER_ASSERT(reporter, read[i]->rect() == written[i]->rect());
+            REPORTER_ASSERT(reporter, read[i]->advanceX() == written[i]->advanceX());
+            REPORTER_ASSERT(reporter, read[i]->imageSize() == written[i]->imageSize());
+            REPORTER_ASSERT(reporter, read[i]->imageSize() == 0 ||
+                    memcmp(read[i]->image(), written[i]->image(), read[i]->imageSize()) == 0);
+        }
+    }
+
+    // The loaded glyphs are the snapshot's rather than rasterized again: invert one mask in the
+    // snapshot and find it inverted in the loaded glyph.
+    int marked = 0;
+    while (marked < 16 && written[marked]->imageSize() == 0) {
+        ++marked;
+    }
+    REPORTER_ASSERT(reporter, marked < 16);
+    if (marked < 16) {
+        const uint8_t* image = static_cast<const uint8_t*>(written[marked]->image());
+        const size_t imageSize = written[marked]->imageSize();
+        std::vector<uint8_t> bytes(snapshot->bytes(), snapshot->bytes() + snapshot->size());
+        auto found = std::search(bytes.begin(), bytes.end(), image, image + imageSize);
+        REPORTER_ASSERT(reporter, found != bytes.end());
+        if (found == bytes.end()) {
+            return;
+        }
+        std::vector<uint8_t> inverted(image, image + imageSize);
+        for (size_t i = 0; i < imageSize; ++i) {
+            inverted[i] = ~inverted[i];
+            found[i] = inverted[i];
+        }
+
+        SkStrikeCache reader;
+        SkMemoryStream readStream(bytes.data(), bytes.size());
+        REPORTER_ASSERT(reporter, reader.readSnapshot(&readStream, {&typeface, 1}) == 1);
+        sk_sp<SkStrike> strike = reader.findStrike(strikeSpec.descriptor());
+        REPORTER_ASSERT(reporter, strike != nullptr);
+        if (strike != nullptr) {
+            const SkGlyph* read[16];
+            strike->prepareImages(glyphIDs, read);
+            REPORTER_ASSERT(reporter, read[marked]->imageSize() == imageSize &&
+                                      memcmp(read[marked]->image(), inverted.data(),
+                                             imageSize) == 0);
+        }
+    }
+
+    // A snapshot cut short is rejected.
+    {
+        SkStrikeCache reader;
+        SkMemoryStream readStream(snapshot->data(), snapshot->size() - 1);
+        REPORTER_ASSERT(reporter, reader.readSnapshot(&readStream, {&typeface, 1}) == -1);
+    }
+}
+
+DEF_TEST(SkStrikeCache_SnapshotWhileDrawing, reporter) {
+    sk_sp<SkTypeface> typeface =
+            ToolUtils::create_portable_typeface("serif", SkFontStyle::Italic());
+
+    static constexpr int kThreadCount = 4;
+    static constexpr int kSizeCount = 8;
+    static constexpr int kGlyphCount = 16;
+    auto strikeSpecForSize = [&](int size) {
+        SkFont font{typeface, SkIntToScalar(12 + size)};
+        font.setEdging(SkFont::Edging::kAntiAlias);
+        return SkStrikeSpec::MakeMask(
+                font, SkPaint{}, SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+                SkScalerContextFlags::kNone, SkMatrix::I());
+    };
+
+    SkPackedGlyphID glyphIDs[kGlyphCount];
+    for (int i = 0; i < kGlyphCount; ++i) {
+        glyphIDs[i] = SkPackedGlyphID{typeface->unicharToGlyph('a' + i)};
+    }
+
+    SkStrikeCache writer;
+    const SkGlyph* written[kSizeCount][kGlyphCount];
+    for (int size = 0; size < kSizeCount; ++size) {
+        strikeSpecForSize(size).findOrCreateStrike(&writer)->prepareImages(glyphIDs,
+                                                                           written[size]);
+    }
+    SkDynamicMemoryWStream stream;
+    writer.writeSnapshot(&stream);
+    sk_sp<SkData> snapshot = stream.detachAsData();
+
+    // Threads draw the snapshot's strikes while it loads. Each strike must end up in the cache
+    // once, whether the snapshot or a drawing thread created it, with the same glyphs.
+    for (int round = 0; round < 8; ++round) {
+        SkStrikeCache reader;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreadCount; ++t) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < kSizeCount; ++i) {
+                    const SkGlyph* drawn[kGlyphCount];
+                    strikeSpecForSize((i + t) % kSizeCount).findOrCreateStrike(&reader)
+                            ->prepareImages(glyphIDs, drawn);
+                }
+            });
+        }
+        SkMemoryStream readStream(snapshot);
+        int loaded = reader.readSnapshot(&readStream, {&typeface, 1});
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        REPORTER_ASSERT(reporter, 0 <= loaded && loaded <= kSizeCount);
+        REPORTER_ASSERT(reporter, reader.getCacheCountUsed() == kSizeCount);
+        for (int size = 0; size < kSizeCount; ++size) {
+            sk_sp<SkStrike> strike = reader.findStrike(strikeSpecForSize(size).descriptor());
+            REPORTER_ASSERT(reporter, strike != nullptr);
+            if (strike == nullptr) {
+                continue;
+            }
+            const SkGlyph* read[kGlyphCount];
+            strike->prepareImages(glyphIDs, read);
+            for (int i = 0; i < kGlyphCount; ++i) {
+                REPORTER_ASSERT(reporter, read[i]->rect() == written[size][i]->rect());
+                REPORTER_ASSERT(reporter, read[i]->imageSize() == written[size][i]->imageSize());
+                REPORTER_ASSERT(reporter, read[i]->imageSize() == 0 ||
+                        memcmp(read[i]->image(), written[size][i]->image(),
+                               read[i]->imageSize()) == 0);
+            }
+        }
+
+        reader.purgeAll();
+        REPORTER_ASSERT(reporter, reader.getCacheCountUsed() == 0);
+        REPORTER_ASSERT(reporter, reader.getTotalMemoryUsed() == 0);
+    }
+}
+
+DEF_TEST(SkStrikeCache_SnapshotVariations, reporter) {
+    sk_sp<SkTypeface> regular = MakeResourceAsTypeface("fonts/Variable.ttf");
+    if (!regular || regular->getVariationDesignPosition(nullptr, 0) <= 0) {
+        return;
+    }
+    using Coordinate = SkFontArguments::VariationPosition::Coordinate;
+    const Coordinate bold[] = {{SkSetFourByteTag('w', 'g', 'h', 't'), 700.0f}};
+    sk_sp<SkTypeface> boldTypeface = regular->makeClone(
+            SkFontArguments().setVariationDesignPosition({bold, std::size(bold)}));
+    if (!boldTypeface) {
+        return;
+    }
+
+    auto strikeSpecFor = [](sk_sp<SkTypeface> typeface) {
+        return SkStrikeSpec::MakeMask(SkFont{std::move(typeface), 24}, SkPaint{},
+                                      SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+                                      SkScalerContextFlags::kNone, SkMatrix::I());
+    };
+    SkStrikeSpec regularSpec = strikeSpecFor(regular),
+                 boldSpec    = strikeSpecFor(boldTypeface);
+
+    SkPackedGlyphID glyphIDs[4];
+    for (int i = 0; i < 4; ++i) {
+        glyphIDs[i] = SkPackedGlyphID{regular->unicharToGlyph('A' + i)};
+    }
+    SkStrikeCache writer;
+    const SkGlyph* written[4];
+    regularSpec.findOrCreateStrike(&writer)->prepareImages(glyphIDs, written);
+    SkDynamicMemoryWStream stream;
+    writer.writeSnapshot(&stream);
+    sk_sp<SkData> snapshot = stream.detachAsData();
+
+    // The same font at a different design position has the same tables, but not the same glyphs.
+    SkStrikeCache reader;
+    SkMemoryStream readStream(snapshot);
+    REPORTER_ASSERT(reporter, reader.readSnapshot(&readStream, {&boldTypeface, 1}) >= 0);
+    REPORTER_ASSERT(reporter, reader.findStrike(boldSpec.descriptor()) == nullptr);
+}
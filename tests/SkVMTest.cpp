@@ -15,7 +15,10 @@
 #include "include/private/SkSLProgramKind.h"
 #include "include/private/base/SkDebug.h"
 #include "include/private/base/SkFloatingPoint.h"
+#include "include/private/base/SkTo.h"
 #include "src/base/SkMSAN.h"
+#include "src/base/SkRandom.h"
+#include "src/core/SkOpts.h"
 #include "src/core/SkVM.h"
 #include "src/sksl/SkSLCompiler.h"
 #include "src/sksl/SkSLProgramSettings.h"
@@ -119,6 +122,112 @@ DEF_TEST(SkVM_memcpy, r) {
     });
 }
 
+DEF_TEST(SkVM_serialize, r) {
+    skvm::Builder b;
+    {
+        auto src = b.varying<int>(),
+             dst = b.varying<int>();
+        b.store32(dst, b.add(b.mul(b.load32(src), b.splat(3)), b.uniform32(b.uniform(), 0)));
+    }
+
+    for (bool allow_jit : {true, false}) {
+        skvm::Program original = b.done(/*debug_name=*/nullptr, allow_jit);
+        sk_sp<SkData> data = original.serialize();
+        REPORTER_ASSERT(r, data);
+
+        skvm::Program p = skvm::Program::Deserialize(data->data(), data->size());
+        REPORTER_ASSERT(r, !p.empty());
+        REPORTER_ASSERT(r, p.hasJIT() == original.hasJIT());
+        REPORTER_ASSERT(r, p.nargs() == original.nargs() && p.nregs() == original.nregs());
+
+        int src[] = {1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17},
+            dst[std::size(src)] = {},
+            uni = 5;
+        p.eval(std::size(src), src, dst, &uni);
+        for (size_t i = 0; i < std::size(src); i++) {
+            REPORTER_ASSERT(r, dst[i] == src[i] * 3 + 5);
+        }
+
+        // Anything damaged should be rejected rather than run.
+        std::vector<uint8_t> bytes(data->bytes(), data->bytes() + data->size());
+        bytes.back() ^= 1;
+        REPORTER_ASSERT(r, skvm::Program::Deserialize(bytes.data(), bytes.size()).empty());
+        REPORTER_ASSERT(r, skvm::Program::Deserialize(data->data(), data->size() - 1).empty());
+        REPORTER_ASSERT(r, skvm::Program::Deserialize(nullptr, 0).empty());
+    }
+}
+
+DEF_TEST(SkVM_deserialize_fuzz, r) {
+    skvm::Builder b;
+    {
+        auto src = b.varying<int>(),
+             dst = b.varying<int>();
+        auto uniforms = b.uniform();
+        b.store32(dst, b.add(b.load32(src), b.uniform32(uniforms, 0)));
+    }
+    // Without JIT code the instructions are all that Deserialize() can check.
+    skvm::Program original = b.done(/*debug_name=*/nullptr, /*allow_jit=*/false);
+    sk_sp<SkData> data = original.serialize();
+    REPORTER_ASSERT(r, data);
+    if (!data) {
+        return;
+    }
+
+    // The header is a magic number, a fingerprint and a checksum of everything after it, then
+    // the body starts with regs, loop, nargs, instruction count and JIT size, then the strides.
+    // Recomputing the checksum lets damage reach the instruction checks.
+    static constexpr size_t kHeaderBytes = 3 * sizeof(uint32_t),
+                            kChecksumOffset = 2 * sizeof(uint32_t);
+    const size_t firstInstruction = kHeaderBytes + (5 + original.nargs()) * sizeof(int32_t);
+    auto deserialize_resigned = [&](std::vector<uint8_t>& bytes) {
+        uint32_t checksum = SkOpts::hash(bytes.data() + kHeaderBytes,
+                                         bytes.size() - kHeaderBytes);
+        memcpy(bytes.data() + kChecksumOffset, &checksum, sizeof(checksum));
+        return skvm::Program::Deserialize(bytes.data(), bytes.size());
+    };
+
+    // Pointer arguments out of range are rejected, for every op that indexes args[].
+    const std::vector<skvm::InterpreterInstruction> instructions = original.instructions();
+    for (size_t i = 0; i < instructions.size(); i++) {
+        const skvm::Op op = instructions[i].op;
+        if (op != skvm::Op::load32 && op != skvm::Op::store32 && op != skvm::Op::uniform32) {
+            continue;
+        }
+        for (int32_t immA : {-1, original.nargs(), 1 << 30}) {
+            std::vector<uint8_t> bytes(data->bytes(), data->bytes() + data->size());
+            memcpy(bytes.data() + firstInstruction + (9 * i + 6) * sizeof(int32_t),
+                   &immA, sizeof(immA));
+            REPORTER_ASSERT(r, deserialize_resigned(bytes).empty(), "op %d, immA %d", (int)op,
+                            immA);
+        }
+    }
+
+    // Any other damage either fails to load or loads a program that only indexes valid
+    // registers and arguments.
+    SkRandom rand;
+    for (int iter = 0; iter < 2000; iter++) {
+        std::vector<uint8_t> bytes(data->bytes(), data->bytes() + data->size());
+        for (int flips = 1 + rand.nextULessThan(3); flips --> 0;) {
+            bytes[kHeaderBytes + rand.nextULessThan(SkToU32(bytes.size() - kHeaderBytes))] ^=
+                    1 << rand.nextULessThan(8);
+        }
+        skvm::Program p = deserialize_resigned(bytes);
+        if (p.empty()) {
+            continue;
+        }
+        for (const skvm::InterpreterInstruction& inst : p.instructions()) {
+            REPORTER_ASSERT(r, !skvm::is_trace(inst.op));
+            for (skvm::Reg reg : {inst.d, inst.x, inst.y, inst.z, inst.w}) {
+                REPORTER_ASSERT(r, 0 <= reg && (reg == 0 || reg < p.nregs()));
+            }
+            if (skvm::touches_varying_memory(inst.op) ||
+                (skvm::Op::gather8 <= inst.op && inst.op <= skvm::Op::array32)) {
+                REPORTER_ASSERT(r, 0 <= inst.immA && inst.immA < p.nargs());
+            }
+        }
+    }
+}
+
 DEF_TEST(SkVM_allow_jit, r) {
     skvm::Builder b;
     {
@@ -14,6 +14,7 @@
 #include "include/core/SkColorPriv.h"
 #include "include/core/SkColorSpace.h"
 #include "include/core/SkColorType.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkFont.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageInfo.h"
@@ -34,6 +35,7 @@
 #include "include/core/SkSurface.h"
 #include "include/core/SkTypes.h"
 #include "include/effects/SkColorMatrix.h"
+#include "include/effects/SkImageFilters.h"
 #include "include/gpu/GpuTypes.h"
 #include "include/gpu/GrBackendSurface.h"
 #include "include/gpu/GrDirectContext.h"
@@ -775,6 +777,106 @@ DEF_TEST(surface_raster_zeroinitialized, reporter) {
     }
 }
 
+static void draw_threaded_raster_scene(SkCanvas* canvas, int frame) {
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    canvas->save();
+    canvas->translate(13.5f * frame, 7.25f);
+    canvas->clipRect(SkRect::MakeLTRB(20, 20, 580, 560), true);
+    for (int i = 0; i < 40; ++i) {
+        paint.setColor(SkColorSetARGB(0x80 + 3 * i, (37 * i) & 0xff, 255 - 5 * i, (11 * i) & 0xff));
+        canvas->drawCircle(15.f * i, 13.f * i + 3 * frame, 25.f + i, paint);
+        canvas->rotate(3.f);
+        canvas->drawRect(SkRect::MakeXYWH(9.f * i, 300 - 4.f * i, 70, 33), paint);
+    }
+    canvas->restore();
+
+    SkPaint layerPaint;
+    layerPaint.setAlphaf(0.5f);
+    canvas->saveLayer(nullptr, &layerPaint);
+    paint.setColor(SK_ColorBLUE);
+    canvas->drawRRect(SkRRect::MakeRectXY(SkRect::MakeLTRB(100, 200, 500, 400), 40, 40), paint);
+    canvas->restore();
+}
+
+DEF_TEST(surface_raster_threaded, reporter) {
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    const SkImageInfo info = SkImageInfo::MakeN32Premul(600, 600);
+
+    sk_sp<SkSurface> expected = SkSurface::MakeRaster(info);
+    sk_sp<SkSurface> threaded = SkSurface::MakeRasterThreaded(info, executor.get());
+    REPORTER_ASSERT(reporter, threaded);
+    REPORTER_ASSERT(reporter, !SkSurface::MakeRasterThreaded(info, nullptr));
+
+    // Leave a matrix and clip set across the first snapshot; they must apply to later draws.
+    for (SkSurface* surface : {expected.get(), threaded.get()}) {
+        surface->getCanvas()->translate(3, 5);
+        surface->getCanvas()->clipRect(SkRect::MakeLTRB(0, 0, 550, 590));
+        draw_threaded_raster_scene(surface->getCanvas(), 0);
+    }
+    sk_sp<SkImage> firstSnapshot = threaded->makeImageSnapshot();
+    for (SkSurface* surface : {expected.get(), threaded.get()}) {
+        draw_threaded_raster_scene(surface->getCanvas(), 1);
+    }
+
+    SkBitmap expectedBM, threadedBM, firstBM;
+    expectedBM.allocPixels(info);
+    threadedBM.allocPixels(info);
+    firstBM.allocPixels(info);
+    REPORTER_ASSERT(reporter, expected->readPixels(expectedBM, 0, 0));
+    REPORTER_ASSERT(reporter, threaded->readPixels(threadedBM, 0, 0));
+    REPORTER_ASSERT(reporter, firstSnapshot->readPixels(nullptr, firstBM.pixmap(), 0, 0));
+    REPORTER_ASSERT(reporter, ToolUtils::equal_pixels(expectedBM, threadedBM));
+    // The snapshot must not see draws made after it was taken.
+    REPORTER_ASSERT(reporter, !ToolUtils::equal_pixels(firstBM, threadedBM));
+}
+
+// Filtered layers and draws that straddle the rows where tiles meet must still match exactly,
+// whether they are drawn per tile (image filters) or on one thread (backdrop filters).
+DEF_TEST(surface_raster_threaded_filters, reporter) {
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    const SkImageInfo info = SkImageInfo::MakeN32Premul(600, 600);
+
+    auto draw = [](SkCanvas* canvas, bool backdrop) {
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setColor(SK_ColorRED);
+        canvas->drawCircle(300, 256, 90.5f, paint);
+
+        SkPaint layerPaint;
+        layerPaint.setImageFilter(SkImageFilters::Blur(12, 12, nullptr));
+        canvas->saveLayer(nullptr, &layerPaint);
+        paint.setColor(SK_ColorGREEN);
+        canvas->drawRect(SkRect::MakeLTRB(50.25f, 240.5f, 250.75f, 275.25f), paint);
+        canvas->restore();
+
+        paint.setColor(SK_ColorBLUE);
+        paint.setImageFilter(SkImageFilters::DropShadow(5, 30, 4, 4, SK_ColorBLACK, nullptr));
+        canvas->drawRRect(SkRRect::MakeRectXY(SkRect::MakeLTRB(350, 470, 560, 505), 9, 9), paint);
+
+        if (backdrop) {
+            auto blur = SkImageFilters::Blur(6, 6, nullptr);
+            canvas->saveLayer(SkCanvas::SaveLayerRec(nullptr, nullptr, blur.get(), 0));
+            canvas->restore();
+        }
+    };
+
+    for (bool backdrop : {false, true}) {
+        sk_sp<SkSurface> expected = SkSurface::MakeRaster(info);
+        sk_sp<SkSurface> threaded = SkSurface::MakeRasterThreaded(info, executor.get());
+        draw(expected->getCanvas(), backdrop);
+        draw(threaded->getCanvas(), backdrop);
+
+        SkBitmap expectedBM, threadedBM;
+        expectedBM.allocPixels(info);
+        threadedBM.allocPixels(info);
+        REPORTER_ASSERT(reporter, expected->readPixels(expectedBM, 0, 0));
+        REPORTER_ASSERT(reporter, threaded->readPixels(threadedBM, 0, 0));
+        REPORTER_ASSERT(reporter, ToolUtils::equal_pixels(expectedBM, threadedBM),
+                        "backdrop %d", backdrop);
+    }
+}
+
 static sk_sp<SkSurface> create_gpu_surface_backend_texture(GrDirectContext* dContext,
                                                            int sampleCnt,
                                                            const SkColor4f& color) {
@@ -9,9 +9,9 @@
 
 #include "include/core/SkString.h"
 #include "include/core/SkTime.h"
+#include "tools/ToolUtils.h"
 #include "tools/flags/CommandLineFlags.h"
 
-#include <cstdlib>
 #include <string>
 
 static DEFINE_string2(tmpDir, t, nullptr, "Temp directory to use.");
@@ -54,21 +54,7 @@ SkString skiatest::GetTmpDir() {
     if (!FLAGS_tmpDir.isEmpty()) {
         return SkString(FLAGS_tmpDir[0]);
     }
-#ifdef SK_BUILD_FOR_ANDROID
-    const char* environmentVariable = "TMPDIR";
-    const char* defaultValue = "/data/local/tmp";
-#elif defined(SK_BUILD_FOR_MAC) || defined(SK_BUILD_FOR_UNIX)
-    const char* environmentVariable = "TMPDIR";
-    const char* defaultValue = "/tmp";
-#elif defined(SK_BUILD_FOR_WIN)
-    const char* environmentVariable = "TEMP";
-    const char* defaultValue = nullptr;
-#else
-    const char* environmentVariable = nullptr;
-    const char* defaultValue = nullptr;
-#endif
-    const char* tmpdir = environmentVariable ? getenv(environmentVariable) : nullptr;
-    return SkString(tmpdir ? tmpdir : defaultValue);
+    return ToolUtils::temp_dir();
 }
 
 skiatest::Timer::Timer() : fStartNanos(SkTime::GetNSecs()) {}
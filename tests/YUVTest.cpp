@@ -20,6 +20,7 @@
 #include "include/effects/SkColorMatrix.h"
 #include "include/encode/SkJpegEncoder.h"
 #include "include/private/base/SkTo.h"
+#include "tests/CodecPriv.h"
 #include "tests/Test.h"
 #include "tools/Resources.h"
 
@@ -30,7 +31,8 @@
 
 static void codec_yuv(skiatest::Reporter* reporter,
                       const char path[],
-                      const SkYUVAInfo* expectedInfo) {
+                      const SkYUVAInfo* expectedInfo,
+                      bool compareWithRGBA = false) {
     std::unique_ptr<SkStream> stream(GetResourceAsStream(path));
     if (!stream) {
         return;
@@ -93,6 +95,10 @@ static void codec_yuv(skiatest::Reporter* reporter,
 
     // Test getYUVAPlanes()
     REPORTER_ASSERT(reporter, SkCodec::kSuccess == codec->getYUVAPlanes(pixmaps));
+
+    if (compareWithRGBA) {
+        check_yuva_planes_match_rgba(reporter, codec.get(), pixmaps, path);
+    }
 }
 
 DEF_TEST(Jpeg_YUV_Codec, r) {
@@ -141,6 +147,71 @@ DEF_TEST(Jpeg_YUV_Codec, r) {
     codec_yuv(r, "images/arrow.png", nullptr);
 }
 
+DEF_TEST(Webp_YUV_Codec, r) {
+    auto setExpectations = [](SkISize dims, SkYUVAInfo::PlaneConfig planeConfig) {
+        return SkYUVAInfo(dims,
+                          planeConfig,
+                          SkYUVAInfo::Subsampling::k420,
+                          kRec601_Limited_SkYUVColorSpace,
+                          kTopLeft_SkEncodedOrigin,
+                          SkYUVAInfo::Siting::kCentered,
+                          SkYUVAInfo::Siting::kCentered);
+    };
+
+    SkYUVAInfo expectations = setExpectations({800, 800}, SkYUVAInfo::PlaneConfig::kY_U_V);
+    codec_yuv(r, "images/webp-color-profile-lossy.webp", &expectations, true);
+
+    // Lossy with an alpha plane
+    expectations = setExpectations({386, 395}, SkYUVAInfo::PlaneConfig::kY_U_V_A);
+    codec_yuv(r, "images/baby_tux.webp", &expectations, true);
+
+    // Odd dimensions
+    expectations = setExpectations({400, 301}, SkYUVAInfo::PlaneConfig::kY_U_V_A);
+    codec_yuv(r, "images/yellow_rose.webp", &expectations, true);
+
+    // Lossless images are encoded as RGB and should fail.
+    codec_yuv(r, "images/color_wheel.webp", nullptr);
+    codec_yuv(r, "images/webp-color-profile-lossless.webp", nullptr);
+}
+
+DEF_TEST(Webp_YUV_Codec_Incomplete, r) {
+    const char* path = "images/baby_tux.webp";
+    sk_sp<SkData> data = GetResourceAsData(path);
+    if (!data) {
+        return;
+    }
+    std::unique_ptr<SkCodec> codec(
+            SkCodec::MakeFromData(SkData::MakeSubset(data.get(), 0, data->size() / 2)));
+    REPORTER_ASSERT(r, codec);
+    if (!codec) {
+        return;
+    }
+
+    SkYUVAPixmapInfo yuvaPixmapInfo;
+    REPORTER_ASSERT(r, codec->queryYUVAInfo(SkYUVAPixmapInfo::SupportedDataTypes::All(),
+                                            &yuvaPixmapInfo));
+    auto pixmaps = SkYUVAPixmaps::Allocate(yuvaPixmapInfo);
+    REPORTER_ASSERT(r, pixmaps.isValid());
+    // Scribble on the planes, to check that the rows that aren't decoded are filled.
+    for (int i = 0; i < pixmaps.numPlanes(); ++i) {
+        pixmaps.plane(i).erase(SK_ColorWHITE);
+    }
+    REPORTER_ASSERT(r, SkCodec::kIncompleteInput == codec->getYUVAPlanes(pixmaps));
+
+    // Like getPixels(), the rest of the image is transparent black.
+    static constexpr uint8_t kExpected[] = {16, 128, 128, 0};
+    for (int i = 0; i < pixmaps.numPlanes(); ++i) {
+        const SkPixmap& plane = pixmaps.plane(i);
+        const uint8_t* lastRow = plane.addr8(0, plane.height() - 1);
+        for (int x = 0; x < plane.width(); ++x) {
+            if (lastRow[x] != kExpected[i]) {
+                ERRORF(r, "plane %d, x %d: expected %d, got %d", i, x, kExpected[i], lastRow[x]);
+                break;
+            }
+        }
+    }
+}
+
 SkYUVAPixmaps decode_yuva(skiatest::Reporter* r, std::unique_ptr<SkStream> stream) {
     static constexpr auto kAllTypes = SkYUVAPixmapInfo::SupportedDataTypes::All();
     SkYUVAPixmaps result;
@@ -29,6 +29,7 @@
 #include "src/core/SkFontPriv.h"
 
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 
 #if defined(SK_GRAPHITE)
@@ -526,6 +527,24 @@ sk_sp<SkSurface> makeSurface(SkCanvas*             canvas,
     return surf;
 }
 
+SkString temp_dir() {
+#ifdef SK_BUILD_FOR_ANDROID
+    const char* environmentVariable = "TMPDIR";
+    const char* defaultValue = "/data/local/tmp";
+#elif defined(SK_BUILD_FOR_MAC) || defined(SK_BUILD_FOR_UNIX)
+    const char* environmentVariable = "TMPDIR";
+    const char* defaultValue = "/tmp";
+#elif defined(SK_BUILD_FOR_WIN)
+    const char* environmentVariable = "TEMP";
+    const char* defaultValue = nullptr;
+#else
+    const char* environmentVariable = nullptr;
+    const char* defaultValue = nullptr;
+#endif
+    const char* tmpdir = environmentVariable ? getenv(environmentVariable) : nullptr;
+    return SkString(tmpdir ? tmpdir : defaultValue);
+}
+
 void sniff_paths(const char filepath[], std::function<PathSniffCallback> callback) {
     SkFILEStream stream(filepath);
     if (!stream.isValid()) {
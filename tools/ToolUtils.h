@@ -11,6 +11,7 @@
 #include "include/core/SkColor.h"
 #include "include/core/SkData.h"
 #include "include/core/SkEncodedImageFormat.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkFont.h"
 #include "include/core/SkFontStyle.h"
 #include "include/core/SkFontTypes.h"
@@ -31,6 +32,8 @@
 #include "src/base/SkTInternalLList.h"
 #include "tools/SkMetaData.h"
 
+#include <functional>
+
 #if defined(SK_GRAPHITE)
 #include "include/gpu/graphite/Recorder.h"
 #endif
@@ -164,6 +167,25 @@ void create_frustum_normal_map(SkBitmap* bm, const SkIRect& dst);
 
 void create_tetra_normal_map(SkBitmap* bm, const SkIRect& dst);
 
+// An SkExecutor that runs each task on the calling thread as soon as it is added, and counts them.
+// This lets tests check deterministically that work was split up.
+class CountingExecutor final : public SkExecutor {
+public:
+    void add(std::function<void(void)> work) override {
+        fTaskCount++;
+        work();
+    }
+
+    int taskCount() const { return fTaskCount; }
+
+private:
+    int fTaskCount = 0;
+};
+
+// Returns the platform's temporary directory, e.g. $TMPDIR or /tmp, or an empty string if it has
+// none.
+SkString temp_dir();
+
 // A helper object to test the topological sorting code (TopoSortBench.cpp & TopoSortTest.cpp)
 class TopoTestNode : public SkRefCnt {
 public:
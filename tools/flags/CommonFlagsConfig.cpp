@@ -157,7 +157,7 @@ static const struct {
 
 static const char configHelp[] =
         "Options: 565 4444 8888 rgba bgra rgbx 1010102 101010x bgra1010102 bgr101010x f16 f16norm "
-        "f32 nonrendering null pdf pdfa pdf300 skp svg xps";
+        "f32 nonrendering null pdf pdfa pdf300 skp svg threaded8888 xps";
 
 static const char* config_help_fn() {
     static SkString helpString;
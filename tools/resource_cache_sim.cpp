@@ -0,0 +1,170 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// Replays a trace of SkResourceCache lookups against each SkResourceCache::Policy and prints the
+// hit rate of each category. Each line of a trace file is "<category> <key> <bytes>". Without a
+// trace file a synthetic one is used: blur masks and mipmaps drawn every frame, interleaved with
+// flinging through a gallery of images that are each drawn for a few frames.
+//
+//   resource_cache_sim [--limit <bytes>] [trace.txt]
+
+#include "src/core/SkResourceCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// SkResourceCache keeps its stats by Key namespace, so each category gets its own.
+struct Category {
+    std::string fName;
+};
+
+struct Access {
+    const Category* fCategory;
+    uint64_t        fKey;
+    size_t          fBytes;
+};
+
+struct SimKey : SkResourceCache::Key {
+    uint64_t fKey;
+
+    SimKey(const Category* category, uint64_t key) : fKey(key) {
+        this->init(const_cast<Category*>(category), 0, sizeof(fKey));
+    }
+};
+
+struct SimRec : SkResourceCache::Rec {
+    SimKey fKey;
+    size_t fBytes;
+
+    explicit SimRec(const Access& access)
+        : fKey(access.fCategory, access.fKey), fBytes(access.fBytes) {}
+
+    const Key& getKey() const override { return fKey; }
+    size_t bytesUsed() const override { return fBytes; }
+    const char* getCategory() const override {
+        return static_cast<const Category*>(fKey.getNamespace())->fName.c_str();
+    }
+    SkDiscardableMemory* diagnostic_only_getDiscardable() const override { return nullptr; }
+};
+
+std::map<std::string, Category> gCategories;
+
+const Category* category(const std::string& name) {
+    Category& category = gCategories[name];
+    category.fName = name;
+    return &category;
+}
+
+std::vector<Access> synthetic_trace() {
+    std::mt19937 random(1);
+
+    // 400 masks and mipmaps of 4K-256K, drawn with a Zipf distribution.
+    constexpr int kHotCount = 400;
+    std::vector<Access> hot(kHotCount);
+    std::vector<double> weights(kHotCount);
+    for (int i = 0; i < kHotCount; ++i) {
+        const Category* c = category(i % 2 ? "mipmap" : "mask");
+        hot[i] = {c, (uint64_t)i, size_t(4096) << (random() % 7)};
+        weights[i] = 1.0 / (i + 1);
+    }
+    std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+
+    std::vector<Access> trace;
+    const Category* gallery = category("gallery");
+    uint64_t galleryImage = 0;
+    for (int frame = 0; frame < 3000; ++frame) {
+        for (int i = 0; i < 40; ++i) {
+            trace.push_back(hot[zipf(random)]);
+        }
+        // While flinging, 12 gallery thumbnails of 192K are visible, and two scroll in every
+        // frame.
+        if ((frame / 500) % 2 == 1) {
+            galleryImage += 2;
+            for (uint64_t image = galleryImage; image < galleryImage + 12; ++image) {
+                trace.push_back({gallery, image, 192 * 1024});
+            }
+        }
+    }
+    return trace;
+}
+
+std::vector<Access> read_trace(const char* filename) {
+    std::vector<Access> trace;
+    std::ifstream in(filename);
+    std::string name;
+    Access access;
+    while (in >> name >> access.fKey >> access.fBytes) {
+        access.fCategory = category(name);
+        trace.push_back(access);
+    }
+    return trace;
+}
+
+bool found_visitor(const SkResourceCache::Rec&, void*) { return true; }
+
+double hit_rate(const SkResourceCache::CategoryStats& stats) {
+    return 100.0 * stats.fHits / std::max<uint64_t>(stats.fHits + stats.fMisses, 1);
+}
+
+void simulate(const std::vector<Access>& trace, size_t limit, SkResourceCache::Policy policy) {
+    SkResourceCache cache(limit);
+    cache.setPolicy(policy);
+    for (const Access& access : trace) {
+        if (!cache.find(SimKey(access.fCategory, access.fKey), found_visitor, nullptr)) {
+            cache.add(new SimRec(access));
+        }
+    }
+
+    SkResourceCache::CategoryStats total;
+    printf("limit %6zuK %-8s", limit >> 10,
+           policy == SkResourceCache::Policy::kLRU ? "LRU" : "TinyLFU");
+    for (const auto& [name, category] : gCategories) {
+        SkResourceCache::CategoryStats stats = cache.getCategoryStats(name.c_str());
+        printf("  %s %5.1f%%", name.c_str(), hit_rate(stats));
+        total.fHits += stats.fHits;
+        total.fMisses += stats.fMisses;
+    }
+    printf("  total %5.1f%%\n", hit_rate(total));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t limit = 0;
+    const char* filename = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp(argv[i], "--limit") && i + 1 < argc) {
+            limit = strtoull(argv[++i], nullptr, 10);
+        } else {
+            filename = argv[i];
+        }
+    }
+
+    std::vector<Access> trace = filename ? read_trace(filename) : synthetic_trace();
+    std::cout << "accesses: " << trace.size() << "\n";
+
+    std::vector<size_t> limits = {limit};
+    if (!limit) {
+        limits = {4 << 20, 8 << 20, 16 << 20, 32 << 20};
+    }
+    for (size_t l : limits) {
+        simulate(trace, l, SkResourceCache::Policy::kLRU);
+        simulate(trace, l, SkResourceCache::Policy::kTinyLFU);
+    }
+    return 0;
+}
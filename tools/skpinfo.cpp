@@ -5,12 +5,16 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkData.h"
 #include "include/core/SkPicture.h"
+#include "include/core/SkSerialProcs.h"
 #include "include/core/SkStream.h"
+#include "include/core/SkTime.h"
 #include "include/private/base/SkTo.h"
 #include "src/core/SkFontDescriptor.h"
 #include "src/core/SkPictureData.h"
 #include "src/core/SkPicturePriv.h"
+#include "tools/ProcStats.h"
 #include "tools/flags/CommandLineFlags.h"
 
 static DEFINE_string2(input, i, "", "skp on which to report");
@@ -19,6 +23,8 @@ static DEFINE_bool2(cullRect, c, true, "cullRect");
 static DEFINE_bool2(flags, f, true, "flags");
 static DEFINE_bool2(tags, t, true, "tags");
 static DEFINE_bool2(quiet, q, false, "quiet");
+static DEFINE_bool2(load, l, false, "deserialize the skp, reporting load time and peak RSS");
+static DEFINE_bool(mmap, true, "map the skp when loading it, rather than reading it in");
 
 // This tool can print simple information about an SKP but its main use
 // is just to check if an SKP has been truncated during the recording
@@ -31,6 +37,35 @@ static const int kInvalidTag = 3;
 static const int kMissingInput = 4;
 static const int kIOError = 5;
 
+static int load(const char* path) {
+    const double start = SkTime::GetMSecs();
+    sk_sp<SkPicture> picture;
+    if (FLAGS_mmap) {
+        // Images reference the mapping rather than copies of their encoded data.
+        SkDeserialProcs procs;
+        procs.fShareData = true;
+        picture = SkPicture::MakeFromData(SkData::MakeFromFileName(path).get(), &procs);
+    } else {
+        SkFILEStream stream(path);
+        picture = SkPicture::MakeFromStream(&stream);
+    }
+    const double elapsed = SkTime::GetMSecs() - start;
+
+    if (!picture) {
+        if (!FLAGS_quiet) {
+            SkDebugf("Couldn't deserialize picture\n");
+        }
+        return kInvalidTag;
+    }
+    if (!FLAGS_quiet) {
+        SkDebugf("Load time: %.2f ms\n", elapsed);
+        SkDebugf("Peak RSS: %d MB\n", sk_tools::getMaxResidentSetSizeMB());
+        SkDebugf("Ops: %d\n", picture->approximateOpCount(true));
+        SkDebugf("Bytes used: %zu\n", picture->approximateBytesUsed());
+    }
+    return kSuccess;
+}
+
 int main(int argc, char** argv) {
     CommandLineFlags::SetUsage("Prints information about an skp file");
     CommandLineFlags::Parse(argc, argv);
@@ -42,6 +77,13 @@ int main(int argc, char** argv) {
         return kMissingInput;
     }
 
+    if (FLAGS_load) {
+        // Load first, so that the peak RSS is just the picture's.
+        if (int result = load(FLAGS_input[0]); result != kSuccess) {
+            return result;
+        }
+    }
+
     SkFILEStream stream(FLAGS_input[0]);
     if (!stream.isValid()) {
         if (!FLAGS_quiet) {